@@ -34,25 +34,106 @@
 #include "tagmap.h"
 
 extern syscall_desc_t syscall_desc[SYSCALL_MAX];
+
+#define DBG_PRINTS 1
+
+#ifdef TAGMAP_LABEL
+/* with label tags every opened file gets a label of its own */
+static std::map<int, uint32_t> fd2label;
+static std::map<uint32_t, std::string> label2fname;
+
+#define MAX_SOURCES 64
+
+void alert(uintptr_t addr, uint32_t label) {
+	uint32_t src[MAX_SOURCES];
+	size_t i, n;
+
+	fprintf(stderr, "\n(dta-dataleak) !!!!!!! ADDRESS 0x%" PRIxPTR " IS TAINTED (label=%u), ABORTING !!!!!!!\n",
+					addr, label);
+
+	/* visit the source labels of the union */
+	n = tagmap_lbl_sources(label, src, MAX_SOURCES);
+	for(i = 0; i < n && i < MAX_SOURCES; i++) {
+		if(src[i] == TAG_LBL_ALL) fprintf(stderr, "  tainted by label = %u (any file)\n", src[i]);
+		else fprintf(stderr, "  tainted by label = %u (%s)\n", src[i], label2fname[src[i]].c_str());
+	}
+	if(n > MAX_SOURCES) fprintf(stderr, "  ... and %zu more\n", n - MAX_SOURCES);
+	exit(1);
+}
+#else
 static std::map<int, uint8_t> fd2color;
 static std::map<uint8_t, std::string> color2fname;
 
 #define MAX_COLOR 0x80
-#define DBG_PRINTS 1
 
 void alert(uintptr_t addr, uint8_t tag) {
-	fprintf(stderr, "\n(dta-dataleak) !!!!!!! ADDRESS 0x%x IS TAINTED (tag=0x%02x), ABORTING !!!!!!!\n",
+	fprintf(stderr, "\n(dta-dataleak) !!!!!!! ADDRESS 0x%" PRIxPTR " IS TAINTED (tag=0x%02x), ABORTING !!!!!!!\n",
 					addr, tag);
 
-	for(unsigned c = 0x01; c <= MAX_COLOR; c <<= 1) {
-		if(tag & c) {
-			fprintf(stderr, "  tainted by color = 0x%02x (%s)\n", c, color2fname[c].c_str());
-		}
+	/* visit only the colors that are set */
+	for(unsigned c; tag != 0; tag &= tag - 1) {
+		c = tag & -tag;
+		fprintf(stderr, "  tainted by color = 0x%02x (%s)\n", c, color2fname[c].c_str());
 	}
 	exit(1);
 }
+#endif
 
 /* ------- TAINT SOURCES ------- */
+#ifdef TAGMAP_LABEL
+static void post_open_hook(syscall_ctx_t *ctx) {
+	uint32_t label;
+	int fd = (int)ctx->ret;
+	const char *fname = (const char*)ctx->arg[SYSCALL_ARG0];
+
+	if(unlikely((int)ctx->ret < 0)) {
+		return;
+	}
+
+	if(strstr(fname, ".so") || strstr(fname, ".so.")) {
+		return;
+	}
+
+	/* a new label for every file; fds that are reused get a new one too */
+	label = tagmap_lbl_new();
+	fd2label[fd] = label;
+	if(label != TAG_LBL_ALL) label2fname[label] = std::string(fname);
+
+#if DBG_PRINTS
+	fprintf(stderr, "(dta-dataleak) opening %s at fd %u with label %u\n", fname, fd, label);
+#endif
+}
+
+static void post_read_hook(syscall_ctx_t *ctx) {
+	int fd     =    (int)ctx->arg[SYSCALL_ARG0];
+	void *buf  =  (void*)ctx->arg[SYSCALL_ARG1];
+	size_t len = (size_t)ctx->ret;
+	std::map<int, uint32_t>::iterator it;
+
+	if(unlikely((ssize_t)len <= 0)) {
+		return;
+	}
+
+#if DBG_PRINTS
+	fprintf(stderr, "(dta-dataleak) read: %zu bytes from fd %u\n", len, fd);
+#endif
+
+	it = fd2label.find(fd);
+	if(it != fd2label.end()) {
+#if DBG_PRINTS
+		fprintf(stderr, "(dta-dataleak) tainting bytes %p -- 0x%" PRIxPTR " with label %u\n", 
+						buf, (uintptr_t)buf+len, it->second);
+#endif
+		tagmap_lbl_setn((uintptr_t)buf, len, it->second);
+	} else {
+#if DBG_PRINTS
+		fprintf(stderr, "(dta-dataleak) clearing taint on bytes %p -- 0x%" PRIxPTR "\n",
+						buf, (uintptr_t)buf+len);
+#endif
+		tagmap_clrn((uintptr_t)buf, len);
+	}
+}
+#else
 static void post_open_hook(syscall_ctx_t *ctx) {
 	static uint8_t next_color = 0x01;
 	uint8_t color;
@@ -104,26 +185,26 @@ static void post_read_hook(syscall_ctx_t *ctx) {
 	color = fd2color[fd];
 	if(color) {
 #if DBG_PRINTS
-		fprintf(stderr, "(dta-dataleak) tainting bytes %p -- 0x%x with color 0x%x\n", 
+		fprintf(stderr, "(dta-dataleak) tainting bytes %p -- 0x%" PRIxPTR " with color 0x%x\n", 
 						buf, (uintptr_t)buf+len, color);
 #endif
 		tagmap_setn((uintptr_t)buf, len, color);
 	} else {
 #if DBG_PRINTS
-		fprintf(stderr, "(dta-dataleak) clearing taint on bytes %p -- 0x%x\n",
+		fprintf(stderr, "(dta-dataleak) clearing taint on bytes %p -- 0x%" PRIxPTR "\n",
 						buf, (uintptr_t)buf+len);
 #endif
 		tagmap_clrn((uintptr_t)buf, len);
 	}
 }
+#endif
 
 /* ------- TAINT SINKS ------- */
 static void pre_socketcall_hook(syscall_ctx_t *ctx) {
 	int fd;
 	void *buf;
 	size_t i, len;
-	uint8_t tag;
-	uintptr_t start, end, addr;
+	uintptr_t start;
 
 	int call            =            (int)ctx->arg[SYSCALL_ARG0];
 	unsigned long *args = (unsigned long*)ctx->arg[SYSCALL_ARG1];
@@ -144,16 +225,18 @@ static void pre_socketcall_hook(syscall_ctx_t *ctx) {
 		}
 		fprintf(stderr, "\n");
 
-		fprintf(stderr, "(dta-dataleak) checking taint on bytes %p -- 0x%x...", 
+		fprintf(stderr, "(dta-dataleak) checking taint on bytes %p -- 0x%" PRIxPTR "...", 
 						buf, (uintptr_t)buf+len);
 #endif
 
+		/* report the first tainted byte and the colors of the rest */
 		start = (uintptr_t)buf;
-		end   = (uintptr_t)buf+len;
-		for(addr = start; addr <= end; addr++) {
-			tag = tagmap_getb(addr);
-			if(tag != 0) alert(addr, tag);
-		}
+		i     = tagmap_firstn(start, len);
+#ifdef TAGMAP_LABEL
+		if(i < len) alert(start+i, tagmap_lbl_orn(start+i, len-i));
+#else
+		if(i < len) alert(start+i, tagmap_orn(start+i, len-i));
+#endif
 
 #if DBG_PRINTS
 		fprintf(stderr, "OK\n");
@@ -166,6 +249,20 @@ static void pre_socketcall_hook(syscall_ctx_t *ctx) {
 	}
 }
 
+#if defined(TARGET_IA32E)
+/* x86-64 has no socketcall; send(2) is sendto(2) */
+static void pre_sendto_hook(syscall_ctx_t *ctx) {
+	syscall_ctx_t sctx = *ctx;
+	unsigned long args[SYSCALL_ARG_NUM];
+
+	for(size_t i = 0; i < SYSCALL_ARG_NUM; i++) args[i] = ctx->arg[i];
+
+	sctx.arg[SYSCALL_ARG0] = SYS_SENDTO;
+	sctx.arg[SYSCALL_ARG1] = (ADDRINT)args;
+	pre_socketcall_hook(&sctx);
+}
+#endif
+
 int main(int argc, char **argv) {
 	PIN_InitSymbols();
 
@@ -180,7 +277,11 @@ int main(int argc, char **argv) {
 
 	syscall_set_post(&syscall_desc[__NR_open], post_open_hook);
 	syscall_set_post(&syscall_desc[__NR_read], post_read_hook);
+#if defined(TARGET_IA32E)
+	syscall_set_pre (&syscall_desc[__NR_sendto], pre_sendto_hook);
+#else
 	syscall_set_pre (&syscall_desc[__NR_socketcall], pre_socketcall_hook);
+#endif
 
 	PIN_StartProgram();
 	
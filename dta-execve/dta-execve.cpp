@@ -39,27 +39,25 @@ extern syscall_desc_t syscall_desc[SYSCALL_MAX];
 #define DBG_PRINTS 1
 
 void alert(uintptr_t addr, const char *source, uint8_t tag) {
-	fprintf(stderr, "\n(dta-execve) !!!!!!! ADDRESS 0x%x IS TAINTED (%s, tag=0x%02x), ABORTING !!!!!!!\n",
+	fprintf(stderr, "\n(dta-execve) !!!!!!! ADDRESS 0x%" PRIxPTR " IS TAINTED (%s, tag=0x%02x), ABORTING !!!!!!!\n",
 			addr, source, tag);
 	exit(1);
 }
 
 // Check taint information
 void check_string_taint(const char *str, const char *source) {
-	uint8_t tag;
+	size_t i;
 	uintptr_t start = (uintptr_t)str;
 	uintptr_t end   = (uintptr_t)str+strlen(str);
 
 #if DBG_PRINTS
-	fprintf(stderr, "(dta-execve) checking taint on bytes 0x%x -- 0x%x (%s)... ",
+	fprintf(stderr, "(dta-execve) checking taint on bytes 0x%" PRIxPTR " -- 0x%" PRIxPTR " (%s)... ",
 			start, end, source);
 #endif
 
-	for(uintptr_t addr = start; addr <= end; addr++) {
-		// tagmap_getb(): is_taint()
-		tag = tagmap_getb(addr);
-		if(tag != 0) alert(addr, source, tag);
-	}
+	// the string and its terminating NUL byte
+	i = tagmap_firstn(start, end-start+1);
+	if(i <= end-start) alert(start+i, source, tagmap_getb(start+i));
 
 #if DBG_PRINTS
 	fprintf(stderr, "OK\n");
@@ -99,7 +97,7 @@ static void post_socketcall_hook(syscall_ctx_t* ctx) {
 			}
 			fprintf(stderr, "\n");
 
-			fprintf(stderr, "(dta-execve) tainting bytes %p -- 0x%x with tag 0x%x\n", 
+			fprintf(stderr, "(dta-execve) tainting bytes %p -- 0x%" PRIxPTR " with tag 0x%x\n", 
 					buf, (uintptr_t)buf+len, 0x01);
 #endif
 
@@ -113,6 +111,20 @@ static void post_socketcall_hook(syscall_ctx_t* ctx) {
 	}
 }
 
+#if defined(TARGET_IA32E)
+// x86-64 has no socketcall; recv(2) is recvfrom(2)
+static void post_recvfrom_hook(syscall_ctx_t *ctx) {
+	syscall_ctx_t sctx = *ctx;
+	unsigned long args[SYSCALL_ARG_NUM];
+
+	for(size_t i = 0; i < SYSCALL_ARG_NUM; i++) args[i] = ctx->arg[i];
+
+	sctx.arg[SYSCALL_ARG0] = SYS_RECVFROM;
+	sctx.arg[SYSCALL_ARG1] = (ADDRINT)args;
+	post_socketcall_hook(&sctx);
+}
+#endif
+
 /* ------- TAINT SINKS ------- */
 // Check execve arguments
 static void pre_execve_hook(syscall_ctx_t *ctx) {
@@ -155,7 +167,11 @@ int main(int argc, char **argv) {
 	}
 
 	//
+#if defined(TARGET_IA32E)
+	syscall_set_post(&syscall_desc[__NR_recvfrom], post_recvfrom_hook);
+#else
 	syscall_set_post(&syscall_desc[__NR_socketcall], post_socketcall_hook);
+#endif
 	syscall_set_pre (&syscall_desc[__NR_execve], pre_execve_hook);
 
 	PIN_StartProgram();
@@ -37,10 +37,13 @@
  * 	Vasileios P. Kemerlis(vpk@cs.columbia.edu)
  */
 
+#include <sys/mman.h>
+
 #include <errno.h>
 #include <string.h>
 #include <unistd.h>
-#include <assert.h>
+
+#include <vector>
 
 #include "libdft_api.h"
 #include "libdft_core.h"
@@ -66,11 +69,118 @@ ins_desc_t ins_desc[XED_ICLASS_LAST];
 /* null_seg */
 extern void *null_seg;
 
+/* thread contexts; indexed by thread id */
+static thread_ctx_t *threads[PIN_MAX_THREADS];
+
+/*
+ * thread context pool; the contexts are carved out of blocks of
+ * CTX_POOL_NUM (cache line aligned) contexts, and the ones of the
+ * finished threads are kept in a free stack for the threads that
+ * follow (no more than PIN_MAX_THREADS are ever carved, since the
+ * free ones are reused first). Thread start/fini callbacks are
+ * serialized by Pin, thus the pool needs no locking
+ */
+#define CTX_POOL_NUM	64			/* contexts per block	*/
+static thread_ctx_t *ctx_free[PIN_MAX_THREADS];	/* free contexts	*/
+static size_t ctx_nfree		= 0;
+static thread_ctx_t *ctx_top	= NULL;		/* the current block	*/
+static thread_ctx_t *ctx_end	= NULL;
+
+/* VCPU checkpoint; indexed by thread id (see thread_ctx_checkpoint()) */
+static vcpu_ctx_t *vcpu_ckpt[PIN_MAX_THREADS];
+
+/*
+ * trace versions (see trace_inspect()); the slow version propagates
+ * the tags of every instruction, whereas the fast one runs while the
+ * registers and the memory operands of the trace are clean, and hence
+ * there is nothing to propagate
+ */
+#define TRACE_SLOW	0	/* full propagation (default)	*/
+#define TRACE_FAST	1	/* clean state; no propagation	*/
+
+/* the clean-state checks return their verdict in this (tool) register */
+static REG clean_reg;
+
+/* clean-state fast path; on by default */
+static KNOB<bool> fast_knob(KNOB_MODE_WRITEONCE, "pintool", "fast",
+		"1", "skip the propagation of clean traces (trace versions)");
+
+/* dead propagation elimination (register liveness); on by default */
+static KNOB<bool> live_knob(KNOB_MODE_WRITEONCE, "pintool", "liveness",
+		"1", "skip the propagation of dead register tags");
+
+/* BBL-level coalescing (summary calls); on by default */
+static KNOB<bool> coalesce_knob(KNOB_MODE_WRITEONCE, "pintool", "coalesce",
+		"1", "propagate runs of simple instructions with summary calls");
+
+/* instrumented and dead (i.e., not instrumented) instructions */
+static size_t ins_total	= 0;
+static size_t ins_elim	= 0;
+
+/* a clean VCPU register */
+#ifdef	TAGMAP_LABEL
+#define GPR_CLEAN(tags)	\
+	(((tags)[0] | (tags)[1] | (tags)[2] | (tags)[3]) == TAG_ZERO)
+#else
+#define GPR_CLEAN(tags)	((tags) == TAG_ZERO)
+#endif
+
+/*
+ * get a clean thread context from the pool
+ *
+ * returns:	the thread context, or NULL on error
+ */
+static thread_ctx_t *
+ctx_get(void)
+{
+	/* thread context pointer (ptr) */
+	thread_ctx_t *tctx;
+
+	/* reuse a free context; optimized branch */
+	if (likely(ctx_nfree > 0)) {
+		tctx = ctx_free[--ctx_nfree];
+		(void)memset(tctx, 0, sizeof(thread_ctx_t));
+		return tctx;
+	}
+
+	/* the current block is exhausted */
+	if (ctx_top == ctx_end) {
+		/* allocate a new (zeroed) block */
+		if (unlikely((tctx = (thread_ctx_t *)mmap(NULL,
+			CTX_POOL_NUM * sizeof(thread_ctx_t),
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS,
+			-1, 0)) == (thread_ctx_t *)MAP_FAILED))
+			return NULL;
+
+		/* switch to the new block */
+		ctx_top	= tctx;
+		ctx_end	= tctx + CTX_POOL_NUM;
+	}
+
+	/* carve the context */
+	return ctx_top++;
+}
+
+/*
+ * return a thread context to the pool; it is left
+ * intact until it is reused (see ctx_get())
+ *
+ * @tctx:	the thread context
+ */
+static inline void
+ctx_put(thread_ctx_t *tctx)
+{
+	ctx_free[ctx_nfree++] = tctx;
+}
+
 /*
  * thread start callback (analysis function)
  *
  * allocate space for the syscall context and VCPUs
- * (i.e., thread context), and set the TLS-like pointer
+ * (i.e., thread context) from the pool (see ctx_get()),
+ * and set the TLS-like pointer
  * (i.e., thread_ctx_ptr) accordingly
  *
  * @tid:	thread id
@@ -84,9 +194,8 @@ thread_alloc(THREADID tid, CONTEXT *ctx, INT32 flags, VOID *v)
 	/* thread context pointer (ptr) */
 	thread_ctx_t *tctx = NULL;
 
-	/* allocate space for the thread context; optimized branch */
-	if (unlikely((tctx = (thread_ctx_t *)calloc(1,
-					sizeof(thread_ctx_t))) == NULL)) {
+	/* get a thread context from the pool; optimized branch */
+	if (unlikely((tctx = ctx_get()) == NULL)) {
 		/* error message */
 		LOG(string(__func__) + ": thread_ctx_t allocation failed (" +
 				string(strerror(errno)) + ")\n");
@@ -97,12 +206,16 @@ thread_alloc(THREADID tid, CONTEXT *ctx, INT32 flags, VOID *v)
 
 	/* save the address of the per-thread context to the spilled register */
 	PIN_SetContextReg(ctx, thread_ctx_ptr, (ADDRINT)tctx);
+
+	/* keep track of it */
+	threads[tid] = tctx;
 }
 
 /*
  * thread finish callback (analysis function)
  *
- * free the space for the syscall context and VCPUs
+ * release the space for the syscall context and VCPUs
+ * (i.e., return the thread context to the pool)
  *
  * @tid:	thread id
  * @ctx:	CPU context
@@ -116,8 +229,12 @@ thread_free(THREADID tid, const CONTEXT *ctx, INT32 code, VOID *v)
 	thread_ctx_t *tctx = (thread_ctx_t *)
 		PIN_GetContextReg(ctx, thread_ctx_ptr);
 
-	/* free the allocated space */
-	free(tctx);
+	/* forget it */
+	threads[tid] = NULL;
+
+	/* give it back to the pool */
+	if (likely(tctx != NULL))
+		ctx_put(tctx);
 }
 
 /* 
@@ -214,6 +331,10 @@ sysenter_save(THREADID tid, CONTEXT *ctx, SYSCALL_STANDARD std, VOID *v)
 		 * saved as "auxiliary" data
 		 */
 		thread_ctx->syscall_ctx.aux = ctx;
+#ifdef	TAGMAP_DIRECT
+		/* fixed mappings may collide with the direct shadow */
+		syscall_fixed(tid, &thread_ctx->syscall_ctx);
+#endif
 
 		/* call the pre-syscall callback (if any) */
 		if (syscall_desc[syscall_nr].pre != NULL)
@@ -308,6 +429,427 @@ sysexit_save(THREADID tid, CONTEXT *ctx, SYSCALL_STANDARD std, VOID *v)
 	}
 }
 
+/*
+ * check that the memory operands of an instruction
+ * are clean (i.e., their summary units; see tagmap_sum)
+ *
+ * @addr1:	the first operand
+ * @n1:		its size in bytes (up to SUM_SZ)
+ * @addr2:	the second operand (or the first one, again)
+ * @n2:		its size in bytes (up to SUM_SZ)
+ *
+ * returns:	1 if they are clean, 0 otherwise
+ */
+static ADDRINT PIN_FAST_ANALYSIS_CALL
+mem_clean(ADDRINT addr1, ADDRINT n1, ADDRINT addr2, ADDRINT n2)
+{
+	return (tag_sum_test(addr1, n1) | tag_sum_test(addr2, n2)) ^ 1;
+}
+
+/*
+ * check that a set of VCPU registers and the memory
+ * operands of an instruction (if any) are clean
+ *
+ * @thread_ctx:	the thread context
+ * @regs:	the registers; a bitmap of VCPU indices
+ * @addr1:	the first operand
+ * @n1:		its size in bytes (0: no memory operands)
+ * @addr2:	the second operand (or the first one, again)
+ * @n2:		its size in bytes
+ *
+ * returns:	1 if they are clean, 0 otherwise
+ */
+static ADDRINT PIN_FAST_ANALYSIS_CALL
+regs_clean(thread_ctx_t *thread_ctx, ADDRINT regs, ADDRINT addr1,
+		ADDRINT n1, ADDRINT addr2, ADDRINT n2)
+{
+	/* the registers */
+	for (; regs != 0; regs &= regs - 1)
+		if (!GPR_CLEAN(thread_ctx->vcpu.gpr[__builtin_ctzl(regs)]))
+			return 0;
+
+	/* the memory operands */
+	return (n1 == 0) ? 1 : mem_clean(addr1, n1, addr2, n2);
+}
+
+/*
+ * get the VCPU registers (GPRs) that an instruction reads and/or writes
+ *
+ * @ins:	the instruction
+ * @rd:		the registers that it reads
+ * @wr:		the registers that it writes
+ *
+ * returns:	a bitmap of VCPU indices (see REG32_INDX())
+ */
+static ADDRINT
+ins_regs(INS ins, int rd, int wr)
+{
+	ADDRINT	regs = 0;	/* the registers	*/
+	REG	reg;		/* a register		*/
+	UINT32	i;		/* iterator		*/
+
+	for (i = 0; rd && i < INS_MaxNumRRegs(ins); i++)
+		if (REG_is_grl(reg = REG_FullRegName(INS_RegR(ins, i))))
+			regs |= (ADDRINT)1 << REG32_INDX(reg);
+	for (i = 0; wr && i < INS_MaxNumWRegs(ins); i++)
+		if (REG_is_grl(reg = REG_FullRegName(INS_RegW(ins, i))))
+			regs |= (ADDRINT)1 << REG32_INDX(reg);
+
+	return regs;
+}
+
+/*
+ * check if an instruction is a REP-prefixed string comparison
+ * (i.e., REPE/REPNE SCAS/CMPS); they propagate nothing (see
+ * ins_inspect()), thus the fast version of a trace neither checks
+ * them (the check would run on every repetition) nor the registers
+ * after them
+ *
+ * @ins:	the instruction
+ *
+ * returns:	1 if it is, 0 otherwise
+ */
+static int
+ins_rep_cmp(INS ins)
+{
+	/* use XED to decode the instruction and extract its opcode */
+	xed_iclass_enum_t ins_indx = (xed_iclass_enum_t)INS_Opcode(ins);
+
+	/* the tool instruments it; it may propagate on its own */
+	if (ins_desc[ins_indx].pre != NULL || ins_desc[ins_indx].post != NULL)
+		return 0;
+
+	switch (ins_indx) {
+		case XED_ICLASS_SCASB:
+		case XED_ICLASS_SCASW:
+		case XED_ICLASS_SCASD:
+		case XED_ICLASS_SCASQ:
+		case XED_ICLASS_CMPSB:
+		case XED_ICLASS_CMPSW:
+		case XED_ICLASS_CMPSD:
+		case XED_ICLASS_CMPSQ:
+			return INS_HasRealRep(ins);
+		default:
+			return 0;
+	}
+}
+
+/*
+ * get the memory operands of an instruction, if it can be checked
+ * by the fast version of a trace (i.e., it is not a REP-prefixed one,
+ * it does not use the x87 or the SSE/MMX registers, its memory operands
+ * are up to 2 and up to SUM_SZ bytes each, and it is not instrumented
+ * by the tool)
+ *
+ * @ins:	the instruction
+ * @ops:	the memory operands (up to 2)
+ *
+ * returns:	the number of memory operands, or -1 if it cannot be checked
+ */
+static int
+ins_memops(INS ins, UINT32 *ops)
+{
+	/* use XED to decode the instruction and extract its opcode */
+	xed_iclass_enum_t ins_indx = (xed_iclass_enum_t)INS_Opcode(ins);
+
+	UINT32	i;		/* iterator		*/
+	int	n = 0;		/* memory operands	*/
+
+	/* the tool instruments it; it may propagate on its own */
+	if (ins_desc[ins_indx].pre != NULL || ins_desc[ins_indx].post != NULL)
+		return -1;
+
+	/* REP-prefixed; the operands are not fixed */
+	if (INS_HasRealRep(ins))
+		return -1;
+
+	/* x87; the shadow of the stack is not checked */
+	if (INS_Category(ins) == XED_CATEGORY_X87_ALU)
+		return -1;
+
+	/* SSE/MMX; neither is the shadow of the vector registers */
+	for (i = 0; i < INS_MaxNumRRegs(ins); i++)
+		if (REG_is_xmm(INS_RegR(ins, i)) ||
+				REG_is_ymm(INS_RegR(ins, i)) ||
+				REG_is_mm(INS_RegR(ins, i)))
+			return -1;
+	for (i = 0; i < INS_MaxNumWRegs(ins); i++)
+		if (REG_is_xmm(INS_RegW(ins, i)) ||
+				REG_is_ymm(INS_RegW(ins, i)) ||
+				REG_is_mm(INS_RegW(ins, i)))
+			return -1;
+
+	for (i = 0; i < INS_MemoryOperandCount(ins); i++) {
+		/* address generation (e.g., lea) */
+		if (!INS_MemoryOperandIsRead(ins, i) &&
+				!INS_MemoryOperandIsWritten(ins, i))
+			continue;
+
+		/* too many, or too large */
+		if (n == 2 || INS_MemoryOperandSize(ins, i) > SUM_SZ)
+			return -1;
+		ops[n++] = i;
+	}
+
+	return n;
+}
+
+/*
+ * instrument an instruction for propagating tags
+ *
+ * @ins:	the instruction
+ */
+static void
+ins_instrument(INS ins)
+{
+	/* use XED to decode the instruction and extract its opcode */
+	xed_iclass_enum_t ins_indx = (xed_iclass_enum_t)INS_Opcode(ins);
+
+	/* 
+	 * invoke the pre-ins instrumentation callback
+	 */
+	if (ins_desc[ins_indx].pre != NULL)
+		ins_desc[ins_indx].pre(ins);
+
+	/* 
+	 * analyze the instruction (default handler)
+	 */
+	if (ins_desc[ins_indx].dflact == INSDFL_ENABLE)
+		ins_inspect(ins);
+
+	/* 
+	 * invoke the post-ins instrumentation callback
+	 */
+	if (ins_desc[ins_indx].post != NULL)
+		ins_desc[ins_indx].post(ins);
+}
+
+/*
+ * get the VCPU registers (GPRs) whose tags an instruction overwrites
+ * in full, regardless of their previous tags; only the instructions
+ * that move a value to a (32/64-bit) register do so (e.g., mov, lea)
+ *
+ * @ins:	the instruction
+ *
+ * returns:	a bitmap of VCPU indices (see REG32_INDX())
+ */
+static ADDRINT
+ins_kills(INS ins)
+{
+	REG	reg;	/* the destination */
+
+	switch (INS_Opcode(ins)) {
+		case XED_ICLASS_MOV:
+		case XED_ICLASS_MOVZX:
+		case XED_ICLASS_MOVSX:
+#if defined(TARGET_IA32E)
+		case XED_ICLASS_MOVSXD:
+#endif
+		case XED_ICLASS_LEA:
+		case XED_ICLASS_POP:
+			break;
+		default:
+			return 0;
+	}
+
+	/* a register destination */
+	if (INS_OperandCount(ins) == 0 || !INS_OperandIsReg(ins, OP_0) ||
+			!REG_is_grl(reg = INS_OperandReg(ins, OP_0)))
+		return 0;
+
+	return (ADDRINT)1 << REG32_INDX(REG_FullRegName(reg));
+}
+
+/*
+ * find the instructions of a trace whose propagation is dead
+ *
+ * the tags of the registers are live at the end of every BBL, and at
+ * every instruction that is instrumented by the tool (its callbacks may
+ * read any tag) or that enters the kernel. Going backwards, a register
+ * is live if it is read before it is overwritten (see ins_kills()), and
+ * an instruction that does not write memory, and whose destination
+ * registers are all dead, need not be propagated; it is then ignored
+ * (i.e., it neither reads nor overwrites any tag)
+ *
+ * @inss:	the instructions of the trace
+ * @dead:	set for every instruction whose propagation is dead
+ *
+ * returns:	the number of dead instructions
+ */
+static size_t
+ins_dead(vector<INS> &inss, vector<char> &dead)
+{
+	ADDRINT	live	= ~(ADDRINT)0;	/* live registers		*/
+	ADDRINT	r, w;			/* registers read/written	*/
+	INS	ins;			/* current instruction		*/
+	size_t	i, n = 0;		/* iterator, dead instructions	*/
+
+	/* use XED to decode the instruction and extract its opcode */
+	xed_iclass_enum_t ins_indx;
+
+	for (i = inss.size(); i > 0; i--) {
+		ins		= inss[i - 1];
+		ins_indx	= (xed_iclass_enum_t)INS_Opcode(ins);
+
+		/* the end of a BBL */
+		if (!INS_Valid(INS_Next(ins)))
+			live = ~(ADDRINT)0;
+
+		/* the tool instruments it, or it enters the kernel */
+		if (ins_desc[ins_indx].pre != NULL ||
+				ins_desc[ins_indx].post != NULL ||
+				ins_desc[ins_indx].dflact != INSDFL_ENABLE ||
+				INS_IsSyscall(ins)) {
+			live = ~(ADDRINT)0;
+			continue;
+		}
+
+		/* the registers it reads, and writes */
+		r = ins_regs(ins, 1, 0);
+		w = ins_regs(ins, 0, 1);
+
+		/* dead; no memory, no live register */
+		if (w != 0 && (w & live) == 0 && !INS_IsMemoryWrite(ins) &&
+				!INS_IsPredicated(ins) && !INS_HasRealRep(ins)) {
+			dead[i - 1] = INS_DEAD;
+			n++;
+			continue;
+		}
+
+		/* conditional moves do not overwrite */
+		if (!INS_IsPredicated(ins))
+			live &= ~ins_kills(ins);
+		live |= r;
+	}
+
+	return n;
+}
+
+/*
+ * instrument the instructions of a trace for propagating
+ * tags, except for the ones whose propagation is dead; the
+ * runs of simple instructions are coalesced (see ins_coalesce())
+ *
+ * @trace:	the trace
+ * @inss:	the instructions of the trace
+ */
+static void
+trace_instrument(TRACE trace, vector<INS> &inss)
+{
+	vector<char>	state(inss.size(), INS_PLAIN);	/* see INS_*	*/
+	size_t		i, n = 0;		/* iterator, dead	*/
+
+	/* use XED to decode the instruction and extract its opcode */
+	xed_iclass_enum_t ins_indx;
+
+	/* register liveness; optimized branch */
+	if (likely(live_knob.Value()))
+		n = ins_dead(inss, state);
+
+	/* BBL-level coalescing; optimized branch */
+	if (likely(coalesce_knob.Value())) {
+		/* the tool callbacks fire at their own instructions */
+		for (i = 0; i < inss.size(); i++) {
+			ins_indx = (xed_iclass_enum_t)INS_Opcode(inss[i]);
+			if (state[i] == INS_PLAIN &&
+				(ins_desc[ins_indx].pre != NULL ||
+				ins_desc[ins_indx].post != NULL ||
+				ins_desc[ins_indx].dflact != INSDFL_ENABLE))
+				state[i] = INS_TOOL;
+		}
+		(void)ins_coalesce(inss, state);
+	}
+
+	for (i = 0; i < inss.size(); i++)
+		if (state[i] == INS_PLAIN || state[i] == INS_TOOL)
+			ins_instrument(inss[i]);
+
+	/* accounting */
+	ins_total	+= inss.size();
+	ins_elim	+= n;
+#ifdef	DEBUG_LIVENESS
+	/* verbose; before/after, and in total */
+	LOG(string(__func__) + ": trace " + hexstr(TRACE_Address(trace)) +
+		" (" + decstr(TRACE_Version(trace)) + "): " +
+		decstr(inss.size()) + " -> " + decstr(inss.size() - n) +
+		" propagated instructions (" + decstr(ins_total) + " -> " +
+		decstr(ins_total - ins_elim) + " in total)\n");
+#endif
+}
+
+/*
+ * insert a clean-state check (see regs_clean()) before an instruction,
+ * and switch to another version of the trace on the given verdict
+ *
+ * the check and the switch come first (CALL_ORDER_FIRST) among the
+ * analysis calls of the instruction; the calls that propagate its tags,
+ * including the summary of a coalesced run that starts there (see
+ * ins_coalesce()), run only if the trace stays in its version
+ *
+ * @ins:	the instruction
+ * @regs:	the registers to check (bitmap)
+ * @ops:	the memory operands to check
+ * @n:		the number of memory operands
+ * @verdict:	the verdict (1: clean, 0: tainted)
+ * @version:	the version to switch to
+ */
+static void
+ins_check(INS ins, ADDRINT regs, UINT32 *ops, int n, INT32 verdict,
+		ADDRINT version)
+{
+	/* nothing to check */
+	if (regs == 0 && n == 0)
+		return;
+
+	/* the memory operands only; inlined */
+	if (regs == 0)
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)mem_clean,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_MEMORYOP_EA, ops[0],
+			IARG_ADDRINT, INS_MemoryOperandSize(ins, ops[0]),
+			IARG_MEMORYOP_EA, ops[n - 1],
+			IARG_ADDRINT, INS_MemoryOperandSize(ins, ops[n - 1]),
+			IARG_RETURN_REGS, clean_reg,
+			IARG_CALL_ORDER, CALL_ORDER_FIRST,
+			IARG_END);
+	/* registers only */
+	else if (n == 0)
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)regs_clean,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_ADDRINT, regs,
+			IARG_ADDRINT, 0,
+			IARG_ADDRINT, 0,
+			IARG_ADDRINT, 0,
+			IARG_ADDRINT, 0,
+			IARG_RETURN_REGS, clean_reg,
+			IARG_CALL_ORDER, CALL_ORDER_FIRST,
+			IARG_END);
+	/* both */
+	else
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)regs_clean,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_ADDRINT, regs,
+			IARG_MEMORYOP_EA, ops[0],
+			IARG_ADDRINT, INS_MemoryOperandSize(ins, ops[0]),
+			IARG_MEMORYOP_EA, ops[n - 1],
+			IARG_ADDRINT, INS_MemoryOperandSize(ins, ops[n - 1]),
+			IARG_RETURN_REGS, clean_reg,
+			IARG_CALL_ORDER, CALL_ORDER_FIRST,
+			IARG_END);
+
+	/* switch */
+	INS_InsertVersionCase(ins, clean_reg, verdict, version,
+			IARG_CALL_ORDER, CALL_ORDER_FIRST, IARG_END);
+}
+
 /*
  * trace inspection (instrumentation function)
  *
@@ -315,6 +857,20 @@ sysexit_save(THREADID tid, CONTEXT *ctx, SYSCALL_STANDARD std, VOID *v)
  * inspect every instruction for instrumenting it
  * accordingly
  *
+ * every trace comes in two versions (see TRACE_SLOW, TRACE_FAST); the
+ * slow version checks, at its head, that the registers of the trace
+ * and the memory operands of its first instruction are clean, and
+ * switches to the fast version if they are. The fast version skips
+ * the propagation; it checks the memory operands of every instruction,
+ * and it switches back to the slow version (at that instruction) once
+ * they are not clean. Instructions that cannot be checked (see
+ * ins_memops()) are fully instrumented in both versions, and the
+ * registers are checked again after them. Branches keep the version
+ * of the trace, and the fast version re-checks the registers at its
+ * head too. Since a switch only happens when there is nothing to
+ * propagate, or before any propagation, instructions are never
+ * propagated twice
+ *
  * @trace:      instructions trace; given by PIN
  * @v:		callback value
  */
@@ -324,55 +880,80 @@ trace_inspect(TRACE trace, VOID *v)
 	/* iterators */
 	BBL bbl;
 	INS ins;
-	xed_iclass_enum_t ins_indx;
+	size_t i;
+
+	/* the instructions and the registers they use */
+	vector<INS> inss;
+	vector<ADDRINT> regs;
+
+	/* memory operands */
+	UINT32 ops[2];
+	int n;
+
+	/* pending register check */
+	int pending = 1;
 
 	/* traverse all the BBLs in the trace */
-	for (bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl)) {
+	for (bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
 		/* traverse all the instructions in the BBL */
 		for (ins = BBL_InsHead(bbl);
 				INS_Valid(ins);
-				ins = INS_Next(ins)) {
-			        /*
-				 * use XED to decode the instruction and
-				 * extract its opcode
-				 */
-				ins_indx = (xed_iclass_enum_t)INS_Opcode(ins);
+				ins = INS_Next(ins))
+			inss.push_back(ins);
 
-				/* 
-				 * invoke the pre-ins instrumentation callback
-				 */
-				if (ins_desc[ins_indx].pre != NULL)
-					ins_desc[ins_indx].pre(ins);
+	/* no versions; optimized branch */
+	if (unlikely(!fast_knob.Value())) {
+		trace_instrument(trace, inss);
+		return;
+	}
 
-				/* 
-				 * analyze the instruction (default handler)
-				 */
-				if (ins_desc[ins_indx].dflact == INSDFL_ENABLE)
-					ins_inspect(ins);
+	/* the registers that are used from each instruction onwards */
+	regs.resize(inss.size() + 1, 0);
+	for (i = inss.size(); i > 0; i--)
+		regs[i - 1] = regs[i] | ins_regs(inss[i - 1], 1, 1);
 
-				/* 
-				 * invoke the post-ins instrumentation callback
-				 */
-				if (ins_desc[ins_indx].post != NULL)
-					ins_desc[ins_indx].post(ins);
+	/* slow version; switch if the trace is clean */
+	if (TRACE_Version(trace) == TRACE_SLOW) {
+		if (!inss.empty() && (n = ins_memops(inss[0], ops)) >= 0)
+			ins_check(inss[0], regs[0], ops, n, 1, TRACE_FAST);
+		trace_instrument(trace, inss);
+		return;
+	}
+
+	/* fast version; switch once the trace is not clean */
+	for (i = 0; i < inss.size(); i++) {
+		/* REPE/REPNE SCAS/CMPS; nothing to check or propagate */
+		if (ins_rep_cmp(inss[i]))
+			continue;
+
+		/* cannot be checked; propagate */
+		if ((n = ins_memops(inss[i], ops)) < 0) {
+			ins_instrument(inss[i]);
+			pending = 1;
+			continue;
 		}
+
+		ins_check(inss[i], pending ? regs[i] : 0, ops, n, 0,
+				TRACE_SLOW);
+		pending = 0;
 	}
 }
 
 /*
  * initialize thread contexts
  *
- * spill a tool register for the thread contexts
- * and register a thread start callback
+ * spill a tool register for the thread contexts (and one
+ * for the clean-state checks), and register a thread start callback
  *
  * returns: 0 on success, 1 on error
  */
 static inline int
 thread_ctx_init(void)
 {
-	/* claim a tool register; optimized branch */
+	/* claim the tool registers; optimized branch */
 	if (unlikely(
-		(thread_ctx_ptr = PIN_ClaimToolRegister()) == REG_INVALID())) {
+		(thread_ctx_ptr = PIN_ClaimToolRegister()) == REG_INVALID() ||
+		(clean_reg = PIN_ClaimToolRegister()) == REG_INVALID())) {
 		/* error message */
 		LOG(string(__func__) + ": register claim failed\n");
 
@@ -395,7 +976,8 @@ thread_ctx_init(void)
 /*
  * global handler for internal errors (i.e., errors from libdft)
  *
- * handle memory protection (e.g., R/W/X access to null_seg)
+ * handle memory protection (e.g., R/W/X access to null_seg, or the
+ * first write to a lazy tagmap page)
  * 	-- or --
  * for unknown reasons, when an analysis function is executed,
  * the EFLAGS.AC bit (i.e., bit 18) is asserted, thus leading
@@ -420,9 +1002,9 @@ excpt_hdlr(THREADID tid, EXCEPTION_INFO *pExceptInfo,
 	if (PIN_GetExceptionCode(pExceptInfo) ==
 			EXCEPTCODE_ACCESS_MISALIGNED) {
 		/* clear EFLAGS.AC */
-		PIN_SetPhysicalContextReg(pPhysCtxt, REG_EFLAGS,
+		PIN_SetPhysicalContextReg(pPhysCtxt, REG_GFLAGS,
 			CLEAR_EFLAGS_AC(PIN_GetPhysicalContextReg(pPhysCtxt,
-					REG_EFLAGS)));
+					REG_GFLAGS)));
 		
 		/* the exception is handled gracefully; commence execution */
 		return EHR_HANDLED;
@@ -433,6 +1015,10 @@ excpt_hdlr(THREADID tid, EXCEPTION_INFO *pExceptInfo,
 		
 		/* get the address of the memory violation */	
 		PIN_GetFaultyAccessAddress(pExceptInfo, &vaddr);
+
+		/* first write to a lazy tagmap page; commit it and retry */
+		if (tagmap_commit(vaddr) == 0)
+			return EHR_HANDLED;
 		
 		/* sanity check */
 		if (PAGE_ALIGN(vaddr) == (ADDRINT)null_seg) {
@@ -482,6 +1068,9 @@ libdft_init(void)
 	/* initialize the ins descriptors */
 	(void)memset(ins_desc, 0, sizeof(ins_desc));
 
+	/* initialize the dispatch table of ins_inspect() */
+	ins_dispatch_init();
+
 	/* register trace_ins() to be called for every trace */
 	TRACE_AddInstrumentFunction(trace_inspect, NULL);
 
@@ -495,6 +1084,71 @@ libdft_init(void)
 	return 0;
 }
 
+/*
+ * save the VCPU (register tags) of every live thread
+ *
+ * returns:	0 on success, 1 on error
+ */
+int
+thread_ctx_checkpoint(void)
+{
+	size_t	tid;	/* iterator */
+
+	for (tid = 0; tid < PIN_MAX_THREADS; tid++) {
+		/* dead thread; drop its checkpoint */
+		if (threads[tid] == NULL) {
+			free(vcpu_ckpt[tid]);
+			vcpu_ckpt[tid] = NULL;
+			continue;
+		}
+
+		/* allocate space for the checkpoint; optimized branch */
+		if (unlikely(vcpu_ckpt[tid] == NULL &&
+			(vcpu_ckpt[tid] = (vcpu_ctx_t *)malloc(
+					sizeof(vcpu_ctx_t))) == NULL)) {
+			/* error message */
+			LOG(string(__func__) +
+				": vcpu_ctx_t allocation failed (" +
+				string(strerror(errno)) + ")\n");
+
+			/* failed */
+			return 1;
+		}
+
+		/* save the VCPU */
+		(void)memcpy(vcpu_ckpt[tid], &threads[tid]->vcpu,
+				sizeof(vcpu_ctx_t));
+	}
+
+	/* success */
+	return 0;
+}
+
+/*
+ * restore the VCPU (register tags) of every live thread from
+ * the last checkpoint; threads that were created after the
+ * checkpoint get clean registers
+ */
+void
+thread_ctx_reset(void)
+{
+	size_t	tid;	/* iterator */
+
+	for (tid = 0; tid < PIN_MAX_THREADS; tid++) {
+		/* dead thread */
+		if (threads[tid] == NULL)
+			continue;
+
+		/* restore the VCPU */
+		if (vcpu_ckpt[tid] != NULL)
+			(void)memcpy(&threads[tid]->vcpu, vcpu_ckpt[tid],
+					sizeof(vcpu_ctx_t));
+		else
+			(void)memset(&threads[tid]->vcpu, 0,
+					sizeof(vcpu_ctx_t));
+	}
+}
+
 /*
  * stop the execution of the application inside the
  * tag-aware VM; the execution of the application
@@ -638,7 +1292,10 @@ ins_set_dflact(ins_desc_t *desc, size_t action)
 /* 
  * REG-to-VCPU map;
  * get the register index in the VCPU structure
- * given a PIN register (32-bit regs)
+ * given a PIN register (32-bit regs); on x86-64
+ * the 64-bit registers are accepted as well, since
+ * both are mapped to the same container (e.g.,
+ * EAX, RAX -> RAX)
  *
  * @reg:	the PIN register
  * returns:	the index of the register in the VCPU
@@ -652,54 +1309,132 @@ REG32_INDX(REG reg)
 	 */
 	switch (reg) {
 		/* di */
+#if defined(TARGET_IA32E)
+		case LEVEL_BASE::REG::REG_RDI:
+#endif
 		case LEVEL_BASE::REG::REG_EDI:
 			return 0;
 			/* not reached; safety */
 			break;
 		/* si */
+#if defined(TARGET_IA32E)
+		case LEVEL_BASE::REG::REG_RSI:
+#endif
 		case LEVEL_BASE::REG::REG_ESI:
 			return 1;
 			/* not reached; safety */
 			break;
 		/* bp */
+#if defined(TARGET_IA32E)
+		case LEVEL_BASE::REG::REG_RBP:
+#endif
 		case LEVEL_BASE::REG::REG_EBP:
 			return 2;
 			/* not reached; safety */
 			break;
 		/* sp */
+#if defined(TARGET_IA32E)
+		case LEVEL_BASE::REG::REG_RSP:
+#endif
 		case LEVEL_BASE::REG::REG_ESP:
 			return 3;
 			/* not reached; safety */
 			break;
 		/* bx */
+#if defined(TARGET_IA32E)
+		case LEVEL_BASE::REG::REG_RBX:
+#endif
 		case LEVEL_BASE::REG::REG_EBX:
 			return 4;
 			/* not reached; safety */
 			break;
 		/* dx */
+#if defined(TARGET_IA32E)
+		case LEVEL_BASE::REG::REG_RDX:
+#endif
 		case LEVEL_BASE::REG::REG_EDX:
 			return 5;
 			/* not reached; safety */
 			break;
 		/* cx */
+#if defined(TARGET_IA32E)
+		case LEVEL_BASE::REG::REG_RCX:
+#endif
 		case LEVEL_BASE::REG::REG_ECX:
 			return 6;
 			/* not reached; safety */
 			break;
 		/* ax */
+#if defined(TARGET_IA32E)
+		case LEVEL_BASE::REG::REG_RAX:
+#endif
 		case LEVEL_BASE::REG::REG_EAX:
 			return 7;
 			/* not reached; safety */
 			break;
+#if defined(TARGET_IA32E)
+		/* r8 */
+		case LEVEL_BASE::REG::REG_R8:
+		case REG_R8D:
+			return 8;
+			/* not reached; safety */
+			break;
+		/* r9 */
+		case LEVEL_BASE::REG::REG_R9:
+		case REG_R9D:
+			return 9;
+			/* not reached; safety */
+			break;
+		/* r10 */
+		case LEVEL_BASE::REG::REG_R10:
+		case REG_R10D:
+			return 10;
+			/* not reached; safety */
+			break;
+		/* r11 */
+		case LEVEL_BASE::REG::REG_R11:
+		case REG_R11D:
+			return 11;
+			/* not reached; safety */
+			break;
+		/* r12 */
+		case LEVEL_BASE::REG::REG_R12:
+		case REG_R12D:
+			return 12;
+			/* not reached; safety */
+			break;
+		/* r13 */
+		case LEVEL_BASE::REG::REG_R13:
+		case REG_R13D:
+			return 13;
+			/* not reached; safety */
+			break;
+		/* r14 */
+		case LEVEL_BASE::REG::REG_R14:
+		case REG_R14D:
+			return 14;
+			/* not reached; safety */
+			break;
+		/* r15 */
+		case LEVEL_BASE::REG::REG_R15:
+		case REG_R15D:
+			return 15;
+			/* not reached; safety */
+			break;
+#endif
 		default:
+			/* segment registers; a slot each */
+			if (REG_is_seg(reg))
+				return GPR_SEG + (reg - REG_SEG_BASE);
+
 			/* 
 			 * paranoia;
 			 * unknown 32-bit registers are mapped
-			 * to the scratch register of the VCPU
+			 * to the last-resort slot of the VCPU
 			 */
-			//return 8;
-			assert(reg < LEVEL_BASE::REG::REG_LAST);
-			return GRP_NUM + reg;
+			LOG(string(__func__) + ": untracked register (" +
+				REG_StringShort(reg) + ")\n");
+			return GPR_OTHER;
 	}
 }
 
@@ -760,15 +1495,61 @@ REG16_INDX(REG reg)
 			return 7;
 			/* not reached; safety */
 			break;
+#if defined(TARGET_IA32E)
+		/* r8w */
+		case REG_R8W:
+			return 8;
+			/* not reached; safety */
+			break;
+		/* r9w */
+		case REG_R9W:
+			return 9;
+			/* not reached; safety */
+			break;
+		/* r10w */
+		case REG_R10W:
+			return 10;
+			/* not reached; safety */
+			break;
+		/* r11w */
+		case REG_R11W:
+			return 11;
+			/* not reached; safety */
+			break;
+		/* r12w */
+		case REG_R12W:
+			return 12;
+			/* not reached; safety */
+			break;
+		/* r13w */
+		case REG_R13W:
+			return 13;
+			/* not reached; safety */
+			break;
+		/* r14w */
+		case REG_R14W:
+			return 14;
+			/* not reached; safety */
+			break;
+		/* r15w */
+		case REG_R15W:
+			return 15;
+			/* not reached; safety */
+			break;
+#endif
 		default:
+			/* segment registers; a slot each */
+			if (REG_is_seg(reg))
+				return GPR_SEG + (reg - REG_SEG_BASE);
+
 			/* 
 			 * paranoia;
 			 * unknown 16-bit registers are mapped
-			 * to the scratch register of the VCPU
+			 * to the last-resort slot of the VCPU
 			 */
-			//return 8;
-			assert(reg < LEVEL_BASE::REG::REG_LAST);
-			return GRP_NUM + reg;
+			LOG(string(__func__) + ": untracked register (" +
+				REG_StringShort(reg) + ")\n");
+			return GPR_OTHER;
 	}
 }
 
@@ -813,14 +1594,76 @@ REG8_INDX(REG reg)
 			return 4;
 			/* not reached; safety */
 			break;
+#if defined(TARGET_IA32E)
+		/* dil */
+		case REG_DIL:
+			return 0;
+			/* not reached; safety */
+			break;
+		/* sil */
+		case REG_SIL:
+			return 1;
+			/* not reached; safety */
+			break;
+		/* bpl */
+		case REG_BPL:
+			return 2;
+			/* not reached; safety */
+			break;
+		/* spl */
+		case REG_SPL:
+			return 3;
+			/* not reached; safety */
+			break;
+		/* r8b */
+		case REG_R8B:
+			return 8;
+			/* not reached; safety */
+			break;
+		/* r9b */
+		case REG_R9B:
+			return 9;
+			/* not reached; safety */
+			break;
+		/* r10b */
+		case REG_R10B:
+			return 10;
+			/* not reached; safety */
+			break;
+		/* r11b */
+		case REG_R11B:
+			return 11;
+			/* not reached; safety */
+			break;
+		/* r12b */
+		case REG_R12B:
+			return 12;
+			/* not reached; safety */
+			break;
+		/* r13b */
+		case REG_R13B:
+			return 13;
+			/* not reached; safety */
+			break;
+		/* r14b */
+		case REG_R14B:
+			return 14;
+			/* not reached; safety */
+			break;
+		/* r15b */
+		case REG_R15B:
+			return 15;
+			/* not reached; safety */
+			break;
+#endif
 		default:
 			/* 
 			 * paranoia;
 			 * unknown 8-bit registers are mapped
-			 * to the scratch register
+			 * to the last-resort slot of the VCPU
 			 */
-			//return 8;
-			assert(reg < LEVEL_BASE::REG::REG_LAST);
-			return GRP_NUM + reg;
+			LOG(string(__func__) + ": untracked register (" +
+				REG_StringShort(reg) + ")\n");
+			return GPR_OTHER;
 	}
 }
@@ -61,7 +61,33 @@
 #define SYSCALL_MAX	__NR_syncfs+1		/* max syscall number */
 #endif
 
+#if defined(TARGET_IA32E)
+#define GRP_NUM		16			/* general purpose registers */
+#else
 #define GRP_NUM		8			/* general purpose registers */
+#endif
+#define GPR_SCRATCH	GRP_NUM			/* scratch register (VCPU) */
+#define SEG_NUM		6			/* segment registers */
+#define GPR_SEG		(GRP_NUM + 1)		/* segment registers (VCPU) */
+#define GPR_OTHER	(GPR_SEG + SEG_NUM)	/* last resort (VCPU) */
+#define GPR_VCPU	(GPR_OTHER + 1)		/* VCPU registers */
+
+#define CACHE_LINE_SZ	64			/* L1 cache line size */
+
+#if defined(TARGET_IA32E)
+#define XMM_NUM		16			/* SSE registers */
+#else
+#define XMM_NUM		8			/* SSE registers */
+#endif
+#define MMX_NUM		8			/* MMX registers */
+#define X87_NUM		8			/* x87 registers */
+#define XMM_LEN		16			/* SSE register size (bytes) */
+#define YMM_LEN		32			/* AVX register size (bytes) */
+#define MMX_LEN		8			/* MMX register size (bytes) */
+
+#if defined(TARGET_IA32E) && defined(TAGMAP_LABEL)
+#error	"TAGMAP_LABEL is not supported on x86-64 (TARGET_IA32E)"
+#endif
 
 /* FIXME: turn off the EFLAGS.AC bit by applying the corresponding mask */
 #define CLEAR_EFLAGS_AC(eflags)	((eflags & 0xfffbffff))
@@ -82,9 +108,29 @@ enum {						 /* {en,dis}able (ins_desc_t) */
 /* #define */ INSDFL_DISABLE	= 1
 };
 
+/*
+ * tag of a VCPU register; one tag byte per register byte
+ * (i.e., 4 bytes on x86 and 8 bytes on x86-64)
+ */
+#if defined(TARGET_IA32E)
+typedef uint64_t	gpr_tag_t;
+#else
+typedef uint32_t	gpr_tag_t;
+#endif
+
+/*
+ * tag of a byte of a SIMD (SSE, MMX) or x87 register, in the
+ * register format; with TAGMAP_LABEL, the label of the byte
+ */
+#ifdef	TAGMAP_LABEL
+typedef uint32_t	vec_tag_t;
+#else
+typedef uint8_t		vec_tag_t;
+#endif
+
 /*
  * virtual CPU (VCPU) context definition;
- * x86/x86_32/i386 arch
+ * x86/x86_32/i386 and x86-64 arch
  */
 typedef struct {
 	/*
@@ -93,21 +139,47 @@ typedef struct {
 	 * we assign one byte of tag information for
 	 * for every byte of addressable memory; the 32-bit
 	 * GPRs of the x86 architecture will be represented
-	 * with 4 bytes each 
+	 * with 4 bytes each, and the 64-bit GPRs of x86-64
+	 * with 8 bytes each (with TAGMAP_LABEL, 4 labels each;
+	 * gpr[reg][i] is the label of the i-th byte)
 	 *
 	 * NOTE the mapping:
-	 * 	0: EDI
-	 * 	1: ESI
-	 * 	2: EBP
-	 * 	3: ESP
-	 * 	4: EBX
-	 * 	5: EDX
-	 * 	6: ECX
-	 * 	7: EAX
-	 * 	8: scratch (not a real register; helper) 
+	 * 	0: EDI (RDI)
+	 * 	1: ESI (RSI)
+	 * 	2: EBP (RBP)
+	 * 	3: ESP (RSP)
+	 * 	4: EBX (RBX)
+	 * 	5: EDX (RDX)
+	 * 	6: ECX (RCX)
+	 * 	7: EAX (RAX)
+	 * 	8-15: R8-R15 (x86-64 only)
+	 * 	GPR_SCRATCH: scratch (not a real register; helper) 
+	 * 	GPR_SEG-GPR_SEG+5: CS, SS, DS, ES, FS, GS
+	 * 	GPR_OTHER: last resort for any other register; the
+	 * 		handlers never pass one (see REG32_INDX())
+	 */
+#ifdef	TAGMAP_LABEL
+	uint32_t gpr[GPR_VCPU][4];
+#else
+	gpr_tag_t gpr[GPR_VCPU];
+#endif
+
+	/*
+	 * SIMD registers; one tag per byte, like the GPRs (the tag of
+	 * a GPR has the same layout as vec_tag_t[4] or vec_tag_t[8]).
+	 * XMMi is the lower half (XMM_LEN bytes) of YMMi
+	 *
+	 * NOTE: the MMX registers are not aliased to the x87 ones
 	 */
-	//uint32_t gpr[GRP_NUM + 1];
-	uint32_t gpr[LEVEL_BASE::REG::REG_LAST + GRP_NUM + 1];
+	vec_tag_t xmm[XMM_NUM][YMM_LEN];	/* YMM0-YMM7 (YMM15) */
+	vec_tag_t mmx[MMX_NUM][MMX_LEN];	/* MM0-MM7 */
+
+	/*
+	 * x87 registers; a single tag per (80-bit) register, since the
+	 * values are converted on every load and store. x87[i] is the
+	 * tag of ST(i), and hence it follows the pushes and the pops
+	 */
+	vec_tag_t x87[X87_NUM];
 } vcpu_ctx_t;
 
 /*
@@ -123,12 +195,19 @@ typedef struct {
 /* 	ADDRINT errno; */		/* error code */
 } syscall_ctx_t;
 
-/* thread context definition */
+/*
+ * thread context definition
+ *
+ * the VCPU comes first, since it is accessed by every analysis function
+ * (the GPRs fit in the first cache lines); the contexts are aligned to,
+ * and padded up to, CACHE_LINE_SZ so that the contexts of different
+ * threads never share a cache line (see thread_alloc())
+ */
 typedef struct {
 	vcpu_ctx_t	vcpu;		/* VCPU context */
 	syscall_ctx_t	syscall_ctx;	/* syscall context */
 	void		*uval;		/* local storage */
-} thread_ctx_t;
+} __attribute__((aligned(CACHE_LINE_SZ))) thread_ctx_t;
 
 /* instruction (ins) descriptor */
 typedef struct {
@@ -142,6 +221,10 @@ typedef struct {
 int	libdft_init(void);
 void	libdft_die(void);
 
+/* thread context API */
+int	thread_ctx_checkpoint(void);
+void	thread_ctx_reset(void);
+
 /* ins API */
 int	ins_set_pre(ins_desc_t*, void (*)(INS));
 int	ins_clr_pre(ins_desc_t*);
@@ -31,10 +31,16 @@
  */
 
 #include <errno.h>
+#include <stddef.h>
 #include <string.h>
 #include <wchar.h>
 
+#include <set>
+
 #include "pin.H"
+extern "C" {
+#include "xed-interface.h"
+}
 #include "libdft_api.h"
 #include "libdft_core.h"
 #include "tagmap.h"
@@ -44,2876 +50,5389 @@
 /* thread context */
 extern REG	thread_ctx_ptr;
 
-/* STAB */
-extern uint32_t	*STAB;
 
 /*
  * tag propagation (analysis function)
  *
- * extend the tag as follows: t[upper(eax)] = t[ax]
- *
- * NOTE: special case for the CWDE instruction
+ * instrumentation helper; returns the flag that
+ * takes as argument -- seems lame, but it is
+ * necessary for aiding conditional analysis to
+ * be inlined. Typically used with INS_InsertIfCall()
+ * in order to return true (i.e., allow the execution
+ * of the function that has been instrumented with
+ * INS_InsertThenCall()) only once
  *
- * @thread_ctx:	the thread context
+ * first_iteration:	flag; indicates whether the rep-prefixed instruction is
+ * 			executed for the first time or not
  */
-static void PIN_FAST_ANALYSIS_CALL
-_cwde(thread_ctx_t *thread_ctx)
+static ADDRINT PIN_FAST_ANALYSIS_CALL
+rep_predicate(BOOL first_iteration)
 {
-	*(((uint16_t *)&thread_ctx->vcpu.gpr[7]) + 1) =
-		*((uint16_t *)&thread_ctx->vcpu.gpr[7]);
+	/* return the flag; typically this is true only once */
+	return first_iteration; 
 }
 
+#ifdef	TAGMAP_LABEL
 /*
- * tag propagation (analysis function)
+ * tag propagation with labels (TAGMAP_LABEL)
  *
- * propagate and extend tag between a 16-bit 
- * register and an 8-bit register as t[dst] = t[upper(src)]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
+ * the analysis functions below mirror the ones that follow (#else), with
+ * the same names and semantics; every byte of a VCPU register carries a
+ * label (i.e., gpr[reg][0] is the label of the lowest byte, and gpr[reg][1]
+ * is the label of the upper 8-bit register), and t[dst] |= t[src] becomes
+ * the union of the labels (see tag_union())
  */
+
+/* copy n labels */
+static inline void
+lbl_xfer(uint32_t *dst, const uint32_t *src, size_t n)
+{
+	size_t	i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = src[i];
+}
+
+/* combine n labels with another n labels */
+static inline void
+lbl_or(uint32_t *dst, const uint32_t *src, size_t n)
+{
+	size_t	i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = tag_union(dst[i], src[i]);
+}
+
+/* set n labels to the same label */
+static inline void
+lbl_fill(uint32_t *dst, uint32_t lbl, size_t n)
+{
+	size_t	i;
+
+	for (i = 0; i < n; i++)
+		dst[i] = lbl;
+}
+
+/* combine n labels with the same label */
+static inline void
+lbl_orfill(uint32_t *dst, uint32_t lbl, size_t n)
+{
+	size_t	i;
+
+	/* clean; optimized branch */
+	if (likely(lbl == TAG_ZERO))
+		return;
+
+	for (i = 0; i < n; i++)
+		dst[i] = tag_union(dst[i], lbl);
+}
+
+/* t[upper(eax)] = t[ax]; CWDE */
 static void PIN_FAST_ANALYSIS_CALL
-_movsx_r2r_opwb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+_cwde(thread_ctx_t *thread_ctx)
 {
-	/* temporary tag value */
-	uint8_t src_tag = *(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
+	lbl_xfer(&thread_ctx->vcpu.gpr[7][2], thread_ctx->vcpu.gpr[7], 2);
+}
 
-	/* update the destination (xfer) */
-	*((uint8_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
+/* t[dst] = t[upper(src)]; 16-bit MOVSX */
+static void PIN_FAST_ANALYSIS_CALL
+_movsx_r2r_opwb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	lbl_fill(thread_ctx->vcpu.gpr[dst], thread_ctx->vcpu.gpr[src][1], 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 16-bit 
- * register and an 8-bit register as t[dst] = t[lower(src)]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
+/* t[dst] = t[lower(src)]; 16-bit MOVSX */
 static void PIN_FAST_ANALYSIS_CALL
 _movsx_r2r_opwb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint8_t src_tag = *((uint8_t *)&thread_ctx->vcpu.gpr[src]);
-
-	/* update the destination (xfer) */
-	*((uint8_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
+	lbl_fill(thread_ctx->vcpu.gpr[dst], thread_ctx->vcpu.gpr[src][0], 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and an upper 8-bit register as t[dst] = t[upper(src)]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
+/* t[dst] = t[upper(src)]; 32-bit MOVSX */
 static void PIN_FAST_ANALYSIS_CALL
 _movsx_r2r_oplb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint8_t src_tag = *(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
-
-	/* update the destination (xfer) */
-	*((uint8_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 2)	= src_tag;
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 3)	= src_tag;
+	lbl_fill(thread_ctx->vcpu.gpr[dst], thread_ctx->vcpu.gpr[src][1], 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and a lower 8-bit register as t[dst] = t[lower(src)]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
+/* t[dst] = t[lower(src)]; 32-bit MOVSX */
 static void PIN_FAST_ANALYSIS_CALL
 _movsx_r2r_oplb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint8_t src_tag = *((uint8_t *)&thread_ctx->vcpu.gpr[src]);
-
-	/* update the destination (xfer) */
-	*((uint8_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 2)	= src_tag;
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 3)	= src_tag;
+	lbl_fill(thread_ctx->vcpu.gpr[dst], thread_ctx->vcpu.gpr[src][0], 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and a 16-bit register as t[dst] = t[src]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
+/* t[dst] = t[src]; 32-bit MOVSX (16-bit src) */
 static void PIN_FAST_ANALYSIS_CALL
 _movsx_r2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint16_t src_tag = *((uint16_t *)&thread_ctx->vcpu.gpr[src]);
+	/* temporary labels; src may be dst */
+	uint32_t src_tag[2];
 
-	/* update the destination (xfer) */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
-	*(((uint16_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
+	lbl_xfer(src_tag, thread_ctx->vcpu.gpr[src], 2);
+	lbl_xfer(thread_ctx->vcpu.gpr[dst], src_tag, 2);
+	lbl_xfer(&thread_ctx->vcpu.gpr[dst][2], src_tag, 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 16-bit 
- * register and an 8-bit memory location as
- * t[dst] = t[src]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
+/* t[dst] = t[src]; 16-bit MOVSX (8-bit memory) */
 static void PIN_FAST_ANALYSIS_CALL
 _movsx_m2r_opwb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	/* temporary tag value */
-	uint8_t src_tag = *((uint8_t *)(src + STAB[VIRT2STAB(src)]));
-
-	/* update the destination (xfer) */
-	*((uint8_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
+	lbl_fill(thread_ctx->vcpu.gpr[dst], tag_ldlbl(src), 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit 
- * register and an 8-bit memory location as
- * t[dst] = t[src]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
+/* t[dst] = t[src]; 32-bit MOVSX (8-bit memory) */
 static void PIN_FAST_ANALYSIS_CALL
 _movsx_m2r_oplb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	/* temporary tag value */
-	uint8_t src_tag = *((uint8_t *)(src + STAB[VIRT2STAB(src)]));
-
-	/* update the destination (xfer) */
-	*((uint8_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 2)	= src_tag;
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 3)	= src_tag;
+	lbl_fill(thread_ctx->vcpu.gpr[dst], tag_ldlbl(src), 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and a 16-bit register as t[dst] = t[src]
- *
- * NOTE: special case for MOVSX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
+/* t[dst] = t[src]; 32-bit MOVSX (16-bit memory) */
 static void PIN_FAST_ANALYSIS_CALL
 _movsx_m2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint16_t src_tag =  *((uint16_t *)(src + STAB[VIRT2STAB(src)]));
-
-	/* update the destination (xfer) */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
-	*(((uint16_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
+	tag_ldlbln(src, thread_ctx->vcpu.gpr[dst], 2);
+	lbl_xfer(&thread_ctx->vcpu.gpr[dst][2], thread_ctx->vcpu.gpr[dst], 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 16-bit 
- * register and an 8-bit register as t[dst] = t[upper(src)]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
+/* t[dst] = t[upper(src)]; 16-bit MOVZX */
 static void PIN_FAST_ANALYSIS_CALL
 _movzx_r2r_opwb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint8_t src_tag = *(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
-
-	/* update the destination (xfer) */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	thread_ctx->vcpu.gpr[dst][0] = thread_ctx->vcpu.gpr[src][1];
+	thread_ctx->vcpu.gpr[dst][1] = TAG_ZERO;
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 16-bit 
- * register and an 8-bit register as t[dst] = t[lower(src)]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
+/* t[dst] = t[lower(src)]; 16-bit MOVZX */
 static void PIN_FAST_ANALYSIS_CALL
 _movzx_r2r_opwb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint8_t src_tag = *((uint8_t *)&thread_ctx->vcpu.gpr[src]);
-
-	/* update the destination (xfer) */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	thread_ctx->vcpu.gpr[dst][0] = thread_ctx->vcpu.gpr[src][0];
+	thread_ctx->vcpu.gpr[dst][1] = TAG_ZERO;
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and an upper 8-bit register as t[dst] = t[upper(src)]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
+/* t[dst] = t[upper(src)]; 32-bit MOVZX */
 static void PIN_FAST_ANALYSIS_CALL
 _movzx_r2r_oplb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint8_t src_tag = *(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
-
-	/* update the destination (xfer) */
-	*((uint32_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	thread_ctx->vcpu.gpr[dst][0] = thread_ctx->vcpu.gpr[src][1];
+	lbl_fill(&thread_ctx->vcpu.gpr[dst][1], TAG_ZERO, 3);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and a lower 8-bit register as t[dst] = t[lower(src)]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
+/* t[dst] = t[lower(src)]; 32-bit MOVZX */
 static void PIN_FAST_ANALYSIS_CALL
 _movzx_r2r_oplb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint8_t src_tag = *((uint8_t *)&thread_ctx->vcpu.gpr[src]);
-
-	/* update the destination (xfer) */
-	*((uint32_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	thread_ctx->vcpu.gpr[dst][0] = thread_ctx->vcpu.gpr[src][0];
+	lbl_fill(&thread_ctx->vcpu.gpr[dst][1], TAG_ZERO, 3);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and a 16-bit register as t[dst] = t[src]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
+/* t[dst] = t[src]; 32-bit MOVZX (16-bit src) */
 static void PIN_FAST_ANALYSIS_CALL
 _movzx_r2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint16_t src_tag = *((uint16_t *)&thread_ctx->vcpu.gpr[src]);
-
-	/* update the destination (xfer) */
-	*((uint32_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	lbl_xfer(thread_ctx->vcpu.gpr[dst], thread_ctx->vcpu.gpr[src], 2);
+	lbl_fill(&thread_ctx->vcpu.gpr[dst][2], TAG_ZERO, 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 16-bit 
- * register and an 8-bit memory location as
- * t[dst] = t[src]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
+/* t[dst] = t[src]; 16-bit MOVZX (8-bit memory) */
 static void PIN_FAST_ANALYSIS_CALL
 _movzx_m2r_opwb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	/* temporary tag value */
-	uint8_t src_tag = *((uint8_t *)(src + STAB[VIRT2STAB(src)]));
-
-	/* update the destination (xfer) */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	thread_ctx->vcpu.gpr[dst][0] = tag_ldlbl(src);
+	thread_ctx->vcpu.gpr[dst][1] = TAG_ZERO;
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit 
- * register and an 8-bit memory location as
- * t[dst] = t[src]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
+/* t[dst] = t[src]; 32-bit MOVZX (8-bit memory) */
 static void PIN_FAST_ANALYSIS_CALL
 _movzx_m2r_oplb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	/* temporary tag value */
-	uint8_t src_tag = *((uint8_t *)(src + STAB[VIRT2STAB(src)]));
-
-	/* update the destination (xfer) */
-	*((uint32_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	thread_ctx->vcpu.gpr[dst][0] = tag_ldlbl(src);
+	lbl_fill(&thread_ctx->vcpu.gpr[dst][1], TAG_ZERO, 3);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate and extend tag between a 32-bit register
- * and a 16-bit register as t[dst] = t[src]
- *
- * NOTE: special case for MOVZX instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
+/* t[dst] = t[src]; 32-bit MOVZX (16-bit memory) */
 static void PIN_FAST_ANALYSIS_CALL
 _movzx_m2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint16_t src_tag =  *((uint16_t *)(src + STAB[VIRT2STAB(src)]));
-
-	/* update the destination (xfer) */
-	*((uint32_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	tag_ldlbln(src, thread_ctx->vcpu.gpr[dst], 2);
+	lbl_fill(&thread_ctx->vcpu.gpr[dst][2], TAG_ZERO, 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 32-bit
- * registers as t[EAX] = t[src]; return
- * the result of EAX == src and also
- * store the original tag value of
- * EAX in the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst_val:	EAX register value
- * @src:	source register index (VCPU)
- * @src_val:	source register value
- */
+/* t[scratch] = t[EAX]; t[EAX] = t[src]; 32-bit CMPXCHG */
 static ADDRINT PIN_FAST_ANALYSIS_CALL
 _cmpxchg_r2r_opl_fast(thread_ctx_t *thread_ctx, uint32_t dst_val, uint32_t src,
 							uint32_t src_val)
 {
-	/* save the tag value of dst in the scratch register */
-	thread_ctx->vcpu.gpr[8] = 
-		thread_ctx->vcpu.gpr[7];
-	
-	/* update */
-	thread_ctx->vcpu.gpr[7] =
-		thread_ctx->vcpu.gpr[src];
+	lbl_xfer(thread_ctx->vcpu.gpr[GPR_SCRATCH], thread_ctx->vcpu.gpr[7], 4);
+	lbl_xfer(thread_ctx->vcpu.gpr[7], thread_ctx->vcpu.gpr[src], 4);
 
 	/* compare the dst and src values */
 	return (dst_val == src_val);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 32-bit 
- * registers as t[dst] = t[src]; restore the
- * value of EAX from the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
+/* t[EAX] = t[scratch]; t[dst] = t[src]; 32-bit CMPXCHG */
 static void PIN_FAST_ANALYSIS_CALL
 _cmpxchg_r2r_opl_slow(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* restore the tag value from the scratch register */
-	thread_ctx->vcpu.gpr[7] = 
-		thread_ctx->vcpu.gpr[8];
-	
-	/* update */
-	thread_ctx->vcpu.gpr[dst] =
-		thread_ctx->vcpu.gpr[src];
+	lbl_xfer(thread_ctx->vcpu.gpr[7], thread_ctx->vcpu.gpr[GPR_SCRATCH], 4);
+	lbl_xfer(thread_ctx->vcpu.gpr[dst], thread_ctx->vcpu.gpr[src], 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 16-bit
- * registers as t[AX] = t[src]; return
- * the result of AX == src and also
- * store the original tag value of
- * AX in the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst_val:	AX register value
- * @src:	source register index (VCPU)
- * @src_val:	source register value
- */
+/* t[scratch] = t[EAX]; t[AX] = t[src]; 16-bit CMPXCHG */
 static ADDRINT PIN_FAST_ANALYSIS_CALL
 _cmpxchg_r2r_opw_fast(thread_ctx_t *thread_ctx, uint16_t dst_val, uint32_t src,
 						uint16_t src_val)
 {
-	/* save the tag value of dst in the scratch register */
-	thread_ctx->vcpu.gpr[8] = 
-		thread_ctx->vcpu.gpr[7];
-	
-	/* update */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[7]) =
-		*((uint16_t *)&thread_ctx->vcpu.gpr[src]);
+	lbl_xfer(thread_ctx->vcpu.gpr[GPR_SCRATCH], thread_ctx->vcpu.gpr[7], 4);
+	lbl_xfer(thread_ctx->vcpu.gpr[7], thread_ctx->vcpu.gpr[src], 2);
 
 	/* compare the dst and src values */
 	return (dst_val == src_val);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 16-bit 
- * registers as t[dst] = t[src]; restore the
- * value of AX from the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
+/* t[EAX] = t[scratch]; t[dst] = t[src]; 16-bit CMPXCHG */
 static void PIN_FAST_ANALYSIS_CALL
 _cmpxchg_r2r_opw_slow(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* restore the tag value from the scratch register */
-	thread_ctx->vcpu.gpr[7] = 
-		thread_ctx->vcpu.gpr[8];
-	
-	/* update */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[dst]) =
-		*((uint16_t *)&thread_ctx->vcpu.gpr[src]);
+	lbl_xfer(thread_ctx->vcpu.gpr[7], thread_ctx->vcpu.gpr[GPR_SCRATCH], 4);
+	lbl_xfer(thread_ctx->vcpu.gpr[dst], thread_ctx->vcpu.gpr[src], 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit
- * register and a memory location
- * as t[EAX] = t[src]; return the result
- * of EAX == src and also store the
- * original tag value of EAX in
- * the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst_val:	destination register value
- * @src:	source memory address
- */
+/* t[scratch] = t[EAX]; t[EAX] = t[src]; 32-bit CMPXCHG (memory) */
 static ADDRINT PIN_FAST_ANALYSIS_CALL
 _cmpxchg_m2r_opl_fast(thread_ctx_t *thread_ctx, uint32_t dst_val, ADDRINT src)
 {
-	/* save the tag value of dst in the scratch register */
-	thread_ctx->vcpu.gpr[8] = 
-		thread_ctx->vcpu.gpr[7];
-	
-	/* update */
-	thread_ctx->vcpu.gpr[7] = 
-		*((uint32_t *)(src + STAB[VIRT2STAB(src)]));
-	
-	/* compare the dst and src values; the original values the tag bits */
+	lbl_xfer(thread_ctx->vcpu.gpr[GPR_SCRATCH], thread_ctx->vcpu.gpr[7], 4);
+	tag_ldlbln(src, thread_ctx->vcpu.gpr[7], 4);
+
+	/* compare the dst and src values */
 	return (dst_val == *(uint32_t *)src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit 
- * register and a memory location
- * as t[dst] = t[src]; restore the value
- * of EAX from the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
+/* t[EAX] = t[scratch]; t[dst] = t[src]; 32-bit CMPXCHG (memory) */
 static void PIN_FAST_ANALYSIS_CALL
 _cmpxchg_r2m_opl_slow(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	/* restore the tag value from the scratch register */
-	thread_ctx->vcpu.gpr[7] = 
-		thread_ctx->vcpu.gpr[8];
-	
-	/* update */
-	*((uint32_t *)(dst + STAB[VIRT2STAB(dst)])) =
-		thread_ctx->vcpu.gpr[src];
+	lbl_xfer(thread_ctx->vcpu.gpr[7], thread_ctx->vcpu.gpr[GPR_SCRATCH], 4);
+	tag_stlbln(dst, thread_ctx->vcpu.gpr[src], 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 16-bit
- * register and a memory location
- * as t[AX] = t[src]; return the result
- * of AX == src and also store the
- * original tag value of AX in
- * the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @dst_val:	destination register value
- * @src:	source memory address
- */
+/* t[scratch] = t[EAX]; t[AX] = t[src]; 16-bit CMPXCHG (memory) */
 static ADDRINT PIN_FAST_ANALYSIS_CALL
 _cmpxchg_m2r_opw_fast(thread_ctx_t *thread_ctx, uint16_t dst_val, ADDRINT src)
 {
-	/* save the tag value of dst in the scratch register */
-	thread_ctx->vcpu.gpr[8] = 
-		thread_ctx->vcpu.gpr[7];
-	
-	/* update */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[7]) = 
-		*((uint16_t *)(src + STAB[VIRT2STAB(src)]));
-	
-	/* compare the dst and src values; the original values the tag bits */
+	lbl_xfer(thread_ctx->vcpu.gpr[GPR_SCRATCH], thread_ctx->vcpu.gpr[7], 4);
+	tag_ldlbln(src, thread_ctx->vcpu.gpr[7], 2);
+
+	/* compare the dst and src values */
 	return (dst_val == *(uint16_t *)src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 16-bit 
- * register and a memory location
- * as t[dst] = t[src]; restore the value
- * of AX from the scratch register
- *
- * NOTE: special case for the CMPXCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- * @res:	restore register index (VCPU)
- */
+/* t[EAX] = t[scratch]; t[dst] = t[src]; 16-bit CMPXCHG (memory) */
 static void PIN_FAST_ANALYSIS_CALL
 _cmpxchg_r2m_opw_slow(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	/* restore the tag value from the scratch register */
-	thread_ctx->vcpu.gpr[7] = 
-		thread_ctx->vcpu.gpr[8];
-	
-	/* update */
-	*((uint16_t *)(dst + STAB[VIRT2STAB(dst)])) =
-		*((uint16_t *)&thread_ctx->vcpu.gpr[src]);
+	lbl_xfer(thread_ctx->vcpu.gpr[7], thread_ctx->vcpu.gpr[GPR_SCRATCH], 4);
+	tag_stlbln(dst, thread_ctx->vcpu.gpr[src], 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit 
- * register and a memory location as
- * t[dst] = t[src] and t[src] = t[dst] 
- * (src is a register)
- *
- * NOTE: special case for the XCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
+/* t[dst] = t[src] and t[src] = t[dst]; XCHG */
 static void PIN_FAST_ANALYSIS_CALL
 _xchg_r2m_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint32_t tmp_tag = *((uint32_t *)(dst + STAB[VIRT2STAB(dst)]));
+	/* temporary labels */
+	uint32_t tmp_tag[4];
 
-	/* swap */
-	*((uint32_t *)(dst + STAB[VIRT2STAB(dst)])) =
-		thread_ctx->vcpu.gpr[src];
-		
-	thread_ctx->vcpu.gpr[src] = tmp_tag;
+	tag_ldlbln(dst, tmp_tag, 4);
+	tag_stlbln(dst, thread_ctx->vcpu.gpr[src], 4);
+	lbl_xfer(thread_ctx->vcpu.gpr[src], tmp_tag, 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 16-bit 
- * register and a memory location as
- * t[dst] = t[src] and t[src] = t[dst]
- * (src is a register)
- *
- * NOTE: special case for the XCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 _xchg_r2m_opw(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint16_t tmp_tag = *((uint16_t *)(dst + STAB[VIRT2STAB(dst)]));
+	/* temporary labels */
+	uint32_t tmp_tag[2];
 
-	/* swap */
-	*((uint16_t *)(dst + STAB[VIRT2STAB(dst)])) =
-		*((uint16_t *)&thread_ctx->vcpu.gpr[src]);
-		
-	*((uint16_t *)&thread_ctx->vcpu.gpr[src]) = tmp_tag;
+	tag_ldlbln(dst, tmp_tag, 2);
+	tag_stlbln(dst, thread_ctx->vcpu.gpr[src], 2);
+	lbl_xfer(thread_ctx->vcpu.gpr[src], tmp_tag, 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[dst] = t[upper(src)] and t[upper(src)] = t[dst]
- * (src is a register)
- *
- * NOTE: special case for the XCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 _xchg_r2m_opb_u(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint8_t tmp_tag = *((uint8_t *)(dst + STAB[VIRT2STAB(dst)]));
+	/* temporary label */
+	uint32_t tmp_tag = tag_ldlbl(dst);
 
-	/* swap */
-	*((uint8_t *)(dst + STAB[VIRT2STAB(dst)])) =
-		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
-	
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1) = tmp_tag;
+	tag_stlbl(dst, thread_ctx->vcpu.gpr[src][1]);
+	thread_ctx->vcpu.gpr[src][1] = tmp_tag;
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[dst] = t[lower(src)] and t[lower(src)] = t[dst]
- * (src is a register)
- *
- * NOTE: special case for the XCHG instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 _xchg_r2m_opb_l(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint8_t tmp_tag = *((uint8_t *)(dst + STAB[VIRT2STAB(dst)]));
-	
-	/* swap */
-	*((uint8_t *)(dst + STAB[VIRT2STAB(dst)])) =
-		*((uint8_t *)&thread_ctx->vcpu.gpr[src]);
-	
-	*((uint8_t *)&thread_ctx->vcpu.gpr[src]) = tmp_tag;
+	/* temporary label */
+	uint32_t tmp_tag = tag_ldlbl(dst);
+
+	tag_stlbl(dst, thread_ctx->vcpu.gpr[src][0]);
+	thread_ctx->vcpu.gpr[src][0] = tmp_tag;
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit 
- * register and a memory location as
- * t[dst] |= t[src] and t[src] = t[dst] 
- * (src is a register)
- *
- * NOTE: special case for the XADD instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
+/* t[dst] |= t[src] and t[src] = t[dst]; XADD */
 static void PIN_FAST_ANALYSIS_CALL
 _xadd_r2m_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint32_t tmp_tag = *((uint32_t *)(dst + STAB[VIRT2STAB(dst)]));
+	/* temporary labels */
+	uint32_t tmp_tag[4];
 
-	/* swap */
-	*((uint32_t *)(dst + STAB[VIRT2STAB(dst)])) |=
-		thread_ctx->vcpu.gpr[src];
-		
-	thread_ctx->vcpu.gpr[src] = tmp_tag;
+	tag_ldlbln(dst, tmp_tag, 4);
+	tag_orlbln(dst, thread_ctx->vcpu.gpr[src], 4);
+	lbl_xfer(thread_ctx->vcpu.gpr[src], tmp_tag, 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 16-bit 
- * register and a memory location as
- * t[dst] |= t[src] and t[src] = t[dst]
- * (src is a register)
- *
- * NOTE: special case for the XADD instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 _xadd_r2m_opw(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint16_t tmp_tag = *((uint16_t *)(dst + STAB[VIRT2STAB(dst)]));
+	/* temporary labels */
+	uint32_t tmp_tag[2];
 
-	/* swap */
-	*((uint16_t *)(dst + STAB[VIRT2STAB(dst)])) |=
-		*((uint16_t *)&thread_ctx->vcpu.gpr[src]);
-		
-	*((uint16_t *)&thread_ctx->vcpu.gpr[src]) = tmp_tag;
+	tag_ldlbln(dst, tmp_tag, 2);
+	tag_orlbln(dst, thread_ctx->vcpu.gpr[src], 2);
+	lbl_xfer(thread_ctx->vcpu.gpr[src], tmp_tag, 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[dst] |= t[upper(src)] and t[upper(src)] = t[dst]
- * (src is a register)
- *
- * NOTE: special case for the XADD instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 _xadd_r2m_opb_u(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint8_t tmp_tag = *((uint8_t *)(dst + STAB[VIRT2STAB(dst)]));
+	/* temporary label */
+	uint32_t tmp_tag = tag_ldlbl(dst);
 
-	/* swap */
-	*((uint8_t *)(dst + STAB[VIRT2STAB(dst)])) |=
-		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
-	
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1) = tmp_tag;
+	tag_orlbln(dst, &thread_ctx->vcpu.gpr[src][1], 1);
+	thread_ctx->vcpu.gpr[src][1] = tmp_tag;
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[dst] |= t[lower(src)] and t[lower(src)] = t[dst]
- * (src is a register)
- *
- * NOTE: special case for the XADD instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 _xadd_r2m_opb_l(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	/* temporary tag value */
-	uint8_t tmp_tag = *((uint8_t *)(dst + STAB[VIRT2STAB(dst)]));
-	
-	/* swap */
-	*((uint8_t *)(dst + STAB[VIRT2STAB(dst)])) |=
-		*((uint8_t *)&thread_ctx->vcpu.gpr[src]);
-	
-	*((uint8_t *)&thread_ctx->vcpu.gpr[src]) = tmp_tag;
+	/* temporary label */
+	uint32_t tmp_tag = tag_ldlbl(dst);
+
+	tag_orlbln(dst, thread_ctx->vcpu.gpr[src], 1);
+	thread_ctx->vcpu.gpr[src][0] = tmp_tag;
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between three 16-bit 
- * registers as t[dst] = t[base] | t[index]
- *
- * NOTE: special case for the LEA instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register
- * @base:	base register
- * @index:	index register
- */
+/* t[dst] = t[base] | t[index]; LEA */
 static void PIN_FAST_ANALYSIS_CALL
 _lea_r2r_opw(thread_ctx_t *thread_ctx,
 		uint32_t dst,
 		uint32_t base,
 		uint32_t index)
 {
-	/* update the destination */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[dst]) =
-		*((uint16_t *)&thread_ctx->vcpu.gpr[base]) |
-		*((uint16_t *)&thread_ctx->vcpu.gpr[index]); 
+	/* temporary labels; base (or index) may be dst */
+	uint32_t tmp_tag[2];
+
+	lbl_xfer(tmp_tag, thread_ctx->vcpu.gpr[base], 2);
+	lbl_or(tmp_tag, thread_ctx->vcpu.gpr[index], 2);
+	lbl_xfer(thread_ctx->vcpu.gpr[dst], tmp_tag, 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between three 32-bit 
- * registers as t[dst] = t[base] | t[index]
- *
- * NOTE: special case for the LEA instruction
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register
- * @base:	base register
- * @index:	index register
- */
 static void PIN_FAST_ANALYSIS_CALL
 _lea_r2r_opl(thread_ctx_t *thread_ctx,
 		uint32_t dst,
 		uint32_t base,
 		uint32_t index)
 {
-	/* update the destination */
-	thread_ctx->vcpu.gpr[dst] =
-		thread_ctx->vcpu.gpr[base] | thread_ctx->vcpu.gpr[index]; 
+	/* temporary labels; base (or index) may be dst */
+	uint32_t tmp_tag[4];
+
+	lbl_xfer(tmp_tag, thread_ctx->vcpu.gpr[base], 4);
+	lbl_or(tmp_tag, thread_ctx->vcpu.gpr[index], 4);
+	lbl_xfer(thread_ctx->vcpu.gpr[dst], tmp_tag, 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag among three 8-bit registers as t[dst] |= t[upper(src)];
- * dst is AX, whereas src is an upper 8-bit register (e.g., CH, BH, ...)
- *
- * NOTE: special case for DIV and IDIV instructions
- *
- * @thread_ctx:	the thread context
- * @src:	source register index (VCPU)
- */
+/* t[AX] |= t[upper(src)]; DIV and IDIV */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_ternary_opb_u(thread_ctx_t *thread_ctx, uint32_t src)
 {
-	/* temporary tag value */
-	uint8_t tmp_tag = *(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
-	
-	/* update the destination (ternary) */
-	*((uint8_t *)&thread_ctx->vcpu.gpr[7])		|= tmp_tag;
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[7]) + 1)	|= tmp_tag;
+	lbl_orfill(thread_ctx->vcpu.gpr[7], thread_ctx->vcpu.gpr[src][1], 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag among three 8-bit registers as t[dst] |= t[lower(src)];
- * dst is AX, whereas src is a lower 8-bit register (e.g., CL, BL, ...)
- *
- * NOTE: special case for DIV and IDIV instructions
- *
- * @thread_ctx:	the thread context
- * @src:	source register index (VCPU)
- */
+/* t[AX] |= t[lower(src)]; DIV and IDIV */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_ternary_opb_l(thread_ctx_t *thread_ctx, uint32_t src)
 {
-	/* temporary tag value */
-	uint8_t tmp_tag = *((uint8_t *)&thread_ctx->vcpu.gpr[src]);
-	
-	/* update the destination (ternary) */
-	*((uint8_t *)&thread_ctx->vcpu.gpr[7])		|= tmp_tag;
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[7]) + 1)	|= tmp_tag;
+	lbl_orfill(thread_ctx->vcpu.gpr[7], thread_ctx->vcpu.gpr[src][0], 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between among three 16-bit 
- * registers as t[dst1] |= t[src] and t[dst2] |= t[src];
- * dst1 is DX, dst2 is AX, and src is a 16-bit register 
- * (e.g., CX, BX, ...)
- *
- * NOTE: special case for DIV and IDIV instructions
- *
- * @thread_ctx:	the thread context
- * @src:	source register index (VCPU)
- */
+/* t[DX] |= t[src] and t[AX] |= t[src]; DIV and IDIV */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_ternary_opw(thread_ctx_t *thread_ctx, uint32_t src)
 {
-	/* temporary tag value */
-	uint16_t tmp_tag = *((uint16_t *)&thread_ctx->vcpu.gpr[src]);
+	/* temporary labels; src may be DX */
+	uint32_t tmp_tag[2];
 
-	/* update the destination (ternary) */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[5])	|= tmp_tag;
-	*((uint16_t *)&thread_ctx->vcpu.gpr[7])	|= tmp_tag;
+	lbl_xfer(tmp_tag, thread_ctx->vcpu.gpr[src], 2);
+	lbl_or(thread_ctx->vcpu.gpr[5], tmp_tag, 2);
+	lbl_or(thread_ctx->vcpu.gpr[7], tmp_tag, 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between among three 32-bit 
- * registers as t[dst1] |= t[src] and t[dst2] |= t[src];
- * dst1 is EDX, dst2 is EAX, and src is a 32-bit register
- * (e.g., ECX, EBX, ...)
- *
- * NOTE: special case for DIV and IDIV instructions
- *
- * @thread_ctx:	the thread context
- * @src:	source register index (VCPU)
- */
+/* t[EDX] |= t[src] and t[EAX] |= t[src]; DIV and IDIV */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_ternary_opl(thread_ctx_t *thread_ctx, uint32_t src)
-{ 
-	/* temporary tag value */
-	uint32_t tmp_tag = thread_ctx->vcpu.gpr[src];
+{
+	/* temporary labels; src may be EDX */
+	uint32_t tmp_tag[4];
 
-	/* update the destinations */
-	thread_ctx->vcpu.gpr[5] |= tmp_tag;
-	thread_ctx->vcpu.gpr[7] |= tmp_tag; 
+	lbl_xfer(tmp_tag, thread_ctx->vcpu.gpr[src], 4);
+	lbl_or(thread_ctx->vcpu.gpr[5], tmp_tag, 4);
+	lbl_or(thread_ctx->vcpu.gpr[7], tmp_tag, 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag among two 8-bit registers
- * and an 8-bit memory location as t[dst] |= t[src];
- * dst is AX, whereas src is an 8-bit memory location
- *
- * NOTE: special case for DIV and IDIV instructions
- *
- * @thread_ctx:	the thread context
- * @src:	source memory address
- */
+/* t[AX] |= t[src]; DIV and IDIV (memory) */
 static void PIN_FAST_ANALYSIS_CALL
 m2r_ternary_opb(thread_ctx_t *thread_ctx, ADDRINT src)
 {
-	/* temporary tag value */
-	uint8_t tmp_tag = *((uint8_t *)(src + STAB[VIRT2STAB(src)]));
-	
-	/* update the destination (ternary) */
-	*((uint8_t *)&thread_ctx->vcpu.gpr[7])		|= tmp_tag;
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[7]) + 1)	|= tmp_tag;
+	lbl_orfill(thread_ctx->vcpu.gpr[7], tag_ldlbl(src), 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag among two 16-bit registers
- * and a 16-bit memory address as
- * t[dst1] |= t[src] and t[dst1] |= t[src];
- *
- * dst1 is DX, dst2 is AX, and src is a 16-bit
- * memory location
- *
- * NOTE: special case for DIV and IDIV instructions
- *
- * @thread_ctx:	the thread context
- * @src:	source memory address
- */
+/* t[DX] |= t[src] and t[AX] |= t[src]; DIV and IDIV (memory) */
 static void PIN_FAST_ANALYSIS_CALL
 m2r_ternary_opw(thread_ctx_t *thread_ctx, ADDRINT src)
 {
-	/* temporary tag value */
-	uint16_t tmp_tag = *((uint16_t *)(src + STAB[VIRT2STAB(src)]));
-	
-	/* update the destination (ternary) */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[5])	|= tmp_tag;
-	*((uint16_t *)&thread_ctx->vcpu.gpr[7])	|= tmp_tag;
+	/* temporary labels */
+	uint32_t tmp_tag[2];
+
+	tag_ldlbln(src, tmp_tag, 2);
+	lbl_or(thread_ctx->vcpu.gpr[5], tmp_tag, 2);
+	lbl_or(thread_ctx->vcpu.gpr[7], tmp_tag, 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag among two 32-bit 
- * registers and a 32-bit memory as
- * t[dst1] |= t[src] and t[dst2] |= t[src];
- * dst1 is EDX, dst2 is EAX, and src is a 32-bit
- * memory location
- *
- * NOTE: special case for DIV and IDIV instructions
- *
- * @thread_ctx:	the thread context
- * @src:	source memory address
- */
+/* t[EDX] |= t[src] and t[EAX] |= t[src]; DIV and IDIV (memory) */
 static void PIN_FAST_ANALYSIS_CALL
 m2r_ternary_opl(thread_ctx_t *thread_ctx, ADDRINT src)
 {
-	/* temporary tag value */
-	uint32_t tmp_tag = *((uint32_t *)(src + STAB[VIRT2STAB(src)]));
-	
-	/* update the destinations */
-	thread_ctx->vcpu.gpr[5] |= tmp_tag;
-	thread_ctx->vcpu.gpr[7] |= tmp_tag;
+	/* temporary labels */
+	uint32_t tmp_tag[4];
+
+	tag_ldlbln(src, tmp_tag, 4);
+	lbl_or(thread_ctx->vcpu.gpr[5], tmp_tag, 4);
+	lbl_or(thread_ctx->vcpu.gpr[7], tmp_tag, 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[upper(dst)] |= t[lower(src)];
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
+/* t[dst] |= t[src] (binary); registers */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_binary_opb_ul(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1) |=
-		*((uint8_t *)&thread_ctx->vcpu.gpr[src]);
+	lbl_or(&thread_ctx->vcpu.gpr[dst][1], thread_ctx->vcpu.gpr[src], 1);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[lower(dst)] |= t[upper(src)];
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_binary_opb_lu(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	*((uint8_t *)&thread_ctx->vcpu.gpr[dst]) |=
-		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
+	lbl_or(thread_ctx->vcpu.gpr[dst], &thread_ctx->vcpu.gpr[src][1], 1);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[upper(dst)] |= t[upper(src)]
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_binary_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1) |=
-		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
+	lbl_or(&thread_ctx->vcpu.gpr[dst][1], &thread_ctx->vcpu.gpr[src][1], 1);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[lower(dst)] |= t[lower(src)]
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_binary_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	*((uint8_t *)&thread_ctx->vcpu.gpr[dst]) |=
-		*((uint8_t *)&thread_ctx->vcpu.gpr[src]);
+	lbl_or(thread_ctx->vcpu.gpr[dst], thread_ctx->vcpu.gpr[src], 1);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 16-bit registers
- * as t[dst] |= t[src]
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_binary_opw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	*((uint16_t *)&thread_ctx->vcpu.gpr[dst]) |=
-		*((uint16_t *)&thread_ctx->vcpu.gpr[src]);
+	lbl_or(thread_ctx->vcpu.gpr[dst], thread_ctx->vcpu.gpr[src], 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 32-bit 
- * registers as t[dst] |= t[src]
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_binary_opl(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	thread_ctx->vcpu.gpr[dst] |= thread_ctx->vcpu.gpr[src];
+	lbl_or(thread_ctx->vcpu.gpr[dst], thread_ctx->vcpu.gpr[src], 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[upper(dst)] |= t[src] (dst is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
+/* t[dst] |= t[src] (binary); dst is a register */
 static void PIN_FAST_ANALYSIS_CALL
 m2r_binary_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1) |=
-		*((uint8_t *)(src + STAB[VIRT2STAB(src)]));
+	lbl_orfill(&thread_ctx->vcpu.gpr[dst][1], tag_ldlbl(src), 1);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[lower(dst)] |= t[src] (dst is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
 static void PIN_FAST_ANALYSIS_CALL
 m2r_binary_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	*((uint8_t *)&thread_ctx->vcpu.gpr[dst]) |=
-		*((uint8_t *)(src + STAB[VIRT2STAB(src)]));
+	lbl_orfill(thread_ctx->vcpu.gpr[dst], tag_ldlbl(src), 1);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 16-bit 
- * register and a memory location as
- * t[dst] |= t[src] (dst is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
 static void PIN_FAST_ANALYSIS_CALL
 m2r_binary_opw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	*((uint16_t *)&thread_ctx->vcpu.gpr[dst]) |=
-		*((uint16_t *)(src + STAB[VIRT2STAB(src)]));
+	/* temporary labels */
+	uint32_t tmp_tag[2];
+
+	tag_ldlbln(src, tmp_tag, 2);
+	lbl_or(thread_ctx->vcpu.gpr[dst], tmp_tag, 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit 
- * register and a memory location as
- * t[dst] |= t[src] (dst is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
 static void PIN_FAST_ANALYSIS_CALL
 m2r_binary_opl(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	thread_ctx->vcpu.gpr[dst] |=
-		*((uint32_t *)(src + STAB[VIRT2STAB(src)]));
+	/* temporary labels */
+	uint32_t tmp_tag[4];
+
+	tag_ldlbln(src, tmp_tag, 4);
+	lbl_or(thread_ctx->vcpu.gpr[dst], tmp_tag, 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[dst] |= t[upper(src)] (src is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
+/* t[dst] |= t[src] (binary); src is a register */
 static void PIN_FAST_ANALYSIS_CALL
 r2m_binary_opb_u(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	*((uint8_t *)(dst + STAB[VIRT2STAB(dst)])) |= 
-		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
+	tag_orlbln(dst, &thread_ctx->vcpu.gpr[src][1], 1);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[dst] |= t[lower(src)] (src is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 r2m_binary_opb_l(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	*((uint8_t *)(dst + STAB[VIRT2STAB(dst)])) |= 
-		*((uint8_t *)&thread_ctx->vcpu.gpr[src]);
+	tag_orlbln(dst, thread_ctx->vcpu.gpr[src], 1);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 16-bit 
- * register and a memory location as
- * t[dst] |= t[src] (src is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 r2m_binary_opw(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	*((uint16_t *)(dst + STAB[VIRT2STAB(dst)])) |= 
-		*((uint16_t *)&thread_ctx->vcpu.gpr[src]);
+	tag_orlbln(dst, thread_ctx->vcpu.gpr[src], 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit 
- * register and a memory location as
- * t[dst] |= t[src] (src is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 r2m_binary_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	*((uint32_t *)(dst + STAB[VIRT2STAB(dst)])) |=
-		thread_ctx->vcpu.gpr[src];
+	tag_orlbln(dst, thread_ctx->vcpu.gpr[src], 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * clear the tag of EAX, EBX, ECX, EDX
- *
- * @thread_ctx:	the thread context
- * @reg:	register index (VCPU) 
- */
+/* clear the labels of EAX, EBX, ECX, EDX */
 static void PIN_FAST_ANALYSIS_CALL
 r_clrl4(thread_ctx_t *thread_ctx)
 {
-	thread_ctx->vcpu.gpr[4] = TAG_ZERO;
-	thread_ctx->vcpu.gpr[5] = TAG_ZERO;
-	thread_ctx->vcpu.gpr[6] = TAG_ZERO;
-	thread_ctx->vcpu.gpr[7] = TAG_ZERO;
+	lbl_fill(thread_ctx->vcpu.gpr[4], TAG_ZERO, 4);
+	lbl_fill(thread_ctx->vcpu.gpr[5], TAG_ZERO, 4);
+	lbl_fill(thread_ctx->vcpu.gpr[6], TAG_ZERO, 4);
+	lbl_fill(thread_ctx->vcpu.gpr[7], TAG_ZERO, 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * clear the tag of EAX, EDX
- *
- * @thread_ctx:	the thread context
- * @reg:	register index (VCPU) 
- */
+/* clear the labels of EAX, EDX */
 static void PIN_FAST_ANALYSIS_CALL
 r_clrl2(thread_ctx_t *thread_ctx)
 {
-	thread_ctx->vcpu.gpr[5] = TAG_ZERO;
-	thread_ctx->vcpu.gpr[7] = TAG_ZERO;
+	lbl_fill(thread_ctx->vcpu.gpr[5], TAG_ZERO, 4);
+	lbl_fill(thread_ctx->vcpu.gpr[7], TAG_ZERO, 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * clear the tag of a 32-bit register
- *
- * @thread_ctx:	the thread context
- * @reg:	register index (VCPU) 
- */
+/* clear the labels of a register */
 static void PIN_FAST_ANALYSIS_CALL
 r_clrl(thread_ctx_t *thread_ctx, uint32_t reg)
 {
-	thread_ctx->vcpu.gpr[reg] = TAG_ZERO;
+	lbl_fill(thread_ctx->vcpu.gpr[reg], TAG_ZERO, 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * clear the tag of a 16-bit register
- *
- * @thread_ctx:	the thread context
- * @reg:	register index (VCPU) 
- */
 static void PIN_FAST_ANALYSIS_CALL
 r_clrw(thread_ctx_t *thread_ctx, uint32_t reg)
 {
-	*((uint16_t *)&thread_ctx->vcpu.gpr[reg]) = TAG_ZERO;
+	lbl_fill(thread_ctx->vcpu.gpr[reg], TAG_ZERO, 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * clear the tag of an upper 8-bit register
- *
- * @thread_ctx:	the thread context
- * @reg:	register index (VCPU) 
- */
 static void PIN_FAST_ANALYSIS_CALL
 r_clrb_u(thread_ctx_t *thread_ctx, uint32_t reg)
 {
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[reg]) + 1) = TAG_ZERO;
+	thread_ctx->vcpu.gpr[reg][1] = TAG_ZERO;
 }
 
-/*
- * tag propagation (analysis function)
- *
- * clear the tag of a lower 8-bit register
- *
- * @thread_ctx:	the thread context
- * @reg:	register index (VCPU) 
- */
 static void PIN_FAST_ANALYSIS_CALL
 r_clrb_l(thread_ctx_t *thread_ctx, uint32_t reg)
 {
-	*((uint8_t *)&thread_ctx->vcpu.gpr[reg]) = TAG_ZERO;
+	thread_ctx->vcpu.gpr[reg][0] = TAG_ZERO;
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[upper(dst)] = t[lower(src)]
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
+/* t[dst] = t[src]; registers */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_xfer_opb_ul(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1) =
-		*((uint8_t *)&thread_ctx->vcpu.gpr[src]);
+	thread_ctx->vcpu.gpr[dst][1] = thread_ctx->vcpu.gpr[src][0];
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[lower(dst)] = t[upper(src)];
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_xfer_opb_lu(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	*((uint8_t *)&thread_ctx->vcpu.gpr[dst]) =
-		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
+	thread_ctx->vcpu.gpr[dst][0] = thread_ctx->vcpu.gpr[src][1];
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[upper(dst)] = t[upper(src)]
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_xfer_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1) =
-		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
+	thread_ctx->vcpu.gpr[dst][1] = thread_ctx->vcpu.gpr[src][1];
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * registers as t[lower(dst)] = t[lower(src)]
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_xfer_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	*((uint8_t *)&thread_ctx->vcpu.gpr[dst]) =
-		*((uint8_t *)&thread_ctx->vcpu.gpr[src]);
+	thread_ctx->vcpu.gpr[dst][0] = thread_ctx->vcpu.gpr[src][0];
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 16-bit 
- * registers as t[dst] = t[src]
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_xfer_opw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	*((uint16_t *)&thread_ctx->vcpu.gpr[dst]) =
-		*((uint16_t *)&thread_ctx->vcpu.gpr[src]);
+	lbl_xfer(thread_ctx->vcpu.gpr[dst], thread_ctx->vcpu.gpr[src], 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 32-bit 
- * registers as t[dst] = t[src]
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
 r2r_xfer_opl(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	thread_ctx->vcpu.gpr[dst] = thread_ctx->vcpu.gpr[src];
+	lbl_xfer(thread_ctx->vcpu.gpr[dst], thread_ctx->vcpu.gpr[src], 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an upper 8-bit 
- * register and a memory location as
- * t[dst] = t[src] (dst is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
+/* t[dst] = t[src]; dst is a register */
 static void PIN_FAST_ANALYSIS_CALL
 m2r_xfer_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1) =
-		*((uint8_t *)(src + STAB[VIRT2STAB(src)]));
+	thread_ctx->vcpu.gpr[dst][1] = tag_ldlbl(src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a lower 8-bit 
- * register and a memory location as
- * t[dst] = t[src] (dst is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
 static void PIN_FAST_ANALYSIS_CALL
 m2r_xfer_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	*((uint8_t *)&thread_ctx->vcpu.gpr[dst]) =
-		*((uint8_t *)(src + STAB[VIRT2STAB(src)]));
+	thread_ctx->vcpu.gpr[dst][0] = tag_ldlbl(src);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 16-bit 
- * register and a memory location as
- * t[dst] = t[src] (dst is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
 static void PIN_FAST_ANALYSIS_CALL
 m2r_xfer_opw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	*((uint16_t *)&thread_ctx->vcpu.gpr[dst]) =
-		*((uint16_t *)(src + STAB[VIRT2STAB(src)]));
+	tag_ldlbln(src, thread_ctx->vcpu.gpr[dst], 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit 
- * register and a memory location as
- * t[dst] = t[src] (dst is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination register index (VCPU)
- * @src:	source memory address
- */
 static void PIN_FAST_ANALYSIS_CALL
 m2r_xfer_opl(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
 {
-	thread_ctx->vcpu.gpr[dst] = *((uint32_t *)(src + STAB[VIRT2STAB(src)]));
+	tag_ldlbln(src, thread_ctx->vcpu.gpr[dst], 4);
 }
 
-#if 0
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a n-memory locations as
- * t[dst] = t[src]; src is AL
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @count:	memory bytes
- * @eflags:	the value of the EFLAGS register
- */
+/* t[dst] = t[src]; src is a register */
 static void PIN_FAST_ANALYSIS_CALL
-r2m_xfer_opbn(thread_ctx_t *thread_ctx,
-		ADDRINT dst,
-		uint32_t count,
-		uint32_t eflags)
+r2m_xfer_opb_u(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	if (likely(EFLAGS_DF(eflags) == 0))
-		/* EFLAGS.DF = 0 */
-		(void)memset((void *)(dst + STAB[VIRT2STAB(dst)]),
-			thread_ctx->vcpu.gpr[7], count);
-	else
-		/* EFLAGS.DF = 1 */
-		(void)memset((void *)(dst + STAB[VIRT2STAB(dst)] - count + 1),
-			thread_ctx->vcpu.gpr[7], count);
+	tag_stlbl(dst, thread_ctx->vcpu.gpr[src][1]);
 }
-#endif
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[dst] = t[upper(src)] (src is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
-r2m_xfer_opb_u(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+r2m_xfer_opb_l(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	*((uint8_t *)(dst + STAB[VIRT2STAB(dst)])) =
-		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
+	tag_stlbl(dst, thread_ctx->vcpu.gpr[src][0]);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between an 8-bit 
- * register and a memory location as
- * t[dst] = t[lower(src)] (src is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
-r2m_xfer_opb_l(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+r2m_xfer_opw(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	*((uint8_t *)(dst + STAB[VIRT2STAB(dst)])) =
-		*((uint8_t *)&thread_ctx->vcpu.gpr[src]);
+	tag_stlbln(dst, thread_ctx->vcpu.gpr[src], 2);
 }
 
-#if 0
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 16-bit 
- * register and a n-memory locations as
- * t[dst] = t[src]; src is AX
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @count:	memory words
- * @eflags:	the value of the EFLAGS register
- */
 static void PIN_FAST_ANALYSIS_CALL
-r2m_xfer_opwn(thread_ctx_t *thread_ctx,
-		ADDRINT dst,
-		uint32_t count,
-		uint32_t eflags)
+r2m_xfer_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
 {
-	/* temporaries */
-	uint32_t tmp_tag	= *((uint16_t *)&thread_ctx->vcpu.gpr[7]);
-	uint32_t addr		= (dst + STAB[VIRT2STAB(dst)]);
+	tag_stlbln(dst, thread_ctx->vcpu.gpr[src], 4);
+}
 
-	/* extend the value of tmp_tag */
-	tmp_tag |= (tmp_tag << 16);
-		
-	/* count is odd */
-	if ((count != 0) && (count % 2 != 0)) {
-		if (likely(EFLAGS_DF(eflags) == 0)) {
-			/* EFLAGS.DF = 0 */
-			/* fast path */
-			(void)wmemset((wchar_t *)addr, (wchar_t)tmp_tag,
-				(count - 1) >> 1);
-
-			/* remainder */
-			*(uint16_t *)(addr + (count << 1) - 2) =
-				(uint16_t)tmp_tag;
-		}
-		else {
-			/* EFLAGS.DF = 1 */
-			/* fast path */
-			(void)wmemset((wchar_t *) (addr - (count << 1) + 3),
-					(wchar_t)tmp_tag, (count - 1) >> 1);
-
-			/* remainder */
-			*(uint16_t *)(addr - (count << 1) + 1) =
-				(uint16_t)tmp_tag;
-		}
-	}
-	/* count is even */
-	else {
+/* t[dst] = t[src]; memory */
+static void PIN_FAST_ANALYSIS_CALL
+m2m_xfer_opw(ADDRINT dst, ADDRINT src)
+{
+	/* temporary labels */
+	uint32_t tmp_tag[2];
 
-		if (likely(EFLAGS_DF(eflags) == 0 || count == 0))
-			/* EFLAGS.DF = 0 */
-			(void)wmemset((wchar_t *)addr,
-					(wchar_t)tmp_tag,
-					count >> 1);
-		else
-			/* EFLAGS.DF = 1 */
-			(void)wmemset((wchar_t *)(addr - (count << 1) + 1),
-					(wchar_t)tmp_tag,
-					count >> 1);
-	}
+	tag_ldlbln(src, tmp_tag, 2);
+	tag_stlbln(dst, tmp_tag, 2);
 }
-#endif
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 16-bit 
- * register and a memory location as
- * t[dst] = t[src] (src is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
-r2m_xfer_opw(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+m2m_xfer_opb(ADDRINT dst, ADDRINT src)
 {
-	*((uint16_t *)(dst + STAB[VIRT2STAB(dst)])) =
-		*((uint16_t *)&thread_ctx->vcpu.gpr[src]);
+	tag_stlbl(dst, tag_ldlbl(src));
 }
 
-#if 0
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit 
- * register and a n-memory locations as
- * t[dst] = t[src]; src is EAX
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- * @count:	memory double words
- * @eflags:	the value of the EFLAGS register
- */
 static void PIN_FAST_ANALYSIS_CALL
-r2m_xfer_opln(thread_ctx_t *thread_ctx,
-		ADDRINT dst,
-		uint32_t count,
-		uint32_t eflags)
+m2m_xfer_opl(ADDRINT dst, ADDRINT src)
+{
+	/* temporary labels */
+	uint32_t tmp_tag[4];
+
+	tag_ldlbln(src, tmp_tag, 4);
+	tag_stlbln(dst, tmp_tag, 4);
+}
+
+/* t[dst] = t[src]; REP MOVS (tagmap_copyn() moves labels as well) */
+static void PIN_FAST_ANALYSIS_CALL
+m2m_xfer_opwn(ADDRINT dst, ADDRINT src, uint32_t count, uint32_t eflags)
 {
 	if (likely(EFLAGS_DF(eflags) == 0))
 		/* EFLAGS.DF = 0 */
-		(void)wmemset((wchar_t *)(dst + STAB[VIRT2STAB(dst)]),
-			(wchar_t)thread_ctx->vcpu.gpr[7], count);
+		tagmap_copyn(dst, src, count << 1);
 	else
 		/* EFLAGS.DF = 1 */
-		(void)wmemset((wchar_t *)
-			(dst + STAB[VIRT2STAB(dst)] - (count << 2) + 1),
-				(wchar_t)thread_ctx->vcpu.gpr[7], count);
+		tagmap_copyn(dst - ((count - 1) << 1),
+				src - ((count - 1) << 1), count << 1);
 }
-#endif
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between a 32-bit 
- * register and a memory location as
- * t[dst] = t[src] (src is a register)
- *
- * @thread_ctx:	the thread context
- * @dst:	destination memory address
- * @src:	source register index (VCPU)
- */
 static void PIN_FAST_ANALYSIS_CALL
-r2m_xfer_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+m2m_xfer_opbn(ADDRINT dst, ADDRINT src, uint32_t count, uint32_t eflags)
 {
-	*((uint32_t *)(dst + STAB[VIRT2STAB(dst)])) =
-		thread_ctx->vcpu.gpr[src];
+	if (likely(EFLAGS_DF(eflags) == 0))
+		/* EFLAGS.DF = 0 */
+		tagmap_copyn(dst, src, count);
+	else
+		/* EFLAGS.DF = 1 */
+		tagmap_copyn(dst - count + 1, src - count + 1, count);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 16-bit 
- * memory locations as t[dst] = t[src]
- *
- * @dst:	destination memory address
- * @src:	source memory address
- */
 static void PIN_FAST_ANALYSIS_CALL
-m2m_xfer_opw(ADDRINT dst, ADDRINT src)
+m2m_xfer_opln(ADDRINT dst, ADDRINT src, uint32_t count, uint32_t eflags)
 {
-	*((uint16_t *)(dst + STAB[VIRT2STAB(dst)])) =
-		*((uint16_t *)(src + STAB[VIRT2STAB(src)]));
-	
+	if (likely(EFLAGS_DF(eflags) == 0))
+		/* EFLAGS.DF = 0 */
+		tagmap_copyn(dst, src, count << 2);
+	else
+		/* EFLAGS.DF = 1 */
+		tagmap_copyn(dst - ((count - 1) << 2),
+				src - ((count - 1) << 2), count << 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 8-bit 
- * memory locations as t[dst] = t[src]
- *
- * @dst:	destination memory address
- * @src:	source memory address
- */
+/* restore the labels of the 16-bit GPRs; POPA (SP is ignored) */
 static void PIN_FAST_ANALYSIS_CALL
-m2m_xfer_opb(ADDRINT dst, ADDRINT src)
+m2r_restore_opw(thread_ctx_t *thread_ctx, ADDRINT src)
 {
-	*((uint8_t *)(dst + STAB[VIRT2STAB(dst)])) =
-		*((uint8_t *)(src + STAB[VIRT2STAB(src)]));
+	tag_ldlbln(src, thread_ctx->vcpu.gpr[0], 2);
+	tag_ldlbln(src + 2, thread_ctx->vcpu.gpr[1], 2);
+	tag_ldlbln(src + 4, thread_ctx->vcpu.gpr[2], 2);
+	tag_ldlbln(src + 8, thread_ctx->vcpu.gpr[4], 2);
+	tag_ldlbln(src + 10, thread_ctx->vcpu.gpr[5], 2);
+	tag_ldlbln(src + 12, thread_ctx->vcpu.gpr[6], 2);
+	tag_ldlbln(src + 14, thread_ctx->vcpu.gpr[7], 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between two 32-bit 
- * memory locations as t[dst] = t[src]
- *
- * @dst:	destination memory address
- * @src:	source memory address
- */
+/* restore the labels of the 32-bit GPRs; POPAD (ESP is ignored) */
 static void PIN_FAST_ANALYSIS_CALL
-m2m_xfer_opl(ADDRINT dst, ADDRINT src)
+m2r_restore_opl(thread_ctx_t *thread_ctx, ADDRINT src)
 {
-	*((uint32_t *)(dst + STAB[VIRT2STAB(dst)])) =
-		*((uint32_t *)(src + STAB[VIRT2STAB(src)]));
+	tag_ldlbln(src, thread_ctx->vcpu.gpr[0], 4);
+	tag_ldlbln(src + 4, thread_ctx->vcpu.gpr[1], 4);
+	tag_ldlbln(src + 8, thread_ctx->vcpu.gpr[2], 4);
+	tag_ldlbln(src + 16, thread_ctx->vcpu.gpr[4], 4);
+	tag_ldlbln(src + 20, thread_ctx->vcpu.gpr[5], 4);
+	tag_ldlbln(src + 24, thread_ctx->vcpu.gpr[6], 4);
+	tag_ldlbln(src + 28, thread_ctx->vcpu.gpr[7], 4);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between n 16-bit 
- * memory locations as t[dst] = t[src]
- *
- * @dst:	destination memory address
- * @src:	source memory address
- * @count:	memory words
- * @eflags:	the value of the EFLAGS register
- */
+/* save the labels of the 16-bit GPRs; PUSHA */
 static void PIN_FAST_ANALYSIS_CALL
-m2m_xfer_opwn(ADDRINT dst, ADDRINT src, uint32_t count, uint32_t eflags)
+r2m_save_opw(thread_ctx_t *thread_ctx, ADDRINT dst)
 {
-	if (likely(EFLAGS_DF(eflags) == 0))
-		/* EFLAGS.DF = 0 */
-		(void)memcpy((void *)(dst + STAB[VIRT2STAB(dst)]),
-			(void *)(src + STAB[VIRT2STAB(src)]),
-			count << 1);
-	else
-		/* EFLAGS.DF = 1 */
-		(void)memcpy((void *)
-			(dst + STAB[VIRT2STAB(dst)] - (count << 1) + 1),
-			(void *)(src + STAB[VIRT2STAB(src)] - (count << 1) + 1),
-			count << 1);
+	size_t	i;
+
+	for (i = 0; i < 8; i++)
+		tag_stlbln(dst + (i << 1), thread_ctx->vcpu.gpr[i], 2);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between n 8-bit 
- * memory locations as t[dst] = t[src]
- *
- * @dst:	destination memory address
- * @src:	source memory address
- * @count:	memory bytes
- * @eflags:	the value of the EFLAGS register
- */
+/* save the labels of the 32-bit GPRs; PUSHAD */
 static void PIN_FAST_ANALYSIS_CALL
-m2m_xfer_opbn(ADDRINT dst, ADDRINT src, uint32_t count, uint32_t eflags)
+r2m_save_opl(thread_ctx_t *thread_ctx, ADDRINT dst)
 {
-	if (likely(EFLAGS_DF(eflags) == 0))
-		/* EFLAGS.DF = 0 */
-		(void)memcpy((void *)(dst + STAB[VIRT2STAB(dst)]),
-			(void *)(src + STAB[VIRT2STAB(src)]),
-			count);
-	else
-		/* EFLAGS.DF = 1 */
-		(void)memcpy((void *)(dst + STAB[VIRT2STAB(dst)] - count + 1),
-			(void *)(src + STAB[VIRT2STAB(src)] - count + 1),
-			count);
+	size_t	i;
+
+	for (i = 0; i < 8; i++)
+		tag_stlbln(dst + (i << 2), thread_ctx->vcpu.gpr[i], 4);
+}
+
+/* fill the labels of n elements of sz bytes; REP STOS (src is AL...EAX) */
+static inline void
+r2m_filln(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t count,
+		uint32_t eflags, size_t sz)
+{
+	const uint32_t	*lbl	= thread_ctx->vcpu.gpr[7];
+	size_t		i;
+
+	/* nothing to do; optimized branch */
+	if (unlikely(count == 0))
+		return;
+
+	/* EFLAGS.DF = 1; start from the last element */
+	if (unlikely(EFLAGS_DF(eflags) != 0))
+		dst -= (count - 1) * sz;
+
+	/* the same label in every byte (e.g., memset(), calloc()) */
+	for (i = 1; i < sz && lbl[i] == lbl[0]; i++);
+	if (likely(i == sz)) {
+		tagmap_lbl_setn(dst, count * sz, lbl[0]);
+		return;
+	}
+
+	/* different labels; byte by byte */
+	for (i = 0; i < count * sz; i++)
+		tag_stlbl(dst + i, lbl[i % sz]);
 }
 
-/*
- * tag propagation (analysis function)
- *
- * propagate tag between n 32-bit 
- * memory locations as t[dst] = t[src]
- *
- * @dst:	destination memory address
- * @src:	source memory address
- * @count:	memory double words
- * @eflags:	the value of the EFLAGS register
- */
 static void PIN_FAST_ANALYSIS_CALL
-m2m_xfer_opln(ADDRINT dst, ADDRINT src, uint32_t count, uint32_t eflags)
+r2m_xfer_opbn(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t count,
+		uint32_t eflags)
 {
-	if (likely(EFLAGS_DF(eflags) == 0))
-		/* EFLAGS.DF = 0 */
-		(void)memcpy((void *)(dst + STAB[VIRT2STAB(dst)]),
-			(void *)(src + STAB[VIRT2STAB(src)]),
-			count << 2);
-	else
-		/* EFLAGS.DF = 1 */
-		(void)memcpy((void *)
-			(dst + STAB[VIRT2STAB(dst)] - (count << 2) + 1),
-			(void *)(src + STAB[VIRT2STAB(src)] - (count << 2) + 1),
-			count << 2);
+	r2m_filln(thread_ctx, dst, count, eflags, 1);
+}
+
+static void PIN_FAST_ANALYSIS_CALL
+r2m_xfer_opwn(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t count,
+		uint32_t eflags)
+{
+	r2m_filln(thread_ctx, dst, count, eflags, 2);
 }
 
+static void PIN_FAST_ANALYSIS_CALL
+r2m_xfer_opln(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t count,
+		uint32_t eflags)
+{
+	r2m_filln(thread_ctx, dst, count, eflags, 4);
+}
+#else
 /*
  * tag propagation (analysis function)
  *
- * instrumentation helper; returns the flag that
- * takes as argument -- seems lame, but it is
- * necessary for aiding conditional analysis to
- * be inlined. Typically used with INS_InsertIfCall()
- * in order to return true (i.e., allow the execution
- * of the function that has been instrumented with
- * INS_InsertThenCall()) only once
+ * extend the tag as follows: t[upper(eax)] = t[ax]
  *
- * first_iteration:	flag; indicates whether the rep-prefixed instruction is
- * 			executed for the first time or not
+ * NOTE: special case for the CWDE instruction
+ *
+ * @thread_ctx:	the thread context
  */
-static ADDRINT PIN_FAST_ANALYSIS_CALL
-rep_predicate(BOOL first_iteration)
+static void PIN_FAST_ANALYSIS_CALL
+_cwde(thread_ctx_t *thread_ctx)
 {
-	/* return the flag; typically this is true only once */
-	return first_iteration; 
+	*(((uint16_t *)&thread_ctx->vcpu.gpr[7]) + 1) =
+		*((uint16_t *)&thread_ctx->vcpu.gpr[7]);
 }
 
 /*
  * tag propagation (analysis function)
  *
- * restore the tag values for all the
- * 16-bit general purpose registers from
- * the memory
+ * propagate and extend tag between a 16-bit 
+ * register and an 8-bit register as t[dst] = t[upper(src)]
  *
- * NOTE: special case for POPA instruction 
+ * NOTE: special case for MOVSX instruction
  *
  * @thread_ctx:	the thread context
- * @src:	the source memory address	
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
  */
 static void PIN_FAST_ANALYSIS_CALL
-m2r_restore_opw(thread_ctx_t *thread_ctx, ADDRINT src)
+_movsx_r2r_opwb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* tagmap address */
-	uint32_t dst = src + STAB[VIRT2STAB(src)];
+	/* temporary tag value */
+	uint8_t src_tag = *(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
 
-	/* restore DI */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[0]) = *(uint16_t *)dst;
-	
-	/* restore SI */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[1]) = *(uint16_t *)(dst + 2);
-	
-	/* restore BP */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[2]) = *(uint16_t *)(dst + 4);
-	
-	/* SP is ignored */
-	
-	/* restore BX */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[4]) = *(uint16_t *)(dst + 8);
-	
-	/* restore DX */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[5]) = *(uint16_t *)(dst + 10);
-	
-	/* restore CX */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[6]) = *(uint16_t *)(dst + 12);
-	
-	/* restore AX */
-	*((uint16_t *)&thread_ctx->vcpu.gpr[7]) = *(uint16_t *)(dst + 14);
+	/* update the destination (xfer) */
+	*((uint8_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
 }
 
 /*
  * tag propagation (analysis function)
  *
- * restore the tag values for all the
- * 32-bit general purpose registers from
- * the memory
+ * propagate and extend tag between a 16-bit 
+ * register and an 8-bit register as t[dst] = t[lower(src)]
  *
- * NOTE: special case for POPAD instruction 
+ * NOTE: special case for MOVSX instruction
  *
  * @thread_ctx:	the thread context
- * @src:	the source memory address	
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
  */
 static void PIN_FAST_ANALYSIS_CALL
-m2r_restore_opl(thread_ctx_t *thread_ctx, ADDRINT src)
+_movsx_r2r_opwb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* tagmap address */
-	uint32_t dst = src + STAB[VIRT2STAB(src)];
-
-	/* restore EDI */
-	thread_ctx->vcpu.gpr[0] = *(uint32_t *)dst;
-
-	/* restore ESI */
-	thread_ctx->vcpu.gpr[1] = *(uint32_t *)(dst + 4);
-	
-	/* restore EBP */
-	thread_ctx->vcpu.gpr[2] = *(uint32_t *)(dst + 8);
+	/* temporary tag value */
+	uint8_t src_tag = *((uint8_t *)&thread_ctx->vcpu.gpr[src]);
 
-	/* ESP is ignored */
-	
-	/* restore EBX */
-	thread_ctx->vcpu.gpr[4] = *(uint32_t *)(dst + 16);
-	
-	/* restore EDX */
-	thread_ctx->vcpu.gpr[5] = *(uint32_t *)(dst + 20);
-	
-	/* restore ECX */
-	thread_ctx->vcpu.gpr[6] = *(uint32_t *)(dst + 24);
-	
-	/* restore EAX */
-	thread_ctx->vcpu.gpr[7] = *(uint32_t *)(dst + 28);
+	/* update the destination (xfer) */
+	*((uint8_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
 }
 
 /*
  * tag propagation (analysis function)
  *
- * save the tag values for all the 16-bit
- * general purpose registers into the memory
+ * propagate and extend tag between a 32-bit register
+ * and an upper 8-bit register as t[dst] = t[upper(src)]
  *
- * NOTE: special case for PUSHA instruction
+ * NOTE: special case for MOVSX instruction
  *
  * @thread_ctx:	the thread context
- * @dst:	the destination memory address
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
  */
 static void PIN_FAST_ANALYSIS_CALL
-r2m_save_opw(thread_ctx_t *thread_ctx, ADDRINT dst)
+_movsx_r2r_oplb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* tagmap address */
-	uint32_t dst_val = dst + STAB[VIRT2STAB(dst)];
-
-	/* save DI */
-	*(uint16_t *)dst_val =  *((uint16_t *)&thread_ctx->vcpu.gpr[0]);
-
-	/* save SI */
-	*(uint16_t *)(dst_val + 2) = *((uint16_t *)&thread_ctx->vcpu.gpr[1]);
-
-	/* save BP */
-	*(uint16_t *)(dst_val + 4) = *((uint16_t *)&thread_ctx->vcpu.gpr[2]);
-
-	/* save SP */
-	*(uint16_t *)(dst_val + 6) = *((uint16_t *)&thread_ctx->vcpu.gpr[3]);
-
-	/* save BX */
-	*(uint16_t *)(dst_val + 8) = *((uint16_t *)&thread_ctx->vcpu.gpr[4]);
-
-	/* save DX */
-	*(uint16_t *)(dst_val + 10) = *((uint16_t *)&thread_ctx->vcpu.gpr[5]);
+	/* temporary tag value */
+	uint8_t src_tag = *(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
 
-	/* save CX */
-	*(uint16_t *)(dst_val + 12) = *((uint16_t *)&thread_ctx->vcpu.gpr[6]);
+#if defined(TARGET_IA32E)
+	/* 32-bit destination; clear the upper half */
+	thread_ctx->vcpu.gpr[dst] = TAG_ZERO;
+#endif
 
-	/* save AX */
-	*(uint16_t *)(dst_val + 14) = *((uint16_t *)&thread_ctx->vcpu.gpr[7]);
+	/* update the destination (xfer) */
+	*((uint8_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 2)	= src_tag;
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 3)	= src_tag;
 }
 
 /*
  * tag propagation (analysis function)
  *
- * save the tag values for all the 32-bit
- * general purpose registers into the memory
+ * propagate and extend tag between a 32-bit register
+ * and a lower 8-bit register as t[dst] = t[lower(src)]
  *
- * NOTE: special case for PUSHAD instruction 
+ * NOTE: special case for MOVSX instruction
  *
  * @thread_ctx:	the thread context
- * @dst:	the destination memory address
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
  */
 static void PIN_FAST_ANALYSIS_CALL
-r2m_save_opl(thread_ctx_t *thread_ctx, ADDRINT dst)
+_movsx_r2r_oplb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* tagmap address */
-	uint32_t dst_val = dst + STAB[VIRT2STAB(dst)];
+	/* temporary tag value */
+	uint8_t src_tag = *((uint8_t *)&thread_ctx->vcpu.gpr[src]);
 
-	/* save EDI */
-	*(uint32_t *)dst_val = thread_ctx->vcpu.gpr[0];
+#if defined(TARGET_IA32E)
+	/* 32-bit destination; clear the upper half */
+	thread_ctx->vcpu.gpr[dst] = TAG_ZERO;
+#endif
 
-	/* save ESI */
-	*(uint32_t *)(dst_val + 4) = thread_ctx->vcpu.gpr[1];
+	/* update the destination (xfer) */
+	*((uint8_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 2)	= src_tag;
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 3)	= src_tag;
+}
 
-	/* save EBP */
-	*(uint32_t *)(dst_val + 8) = thread_ctx->vcpu.gpr[2];
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit register
+ * and a 16-bit register as t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movsx_r2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint16_t src_tag = *((uint16_t *)&thread_ctx->vcpu.gpr[src]);
 
-	/* save ESP */
-	*(uint32_t *)(dst_val + 12) = thread_ctx->vcpu.gpr[3];
+#if defined(TARGET_IA32E)
+	/* 32-bit destination; clear the upper half */
+	thread_ctx->vcpu.gpr[dst] = TAG_ZERO;
+#endif
 
-	/* save EBX */
-	*(uint32_t *)(dst_val + 16) = thread_ctx->vcpu.gpr[4];
+	/* update the destination (xfer) */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	*(((uint16_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
+}
 
-	/* save EDX */
-	*(uint32_t *)(dst_val + 20) = thread_ctx->vcpu.gpr[5];
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 16-bit 
+ * register and an 8-bit memory location as
+ * t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movsx_m2r_opwb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	/* temporary tag value */
+	uint8_t src_tag = tag_ldb(src);
 
-	/* save ECX */
-	*(uint32_t *)(dst_val + 24) = thread_ctx->vcpu.gpr[6];
+	/* update the destination (xfer) */
+	*((uint8_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
+}
 
-	/* save EAX */
-	*(uint32_t *)(dst_val + 28) = thread_ctx->vcpu.gpr[7];
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit 
+ * register and an 8-bit memory location as
+ * t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movsx_m2r_oplb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	/* temporary tag value */
+	uint8_t src_tag = tag_ldb(src);
+
+#if defined(TARGET_IA32E)
+	/* 32-bit destination; clear the upper half */
+	thread_ctx->vcpu.gpr[dst] = TAG_ZERO;
+#endif
+
+	/* update the destination (xfer) */
+	*((uint8_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 2)	= src_tag;
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 3)	= src_tag;
 }
 
-#ifdef DEBUG_MEMOPS
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit register
+ * and a 16-bit register as t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
 static void PIN_FAST_ANALYSIS_CALL
-log_memory_read(ADDRINT ip, ADDRINT addr)
+_movsx_m2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	fprintf(stderr, "0x%x: R 0x%x\n", ip, addr);
+	/* temporary tag value */
+	uint16_t src_tag =  tag_ldw(src);
+
+#if defined(TARGET_IA32E)
+	/* 32-bit destination; clear the upper half */
+	thread_ctx->vcpu.gpr[dst] = TAG_ZERO;
+#endif
+
+	/* update the destination (xfer) */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+	*(((uint16_t *)&thread_ctx->vcpu.gpr[dst]) + 1)	= src_tag;
 }
 
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 16-bit 
+ * register and an 8-bit register as t[dst] = t[upper(src)]
+ *
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
 static void PIN_FAST_ANALYSIS_CALL
-log_memory_write(ADDRINT ip, ADDRINT addr)
+_movzx_r2r_opwb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	fprintf(stderr, "0x%x: W 0x%x\n", ip, addr);
+	/* temporary tag value */
+	uint8_t src_tag = *(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
+
+	/* update the destination (xfer) */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
 }
-#endif
 
 /*
- * instruction inspection (instrumentation function)
+ * tag propagation (analysis function)
  *
- * analyze every instruction and instrument it
- * for propagating the tag bits accordingly
+ * propagate and extend tag between a 16-bit 
+ * register and an 8-bit register as t[dst] = t[lower(src)]
  *
- * @ins:	the instruction to be instrumented
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
  */
-void
-ins_inspect(INS ins)
+static void PIN_FAST_ANALYSIS_CALL
+_movzx_r2r_opwb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
 {
-	/* 
-	 * temporaries;
-	 * source, destination, base, and index registers
-	 */
-	REG reg_dst, reg_src, reg_base, reg_indx;
+	/* temporary tag value */
+	uint8_t src_tag = *((uint8_t *)&thread_ctx->vcpu.gpr[src]);
 
-	/* use XED to decode the instruction and extract its opcode */
-	xed_iclass_enum_t ins_indx = (xed_iclass_enum_t)INS_Opcode(ins);
-	
-	/* sanity check */
-	if (unlikely(ins_indx <= XED_ICLASS_INVALID || 
-				ins_indx >= XED_ICLASS_LAST)) {
-		LOG(string(__func__) + ": unknown opcode (opcode=" + 
-				decstr(ins_indx) + ")\n");
+	/* update the destination (xfer) */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+}
 
-		/* done */
-		return;
-	}
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit register
+ * and an upper 8-bit register as t[dst] = t[upper(src)]
+ *
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movzx_r2r_oplb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint8_t src_tag = *(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
 
-#ifdef DEBUG_MEMOPS
-	(void)fprintf(stderr, "0x%x: %s\n", INS_Address(ins), INS_Disassemble(ins).c_str());
-	if(INS_IsMemoryRead(ins) || INS_IsMemoryWrite(ins)) {
-		for(uint32_t memOp = 0; memOp < INS_MemoryOperandCount(ins); memOp++) {
-			if(INS_MemoryOperandIsRead(ins, memOp)) {
-				INS_InsertPredicatedCall(
-					ins, IPOINT_BEFORE, (AFUNPTR)log_memory_read,
-					IARG_INST_PTR, IARG_MEMORYOP_EA, memOp, IARG_END);
-			} else if(INS_MemoryOperandIsWritten(ins, memOp)) {
-				INS_InsertPredicatedCall(
-					ins, IPOINT_BEFORE, (AFUNPTR)log_memory_write,
-					IARG_INST_PTR, IARG_MEMORYOP_EA, memOp, IARG_END);
-			}
-		}
-	}
-#endif
+	/* update the destination (xfer) */
+	thread_ctx->vcpu.gpr[dst] = src_tag;
+}
 
-	/* analyze the instruction */
-	switch (ins_indx) {
-		/* adc */
-		case XED_ICLASS_ADC:
-		/* add */
-		case XED_ICLASS_ADD:
-		/* and */
-		case XED_ICLASS_AND:
-		/* or */
-		case XED_ICLASS_OR:
-		/* xor */
-		case XED_ICLASS_XOR:
-		/* sbb */
-		case XED_ICLASS_SBB:
-		/* sub */
-		case XED_ICLASS_SUB:
-			/*
-			 * the general format of these instructions
-			 * is the following: dst {op}= src, where
-			 * op can be +, -, &, |, etc. We tag the
-			 * destination if the source is also taged
-			 * (i.e., t[dst] |= t[src])
-			 */
-			/* 2nd operand is immediate; do nothing */
-			if (INS_OperandIsImmediate(ins, OP_1))
-				break;
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit register
+ * and a lower 8-bit register as t[dst] = t[lower(src)]
+ *
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movzx_r2r_oplb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint8_t src_tag = *((uint8_t *)&thread_ctx->vcpu.gpr[src]);
 
-			/* both operands are registers */
-			if (INS_MemoryOperandCount(ins) == 0) {
-				/* extract the operands */
-				reg_dst = INS_OperandReg(ins, OP_0);
-				reg_src = INS_OperandReg(ins, OP_1);
-				
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_dst)) {
-					/* check for x86 clear register idiom */
-					switch (ins_indx) {
-						/* xor, sub, sbb */
-						case XED_ICLASS_XOR:
-						case XED_ICLASS_SUB:
-						case XED_ICLASS_SBB:
-							/* same dst, src */
-							if (reg_dst == reg_src) 
-							{
-								/* clear */
-							INS_InsertCall(ins,
-								IPOINT_BEFORE,
-								(AFUNPTR)r_clrl,
-							IARG_FAST_ANALYSIS_CALL,
-								IARG_REG_VALUE, 
-								thread_ctx_ptr,
-								IARG_UINT32,
-							REG32_INDX(reg_dst),
-								IARG_END);
-
-								/* done */
-								break;
-							}
-						/* default behavior */
-						default:
-							/* 
-							 * propagate the tag
-							 * markings accordingly
-							 */
-							INS_InsertCall(ins,
-							IPOINT_BEFORE,
-							(AFUNPTR)r2r_binary_opl,
-							IARG_FAST_ANALYSIS_CALL,
-							IARG_REG_VALUE,
-							thread_ctx_ptr,
-							IARG_UINT32,
-							REG32_INDX(reg_dst),
-							IARG_UINT32,
-							REG32_INDX(reg_src),
-							IARG_END);
-					}
-				}
-				/* 16-bit operands */
-				else if (REG_is_gr16(reg_dst)) {
-					/* check for x86 clear register idiom */
-					switch (ins_indx) {
-						/* xor, sub, sbb */
-						case XED_ICLASS_XOR:
-						case XED_ICLASS_SUB:
-						case XED_ICLASS_SBB:
-							/* same dst, src */
-							if (reg_dst == reg_src) 
-							{
-								/* clear */
-							INS_InsertCall(ins,
-								IPOINT_BEFORE,
-								(AFUNPTR)r_clrw,
-							IARG_FAST_ANALYSIS_CALL,
-								IARG_REG_VALUE, 
-								thread_ctx_ptr,
-								IARG_UINT32,
-							REG16_INDX(reg_dst),
-								IARG_END);
-
-								/* done */
-								break;
-							}
-						/* default behavior */
-						default:
-						/* propagate tags accordingly */
-							INS_InsertCall(ins,
-								IPOINT_BEFORE,
-							(AFUNPTR)r2r_binary_opw,
-							IARG_FAST_ANALYSIS_CALL,
-								IARG_REG_VALUE, 
-								thread_ctx_ptr,
-								IARG_UINT32,
-							REG16_INDX(reg_dst),
-								IARG_UINT32,
-							REG16_INDX(reg_src),
-								IARG_END);
-					}
-				}
-				/* 8-bit operands */
-				else {
-					/* check for x86 clear register idiom */
-					switch (ins_indx) {
-						/* xor, sub, sbb */
-						case XED_ICLASS_XOR:
-						case XED_ICLASS_SUB:
-						case XED_ICLASS_SBB:
-							/* same dst, src */
-							if (reg_dst == reg_src) 
-							{
-							/* 8-bit upper */
-						if (REG_is_Upper8(reg_dst))
-								/* clear */
-							INS_InsertCall(ins,
-								IPOINT_BEFORE,
-							(AFUNPTR)r_clrb_u,
-							IARG_FAST_ANALYSIS_CALL,
-								IARG_REG_VALUE,
-								thread_ctx_ptr,
-								IARG_UINT32,
-							REG8_INDX(reg_dst),
-								IARG_END);
-							/* 8-bit lower */
-						else 
-								/* clear */
-							INS_InsertCall(ins,
-								IPOINT_BEFORE,
-							(AFUNPTR)r_clrb_l,
-							IARG_FAST_ANALYSIS_CALL,
-								IARG_REG_VALUE,
-								thread_ctx_ptr,
-								IARG_UINT32,
-							REG8_INDX(reg_dst),
-								IARG_END);
-
-								/* done */
-								break;
-							}
-						/* default behavior */
-						default:
-						/* propagate tags accordingly */
-					if (REG_is_Lower8(reg_dst) &&
-							REG_is_Lower8(reg_src))
-						/* lower 8-bit registers */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2r_binary_opb_l,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, REG8_INDX(reg_dst),
-						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_END);
-					else if(REG_is_Upper8(reg_dst) &&
-							REG_is_Upper8(reg_src))
-						/* upper 8-bit registers */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2r_binary_opb_u,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, REG8_INDX(reg_dst),
-						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_END);
-					else if (REG_is_Lower8(reg_dst))
-						/* 
-						 * destination register is a
-						 * lower 8-bit register and
-						 * source register is an upper
-						 * 8-bit register
-						 */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2r_binary_opb_lu,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, REG8_INDX(reg_dst),
-						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_END);
-					else
-						/* 
-						 * destination register is an
-						 * upper 8-bit register and
-						 * source register is a lower
-						 * 8-bit register
-						 */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2r_binary_opb_ul,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, REG8_INDX(reg_dst),
-						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_END);
-					}
-				}
-			}
-			/* 
-			 * 2nd operand is memory;
-			 * we optimize for that case, since most
-			 * instructions will have a register as
-			 * the first operand -- leave the result
-			 * into the reg and use it later
-			 */
-			else if (INS_OperandIsMemory(ins, OP_1)) {
-				/* extract the register operand */
-				reg_dst = INS_OperandReg(ins, OP_0);
+	/* update the destination (xfer) */
+	thread_ctx->vcpu.gpr[dst] = src_tag;
+}
 
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_dst))
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)m2r_binary_opl,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-					IARG_UINT32, REG32_INDX(reg_dst),
-						IARG_MEMORYREAD_EA,
-						IARG_END);
-				/* 16-bit operands */
-				else if (REG_is_gr16(reg_dst))
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)m2r_binary_opw,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-					IARG_UINT32, REG16_INDX(reg_dst),
-						IARG_MEMORYREAD_EA,
-						IARG_END);
-				/* 8-bit operand (upper) */
-				else if (REG_is_Upper8(reg_dst))
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)m2r_binary_opb_u,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, REG8_INDX(reg_dst),
-						IARG_MEMORYREAD_EA,
-						IARG_END);
-				/* 8-bit operand (lower) */
-				else 
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)m2r_binary_opb_l,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, REG8_INDX(reg_dst),
-						IARG_MEMORYREAD_EA,
-						IARG_END);
-			}
-			/* 1st operand is memory */
-			else {
-				/* extract the register operand */
-				reg_src = INS_OperandReg(ins, OP_1);
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit register
+ * and a 16-bit register as t[dst] = t[src]
+ *
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movzx_r2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint16_t src_tag = *((uint16_t *)&thread_ctx->vcpu.gpr[src]);
 
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_src))
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2m_binary_opl,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_MEMORYWRITE_EA,
-					IARG_UINT32, REG32_INDX(reg_src),
-						IARG_END);
-				/* 16-bit operands */
-				else if (REG_is_gr16(reg_src))
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2m_binary_opw,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_MEMORYWRITE_EA,
-					IARG_UINT32, REG16_INDX(reg_src),
-						IARG_END);
-				/* 8-bit operand (upper) */
-				else if (REG_is_Upper8(reg_src))
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2m_binary_opb_u,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_MEMORYWRITE_EA,
-						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_END);
-				/* 8-bit operand (lower) */
-				else
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2m_binary_opb_l,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_MEMORYWRITE_EA,
-						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_END);
-			}
+	/* update the destination (xfer) */
+	thread_ctx->vcpu.gpr[dst] = src_tag;
+}
 
-			/* done */
-			break;
-		/* bsf */
-		case XED_ICLASS_BSF:
-		/* bsr */
-		case XED_ICLASS_BSR:
-		/* mov */
-		case XED_ICLASS_MOV:
-			/*
-			 * the general format of these instructions
-			 * is the following: dst = src. We move the
-			 * tag of the source to the destination
-			 * (i.e., t[dst] = t[src])
-			 */
-			/* 
-			 * 2nd operand is immediate or segment register;
-			 * clear the destination
-			 *
-			 * NOTE: When the processor moves a segment register
-			 * into a 32-bit general-purpose register, it assumes
-			 * that the 16 least-significant bits of the
-			 * general-purpose register are the destination or
-			 * source operand. If the register is a destination
-			 * operand, the resulting value in the two high-order
-			 * bytes of the register is implementation dependent.
-			 * For the Pentium 4, Intel Xeon, and P6 family
-			 * processors, the two high-order bytes are filled with
-			 * zeros; for earlier 32-bit IA-32 processors, the two
-			 * high order bytes are undefined.
-			 */
-			if (INS_OperandIsImmediate(ins, OP_1) ||
-				(INS_OperandIsReg(ins, OP_1) &&
-				REG_is_seg(INS_OperandReg(ins, OP_1)))) {
-				/* destination operand is a memory address */
-				if (INS_OperandIsMemory(ins, OP_0)) {
-					/* clear n-bytes */
-					switch (INS_OperandWidth(ins, OP_0)) {
-						/* 4 bytes */
-						case MEM_LONG_LEN:
-					/* propagate the tag accordingly */
-						INS_InsertCall(ins,
-							IPOINT_BEFORE,
-							(AFUNPTR)tagmap_clrl,
-							IARG_FAST_ANALYSIS_CALL,
-							IARG_MEMORYWRITE_EA,
-							IARG_END);
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 16-bit 
+ * register and an 8-bit memory location as
+ * t[dst] = t[src]
+ *
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movzx_m2r_opwb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	/* temporary tag value */
+	uint8_t src_tag = tag_ldb(src);
 
-							/* done */
-							break;
-						/* 2 bytes */
-						case MEM_WORD_LEN:
-					/* propagate the tag accordingly */
-						INS_InsertCall(ins,
-							IPOINT_BEFORE,
-							(AFUNPTR)tagmap_clrw,
-							IARG_FAST_ANALYSIS_CALL,
-							IARG_MEMORYWRITE_EA,
-							IARG_END);
+	/* update the destination (xfer) */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[dst])	= src_tag;
+}
 
-							/* done */
-							break;
-						/* 1 byte */
-						case MEM_BYTE_LEN:
-					/* propagate the tag accordingly */
-						INS_InsertCall(ins,
-							IPOINT_BEFORE,
-							(AFUNPTR)tagmap_clrb,
-							IARG_FAST_ANALYSIS_CALL,
-							IARG_MEMORYWRITE_EA,
-							IARG_END);
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit 
+ * register and an 8-bit memory location as
+ * t[dst] = t[src]
+ *
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movzx_m2r_oplb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	/* temporary tag value */
+	uint8_t src_tag = tag_ldb(src);
 
-							/* done */
-							break;
-						/* make the compiler happy */
-						default:
-						LOG(string(__func__) +
-						": unhandled operand width (" +
-						INS_Disassemble(ins) + ")\n");
+	/* update the destination (xfer) */
+	thread_ctx->vcpu.gpr[dst] = src_tag;
+}
 
-							/* done */
-							return;
-					}
-				}
-				/* destination operand is a register */
-				else if (INS_OperandIsReg(ins, OP_0)) {
-					/* extract the operand */
-					reg_dst = INS_OperandReg(ins, OP_0);
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 32-bit register
+ * and a 16-bit register as t[dst] = t[src]
+ *
+ * NOTE: special case for MOVZX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movzx_m2r_oplw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint16_t src_tag =  tag_ldw(src);
 
-					/* 32-bit operand */
-					if (REG_is_gr32(reg_dst))
-					/* propagate the tag accordingly */
-						INS_InsertCall(ins,
-							IPOINT_BEFORE,
-							(AFUNPTR)r_clrl,
-							IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-					IARG_UINT32, REG32_INDX(reg_dst),
-							IARG_END);
-					/* 16-bit operand */
-					else if (REG_is_gr16(reg_dst))
-					/* propagate the tag accordingly */
-						INS_InsertCall(ins,
-							IPOINT_BEFORE,
-							(AFUNPTR)r_clrw,
-							IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-					IARG_UINT32, REG16_INDX(reg_dst),
-							IARG_END);
-					/* 8-bit operand (upper) */
-					else if (REG_is_Upper8(reg_dst))
-					/* propagate the tag accordingly */
-						INS_InsertCall(ins,
-							IPOINT_BEFORE,
-							(AFUNPTR)r_clrb_u,
-							IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, REG8_INDX(reg_dst),
-							IARG_END);
-					/* 8-bit operand (lower) */
-					else
-					/* propagate the tag accordingly */
-						INS_InsertCall(ins,
-							IPOINT_BEFORE,
-							(AFUNPTR)r_clrb_l,
-							IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, REG8_INDX(reg_dst),
-							IARG_END);
+	/* update the destination (xfer) */
+	thread_ctx->vcpu.gpr[dst] = src_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 32-bit
+ * registers as t[EAX] = t[src]; return
+ * the result of EAX == src and also
+ * store the original tag value of
+ * EAX in the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst_val:	EAX register value
+ * @src:	source register index (VCPU)
+ * @src_val:	source register value
+ */
+static ADDRINT PIN_FAST_ANALYSIS_CALL
+_cmpxchg_r2r_opl_fast(thread_ctx_t *thread_ctx, uint32_t dst_val, uint32_t src,
+							uint32_t src_val)
+{
+	/* save the tag value of dst in the scratch register */
+	thread_ctx->vcpu.gpr[GPR_SCRATCH] = 
+		thread_ctx->vcpu.gpr[7];
+	
+	/* update */
+	thread_ctx->vcpu.gpr[7] =
+		VCPU_ZX32(thread_ctx->vcpu.gpr[src]);
+
+	/* compare the dst and src values */
+	return (dst_val == src_val);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 32-bit 
+ * registers as t[dst] = t[src]; restore the
+ * value of EAX from the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_cmpxchg_r2r_opl_slow(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* restore the tag value from the scratch register */
+	thread_ctx->vcpu.gpr[7] = 
+		thread_ctx->vcpu.gpr[GPR_SCRATCH];
+	
+	/* update */
+	thread_ctx->vcpu.gpr[dst] =
+		VCPU_ZX32(thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 16-bit
+ * registers as t[AX] = t[src]; return
+ * the result of AX == src and also
+ * store the original tag value of
+ * AX in the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst_val:	AX register value
+ * @src:	source register index (VCPU)
+ * @src_val:	source register value
+ */
+static ADDRINT PIN_FAST_ANALYSIS_CALL
+_cmpxchg_r2r_opw_fast(thread_ctx_t *thread_ctx, uint16_t dst_val, uint32_t src,
+						uint16_t src_val)
+{
+	/* save the tag value of dst in the scratch register */
+	thread_ctx->vcpu.gpr[GPR_SCRATCH] = 
+		thread_ctx->vcpu.gpr[7];
+	
+	/* update */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[7]) =
+		*((uint16_t *)&thread_ctx->vcpu.gpr[src]);
+
+	/* compare the dst and src values */
+	return (dst_val == src_val);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 16-bit 
+ * registers as t[dst] = t[src]; restore the
+ * value of AX from the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_cmpxchg_r2r_opw_slow(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* restore the tag value from the scratch register */
+	thread_ctx->vcpu.gpr[7] = 
+		thread_ctx->vcpu.gpr[GPR_SCRATCH];
+	
+	/* update */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[dst]) =
+		*((uint16_t *)&thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 32-bit
+ * register and a memory location
+ * as t[EAX] = t[src]; return the result
+ * of EAX == src and also store the
+ * original tag value of EAX in
+ * the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst_val:	destination register value
+ * @src:	source memory address
+ */
+static ADDRINT PIN_FAST_ANALYSIS_CALL
+_cmpxchg_m2r_opl_fast(thread_ctx_t *thread_ctx, uint32_t dst_val, ADDRINT src)
+{
+	/* save the tag value of dst in the scratch register */
+	thread_ctx->vcpu.gpr[GPR_SCRATCH] = 
+		thread_ctx->vcpu.gpr[7];
+	
+	/* update */
+	thread_ctx->vcpu.gpr[7] = 
+		tag_ldl(src);
+	
+	/* compare the dst and src values; the original values the tag bits */
+	return (dst_val == *(uint32_t *)src);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 32-bit 
+ * register and a memory location
+ * as t[dst] = t[src]; restore the value
+ * of EAX from the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_cmpxchg_r2m_opl_slow(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	/* restore the tag value from the scratch register */
+	thread_ctx->vcpu.gpr[7] = 
+		thread_ctx->vcpu.gpr[GPR_SCRATCH];
+	
+	/* update */
+	tag_stl(dst,
+		thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 16-bit
+ * register and a memory location
+ * as t[AX] = t[src]; return the result
+ * of AX == src and also store the
+ * original tag value of AX in
+ * the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @dst_val:	destination register value
+ * @src:	source memory address
+ */
+static ADDRINT PIN_FAST_ANALYSIS_CALL
+_cmpxchg_m2r_opw_fast(thread_ctx_t *thread_ctx, uint16_t dst_val, ADDRINT src)
+{
+	/* save the tag value of dst in the scratch register */
+	thread_ctx->vcpu.gpr[GPR_SCRATCH] = 
+		thread_ctx->vcpu.gpr[7];
+	
+	/* update */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[7]) = 
+		tag_ldw(src);
+	
+	/* compare the dst and src values; the original values the tag bits */
+	return (dst_val == *(uint16_t *)src);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 16-bit 
+ * register and a memory location
+ * as t[dst] = t[src]; restore the value
+ * of AX from the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ * @res:	restore register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_cmpxchg_r2m_opw_slow(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	/* restore the tag value from the scratch register */
+	thread_ctx->vcpu.gpr[7] = 
+		thread_ctx->vcpu.gpr[GPR_SCRATCH];
+	
+	/* update */
+	tag_stw(dst,
+		*((uint16_t *)&thread_ctx->vcpu.gpr[src]));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 32-bit 
+ * register and a memory location as
+ * t[dst] = t[src] and t[src] = t[dst] 
+ * (src is a register)
+ *
+ * NOTE: special case for the XCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_xchg_r2m_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint32_t tmp_tag = tag_ldl(dst);
+
+	/* swap */
+	tag_stl(dst,
+		thread_ctx->vcpu.gpr[src]);
+		
+	thread_ctx->vcpu.gpr[src] = tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 16-bit 
+ * register and a memory location as
+ * t[dst] = t[src] and t[src] = t[dst]
+ * (src is a register)
+ *
+ * NOTE: special case for the XCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_xchg_r2m_opw(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint16_t tmp_tag = tag_ldw(dst);
+
+	/* swap */
+	tag_stw(dst,
+		*((uint16_t *)&thread_ctx->vcpu.gpr[src]));
+		
+	*((uint16_t *)&thread_ctx->vcpu.gpr[src]) = tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between an 8-bit 
+ * register and a memory location as
+ * t[dst] = t[upper(src)] and t[upper(src)] = t[dst]
+ * (src is a register)
+ *
+ * NOTE: special case for the XCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_xchg_r2m_opb_u(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint8_t tmp_tag = tag_ldb(dst);
+
+	/* swap */
+	tag_stb(dst,
+		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1));
+	
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1) = tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between an 8-bit 
+ * register and a memory location as
+ * t[dst] = t[lower(src)] and t[lower(src)] = t[dst]
+ * (src is a register)
+ *
+ * NOTE: special case for the XCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_xchg_r2m_opb_l(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint8_t tmp_tag = tag_ldb(dst);
+	
+	/* swap */
+	tag_stb(dst,
+		*((uint8_t *)&thread_ctx->vcpu.gpr[src]));
+	
+	*((uint8_t *)&thread_ctx->vcpu.gpr[src]) = tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 32-bit 
+ * register and a memory location as
+ * t[dst] |= t[src] and t[src] = t[dst] 
+ * (src is a register)
+ *
+ * NOTE: special case for the XADD instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_xadd_r2m_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint32_t tmp_tag = tag_ldl(dst);
+
+	/* swap */
+	tag_orl(dst,
+		thread_ctx->vcpu.gpr[src]);
+		
+	thread_ctx->vcpu.gpr[src] = tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 16-bit 
+ * register and a memory location as
+ * t[dst] |= t[src] and t[src] = t[dst]
+ * (src is a register)
+ *
+ * NOTE: special case for the XADD instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_xadd_r2m_opw(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint16_t tmp_tag = tag_ldw(dst);
+
+	/* swap */
+	tag_orw(dst,
+		*((uint16_t *)&thread_ctx->vcpu.gpr[src]));
+		
+	*((uint16_t *)&thread_ctx->vcpu.gpr[src]) = tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between an 8-bit 
+ * register and a memory location as
+ * t[dst] |= t[upper(src)] and t[upper(src)] = t[dst]
+ * (src is a register)
+ *
+ * NOTE: special case for the XADD instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_xadd_r2m_opb_u(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint8_t tmp_tag = tag_ldb(dst);
+
+	/* swap */
+	tag_orb(dst,
+		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1));
+	
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1) = tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between an 8-bit 
+ * register and a memory location as
+ * t[dst] |= t[lower(src)] and t[lower(src)] = t[dst]
+ * (src is a register)
+ *
+ * NOTE: special case for the XADD instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_xadd_r2m_opb_l(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint8_t tmp_tag = tag_ldb(dst);
+	
+	/* swap */
+	tag_orb(dst,
+		*((uint8_t *)&thread_ctx->vcpu.gpr[src]));
+	
+	*((uint8_t *)&thread_ctx->vcpu.gpr[src]) = tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between three 16-bit 
+ * registers as t[dst] = t[base] | t[index]
+ *
+ * NOTE: special case for the LEA instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register
+ * @base:	base register
+ * @index:	index register
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_lea_r2r_opw(thread_ctx_t *thread_ctx,
+		uint32_t dst,
+		uint32_t base,
+		uint32_t index)
+{
+	/* update the destination */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[dst]) =
+		*((uint16_t *)&thread_ctx->vcpu.gpr[base]) |
+		*((uint16_t *)&thread_ctx->vcpu.gpr[index]); 
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between three 32-bit 
+ * registers as t[dst] = t[base] | t[index]
+ *
+ * NOTE: special case for the LEA instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register
+ * @base:	base register
+ * @index:	index register
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_lea_r2r_opl(thread_ctx_t *thread_ctx,
+		uint32_t dst,
+		uint32_t base,
+		uint32_t index)
+{
+	/* update the destination */
+	thread_ctx->vcpu.gpr[dst] =
+		VCPU_ZX32(thread_ctx->vcpu.gpr[base] |
+				thread_ctx->vcpu.gpr[index]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag among three 8-bit registers as t[dst] |= t[upper(src)];
+ * dst is AX, whereas src is an upper 8-bit register (e.g., CH, BH, ...)
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_ternary_opb_u(thread_ctx_t *thread_ctx, uint32_t src)
+{
+	/* temporary tag value */
+	uint8_t tmp_tag = *(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
+	
+	/* update the destination (ternary) */
+	*((uint8_t *)&thread_ctx->vcpu.gpr[7])		|= tmp_tag;
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[7]) + 1)	|= tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag among three 8-bit registers as t[dst] |= t[lower(src)];
+ * dst is AX, whereas src is a lower 8-bit register (e.g., CL, BL, ...)
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_ternary_opb_l(thread_ctx_t *thread_ctx, uint32_t src)
+{
+	/* temporary tag value */
+	uint8_t tmp_tag = *((uint8_t *)&thread_ctx->vcpu.gpr[src]);
+	
+	/* update the destination (ternary) */
+	*((uint8_t *)&thread_ctx->vcpu.gpr[7])		|= tmp_tag;
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[7]) + 1)	|= tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between among three 16-bit 
+ * registers as t[dst1] |= t[src] and t[dst2] |= t[src];
+ * dst1 is DX, dst2 is AX, and src is a 16-bit register 
+ * (e.g., CX, BX, ...)
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_ternary_opw(thread_ctx_t *thread_ctx, uint32_t src)
+{
+	/* temporary tag value */
+	uint16_t tmp_tag = *((uint16_t *)&thread_ctx->vcpu.gpr[src]);
+
+	/* update the destination (ternary) */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[5])	|= tmp_tag;
+	*((uint16_t *)&thread_ctx->vcpu.gpr[7])	|= tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between among three 32-bit 
+ * registers as t[dst1] |= t[src] and t[dst2] |= t[src];
+ * dst1 is EDX, dst2 is EAX, and src is a 32-bit register
+ * (e.g., ECX, EBX, ...)
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_ternary_opl(thread_ctx_t *thread_ctx, uint32_t src)
+{ 
+	/* temporary tag value */
+	uint32_t tmp_tag = thread_ctx->vcpu.gpr[src];
+
+	/* update the destinations */
+	thread_ctx->vcpu.gpr[5] =
+		VCPU_ZX32(thread_ctx->vcpu.gpr[5] | tmp_tag);
+	thread_ctx->vcpu.gpr[7] =
+		VCPU_ZX32(thread_ctx->vcpu.gpr[7] | tmp_tag);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag among two 8-bit registers
+ * and an 8-bit memory location as t[dst] |= t[src];
+ * dst is AX, whereas src is an 8-bit memory location
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_ternary_opb(thread_ctx_t *thread_ctx, ADDRINT src)
+{
+	/* temporary tag value */
+	uint8_t tmp_tag = tag_ldb(src);
+	
+	/* update the destination (ternary) */
+	*((uint8_t *)&thread_ctx->vcpu.gpr[7])		|= tmp_tag;
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[7]) + 1)	|= tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag among two 16-bit registers
+ * and a 16-bit memory address as
+ * t[dst1] |= t[src] and t[dst1] |= t[src];
+ *
+ * dst1 is DX, dst2 is AX, and src is a 16-bit
+ * memory location
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_ternary_opw(thread_ctx_t *thread_ctx, ADDRINT src)
+{
+	/* temporary tag value */
+	uint16_t tmp_tag = tag_ldw(src);
+	
+	/* update the destination (ternary) */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[5])	|= tmp_tag;
+	*((uint16_t *)&thread_ctx->vcpu.gpr[7])	|= tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag among two 32-bit 
+ * registers and a 32-bit memory as
+ * t[dst1] |= t[src] and t[dst2] |= t[src];
+ * dst1 is EDX, dst2 is EAX, and src is a 32-bit
+ * memory location
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_ternary_opl(thread_ctx_t *thread_ctx, ADDRINT src)
+{
+	/* temporary tag value */
+	uint32_t tmp_tag = tag_ldl(src);
+	
+	/* update the destinations */
+	thread_ctx->vcpu.gpr[5] =
+		VCPU_ZX32(thread_ctx->vcpu.gpr[5] | tmp_tag);
+	thread_ctx->vcpu.gpr[7] =
+		VCPU_ZX32(thread_ctx->vcpu.gpr[7] | tmp_tag);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 8-bit 
+ * registers as t[upper(dst)] |= t[lower(src)];
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_binary_opb_ul(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1) |=
+		*((uint8_t *)&thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 8-bit 
+ * registers as t[lower(dst)] |= t[upper(src)];
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_binary_opb_lu(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	*((uint8_t *)&thread_ctx->vcpu.gpr[dst]) |=
+		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 8-bit 
+ * registers as t[upper(dst)] |= t[upper(src)]
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_binary_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1) |=
+		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 8-bit 
+ * registers as t[lower(dst)] |= t[lower(src)]
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_binary_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	*((uint8_t *)&thread_ctx->vcpu.gpr[dst]) |=
+		*((uint8_t *)&thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 16-bit registers
+ * as t[dst] |= t[src]
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_binary_opw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	*((uint16_t *)&thread_ctx->vcpu.gpr[dst]) |=
+		*((uint16_t *)&thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 32-bit 
+ * registers as t[dst] |= t[src]
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_binary_opl(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	thread_ctx->vcpu.gpr[dst] =
+		VCPU_ZX32(thread_ctx->vcpu.gpr[dst] |
+				thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between an 8-bit 
+ * register and a memory location as
+ * t[upper(dst)] |= t[src] (dst is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_binary_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1) |=
+		tag_ldb(src);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between an 8-bit 
+ * register and a memory location as
+ * t[lower(dst)] |= t[src] (dst is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_binary_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	*((uint8_t *)&thread_ctx->vcpu.gpr[dst]) |=
+		tag_ldb(src);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 16-bit 
+ * register and a memory location as
+ * t[dst] |= t[src] (dst is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_binary_opw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	*((uint16_t *)&thread_ctx->vcpu.gpr[dst]) |=
+		tag_ldw(src);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 32-bit 
+ * register and a memory location as
+ * t[dst] |= t[src] (dst is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_binary_opl(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	thread_ctx->vcpu.gpr[dst] =
+		VCPU_ZX32(thread_ctx->vcpu.gpr[dst] | tag_ldl(src));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between an 8-bit 
+ * register and a memory location as
+ * t[dst] |= t[upper(src)] (src is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_binary_opb_u(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	tag_orb(dst, 
+		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between an 8-bit 
+ * register and a memory location as
+ * t[dst] |= t[lower(src)] (src is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_binary_opb_l(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	tag_orb(dst, 
+		*((uint8_t *)&thread_ctx->vcpu.gpr[src]));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 16-bit 
+ * register and a memory location as
+ * t[dst] |= t[src] (src is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_binary_opw(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	tag_orw(dst, 
+		*((uint16_t *)&thread_ctx->vcpu.gpr[src]));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 32-bit 
+ * register and a memory location as
+ * t[dst] |= t[src] (src is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_binary_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	tag_orl(dst,
+		thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tag of EAX, EBX, ECX, EDX
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU) 
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r_clrl4(thread_ctx_t *thread_ctx)
+{
+	thread_ctx->vcpu.gpr[4] = TAG_ZERO;
+	thread_ctx->vcpu.gpr[5] = TAG_ZERO;
+	thread_ctx->vcpu.gpr[6] = TAG_ZERO;
+	thread_ctx->vcpu.gpr[7] = TAG_ZERO;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tag of EAX, EDX
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU) 
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r_clrl2(thread_ctx_t *thread_ctx)
+{
+	thread_ctx->vcpu.gpr[5] = TAG_ZERO;
+	thread_ctx->vcpu.gpr[7] = TAG_ZERO;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tag of a 32-bit register
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU) 
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r_clrl(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+	thread_ctx->vcpu.gpr[reg] = TAG_ZERO;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tag of a 16-bit register
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU) 
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r_clrw(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+	*((uint16_t *)&thread_ctx->vcpu.gpr[reg]) = TAG_ZERO;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tag of an upper 8-bit register
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU) 
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r_clrb_u(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[reg]) + 1) = TAG_ZERO;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tag of a lower 8-bit register
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU) 
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r_clrb_l(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+	*((uint8_t *)&thread_ctx->vcpu.gpr[reg]) = TAG_ZERO;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 8-bit 
+ * registers as t[upper(dst)] = t[lower(src)]
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_xfer_opb_ul(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1) =
+		*((uint8_t *)&thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 8-bit 
+ * registers as t[lower(dst)] = t[upper(src)];
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_xfer_opb_lu(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	*((uint8_t *)&thread_ctx->vcpu.gpr[dst]) =
+		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 8-bit 
+ * registers as t[upper(dst)] = t[upper(src)]
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_xfer_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1) =
+		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 8-bit 
+ * registers as t[lower(dst)] = t[lower(src)]
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_xfer_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	*((uint8_t *)&thread_ctx->vcpu.gpr[dst]) =
+		*((uint8_t *)&thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 16-bit 
+ * registers as t[dst] = t[src]
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_xfer_opw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	*((uint16_t *)&thread_ctx->vcpu.gpr[dst]) =
+		*((uint16_t *)&thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 32-bit 
+ * registers as t[dst] = t[src]
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_xfer_opl(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	thread_ctx->vcpu.gpr[dst] = VCPU_ZX32(thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between an upper 8-bit 
+ * register and a memory location as
+ * t[dst] = t[src] (dst is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_xfer_opb_u(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	*(((uint8_t *)&thread_ctx->vcpu.gpr[dst]) + 1) =
+		tag_ldb(src);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a lower 8-bit 
+ * register and a memory location as
+ * t[dst] = t[src] (dst is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_xfer_opb_l(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	*((uint8_t *)&thread_ctx->vcpu.gpr[dst]) =
+		tag_ldb(src);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 16-bit 
+ * register and a memory location as
+ * t[dst] = t[src] (dst is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_xfer_opw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	*((uint16_t *)&thread_ctx->vcpu.gpr[dst]) =
+		tag_ldw(src);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 32-bit 
+ * register and a memory location as
+ * t[dst] = t[src] (dst is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_xfer_opl(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	thread_ctx->vcpu.gpr[dst] = tag_ldl(src);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a register and n
+ * elements of sz bytes in memory as t[dst] = t[src];
+ * REP STOS (src is AL, AX, EAX, or RAX). The whole
+ * range is tagged at once (i.e., before the first repetition)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @count:	memory elements
+ * @eflags:	the value of the EFLAGS register
+ * @sz:		the size of an element (bytes)
+ */
+static inline void
+r2m_filln(thread_ctx_t *thread_ctx,
+		ADDRINT dst,
+		ADDRINT count,
+		ADDRINT eflags,
+		size_t sz)
+{
+	/* the tags of the source register */
+	const uint8_t	*tag	= (const uint8_t *)&thread_ctx->vcpu.gpr[7];
+	size_t		i;
+
+	/* nothing to do; optimized branch */
+	if (unlikely(count == 0))
+		return;
+
+	/* EFLAGS.DF = 1; start from the last element */
+	if (unlikely(EFLAGS_DF(eflags) != 0))
+		dst -= (count - 1) * sz;
+
+	/* the same tag in every byte (e.g., memset(), calloc()) */
+	for (i = 1; i < sz && tag[i] == tag[0]; i++);
+	if (likely(i == sz)) {
+		tagmap_setn(dst, count * sz, tag[0]);
+		return;
+	}
+
+	/* different tags; byte by byte */
+	for (i = 0; i < count * sz; i++)
+		tag_stb(dst + i, tag[i % sz]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between an 8-bit 
+ * register and a n-memory locations as
+ * t[dst] = t[src]; src is AL
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @count:	memory bytes
+ * @eflags:	the value of the EFLAGS register
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_xfer_opbn(thread_ctx_t *thread_ctx,
+		ADDRINT dst,
+		ADDRINT count,
+		ADDRINT eflags)
+{
+	r2m_filln(thread_ctx, dst, count, eflags, 1);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between an 8-bit 
+ * register and a memory location as
+ * t[dst] = t[upper(src)] (src is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_xfer_opb_u(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	tag_stb(dst,
+		*(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between an 8-bit 
+ * register and a memory location as
+ * t[dst] = t[lower(src)] (src is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_xfer_opb_l(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	tag_stb(dst,
+		*((uint8_t *)&thread_ctx->vcpu.gpr[src]));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 16-bit 
+ * register and a n-memory locations as
+ * t[dst] = t[src]; src is AX
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @count:	memory words
+ * @eflags:	the value of the EFLAGS register
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_xfer_opwn(thread_ctx_t *thread_ctx,
+		ADDRINT dst,
+		ADDRINT count,
+		ADDRINT eflags)
+{
+	r2m_filln(thread_ctx, dst, count, eflags, 2);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 16-bit 
+ * register and a memory location as
+ * t[dst] = t[src] (src is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_xfer_opw(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	tag_stw(dst,
+		*((uint16_t *)&thread_ctx->vcpu.gpr[src]));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 32-bit 
+ * register and a n-memory locations as
+ * t[dst] = t[src]; src is EAX
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @count:	memory double words
+ * @eflags:	the value of the EFLAGS register
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_xfer_opln(thread_ctx_t *thread_ctx,
+		ADDRINT dst,
+		ADDRINT count,
+		ADDRINT eflags)
+{
+	r2m_filln(thread_ctx, dst, count, eflags, 4);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 32-bit 
+ * register and a memory location as
+ * t[dst] = t[src] (src is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_xfer_opl(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	tag_stl(dst,
+		thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 16-bit 
+ * memory locations as t[dst] = t[src]
+ *
+ * @dst:	destination memory address
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2m_xfer_opw(ADDRINT dst, ADDRINT src)
+{
+	tag_stw(dst,
+		tag_ldw(src));
+	
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 8-bit 
+ * memory locations as t[dst] = t[src]
+ *
+ * @dst:	destination memory address
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2m_xfer_opb(ADDRINT dst, ADDRINT src)
+{
+	tag_stb(dst,
+		tag_ldb(src));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 32-bit 
+ * memory locations as t[dst] = t[src]
+ *
+ * @dst:	destination memory address
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2m_xfer_opl(ADDRINT dst, ADDRINT src)
+{
+	tag_stl(dst,
+		tag_ldl(src));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between n 16-bit 
+ * memory locations as t[dst] = t[src]
+ *
+ * @dst:	destination memory address
+ * @src:	source memory address
+ * @count:	memory words
+ * @eflags:	the value of the EFLAGS register
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2m_xfer_opwn(ADDRINT dst, ADDRINT src, uint32_t count, uint32_t eflags)
+{
+	if (likely(EFLAGS_DF(eflags) == 0))
+		/* EFLAGS.DF = 0 */
+		tagmap_copyn(dst, src, count << 1);
+	else
+		/* EFLAGS.DF = 1 */
+		tagmap_copyn(dst - ((count - 1) << 1),
+				src - ((count - 1) << 1), count << 1);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between n 8-bit 
+ * memory locations as t[dst] = t[src]
+ *
+ * @dst:	destination memory address
+ * @src:	source memory address
+ * @count:	memory bytes
+ * @eflags:	the value of the EFLAGS register
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2m_xfer_opbn(ADDRINT dst, ADDRINT src, uint32_t count, uint32_t eflags)
+{
+	if (likely(EFLAGS_DF(eflags) == 0))
+		/* EFLAGS.DF = 0 */
+		tagmap_copyn(dst, src, count);
+	else
+		/* EFLAGS.DF = 1 */
+		tagmap_copyn(dst - count + 1, src - count + 1, count);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between n 32-bit 
+ * memory locations as t[dst] = t[src]
+ *
+ * @dst:	destination memory address
+ * @src:	source memory address
+ * @count:	memory double words
+ * @eflags:	the value of the EFLAGS register
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2m_xfer_opln(ADDRINT dst, ADDRINT src, uint32_t count, uint32_t eflags)
+{
+	if (likely(EFLAGS_DF(eflags) == 0))
+		/* EFLAGS.DF = 0 */
+		tagmap_copyn(dst, src, count << 2);
+	else
+		/* EFLAGS.DF = 1 */
+		tagmap_copyn(dst - ((count - 1) << 2),
+				src - ((count - 1) << 2), count << 2);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * restore the tag values for all the
+ * 16-bit general purpose registers from
+ * the memory
+ *
+ * NOTE: special case for POPA instruction 
+ *
+ * @thread_ctx:	the thread context
+ * @src:	the source memory address	
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_restore_opw(thread_ctx_t *thread_ctx, ADDRINT src)
+{
+	/* restore DI */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[0]) = tag_ldw(src);
+	
+	/* restore SI */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[1]) = tag_ldw(src + 2);
+	
+	/* restore BP */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[2]) = tag_ldw(src + 4);
+	
+	/* SP is ignored */
+	
+	/* restore BX */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[4]) = tag_ldw(src + 8);
+	
+	/* restore DX */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[5]) = tag_ldw(src + 10);
+	
+	/* restore CX */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[6]) = tag_ldw(src + 12);
+	
+	/* restore AX */
+	*((uint16_t *)&thread_ctx->vcpu.gpr[7]) = tag_ldw(src + 14);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * restore the tag values for all the
+ * 32-bit general purpose registers from
+ * the memory
+ *
+ * NOTE: special case for POPAD instruction 
+ *
+ * @thread_ctx:	the thread context
+ * @src:	the source memory address	
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_restore_opl(thread_ctx_t *thread_ctx, ADDRINT src)
+{
+	/* restore EDI */
+	thread_ctx->vcpu.gpr[0] = tag_ldl(src);
+
+	/* restore ESI */
+	thread_ctx->vcpu.gpr[1] = tag_ldl(src + 4);
+	
+	/* restore EBP */
+	thread_ctx->vcpu.gpr[2] = tag_ldl(src + 8);
+
+	/* ESP is ignored */
+	
+	/* restore EBX */
+	thread_ctx->vcpu.gpr[4] = tag_ldl(src + 16);
+	
+	/* restore EDX */
+	thread_ctx->vcpu.gpr[5] = tag_ldl(src + 20);
+	
+	/* restore ECX */
+	thread_ctx->vcpu.gpr[6] = tag_ldl(src + 24);
+	
+	/* restore EAX */
+	thread_ctx->vcpu.gpr[7] = tag_ldl(src + 28);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * save the tag values for all the 16-bit
+ * general purpose registers into the memory
+ *
+ * NOTE: special case for PUSHA instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	the destination memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_save_opw(thread_ctx_t *thread_ctx, ADDRINT dst)
+{
+	/* save DI */
+	tag_stw(dst, *((uint16_t *)&thread_ctx->vcpu.gpr[0]));
+
+	/* save SI */
+	tag_stw(dst + 2, *((uint16_t *)&thread_ctx->vcpu.gpr[1]));
+
+	/* save BP */
+	tag_stw(dst + 4, *((uint16_t *)&thread_ctx->vcpu.gpr[2]));
+
+	/* save SP */
+	tag_stw(dst + 6, *((uint16_t *)&thread_ctx->vcpu.gpr[3]));
+
+	/* save BX */
+	tag_stw(dst + 8, *((uint16_t *)&thread_ctx->vcpu.gpr[4]));
+
+	/* save DX */
+	tag_stw(dst + 10, *((uint16_t *)&thread_ctx->vcpu.gpr[5]));
+
+	/* save CX */
+	tag_stw(dst + 12, *((uint16_t *)&thread_ctx->vcpu.gpr[6]));
+
+	/* save AX */
+	tag_stw(dst + 14, *((uint16_t *)&thread_ctx->vcpu.gpr[7]));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * save the tag values for all the 32-bit
+ * general purpose registers into the memory
+ *
+ * NOTE: special case for PUSHAD instruction 
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	the destination memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_save_opl(thread_ctx_t *thread_ctx, ADDRINT dst)
+{
+	/* save EDI */
+	tag_stl(dst, thread_ctx->vcpu.gpr[0]);
+
+	/* save ESI */
+	tag_stl(dst + 4, thread_ctx->vcpu.gpr[1]);
+
+	/* save EBP */
+	tag_stl(dst + 8, thread_ctx->vcpu.gpr[2]);
+
+	/* save ESP */
+	tag_stl(dst + 12, thread_ctx->vcpu.gpr[3]);
+
+	/* save EBX */
+	tag_stl(dst + 16, thread_ctx->vcpu.gpr[4]);
+
+	/* save EDX */
+	tag_stl(dst + 20, thread_ctx->vcpu.gpr[5]);
+
+	/* save ECX */
+	tag_stl(dst + 24, thread_ctx->vcpu.gpr[6]);
+
+	/* save EAX */
+	tag_stl(dst + 28, thread_ctx->vcpu.gpr[7]);
+}
+
+#if defined(TARGET_IA32E)
+/*
+ * tag propagation (analysis function)
+ *
+ * extend the tag as follows: t[upper(rax)] = t[eax]
+ *
+ * NOTE: special case for the CDQE instruction
+ *
+ * @thread_ctx:	the thread context
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_cdqe(thread_ctx_t *thread_ctx)
+{
+	*(((uint32_t *)&thread_ctx->vcpu.gpr[7]) + 1) =
+		*((uint32_t *)&thread_ctx->vcpu.gpr[7]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 64-bit register
+ * and an upper 8-bit register as t[dst] = t[upper(src)]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movsx_r2r_opqb_u(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint8_t src_tag = *(((uint8_t *)&thread_ctx->vcpu.gpr[src]) + 1);
+
+	/* update the destination (xfer) */
+	thread_ctx->vcpu.gpr[dst] = src_tag * 0x0101010101010101ULL;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 64-bit register
+ * and a lower 8-bit register as t[dst] = t[lower(src)]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movsx_r2r_opqb_l(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint8_t src_tag = *((uint8_t *)&thread_ctx->vcpu.gpr[src]);
+
+	/* update the destination (xfer) */
+	thread_ctx->vcpu.gpr[dst] = src_tag * 0x0101010101010101ULL;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 64-bit register
+ * and a 16-bit register as t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movsx_r2r_opqw(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint16_t src_tag = *((uint16_t *)&thread_ctx->vcpu.gpr[src]);
+
+	/* update the destination (xfer) */
+	thread_ctx->vcpu.gpr[dst] = src_tag * 0x0001000100010001ULL;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 64-bit register
+ * and a 32-bit register as t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSXD instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movsx_r2r_opql(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint32_t src_tag = *((uint32_t *)&thread_ctx->vcpu.gpr[src]);
+
+	/* update the destination (xfer) */
+	thread_ctx->vcpu.gpr[dst] = src_tag * 0x0000000100000001ULL;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 64-bit
+ * register and an 8-bit memory location as
+ * t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movsx_m2r_opqb(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	thread_ctx->vcpu.gpr[dst] = tag_ldb(src) * 0x0101010101010101ULL;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 64-bit
+ * register and a 16-bit memory location as
+ * t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSX instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movsx_m2r_opqw(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	thread_ctx->vcpu.gpr[dst] = tag_ldw(src) * 0x0001000100010001ULL;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate and extend tag between a 64-bit
+ * register and a 32-bit memory location as
+ * t[dst] = t[src]
+ *
+ * NOTE: special case for MOVSXD instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_movsx_m2r_opql(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	thread_ctx->vcpu.gpr[dst] = tag_ldl(src) * 0x0000000100000001ULL;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 64-bit
+ * registers as t[RAX] = t[src]; return
+ * the result of RAX == src and also
+ * store the original tag value of
+ * RAX in the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst_val:	RAX register value
+ * @src:	source register index (VCPU)
+ * @src_val:	source register value
+ */
+static ADDRINT PIN_FAST_ANALYSIS_CALL
+_cmpxchg_r2r_opq_fast(thread_ctx_t *thread_ctx, ADDRINT dst_val, uint32_t src,
+							ADDRINT src_val)
+{
+	/* save the tag value of dst in the scratch register */
+	thread_ctx->vcpu.gpr[GPR_SCRATCH] = 
+		thread_ctx->vcpu.gpr[7];
+	
+	/* update */
+	thread_ctx->vcpu.gpr[7] =
+		thread_ctx->vcpu.gpr[src];
+
+	/* compare the dst and src values */
+	return (dst_val == src_val);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 64-bit 
+ * registers as t[dst] = t[src]; restore the
+ * value of RAX from the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_cmpxchg_r2r_opq_slow(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	/* restore the tag value from the scratch register */
+	thread_ctx->vcpu.gpr[7] = 
+		thread_ctx->vcpu.gpr[GPR_SCRATCH];
+	
+	/* update */
+	thread_ctx->vcpu.gpr[dst] =
+		thread_ctx->vcpu.gpr[src];
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 64-bit 
+ * register and a memory location as
+ * t[RAX] = t[src]; return the result
+ * of RAX == src and also store the
+ * original tag value of RAX in
+ * the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst_val:	destination register value
+ * @src:	source memory address
+ */
+static ADDRINT PIN_FAST_ANALYSIS_CALL
+_cmpxchg_m2r_opq_fast(thread_ctx_t *thread_ctx, ADDRINT dst_val, ADDRINT src)
+{
+	/* save the tag value of dst in the scratch register */
+	thread_ctx->vcpu.gpr[GPR_SCRATCH] = 
+		thread_ctx->vcpu.gpr[7];
+	
+	/* update */
+	thread_ctx->vcpu.gpr[7] = 
+		tag_ldq(src);
+	
+	/* compare the dst and src values; the original values the tag bits */
+	return (dst_val == *(ADDRINT *)src);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 64-bit 
+ * register and a memory location as
+ * t[dst] = t[src]; restore the value
+ * of RAX from the scratch register
+ *
+ * NOTE: special case for the CMPXCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_cmpxchg_r2m_opq_slow(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	/* restore the tag value from the scratch register */
+	thread_ctx->vcpu.gpr[7] = 
+		thread_ctx->vcpu.gpr[GPR_SCRATCH];
+	
+	/* update */
+	tag_stq(dst,
+		thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * exchange the tags between a 64-bit 
+ * register and a memory location as
+ * t[dst] = t[src] and t[src] = t[dst]
+ * (dst is a memory address)
+ *
+ * NOTE: special case for the XCHG instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_xchg_r2m_opq(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint64_t tmp_tag = tag_ldq(dst);
+
+	/* swap */
+	tag_stq(dst,
+		thread_ctx->vcpu.gpr[src]);
+		
+	thread_ctx->vcpu.gpr[src] = tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * exchange the tags between a 64-bit 
+ * register and a memory location as
+ * t[dst] |= t[src] and t[src] = t[dst]
+ * (dst is a memory address)
+ *
+ * NOTE: special case for the XADD instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_xadd_r2m_opq(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	/* temporary tag value */
+	uint64_t tmp_tag = tag_ldq(dst);
+
+	/* swap */
+	tag_orq(dst,
+		thread_ctx->vcpu.gpr[src]);
+		
+	thread_ctx->vcpu.gpr[src] = tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between three 64-bit 
+ * registers as t[dst] = t[base] | t[index]
+ *
+ * NOTE: special case for the LEA instruction
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @base:	base register index (VCPU)
+ * @index:	index register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+_lea_r2r_opq(thread_ctx_t *thread_ctx,
+		uint32_t dst,
+		uint32_t base,
+		uint32_t index)
+{
+	/* update the destination */
+	thread_ctx->vcpu.gpr[dst] =
+		thread_ctx->vcpu.gpr[base] | thread_ctx->vcpu.gpr[index]; 
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between among three 64-bit 
+ * registers as t[dst1] |= t[src] and t[dst2] |= t[src];
+ * dst1 is RDX, dst2 is RAX, and src is a 64-bit register
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_ternary_opq(thread_ctx_t *thread_ctx, uint32_t src)
+{ 
+	/* temporary tag value */
+	uint64_t tmp_tag = thread_ctx->vcpu.gpr[src];
+
+	/* update the destinations */
+	thread_ctx->vcpu.gpr[5] |= tmp_tag;
+	thread_ctx->vcpu.gpr[7] |= tmp_tag; 
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag among two 64-bit registers
+ * and a 64-bit memory location as t[dst] |= t[src];
+ * dst1 is RDX, dst2 is RAX, whereas src is a 64-bit
+ * memory location
+ *
+ * NOTE: special case for DIV and IDIV instructions
+ *
+ * @thread_ctx:	the thread context
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_ternary_opq(thread_ctx_t *thread_ctx, ADDRINT src)
+{
+	/* temporary tag value */
+	uint64_t tmp_tag = tag_ldq(src);
+	
+	/* update the destinations */
+	thread_ctx->vcpu.gpr[5] |= tmp_tag;
+	thread_ctx->vcpu.gpr[7] |= tmp_tag;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 64-bit 
+ * registers as t[dst] |= t[src]
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_binary_opq(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	thread_ctx->vcpu.gpr[dst] |= thread_ctx->vcpu.gpr[src];
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 64-bit 
+ * register and a memory location as
+ * t[dst] |= t[src] (dst is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_binary_opq(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	thread_ctx->vcpu.gpr[dst] |=
+		tag_ldq(src);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 64-bit 
+ * register and a memory location as
+ * t[dst] |= t[src] (src is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_binary_opq(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	tag_orq(dst,
+		thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tag of a 64-bit register
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU) 
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r_clrq(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+	thread_ctx->vcpu.gpr[reg] = TAG_ZERO;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * zero-extend the tag of a 32-bit register; a 32-bit
+ * operation clears the upper half of its 64-bit register
+ *
+ * @thread_ctx:	the thread context
+ * @reg:	register index (VCPU) 
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r_zxl(thread_ctx_t *thread_ctx, uint32_t reg)
+{
+	thread_ctx->vcpu.gpr[reg] = VCPU_ZX32(thread_ctx->vcpu.gpr[reg]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 64-bit 
+ * registers as t[dst] = t[src]
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2r_xfer_opq(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src)
+{
+	thread_ctx->vcpu.gpr[dst] = thread_ctx->vcpu.gpr[src];
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 64-bit 
+ * register and a memory location as
+ * t[dst] = t[src] (dst is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register index (VCPU)
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2r_xfer_opq(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src)
+{
+	thread_ctx->vcpu.gpr[dst] = tag_ldq(src);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 64-bit 
+ * register and a memory location as
+ * t[dst] = t[src] (src is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register index (VCPU)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_xfer_opq(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src)
+{
+	tag_stq(dst,
+		thread_ctx->vcpu.gpr[src]);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between a 64-bit 
+ * register and a n-memory locations as
+ * t[dst] = t[src]; src is RAX
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @count:	memory quad words
+ * @eflags:	the value of the EFLAGS register
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r2m_xfer_opqn(thread_ctx_t *thread_ctx,
+		ADDRINT dst,
+		ADDRINT count,
+		ADDRINT eflags)
+{
+	r2m_filln(thread_ctx, dst, count, eflags, 8);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between two 64-bit 
+ * memory locations as t[dst] = t[src]
+ *
+ * @dst:	destination memory address
+ * @src:	source memory address
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2m_xfer_opq(ADDRINT dst, ADDRINT src)
+{
+	tag_stq(dst,
+		tag_ldq(src));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate tag between n 64-bit 
+ * memory locations as t[dst] = t[src]
+ *
+ * @dst:	destination memory address
+ * @src:	source memory address
+ * @count:	memory quad words
+ * @eflags:	the value of the EFLAGS register
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2m_xfer_opqn(ADDRINT dst, ADDRINT src, ADDRINT count, ADDRINT eflags)
+{
+	if (likely(EFLAGS_DF(eflags) == 0))
+		/* EFLAGS.DF = 0 */
+		tagmap_copyn(dst, src, count << 3);
+	else
+		/* EFLAGS.DF = 1 */
+		tagmap_copyn(dst - ((count - 1) << 3),
+				src - ((count - 1) << 3), count << 3);
+}
+#endif
+#endif
+
+#ifndef	TAGMAP_LABEL
+/*
+ * BBL-level taint-transfer IR (see ins_coalesce())
+ *
+ * the tag effect of the simple data movement instructions (mov, lea,
+ * push, pop, and the binary ALU ones) is described at instrumentation
+ * time, and every run of them within a BBL is propagated by a single
+ * summary call instead of one call per instruction. The register ones
+ * are folded (copy propagation) into t[dst] = t[src1] | t[src2] | ...,
+ * over the tags at the start of the run; the memory ones that share a
+ * base register are kept in order, as offsets off its value at the
+ * start of the run, with the adjacent clears merged into one
+ */
+#define IR_MEM_MAX	16			/* memory operations per run */
+
+/* a set of VCPU registers; the low ones are zero-extended (x86-64) */
+typedef struct {
+	uint32_t	full;			/* t[reg] */
+	uint32_t	low;			/* zx32(t[reg]) */
+} ir_set_t;
+
+/* register run; t[dst] = t[full] | zx32(t[low]) */
+typedef struct {
+	uint32_t	n;			/* assignments */
+	struct {
+		uint32_t	dst;		/* destination (VCPU) */
+		ir_set_t	src;		/* sources (VCPU) */
+	} op[GRP_NUM];
+} ir_reg_t;
+
+/* memory operations */
+enum {
+/* #define */ IR_MEM_LD = 0,		/* t[reg] = t[base + off] */
+/* #define */ IR_MEM_ST = 1,		/* t[base + off] = t[reg] */
+/* #define */ IR_MEM_CLR = 2		/* t[base + off] = 0 */
+};
+
+/* memory run; the operations at base + off, in order */
+typedef struct {
+	uint32_t	n;			/* operations */
+	struct {
+		uint32_t	kind;		/* IR_MEM_{LD, ST, CLR} */
+		uint32_t	reg;		/* register (VCPU) */
+		size_t		len;		/* bytes */
+		ADDRINT		off;		/* offset from the base */
+	} op[IR_MEM_MAX];
+} ir_mem_t;
+
+/* the size of the first n assignments/operations of a summary */
+#define IR_REG_SZ(n)	\
+	(offsetof(ir_reg_t, op) + (n) * sizeof(((ir_reg_t *)0)->op[0]))
+#define IR_MEM_SZ(n)	\
+	(offsetof(ir_mem_t, op) + (n) * sizeof(((ir_mem_t *)0)->op[0]))
+
+/*
+ * the summaries that are passed (IARG_PTR) to r_summary() and
+ * m_summary(); they must outlive the code cache copies of their
+ * traces, and they are interned so that a trace that is instrumented
+ * again (e.g., after a code cache flush, or in another version) reuses
+ * them instead of leaking a new copy each time. The pool is bounded by
+ * the distinct runs of the program, and instrumentation is serialized
+ * by PIN (client lock)
+ */
+static set<string> ir_pool;
+
+/*
+ * intern a summary
+ *
+ * @ir:		the summary
+ * @len:	its size in bytes
+ *
+ * returns:	the pooled copy; it is never shorter than the inline
+ *		buffer of a string, and hence it is heap allocated (aligned)
+ */
+static const void *
+ir_intern(const void *ir, size_t len)
+{
+	return ir_pool.insert(string((const char *)ir, len)).first->data();
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate the tags of a register run (see ir_reg_t); every
+ * assignment reads the tags of the start of the run
+ *
+ * @thread_ctx:	the thread context
+ * @ir:		the assignments
+ */
+static void PIN_FAST_ANALYSIS_CALL
+r_summary(thread_ctx_t *thread_ctx, const ir_reg_t *ir)
+{
+	/* the tags at the start of the run */
+	gpr_tag_t tags[GRP_NUM];
+
+	gpr_tag_t	tag;	/* new tag	*/
+	uint32_t	i, s;	/* iterators	*/
+
+	(void)memcpy(tags, thread_ctx->vcpu.gpr, sizeof(tags));
+
+	for (i = 0; i < ir->n; i++) {
+		tag = TAG_ZERO;
+		for (s = ir->op[i].src.full; s != 0; s &= s - 1)
+			tag |= tags[__builtin_ctz(s)];
+		for (s = ir->op[i].src.low; s != 0; s &= s - 1)
+			tag |= VCPU_ZX32(tags[__builtin_ctz(s)]);
+		thread_ctx->vcpu.gpr[ir->op[i].dst] = tag;
+	}
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate the tags of a memory run (see ir_mem_t)
+ *
+ * @thread_ctx:	the thread context
+ * @base:	the value of the base register at the start of the run
+ * @ir:		the operations
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m_summary(thread_ctx_t *thread_ctx, ADDRINT base, const ir_mem_t *ir)
+{
+	ADDRINT		addr;	/* the address	*/
+	uint32_t	i;	/* iterator	*/
+
+	for (i = 0; i < ir->n; i++) {
+		addr = base + ir->op[i].off;
+
+		switch (ir->op[i].kind) {
+			case IR_MEM_LD:
+#if defined(TARGET_IA32E)
+				if (ir->op[i].len == BIT2BYTE(MEM_QUAD_LEN)) {
+					thread_ctx->vcpu.gpr[ir->op[i].reg] =
+						tag_ldq(addr);
+					break;
 				}
-			}
-			/* both operands are registers */
-			else if (INS_MemoryOperandCount(ins) == 0) {
-				/* extract the operands */
-				reg_dst = INS_OperandReg(ins, OP_0);
-				reg_src = INS_OperandReg(ins, OP_1);
-				
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_dst))
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opl,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-					IARG_UINT32, REG32_INDX(reg_dst),
-					IARG_UINT32, REG32_INDX(reg_src),
-						IARG_END);
-				/* 16-bit operands */
-				else if (REG_is_gr16(reg_dst))
-					/* propagate tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opw,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-					IARG_UINT32, REG16_INDX(reg_dst),
-					IARG_UINT32, REG16_INDX(reg_src),
-						IARG_END);
-				/* 8-bit operands */
-				else if (REG_is_gr8(reg_dst)) {
-					/* propagate tag accordingly */
-					if (REG_is_Lower8(reg_dst) &&
-							REG_is_Lower8(reg_src))
-						/* lower 8-bit registers */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opb_l,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, REG8_INDX(reg_dst),
-						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_END);
-					else if(REG_is_Upper8(reg_dst) &&
-							REG_is_Upper8(reg_src))
-						/* upper 8-bit registers */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opb_u,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, REG8_INDX(reg_dst),
-						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_END);
-					else if (REG_is_Lower8(reg_dst))
-						/* 
-						 * destination register is a
-						 * lower 8-bit register and
-						 * source register is an upper
-						 * 8-bit register
-						 */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opb_lu,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, REG8_INDX(reg_dst),
-						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_END);
-					else
-						/* 
-						 * destination register is an
-						 * upper 8-bit register and
-						 * source register is a lower
-						 * 8-bit register
-						 */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opb_ul,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, REG8_INDX(reg_dst),
-						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_END);
+#endif
+				thread_ctx->vcpu.gpr[ir->op[i].reg] =
+					tag_ldl(addr);
+				break;
+			case IR_MEM_ST:
+#if defined(TARGET_IA32E)
+				if (ir->op[i].len == BIT2BYTE(MEM_QUAD_LEN)) {
+					tag_stq(addr,
+					thread_ctx->vcpu.gpr[ir->op[i].reg]);
+					break;
 				}
-			}
-			/* 
-			 * 2nd operand is memory;
-			 * we optimize for that case, since most
-			 * instructions will have a register as
-			 * the first operand -- leave the result
-			 * into the reg and use it later
-			 */
-			else if (INS_OperandIsMemory(ins, OP_1)) {
-				/* extract the register operand */
-				reg_dst = INS_OperandReg(ins, OP_0);
+#endif
+				tag_stl(addr,
+					thread_ctx->vcpu.gpr[ir->op[i].reg]);
+				break;
+			default:
+				tagmap_clrn(addr, ir->op[i].len);
+				break;
+		}
+	}
+}
+#endif
+
+/*
+ * SIMD (SSE, AVX, MMX) and x87 tag propagation
+ *
+ * the analysis functions below operate on the tags of a register in the
+ * register format (see vec_tag_t), which is given by its offset in the
+ * thread context (see vreg()); hence, the same functions serve the XMM,
+ * the YMM, the MMX, and the GPR operands (e.g., movd, pmovmskb) alike
+ */
+#define VTAG(ctx, off)	((vec_tag_t *)((char *)(ctx) + (off)))
+
+#ifdef	TAGMAP_LABEL
+#define VEC_OR(a, b)	tag_union((a), (b))
+#else
+#define VEC_OR(a, b)	((a) | (b))
+#endif
+#define VEC_MIN(a, b)	(((a) < (b)) ? (a) : (b))
+
+/* permutations (see v2v_shuffle()) */
+#define VEC_PERM_SRC	0x10			/* the source bytes */
+#define VEC_PERM_ZERO	0xFF			/* a clean byte */
+
+/* x87 operations (see x87_op()) */
+#define REG_is_st(reg)	((reg) >= REG_ST_BASE && (reg) <= REG_ST_LAST)
+#define X87_SRC_REG(i)	(1U << (i))		/* ST(i) is read */
+#define X87_DST_REG(i)	(1U << (8 + (i)))	/* ST(i) is written */
+#define X87_PUSH_ONE	(1U << 16)		/* push */
+#define X87_POP_ONE	(1U << 18)		/* pop */
+#define X87_LEN_SHIFT	20			/* memory operand size */
+#define X87_RD		(1U << 24)		/* memory operand is read */
+#define X87_WR		(1U << 25)		/* memory operand is written */
+#define X87_SWAP	(1U << 26)		/* fxch */
+#define X87_MEM_MAX	15			/* max. memory operand size */
+#define X87_SRC(desc)	((desc) & 0xFF)
+#define X87_DST(desc)	(((desc) >> 8) & 0xFF)
+#define X87_PUSH(desc)	(((desc) >> 16) & 0x03)
+#define X87_POP(desc)	(((desc) >> 18) & 0x03)
+#define X87_LEN(desc)	(((desc) >> X87_LEN_SHIFT) & 0x0F)
+
+/*
+ * load the tags of n bytes of memory in the register format
+ *
+ * @vaddr:	the virtual address
+ * @tags:	the tags
+ * @n:		the number of bytes
+ */
+static inline void
+vec_ld(size_t vaddr, vec_tag_t *tags, size_t n)
+{
+#ifdef	TAGMAP_LABEL
+	tag_ldlbln(vaddr, tags, n);
+#else
+	uint32_t tag;	/* 4 tags */
+
+	for (; n >= 4; n -= 4, vaddr += 4, tags += 4) {
+		tag = tag_ldl(vaddr);
+		(void)memcpy(tags, &tag, 4);
+	}
+	for (; n > 0; n--, vaddr++, tags++)
+		*tags = tag_ldb(vaddr);
+#endif
+}
+
+/*
+ * store the tags of n bytes of memory, given in the register format
+ *
+ * @vaddr:	the virtual address
+ * @tags:	the tags
+ * @n:		the number of bytes
+ */
+static inline void
+vec_st(size_t vaddr, const vec_tag_t *tags, size_t n)
+{
+#ifdef	TAGMAP_LABEL
+	tag_stlbln(vaddr, tags, n);
+#else
+	uint32_t tag;	/* 4 tags */
+
+	for (; n >= 4; n -= 4, vaddr += 4, tags += 4) {
+		(void)memcpy(&tag, tags, 4);
+		tag_stl(vaddr, tag);
+	}
+	for (; n > 0; n--, vaddr++, tags++)
+		tag_stb(vaddr, *tags);
+#endif
+}
+
+/* the union of n tags */
+static inline vec_tag_t
+vec_fold(const vec_tag_t *tags, size_t n)
+{
+	vec_tag_t tag = TAG_ZERO;
+
+	while (n-- > 0)
+		tag = VEC_OR(tag, tags[n]);
+
+	return tag;
+}
+
+/* t[dst] |= t[src], per element of e bytes */
+static inline void
+vec_binary(vec_tag_t *dst, const vec_tag_t *src, size_t n, size_t e)
+{
+	vec_tag_t	tag;	/* the tag of an element	*/
+	size_t		i, j;	/* iterators			*/
+
+	for (i = 0; i < n; i += e) {
+		tag = VEC_OR(vec_fold(&dst[i], e), vec_fold(&src[i], e));
+		for (j = 0; j < e; j++)
+			dst[i + j] = tag;
+	}
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate the tags of n bytes between two registers as
+ * t[dst] = t[src], and clear the tags of the next (z - n)
+ * bytes of the destination (zero extension)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register (offset)
+ * @src:	source register (offset)
+ * @n:		the number of bytes
+ * @z:		the number of bytes written to the destination
+ */
+static void PIN_FAST_ANALYSIS_CALL
+v2v_xfer(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src,
+		uint32_t n, uint32_t z)
+{
+	(void)memmove(VTAG(thread_ctx, dst), VTAG(thread_ctx, src),
+			n * sizeof(vec_tag_t));
+	(void)memset(VTAG(thread_ctx, dst) + n, 0,
+			(z - n) * sizeof(vec_tag_t));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate the tags of n bytes between a register and
+ * a memory location as t[dst] = t[src] (dst is a register),
+ * and clear the tags of the next (z - n) bytes of the register
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register (offset)
+ * @src:	source memory address
+ * @n:		the number of bytes
+ * @z:		the number of bytes written to the destination
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2v_xfer(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src,
+		uint32_t n, uint32_t z)
+{
+	vec_ld(src, VTAG(thread_ctx, dst), n);
+	(void)memset(VTAG(thread_ctx, dst) + n, 0,
+			(z - n) * sizeof(vec_tag_t));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate the tags of n bytes between a register and
+ * a memory location as t[dst] = t[src] (src is a register)
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination memory address
+ * @src:	source register (offset)
+ * @n:		the number of bytes
+ */
+static void PIN_FAST_ANALYSIS_CALL
+v2m_xfer(thread_ctx_t *thread_ctx, ADDRINT dst, uint32_t src, uint32_t n)
+{
+	vec_st(dst, VTAG(thread_ctx, src), n);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tags of n bytes of a register
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	the register (offset)
+ * @n:		the number of bytes
+ */
+static void PIN_FAST_ANALYSIS_CALL
+v_clr(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t n)
+{
+	(void)memset(VTAG(thread_ctx, dst), 0, n * sizeof(vec_tag_t));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * vzeroupper, vzeroall; clear the tags of the upper
+ * half of every YMM register, or of the whole of it
+ *
+ * @thread_ctx:	the thread context
+ * @all:	set to clear the whole registers (vzeroall)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+v_zeroupper(thread_ctx_t *thread_ctx, uint32_t all)
+{
+	uint32_t	i;	/* iterator */
+
+	for (i = 0; i < XMM_NUM; i++)
+		(void)memset(&thread_ctx->vcpu.xmm[i][all ? 0 : XMM_LEN], 0,
+			(all ? YMM_LEN : YMM_LEN - XMM_LEN) *
+			sizeof(vec_tag_t));
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * clear the tags of n bytes of memory
+ *
+ * @dst:	the memory address
+ * @n:		the number of bytes
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m_clrn(ADDRINT dst, uint32_t n)
+{
+	tagmap_clrn(dst, n);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate the tags of n bytes between two registers as
+ * t[dst] |= t[src] (binary), per element of e bytes; every
+ * byte of an element gets the tags of the whole element
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register (offset)
+ * @src:	source register (offset)
+ * @n:		the number of bytes
+ * @e:		the element size
+ */
+static void PIN_FAST_ANALYSIS_CALL
+v2v_binary(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src,
+		uint32_t n, uint32_t e)
+{
+	vec_binary(VTAG(thread_ctx, dst), VTAG(thread_ctx, src), n, e);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate the tags of n bytes between a register and a memory
+ * location as t[dst] |= t[src] (binary), per element of e bytes
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register (offset)
+ * @src:	source memory address
+ * @n:		the number of bytes
+ * @e:		the element size
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2v_binary(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src,
+		uint32_t n, uint32_t e)
+{
+	/* temporary tags */
+	vec_tag_t tmp_tag[YMM_LEN];
+
+	vec_ld(src, tmp_tag, n);
+	vec_binary(VTAG(thread_ctx, dst), tmp_tag, n, e);
+}
+
+/* shuffle n bytes; see v2v_shuffle() */
+static inline void
+vec_shuffle(vec_tag_t *dst, const vec_tag_t *src, size_t n,
+		const uint8_t *perm)
+{
+	/* the tags of the destination, and the source (perm[] indices) */
+	vec_tag_t	tmp_tag[VEC_PERM_SRC + XMM_LEN];
+	size_t		i;	/* iterator */
+
+	(void)memcpy(tmp_tag, dst, n * sizeof(vec_tag_t));
+	(void)memcpy(tmp_tag + VEC_PERM_SRC, src, n * sizeof(vec_tag_t));
+
+	for (i = 0; i < n; i++)
+		dst[i] = (perm[i] == VEC_PERM_ZERO) ?
+			TAG_ZERO : tmp_tag[perm[i]];
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate the tags of n bytes between two registers, as given
+ * by a permutation; perm[i] is the byte of the destination
+ * (0 ... n - 1), or of the source (VEC_PERM_SRC ...), that byte
+ * i of the destination gets, or VEC_PERM_ZERO
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register (offset)
+ * @src:	source register (offset)
+ * @n:		the number of bytes
+ * @perm:	the permutation
+ */
+static void PIN_FAST_ANALYSIS_CALL
+v2v_shuffle(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t src,
+		uint32_t n, const uint8_t *perm)
+{
+	vec_shuffle(VTAG(thread_ctx, dst), VTAG(thread_ctx, src), n, perm);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * propagate the tags of n bytes between a register and a memory
+ * location, as given by a permutation (see v2v_shuffle())
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register (offset)
+ * @src:	source memory address
+ * @n:		the number of bytes (register)
+ * @m:		the number of bytes (memory)
+ * @perm:	the permutation
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2v_shuffle(thread_ctx_t *thread_ctx, uint32_t dst, ADDRINT src,
+		uint32_t n, uint32_t m, const uint8_t *perm)
+{
+	/* temporary tags */
+	vec_tag_t tmp_tag[XMM_LEN];
+
+	(void)memset(tmp_tag, 0, sizeof(tmp_tag));
+	vec_ld(src, tmp_tag, m);
+	vec_shuffle(VTAG(thread_ctx, dst), tmp_tag, n, perm);
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * fold the tags of a register into another; the byte i of the
+ * destination gets the tags of the bytes [g * i, g * (i + 1)) of
+ * the source (e.g., pmovmskb), and its bytes [n / g, z) are cleared
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register (offset)
+ * @z:		the number of bytes written to the destination
+ * @src:	source register (offset)
+ * @n:		the number of bytes (source)
+ * @g:		the bytes of the source per byte of the destination
+ */
+static void PIN_FAST_ANALYSIS_CALL
+v2v_fold(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t z, uint32_t src,
+		uint32_t n, uint32_t g)
+{
+	/* temporary tags */
+	vec_tag_t	tmp_tag[YMM_LEN];
+	uint32_t	i;	/* iterator */
+
+	(void)memcpy(tmp_tag, VTAG(thread_ctx, src), n * sizeof(vec_tag_t));
+
+	for (i = 0; i < z; i++)
+		VTAG(thread_ctx, dst)[i] = (i < n / g) ?
+			vec_fold(&tmp_tag[i * g], g) : TAG_ZERO;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * mix the tags of a register into another; the bytes [0, d) of the
+ * destination get the tags of all the n bytes of the source (e.g.,
+ * cvtsi2sd, cvttsd2si), and its bytes [d, z) are cleared
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register (offset)
+ * @d:		the number of bytes (destination)
+ * @z:		the number of bytes written to the destination
+ * @src:	source register (offset)
+ * @n:		the number of bytes (source)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+v2v_mix(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t d, uint32_t z,
+		uint32_t src, uint32_t n)
+{
+	vec_tag_t	tag = vec_fold(VTAG(thread_ctx, src), n);
+	uint32_t	i;	/* iterator */
+
+	for (i = 0; i < z; i++)
+		VTAG(thread_ctx, dst)[i] = (i < d) ? tag : TAG_ZERO;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * mix the tags of a memory location into a register
+ * (see v2v_mix())
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register (offset)
+ * @d:		the number of bytes (destination)
+ * @z:		the number of bytes written to the destination
+ * @src:	source memory address
+ * @n:		the number of bytes (source)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2v_mix(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t d, uint32_t z,
+		ADDRINT src, uint32_t n)
+{
+	/* temporary tags */
+	vec_tag_t	tmp_tag[YMM_LEN];
+	vec_tag_t	tag;
+	uint32_t	i;	/* iterator */
+
+	vec_ld(src, tmp_tag, n);
+	tag = vec_fold(tmp_tag, n);
+
+	for (i = 0; i < z; i++)
+		VTAG(thread_ctx, dst)[i] = (i < d) ? tag : TAG_ZERO;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * pcmp{e,i}str{i,m}; the result (ECX, or XMM0) depends on all
+ * the bytes of both operands, and on EAX and EDX (the lengths)
+ * for the explicit length variants. The bytes [0, d) of the
+ * destination get their tags, and its bytes [d, z) are cleared
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register (offset)
+ * @d:		the number of bytes (destination)
+ * @z:		the number of bytes written to the destination
+ * @src1:	the first operand (offset)
+ * @src2:	the second operand (offset)
+ * @len:	non-zero for the explicit length variants
+ */
+static void PIN_FAST_ANALYSIS_CALL
+v2v_pcmpstr(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t d, uint32_t z,
+		uint32_t src1, uint32_t src2, uint32_t len)
+{
+	vec_tag_t	tag;	/* the result */
+	uint32_t	i;	/* iterator */
+
+	tag = VEC_OR(vec_fold(VTAG(thread_ctx, src1), XMM_LEN),
+			vec_fold(VTAG(thread_ctx, src2), XMM_LEN));
+	if (len != 0)
+		tag = VEC_OR(tag, VEC_OR(
+		vec_fold((vec_tag_t *)&thread_ctx->vcpu.gpr[7], 4),
+		vec_fold((vec_tag_t *)&thread_ctx->vcpu.gpr[5], 4)));
+
+	for (i = 0; i < z; i++)
+		VTAG(thread_ctx, dst)[i] = (i < d) ? tag : TAG_ZERO;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * pcmp{e,i}str{i,m}, with a memory operand (see v2v_pcmpstr())
+ *
+ * @thread_ctx:	the thread context
+ * @dst:	destination register (offset)
+ * @d:		the number of bytes (destination)
+ * @z:		the number of bytes written to the destination
+ * @src1:	the first operand (offset)
+ * @src2:	the second operand (memory address)
+ * @len:	non-zero for the explicit length variants
+ */
+static void PIN_FAST_ANALYSIS_CALL
+m2v_pcmpstr(thread_ctx_t *thread_ctx, uint32_t dst, uint32_t d, uint32_t z,
+		uint32_t src1, ADDRINT src2, uint32_t len)
+{
+	/* temporary tags */
+	vec_tag_t	tmp_tag[XMM_LEN];
+	vec_tag_t	tag;	/* the result */
+	uint32_t	i;	/* iterator */
+
+	vec_ld(src2, tmp_tag, XMM_LEN);
+	tag = VEC_OR(vec_fold(VTAG(thread_ctx, src1), XMM_LEN),
+			vec_fold(tmp_tag, XMM_LEN));
+	if (len != 0)
+		tag = VEC_OR(tag, VEC_OR(
+		vec_fold((vec_tag_t *)&thread_ctx->vcpu.gpr[7], 4),
+		vec_fold((vec_tag_t *)&thread_ctx->vcpu.gpr[5], 4)));
+
+	for (i = 0; i < z; i++)
+		VTAG(thread_ctx, dst)[i] = (i < d) ? tag : TAG_ZERO;
+}
+
+/*
+ * tag propagation (analysis function)
+ *
+ * x87 instructions; the union of the tags of the source registers,
+ * and of the memory operand if it is read, is propagated to the
+ * destination registers, and to the memory operand if it is written.
+ * The sources are numbered before the pushes, and the destinations
+ * after them (but before the pops), as in ST(i) (see X87_*)
+ *
+ * @thread_ctx:	the thread context
+ * @addr:	the memory operand (if any)
+ * @desc:	the operation (see X87_*)
+ */
+static void PIN_FAST_ANALYSIS_CALL
+x87_op(thread_ctx_t *thread_ctx, ADDRINT addr, uint32_t desc)
+{
+	/* temporary tags */
+	vec_tag_t	tmp_tag[X87_MEM_MAX];
+	vec_tag_t	tag = TAG_ZERO;	/* the result */
+	vec_tag_t	*st = thread_ctx->vcpu.x87;
+	uint32_t	i, n = X87_LEN(desc);
+
+	/* fxch; swap ST(0) and ST(i) */
+	if (desc & X87_SWAP) {
+		i		= __builtin_ctz(X87_DST(desc) & ~1U);
+		tag		= st[0];
+		st[0]		= st[i];
+		st[i]		= tag;
+		return;
+	}
+
+	/* the sources */
+	for (i = X87_SRC(desc); i != 0; i &= i - 1)
+		tag = VEC_OR(tag, st[__builtin_ctz(i)]);
+	if (desc & X87_RD) {
+		vec_ld(addr, tmp_tag, n);
+		tag = VEC_OR(tag, vec_fold(tmp_tag, n));
+	}
+
+	/* the pushes */
+	for (i = X87_PUSH(desc); i > 0; i--) {
+		(void)memmove(st + 1, st, (X87_NUM - 1) * sizeof(vec_tag_t));
+		st[0] = TAG_ZERO;
+	}
+
+	/* the destinations */
+	for (i = X87_DST(desc); i != 0; i &= i - 1)
+		st[__builtin_ctz(i)] = tag;
+	if (desc & X87_WR) {
+		for (i = 0; i < n; i++)
+			tmp_tag[i] = tag;
+		vec_st(addr, tmp_tag, n);
+	}
+
+	/* the pops */
+	for (i = X87_POP(desc); i > 0; i--) {
+		(void)memmove(st, st + 1, (X87_NUM - 1) * sizeof(vec_tag_t));
+		st[X87_NUM - 1] = TAG_ZERO;
+	}
+}
+
+#ifdef DEBUG_MEMOPS
+static void PIN_FAST_ANALYSIS_CALL
+log_memory_read(ADDRINT ip, ADDRINT addr)
+{
+	fprintf(stderr, "0x%x: R 0x%x\n", ip, addr);
+}
+
+static void PIN_FAST_ANALYSIS_CALL
+log_memory_write(ADDRINT ip, ADDRINT addr)
+{
+	fprintf(stderr, "0x%x: W 0x%x\n", ip, addr);
+}
+#endif
+
+/*
+ * get the shadow of a (SIMD, or 32/64-bit GPR) register operand
+ *
+ * @reg:	the register
+ * @off:	the offset of its tags in the thread context (see VTAG())
+ * @len:	its size in bytes
+ * @z:		the number of bytes cleared when it is written in full
+ * 		(i.e., the zero extension of the 32-bit GPRs on x86-64)
+ *
+ * returns:	1 on success, 0 if the register is not shadowed
+ */
+static int
+vreg(REG reg, uint32_t *off, uint32_t *len, uint32_t *z)
+{
+	/* the upper half of the YMM register is kept (SSE) */
+	if (REG_is_xmm(reg)) {
+		*off	= offsetof(thread_ctx_t, vcpu.xmm) +
+			(reg - REG_XMM_BASE) * sizeof(vec_tag_t[YMM_LEN]);
+		*len	= *z = XMM_LEN;
+	}
+	else if (REG_is_ymm(reg)) {
+		*off	= offsetof(thread_ctx_t, vcpu.xmm) +
+			(reg - REG_YMM_BASE) * sizeof(vec_tag_t[YMM_LEN]);
+		*len	= *z = YMM_LEN;
+	}
+	else if (REG_is_mm(reg)) {
+		*off	= offsetof(thread_ctx_t, vcpu.mmx) +
+			(reg - REG_MM_BASE) * sizeof(vec_tag_t[MMX_LEN]);
+		*len	= *z = MMX_LEN;
+	}
+	else if (REG_is_grl(reg)) {
+		*off	= offsetof(thread_ctx_t, vcpu.gpr) +
+			REG32_INDX(REG_FullRegName(reg)) *
+			sizeof(((vcpu_ctx_t *)0)->gpr[0]);
+		*len	= REG_Size(reg);
+		*z	= sizeof(((vcpu_ctx_t *)0)->gpr[0]) /
+			sizeof(vec_tag_t);
+	}
+	else
+		return 0;
+
+	return 1;
+}
+
+/*
+ * instrument a SIMD move (dst = src) of n bytes (0: the whole operand),
+ * from byte sofs of the source to byte dofs of the destination
+ *
+ * @ins:	the instruction
+ * @n:		the number of bytes
+ * @zx:		set if the rest of the destination register is cleared
+ * @dofs:	the first byte of the destination (register)
+ * @sofs:	the first byte of the source (register)
+ */
+static void
+ins_vxfer(INS ins, uint32_t n, int zx, uint32_t dofs, uint32_t sofs)
+{
+	uint32_t doff, dlen, dz, soff, slen, sz;
+
+	/* register destination */
+	if (INS_OperandIsReg(ins, OP_0)) {
+		if (!vreg(INS_OperandReg(ins, OP_0), &doff, &dlen, &dz))
+			goto err;
+
+		/* register source */
+		if (INS_OperandIsReg(ins, OP_1)) {
+			if (!vreg(INS_OperandReg(ins, OP_1), &soff, &slen, &sz))
+				goto err;
+			if (n == 0)
+				n = VEC_MIN(dlen, slen);
+
+			/* propagate the tag accordingly */
+			INS_InsertCall(ins,
+				IPOINT_BEFORE,
+				(AFUNPTR)v2v_xfer,
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE, thread_ctx_ptr,
+				IARG_UINT32, doff + dofs * sizeof(vec_tag_t),
+				IARG_UINT32, soff + sofs * sizeof(vec_tag_t),
+				IARG_UINT32, n,
+				IARG_UINT32, zx ? dz - dofs : n,
+				IARG_END);
+		}
+		/* memory source */
+		else if (INS_OperandIsMemory(ins, OP_1)) {
+			if (n == 0)
+				n = VEC_MIN(dlen, INS_MemoryReadSize(ins));
+
+			/* propagate the tag accordingly */
+			INS_InsertCall(ins,
+				IPOINT_BEFORE,
+				(AFUNPTR)m2v_xfer,
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE, thread_ctx_ptr,
+				IARG_UINT32, doff + dofs * sizeof(vec_tag_t),
+				IARG_MEMORYREAD_EA,
+				IARG_UINT32, n,
+				IARG_UINT32, zx ? dz - dofs : n,
+				IARG_END);
+		}
+		else
+			goto err;
+	}
+	/* memory destination; register source */
+	else if (INS_OperandIsMemory(ins, OP_0) &&
+			INS_OperandIsReg(ins, OP_1)) {
+		if (!vreg(INS_OperandReg(ins, OP_1), &soff, &slen, &sz))
+			goto err;
+		if (n == 0)
+			n = VEC_MIN(slen, INS_MemoryWriteSize(ins));
+
+		/* propagate the tag accordingly */
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)v2m_xfer,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_MEMORYWRITE_EA,
+			IARG_UINT32, soff + sofs * sizeof(vec_tag_t),
+			IARG_UINT32, n,
+			IARG_END);
+	}
+	else
+		goto err;
+
+	/* success */
+	return;
+
+err:
+	LOG(string(__func__) + ": unhandled operands (" +
+			INS_Disassemble(ins) + ")\n");
+}
+
+/*
+ * instrument a binary SIMD operation (dst op= src) on n bytes (0: the
+ * whole register), per element of e bytes (0: a single element); an
+ * immediate source is ignored, and the operation only mixes the bytes
+ * of every element of the destination (e.g., shifts)
+ *
+ * @ins:	the instruction
+ * @n:		the number of bytes
+ * @e:		the element size
+ * @clr:	set if the operation clears the destination when both
+ * 		operands are the same register (e.g., pxor, pcmpeqb)
+ */
+static void
+ins_vbinary(INS ins, uint32_t n, uint32_t e, int clr)
+{
+	uint32_t doff, dlen, dz, soff, slen, sz;
+	REG reg_dst;
+
+	if (!INS_OperandIsReg(ins, OP_0) ||
+		!vreg(reg_dst = INS_OperandReg(ins, OP_0), &doff, &dlen, &dz))
+		goto err;
+	if (n == 0)
+		n = dlen;
+	if (e == 0)
+		e = n;
+
+	/* register source */
+	if (INS_OperandIsReg(ins, OP_1)) {
+		if (!vreg(INS_OperandReg(ins, OP_1), &soff, &slen, &sz))
+			goto err;
+
+		/* clear idiom; same dst, src */
+		if (clr && INS_OperandReg(ins, OP_1) == reg_dst)
+			/* propagate the tag accordingly */
+			INS_InsertCall(ins,
+				IPOINT_BEFORE,
+				(AFUNPTR)v_clr,
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE, thread_ctx_ptr,
+				IARG_UINT32, doff,
+				IARG_UINT32, n,
+				IARG_END);
+		else
+			/* propagate the tag accordingly */
+			INS_InsertCall(ins,
+				IPOINT_BEFORE,
+				(AFUNPTR)v2v_binary,
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE, thread_ctx_ptr,
+				IARG_UINT32, doff,
+				IARG_UINT32, soff,
+				IARG_UINT32, n,
+				IARG_UINT32, e,
+				IARG_END);
+	}
+	/* memory source */
+	else if (INS_OperandIsMemory(ins, OP_1))
+		/* propagate the tag accordingly */
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)m2v_binary,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_UINT32, doff,
+			IARG_MEMORYREAD_EA,
+			IARG_UINT32, VEC_MIN(n, INS_MemoryReadSize(ins)),
+			IARG_UINT32, e,
+			IARG_END);
+	/* immediate source; mix the elements of the destination */
+	else if (e > 1)
+		/* propagate the tag accordingly */
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)v2v_binary,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_UINT32, doff,
+			IARG_UINT32, doff,
+			IARG_UINT32, n,
+			IARG_UINT32, e,
+			IARG_END);
+
+	/* success */
+	return;
+
+err:
+	LOG(string(__func__) + ": unhandled operands (" +
+			INS_Disassemble(ins) + ")\n");
+}
+
+/*
+ * instrument a SIMD shuffle (see v2v_shuffle()); perm[] is copied,
+ * since it has to outlive the instrumentation
+ *
+ * @ins:	the instruction
+ * @perm:	the permutation (one entry per byte of the destination)
+ * @self:	set if the source is the destination (e.g., pslldq)
+ */
+static void
+ins_vshuffle(INS ins, const uint8_t *perm, int self)
+{
+	uint32_t	doff, dlen, dz, soff, slen, sz;
+	uint8_t		*p;	/* the permutation (copy) */
+
+	if (!INS_OperandIsReg(ins, OP_0) ||
+		!vreg(INS_OperandReg(ins, OP_0), &doff, &dlen, &dz))
+		goto err;
+
+	if (unlikely((p = (uint8_t *)malloc(dlen)) == NULL)) {
+		LOG(string(__func__) + ": permutation allocation failed (" +
+				string(strerror(errno)) + ")\n");
+		return;
+	}
+	(void)memcpy(p, perm, dlen);
+
+	/* register source */
+	if (self || INS_OperandIsReg(ins, OP_1)) {
+		if (self)
+			soff = doff;
+		else if (!vreg(INS_OperandReg(ins, OP_1), &soff, &slen, &sz))
+			goto err_free;
+
+		/* propagate the tag accordingly */
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)v2v_shuffle,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_UINT32, doff,
+			IARG_UINT32, soff,
+			IARG_UINT32, dlen,
+			IARG_PTR, p,
+			IARG_END);
+	}
+	/* memory source */
+	else if (INS_OperandIsMemory(ins, OP_1))
+		/* propagate the tag accordingly */
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)m2v_shuffle,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_UINT32, doff,
+			IARG_MEMORYREAD_EA,
+			IARG_UINT32, dlen,
+			IARG_UINT32, VEC_MIN(dlen, INS_MemoryReadSize(ins)),
+			IARG_PTR, p,
+			IARG_END);
+	else
+		goto err_free;
+
+	/* success */
+	return;
+
+err_free:
+	free(p);
+err:
+	LOG(string(__func__) + ": unhandled operands (" +
+			INS_Disassemble(ins) + ")\n");
+}
+
+/*
+ * instrument a SIMD operation that folds, or mixes, the bytes of the
+ * source into the destination (see v2v_fold() and v2v_mix())
+ *
+ * @ins:	the instruction
+ * @g:		the bytes of the source per byte of the destination;
+ * 		0 mixes all of them into d bytes of the destination
+ * @d:		the number of bytes (destination; 0: the whole operand)
+ * @n:		the number of bytes (source; 0: the whole operand)
+ * @zx:		set if the rest of the destination register is cleared
+ */
+static void
+ins_vfold(INS ins, uint32_t g, uint32_t d, uint32_t n, int zx)
+{
+	uint32_t doff, dlen, dz, soff, slen, sz;
+
+	if (!INS_OperandIsReg(ins, OP_0) ||
+		!vreg(INS_OperandReg(ins, OP_0), &doff, &dlen, &dz))
+		goto err;
+	if (d == 0)
+		d = dlen;
+
+	/* register source */
+	if (INS_OperandIsReg(ins, OP_1)) {
+		if (!vreg(INS_OperandReg(ins, OP_1), &soff, &slen, &sz))
+			goto err;
+		if (n == 0)
+			n = slen;
+
+		/* fold */
+		if (g != 0)
+			/* propagate the tag accordingly */
+			INS_InsertCall(ins,
+				IPOINT_BEFORE,
+				(AFUNPTR)v2v_fold,
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE, thread_ctx_ptr,
+				IARG_UINT32, doff,
+				IARG_UINT32, dz,
+				IARG_UINT32, soff,
+				IARG_UINT32, n,
+				IARG_UINT32, g,
+				IARG_END);
+		/* mix */
+		else
+			/* propagate the tag accordingly */
+			INS_InsertCall(ins,
+				IPOINT_BEFORE,
+				(AFUNPTR)v2v_mix,
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE, thread_ctx_ptr,
+				IARG_UINT32, doff,
+				IARG_UINT32, d,
+				IARG_UINT32, zx ? dz : d,
+				IARG_UINT32, soff,
+				IARG_UINT32, n,
+				IARG_END);
+	}
+	/* memory source; mix */
+	else if (INS_OperandIsMemory(ins, OP_1) && g == 0)
+		/* propagate the tag accordingly */
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)m2v_mix,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_UINT32, doff,
+			IARG_UINT32, d,
+			IARG_UINT32, zx ? dz : d,
+			IARG_MEMORYREAD_EA,
+			IARG_UINT32, VEC_MIN(YMM_LEN, INS_MemoryReadSize(ins)),
+			IARG_END);
+	else
+		goto err;
+
+	/* success */
+	return;
+
+err:
+	LOG(string(__func__) + ": unhandled operands (" +
+			INS_Disassemble(ins) + ")\n");
+}
+
+/*
+ * instrument pcmp{e,i}str{i,m} (see v2v_pcmpstr())
+ *
+ * @ins:	the instruction
+ * @reg:	the destination (ECX, or XMM0)
+ * @d:		the number of bytes of the destination that are tagged
+ * @len:	set for the explicit length variants
+ */
+static void
+ins_vpcmpstr(INS ins, REG reg, uint32_t d, int len)
+{
+	uint32_t doff, dlen, dz, soff, slen, sz, aoff;
+
+	if (!vreg(reg, &doff, &dlen, &dz) || !INS_OperandIsReg(ins, OP_0) ||
+		!vreg(INS_OperandReg(ins, OP_0), &aoff, &slen, &sz))
+		goto err;
+
+	/* register operand */
+	if (INS_OperandIsReg(ins, OP_1)) {
+		if (!vreg(INS_OperandReg(ins, OP_1), &soff, &slen, &sz))
+			goto err;
+
+		/* propagate the tag accordingly */
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)v2v_pcmpstr,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_UINT32, doff,
+			IARG_UINT32, d,
+			IARG_UINT32, dz,
+			IARG_UINT32, aoff,
+			IARG_UINT32, soff,
+			IARG_UINT32, len,
+			IARG_END);
+	}
+	/* memory operand */
+	else if (INS_OperandIsMemory(ins, OP_1))
+		/* propagate the tag accordingly */
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)m2v_pcmpstr,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_UINT32, doff,
+			IARG_UINT32, d,
+			IARG_UINT32, dz,
+			IARG_UINT32, aoff,
+			IARG_MEMORYREAD_EA,
+			IARG_UINT32, len,
+			IARG_END);
+	else
+		goto err;
+
+	/* success */
+	return;
+
+err:
+	LOG(string(__func__) + ": unhandled operands (" +
+			INS_Disassemble(ins) + ")\n");
+}
+
+/*
+ * instrument the zero extension of a VEX.128 destination; AVX
+ * instructions clear the upper half of the YMM register, whereas
+ * the SSE ones keep it (see vreg())
+ *
+ * @ins:	the instruction
+ */
+static void
+ins_vzx(INS ins)
+{
+	uint32_t doff, dlen, dz;
+
+	if (INS_OperandIsReg(ins, OP_0) &&
+		REG_is_xmm(INS_OperandReg(ins, OP_0)) &&
+		vreg(INS_OperandReg(ins, OP_0), &doff, &dlen, &dz))
+		/* propagate the tag accordingly */
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)v_clr,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_UINT32, doff + XMM_LEN * sizeof(vec_tag_t),
+			IARG_UINT32, YMM_LEN - XMM_LEN,
+			IARG_END);
+}
+
+/*
+ * instrument a binary AVX operation with a non-destructive source
+ * (dst = src1 op src2), per element of e bytes (see ins_vbinary());
+ * the upper half of a VEX.128 destination is cleared
+ *
+ * @ins:	the instruction
+ * @e:		the element size
+ * @clr:	set if the operation clears the destination when both
+ * 		sources are the same register (e.g., vpxor, vpcmpeqb)
+ */
+static void
+ins_vbinary3(INS ins, uint32_t e, int clr)
+{
+	uint32_t doff, dlen, dz, soff, slen, sz, toff, tlen, tz;
+
+	if (!INS_OperandIsReg(ins, OP_0) || !INS_OperandIsReg(ins, OP_1) ||
+		!vreg(INS_OperandReg(ins, OP_0), &doff, &dlen, &dz) ||
+		!vreg(INS_OperandReg(ins, OP_1), &soff, &slen, &sz))
+		goto err;
+
+	/* register source */
+	if (INS_OperandIsReg(ins, OP_2)) {
+		if (!vreg(INS_OperandReg(ins, OP_2), &toff, &tlen, &tz))
+			goto err;
+
+		/* clear idiom; same src1, src2 */
+		if (clr && toff == soff) {
+			/* propagate the tag accordingly */
+			INS_InsertCall(ins,
+				IPOINT_BEFORE,
+				(AFUNPTR)v_clr,
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE, thread_ctx_ptr,
+				IARG_UINT32, doff,
+				IARG_UINT32, dlen,
+				IARG_END);
+			goto done;
+		}
 
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_dst))
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)m2r_xfer_opl,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
+		/* src2 is the destination; t[dst] |= t[src1] */
+		if (toff == doff) {
+			toff	= soff;
+			soff	= doff;
+		}
+	}
+	else if (!INS_OperandIsMemory(ins, OP_2))
+		goto err;
+
+	/* t[dst] = t[src1] */
+	if (soff != doff)
+		/* propagate the tag accordingly */
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)v2v_xfer,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_UINT32, doff,
+			IARG_UINT32, soff,
+			IARG_UINT32, dlen,
+			IARG_UINT32, dlen,
+			IARG_END);
+
+	/* t[dst] |= t[src2] */
+	if (INS_OperandIsReg(ins, OP_2))
+		/* propagate the tag accordingly */
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)v2v_binary,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_UINT32, doff,
+			IARG_UINT32, toff,
+			IARG_UINT32, dlen,
+			IARG_UINT32, e,
+			IARG_END);
+	else
+		/* propagate the tag accordingly */
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)m2v_binary,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_UINT32, doff,
+			IARG_MEMORYREAD_EA,
+			IARG_UINT32, VEC_MIN(dlen, INS_MemoryReadSize(ins)),
+			IARG_UINT32, e,
+			IARG_END);
+
+done:
+	/* VEX.128 */
+	ins_vzx(ins);
+
+	/* success */
+	return;
+
+err:
+	LOG(string(__func__) + ": unhandled operands (" +
+			INS_Disassemble(ins) + ")\n");
+}
+
+/*
+ * check if an instruction is an AVX/AVX2 (VEX-encoded SIMD) one
+ *
+ * @ins:	the instruction
+ *
+ * returns:	1 if it is, 0 otherwise
+ */
+static inline int
+ins_is_avx(INS ins)
+{
+	switch (INS_Extension(ins)) {
+		case XED_EXTENSION_AVX:
+		case XED_EXTENSION_AVX2:
+		case XED_EXTENSION_AVX2GATHER:
+		case XED_EXTENSION_FMA:
+		case XED_EXTENSION_F16C:
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+/*
+ * instrument an AVX/AVX2 instruction that is not handled otherwise; the
+ * tags of the registers and of the memory that it writes are cleared,
+ * since their data are not tracked (i.e., stale tags are worse than lost
+ * ones). VEX.128 instructions write the whole YMM register
+ *
+ * @ins:	the instruction
+ */
+static void
+ins_vclr(INS ins)
+{
+	uint32_t	off, len, z;	/* a register	*/
+	REG		reg;
+	UINT32		i;		/* iterator	*/
+
+	/* the registers */
+	for (i = 0; i < INS_MaxNumWRegs(ins); i++) {
+		reg = INS_RegW(ins, i);
+		if (REG_is_xmm(reg))
+			reg = REG_corresponding_ymm_reg(reg);
+		if (!vreg(reg, &off, &len, &z))
+			continue;
+
+		/* propagate the tag accordingly */
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)v_clr,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_UINT32, off,
+			IARG_UINT32, z,
+			IARG_END);
+	}
+
+	/* the memory (e.g., vextracti128, vmaskmovdqu) */
+	if (INS_IsMemoryWrite(ins))
+		/* propagate the tag accordingly */
+		INS_InsertPredicatedCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)m_clrn,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_MEMORYWRITE_EA,
+			IARG_MEMORYWRITE_SIZE,
+			IARG_END);
+}
+
+/*
+ * instrument an x87 instruction (see x87_op()); the ones that do not
+ * move data (e.g., fldcw, fcomi without a pop) need no propagation
+ *
+ * @ins:	the instruction
+ */
+static void
+ins_x87(INS ins)
+{
+	/* use XED to decode the instruction */
+	xed_decoded_inst_t *xedd = INS_XedDec(ins);
+
+	uint32_t	desc = 0;	/* the operation	*/
+	uint32_t	n = 0;		/* memory operand size	*/
+	REG		reg;		/* a register operand	*/
+	UINT32		i;		/* iterator		*/
+
+	/* the ST(i) operands */
+	for (i = 0; i < INS_OperandCount(ins); i++) {
+		if (!INS_OperandIsReg(ins, i) ||
+				!REG_is_st(reg = INS_OperandReg(ins, i)))
+			continue;
+		if (INS_OperandRead(ins, i))
+			desc |= X87_SRC_REG(reg - REG_ST_BASE);
+		if (INS_OperandWritten(ins, i))
+			desc |= X87_DST_REG(reg - REG_ST_BASE);
+	}
+
+	/* the pushes and the pops */
+	if (xed_decoded_inst_get_attribute(xedd, XED_ATTRIBUTE_STACKPUSH0))
+		desc += X87_PUSH_ONE;
+	if (xed_decoded_inst_get_attribute(xedd, XED_ATTRIBUTE_STACKPUSH1))
+		desc += X87_PUSH_ONE;
+	if (xed_decoded_inst_get_attribute(xedd, XED_ATTRIBUTE_STACKPOP0))
+		desc += X87_POP_ONE;
+	if (xed_decoded_inst_get_attribute(xedd, XED_ATTRIBUTE_STACKPOP1))
+		desc += X87_POP_ONE;
+
+	/* the memory operand */
+	if (INS_IsMemoryRead(ins)) {
+		desc	|= X87_RD;
+		n	= INS_MemoryReadSize(ins);
+	}
+	else if (INS_IsMemoryWrite(ins)) {
+		desc	|= X87_WR;
+		n	= INS_MemoryWriteSize(ins);
+	}
+	if (n > X87_MEM_MAX) {
+		/* the x87 state (e.g., fnsave, frstor) */
+		LOG(string(__func__) + ": unhandled operand width (" +
+				INS_Disassemble(ins) + ")\n");
+		return;
+	}
+	desc |= n << X87_LEN_SHIFT;
+
+	/* fxch */
+	if (INS_Opcode(ins) == XED_ICLASS_FXCH)
+		desc |= X87_SWAP;
+
+	/* nothing to propagate */
+	if (X87_DST(desc) == 0 && (desc & X87_WR) == 0 &&
+			X87_PUSH(desc) == 0 && X87_POP(desc) == 0)
+		return;
+
+	/* propagate the tag accordingly */
+	if (n != 0)
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)x87_op,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_MEMORYOP_EA, 0,
+			IARG_UINT32, desc,
+			IARG_END);
+	else
+		INS_InsertCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)x87_op,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_ADDRINT, (ADDRINT)0,
+			IARG_UINT32, desc,
+			IARG_END);
+}
+
+/* punpckl*, punpckh*; interleave the elements of the low (high) halves */
+static void
+perm_unpck(uint8_t *perm, uint32_t n, uint32_t e, int hi)
+{
+	uint32_t i, j, base = hi ? n / 2 : 0;
+
+	for (i = 0; i < n / (2 * e); i++)
+		for (j = 0; j < e; j++) {
+			perm[2 * i * e + j]		= base + i * e + j;
+			perm[(2 * i + 1) * e + j]	=
+				VEC_PERM_SRC + base + i * e + j;
+		}
+}
+
+/*
+ * pshufd, pshuflw, pshufhw, pshufw; the 4 elements (of e bytes)
+ * starting from the lo-th one are selected from the source by the
+ * immediate, and the rest are copied from the source
+ */
+static void
+perm_pshuf(uint8_t *perm, uint32_t n, uint32_t e, uint32_t lo, UINT64 imm)
+{
+	uint32_t i, j;
+
+	for (i = 0; i < n; i++)
+		perm[i] = VEC_PERM_SRC + i;
+	for (i = 0; i < 4; i++)
+		for (j = 0; j < e; j++)
+			perm[(lo + i) * e + j] = VEC_PERM_SRC +
+				(lo + ((imm >> (2 * i)) & 3)) * e + j;
+}
+
+/*
+ * table-driven dispatch
+ *
+ * the instructions of the simple families below (i.e., dst op= src and
+ * dst = src) are instrumented by ins_dispatch(), instead of the switch
+ * of ins_inspect(). Every family has a table of analysis functions
+ * indexed by the operand form and the operand width, and every form
+ * has a fixed argument list; the operands are decoded once, and adding
+ * an opcode to a family only takes an entry in ins_ops[]
+ */
+
+/* operand forms */
+enum {
+/* #define */ FORM_R2R = 0,		/* register to register */
+/* #define */ FORM_M2R = 1,		/* memory to register */
+/* #define */ FORM_R2M = 2,		/* register to memory */
+/* #define */ FORM_NUM = 3
+};
+
+/* operand widths; 8-bit register pairs are (dst, src) */
+enum {
+/* #define */ WIDTH_Q = 0,		/* 64-bit (x86-64) */
+/* #define */ WIDTH_L = 1,		/* 32-bit */
+/* #define */ WIDTH_W = 2,		/* 16-bit */
+/* #define */ WIDTH_BL = 3,		/* 8-bit (lower) */
+/* #define */ WIDTH_BU = 4,		/* 8-bit (upper) */
+/* #define */ WIDTH_BLU = 5,		/* 8-bit (lower, upper) */
+/* #define */ WIDTH_BUL = 6,		/* 8-bit (upper, lower) */
+/* #define */ WIDTH_NUM = 7		/* not a GPR (e.g., segment) */
+};
+
+/* instruction families */
+enum {
+/* #define */ FAM_NONE = 0,		/* see ins_inspect() */
+/* #define */ FAM_BINARY = 1,		/* t[dst] |= t[src] */
+/* #define */ FAM_XFER = 2,		/* t[dst] = t[src] */
+/* #define */ FAM_NUM = 3
+};
+
+#define FAM_IMM_CLR	0x01	/* an immediate (segment) source clears	*/
+#define FAM_IDIOM	0x02	/* the same dst, src clears		*/
+#define FAM_PRED	0x04	/* predicated (e.g., cmovcc)		*/
+
+/* the quad word analysis functions (x86-64) */
+#if defined(TARGET_IA32E)
+#define FN_Q(fn)	((AFUNPTR)fn##q)
+#else
+#define FN_Q(fn)	((AFUNPTR)NULL)
+#endif
+
+/* analysis functions; family, form, width */
+static const AFUNPTR fam_fn[FAM_NUM][FORM_NUM][WIDTH_NUM] = {
+	/* FAM_NONE */
+	{ { NULL } },
+	/* FAM_BINARY */
+	{
+		{ FN_Q(r2r_binary_op), (AFUNPTR)r2r_binary_opl,
+			(AFUNPTR)r2r_binary_opw, (AFUNPTR)r2r_binary_opb_l,
+			(AFUNPTR)r2r_binary_opb_u, (AFUNPTR)r2r_binary_opb_lu,
+			(AFUNPTR)r2r_binary_opb_ul },
+		{ FN_Q(m2r_binary_op), (AFUNPTR)m2r_binary_opl,
+			(AFUNPTR)m2r_binary_opw, (AFUNPTR)m2r_binary_opb_l,
+			(AFUNPTR)m2r_binary_opb_u, NULL, NULL },
+		{ FN_Q(r2m_binary_op), (AFUNPTR)r2m_binary_opl,
+			(AFUNPTR)r2m_binary_opw, (AFUNPTR)r2m_binary_opb_l,
+			(AFUNPTR)r2m_binary_opb_u, NULL, NULL }
+	},
+	/* FAM_XFER */
+	{
+		{ FN_Q(r2r_xfer_op), (AFUNPTR)r2r_xfer_opl,
+			(AFUNPTR)r2r_xfer_opw, (AFUNPTR)r2r_xfer_opb_l,
+			(AFUNPTR)r2r_xfer_opb_u, (AFUNPTR)r2r_xfer_opb_lu,
+			(AFUNPTR)r2r_xfer_opb_ul },
+		{ FN_Q(m2r_xfer_op), (AFUNPTR)m2r_xfer_opl,
+			(AFUNPTR)m2r_xfer_opw, (AFUNPTR)m2r_xfer_opb_l,
+			(AFUNPTR)m2r_xfer_opb_u, NULL, NULL },
+		{ FN_Q(r2m_xfer_op), (AFUNPTR)r2m_xfer_opl,
+			(AFUNPTR)r2m_xfer_opw, (AFUNPTR)r2m_xfer_opb_l,
+			(AFUNPTR)r2m_xfer_opb_u, NULL, NULL }
+	}
+};
+
+/* clear a register, or a memory location; width */
+static const AFUNPTR r_clr_fn[WIDTH_NUM] = {
+	FN_Q(r_clr), (AFUNPTR)r_clrl, (AFUNPTR)r_clrw,
+	(AFUNPTR)r_clrb_l, (AFUNPTR)r_clrb_u, NULL, NULL
+};
+static const AFUNPTR m_clr_fn[WIDTH_NUM] = {
+	FN_Q(tagmap_clr), (AFUNPTR)tagmap_clrl, (AFUNPTR)tagmap_clrw,
+	(AFUNPTR)tagmap_clrb, NULL, NULL, NULL
+};
+
+/* the table-driven instructions */
+static const struct {
+	xed_iclass_enum_t	iclass;	/* the opcode		*/
+	uint8_t			fam;	/* the family		*/
+	uint8_t			flags;	/* FAM_* flags		*/
+} ins_ops[] = {
+	/* dst op= src; an immediate source propagates nothing */
+	{ XED_ICLASS_ADC,	FAM_BINARY,	0		},
+	{ XED_ICLASS_ADD,	FAM_BINARY,	0		},
+	{ XED_ICLASS_AND,	FAM_BINARY,	0		},
+	{ XED_ICLASS_OR,	FAM_BINARY,	0		},
+	{ XED_ICLASS_XOR,	FAM_BINARY,	FAM_IDIOM	},
+	{ XED_ICLASS_SBB,	FAM_BINARY,	FAM_IDIOM	},
+	{ XED_ICLASS_SUB,	FAM_BINARY,	FAM_IDIOM	},
+	/* dst = src */
+	{ XED_ICLASS_BSF,	FAM_XFER,	0		},
+	{ XED_ICLASS_BSR,	FAM_XFER,	0		},
+	{ XED_ICLASS_MOV,	FAM_XFER,	FAM_IMM_CLR	},
+	/* dst = src iff cond */
+	{ XED_ICLASS_CMOVB,	FAM_XFER,	FAM_PRED	},
+	{ XED_ICLASS_CMOVBE,	FAM_XFER,	FAM_PRED	},
+	{ XED_ICLASS_CMOVL,	FAM_XFER,	FAM_PRED	},
+	{ XED_ICLASS_CMOVLE,	FAM_XFER,	FAM_PRED	},
+	{ XED_ICLASS_CMOVNB,	FAM_XFER,	FAM_PRED	},
+	{ XED_ICLASS_CMOVNBE,	FAM_XFER,	FAM_PRED	},
+	{ XED_ICLASS_CMOVNL,	FAM_XFER,	FAM_PRED	},
+	{ XED_ICLASS_CMOVNLE,	FAM_XFER,	FAM_PRED	},
+	{ XED_ICLASS_CMOVNO,	FAM_XFER,	FAM_PRED	},
+	{ XED_ICLASS_CMOVNP,	FAM_XFER,	FAM_PRED	},
+	{ XED_ICLASS_CMOVNS,	FAM_XFER,	FAM_PRED	},
+	{ XED_ICLASS_CMOVNZ,	FAM_XFER,	FAM_PRED	},
+	{ XED_ICLASS_CMOVO,	FAM_XFER,	FAM_PRED	},
+	{ XED_ICLASS_CMOVP,	FAM_XFER,	FAM_PRED	},
+	{ XED_ICLASS_CMOVS,	FAM_XFER,	FAM_PRED	},
+	{ XED_ICLASS_CMOVZ,	FAM_XFER,	FAM_PRED	}
+};
+
+/* ins_ops[], indexed by opcode (see ins_dispatch_init()) */
+static uint8_t ins_fam[XED_ICLASS_LAST];
+static uint8_t ins_flags[XED_ICLASS_LAST];
+
+/*
+ * get the width of a register operand
+ *
+ * @reg:	the register
+ *
+ * returns:	the width (WIDTH_*), or WIDTH_NUM if it is not a GPR
+ */
+static inline int
+reg_width(REG reg)
+{
+#if defined(TARGET_IA32E)
+	if (REG_is_gr64(reg))
+		return WIDTH_Q;
+#endif
+	if (REG_is_gr32(reg))
+		return WIDTH_L;
+	if (REG_is_gr16(reg))
+		return WIDTH_W;
+	if (REG_is_gr8(reg))
+		return REG_is_Upper8(reg) ? WIDTH_BU : WIDTH_BL;
+	return WIDTH_NUM;
+}
+
+/*
+ * get the VCPU index of a register operand
+ *
+ * @reg:	the register
+ * @w:		its width
+ */
+static inline UINT32
+reg_vcpu(REG reg, int w)
+{
+	if (w <= WIDTH_L)
+		return REG32_INDX(reg);
+	if (w == WIDTH_W)
+		return REG16_INDX(reg);
+	return REG8_INDX(reg);
+}
+
+/*
+ * build the opcode index of ins_ops[]
+ */
+void
+ins_dispatch_init(void)
+{
+	size_t	i;	/* iterator */
+
+	(void)memset(ins_fam, FAM_NONE, sizeof(ins_fam));
+	(void)memset(ins_flags, 0, sizeof(ins_flags));
+
+	for (i = 0; i < sizeof(ins_ops) / sizeof(ins_ops[0]); i++) {
+		ins_fam[ins_ops[i].iclass]	= ins_ops[i].fam;
+		ins_flags[ins_ops[i].iclass]	= ins_ops[i].flags;
+	}
+}
+
+/*
+ * instrument a table-driven instruction (see ins_ops[])
+ *
+ * @ins:	the instruction
+ * @ins_indx:	its opcode
+ *
+ * returns:	1 if it is table-driven, 0 otherwise
+ */
+static int
+ins_dispatch(INS ins, xed_iclass_enum_t ins_indx)
+{
+	/* the family, and the flags */
+	uint8_t	fam	= ins_fam[ins_indx];
+	uint8_t	flags	= ins_flags[ins_indx];
+
+	/* cmovcc are predicated */
+	VOID	(*insert)(INS, IPOINT, AFUNPTR, ...) = (flags & FAM_PRED) ?
+		INS_InsertPredicatedCall : INS_InsertCall;
+
+	REG	reg_dst, reg_src;	/* operands	*/
+	int	w, ws;			/* widths	*/
+
+	/* not table-driven */
+	if (fam == FAM_NONE)
+		return 0;
+
+	/* 2nd operand is immediate or segment register */
+	if (INS_OperandIsImmediate(ins, OP_1) ||
+		(INS_OperandIsReg(ins, OP_1) &&
+		REG_is_seg(INS_OperandReg(ins, OP_1)))) {
+		/* do nothing */
+		if ((flags & FAM_IMM_CLR) == 0) {
+#if defined(TARGET_IA32E)
+			/* but zero-extend a 32-bit destination */
+			if (INS_OperandIsReg(ins, OP_0) &&
+				reg_width(reg_dst = INS_OperandReg(ins, OP_0)) ==
+					WIDTH_L)
+				insert(ins,
+					IPOINT_BEFORE,
+					(AFUNPTR)r_zxl,
+					IARG_FAST_ANALYSIS_CALL,
+					IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
-						IARG_MEMORYREAD_EA,
-						IARG_END);
-				/* 16-bit operands */
-				else if (REG_is_gr16(reg_dst))
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)m2r_xfer_opw,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-					IARG_UINT32, REG16_INDX(reg_dst),
-						IARG_MEMORYREAD_EA,
-						IARG_END);
-				/* 8-bit operands (upper) */
-				else if (REG_is_Upper8(reg_dst)) 
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)m2r_xfer_opb_u,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-					IARG_UINT32, REG8_INDX(reg_dst),
-						IARG_MEMORYREAD_EA,
-						IARG_END);
-				/* 8-bit operands (lower) */
-				else
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)m2r_xfer_opb_l,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-					IARG_UINT32, REG8_INDX(reg_dst),
-						IARG_MEMORYREAD_EA,
-						IARG_END);
-			}
-			/* 1st operand is memory */
-			else {
-				/* extract the register operand */
-				reg_src = INS_OperandReg(ins, OP_1);
+					IARG_END);
+#endif
+			return 1;
+		}
 
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_src))
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2m_xfer_opl,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_MEMORYWRITE_EA,
-					IARG_UINT32, REG32_INDX(reg_src),
-						IARG_END);
-				/* 16-bit operands */
-				else if (REG_is_gr16(reg_src))
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2m_xfer_opw,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_MEMORYWRITE_EA,
-					IARG_UINT32, REG16_INDX(reg_src),
-						IARG_END);
-				/* 8-bit operands (upper) */
-				else if (REG_is_Upper8(reg_src))
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2m_xfer_opb_u,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_MEMORYWRITE_EA,
-						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_END);
-				/* 8-bit operands (lower) */
-				else 
-					/* propagate the tag accordingly */
-					INS_InsertCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2m_xfer_opb_l,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_MEMORYWRITE_EA,
-						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_END);
+		/* destination operand is a memory address; clear n-bytes */
+		if (INS_OperandIsMemory(ins, OP_0)) {
+			switch (INS_OperandWidth(ins, OP_0)) {
+				case MEM_QUAD_LEN:
+					w = WIDTH_Q;
+					break;
+				case MEM_LONG_LEN:
+					w = WIDTH_L;
+					break;
+				case MEM_WORD_LEN:
+					w = WIDTH_W;
+					break;
+				case MEM_BYTE_LEN:
+					w = WIDTH_BL;
+					break;
+				default:
+					w = WIDTH_NUM;
+					break;
+			}
+			/* optimized branch */
+			if (unlikely(w == WIDTH_NUM || m_clr_fn[w] == NULL)) {
+				LOG(string(__func__) +
+					": unhandled operand width (" +
+					INS_Disassemble(ins) + ")\n");
+				return 1;
 			}
+			insert(ins,
+				IPOINT_BEFORE,
+				m_clr_fn[w],
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_MEMORYWRITE_EA,
+				IARG_END);
+		}
+		/* destination operand is a GPR */
+		else if (INS_OperandIsReg(ins, OP_0) &&
+			(w = reg_width(reg_dst = INS_OperandReg(ins, OP_0))) !=
+				WIDTH_NUM)
+			insert(ins,
+				IPOINT_BEFORE,
+				r_clr_fn[w],
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE, thread_ctx_ptr,
+				IARG_UINT32, reg_vcpu(reg_dst, w),
+				IARG_END);
+
+		/* done */
+		return 1;
+	}
+
+	/* both operands are registers */
+	if (INS_MemoryOperandCount(ins) == 0) {
+		/* extract the operands */
+		reg_dst	= INS_OperandReg(ins, OP_0);
+		reg_src	= INS_OperandReg(ins, OP_1);
+
+		/* not a GPR (e.g., mov to a segment register) */
+		if ((w = reg_width(reg_dst)) == WIDTH_NUM)
+			return 1;
+
+		/* check for x86 clear register idiom */
+		if ((flags & FAM_IDIOM) && reg_dst == reg_src) {
+			insert(ins,
+				IPOINT_BEFORE,
+				r_clr_fn[w],
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE, thread_ctx_ptr,
+				IARG_UINT32, reg_vcpu(reg_dst, w),
+				IARG_END);
 
 			/* done */
-			break;
-		/* conditional movs */
-		case XED_ICLASS_CMOVB:
-		case XED_ICLASS_CMOVBE:
-		case XED_ICLASS_CMOVL:
-		case XED_ICLASS_CMOVLE:
-		case XED_ICLASS_CMOVNB:
-		case XED_ICLASS_CMOVNBE:
-		case XED_ICLASS_CMOVNL:
-		case XED_ICLASS_CMOVNLE:
-		case XED_ICLASS_CMOVNO:
-		case XED_ICLASS_CMOVNP:
-		case XED_ICLASS_CMOVNS:
-		case XED_ICLASS_CMOVNZ:
-		case XED_ICLASS_CMOVO:
-		case XED_ICLASS_CMOVP:
-		case XED_ICLASS_CMOVS:
-		case XED_ICLASS_CMOVZ:
-			/*
-			 * the general format of these instructions
-			 * is the following: dst = src iff cond. We
-			 * move the tag of the source to the destination
-			 * iff the corresponding condition is met
-			 * (i.e., t[dst] = t[src])
-			 */
-			/* both operands are registers */
-			if (INS_MemoryOperandCount(ins) == 0) {
-				/* extract the operands */
-				reg_dst = INS_OperandReg(ins, OP_0);
-				reg_src = INS_OperandReg(ins, OP_1);
-				
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_dst))
-					/* propagate the tag accordingly */
-					INS_InsertPredicatedCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opl,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-					IARG_UINT32, REG32_INDX(reg_dst),
-					IARG_UINT32, REG32_INDX(reg_src),
-						IARG_END);
-				/* 16-bit operands */
-				else 
-					/* propagate tag accordingly */
-					INS_InsertPredicatedCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opw,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-					IARG_UINT32, REG16_INDX(reg_dst),
-					IARG_UINT32, REG16_INDX(reg_src),
-						IARG_END);
-			}
-			/* 
-			 * 2nd operand is memory;
-			 * we optimize for that case, since most
-			 * instructions will have a register as
-			 * the first operand -- leave the result
-			 * into the reg and use it later
-			 */
-			else {
-				/* extract the register operand */
-				reg_dst = INS_OperandReg(ins, OP_0);
+			return 1;
+		}
+
+		/* 8-bit operands; lower/upper pairs */
+		if (w >= WIDTH_BL) {
+			ws = reg_width(reg_src);
+			if (w == WIDTH_BL && ws == WIDTH_BU)
+				w = WIDTH_BLU;
+			else if (w == WIDTH_BU && ws == WIDTH_BL)
+				w = WIDTH_BUL;
+		}
+
+		/* propagate the tag accordingly */
+		insert(ins,
+			IPOINT_BEFORE,
+			fam_fn[fam][FORM_R2R][w],
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_UINT32, reg_vcpu(reg_dst, w),
+			IARG_UINT32, reg_vcpu(reg_src, w),
+			IARG_END);
+	}
+	/* 
+	 * 2nd operand is memory;
+	 * we optimize for that case, since most
+	 * instructions will have a register as
+	 * the first operand -- leave the result
+	 * into the reg and use it later
+	 */
+	else if (INS_OperandIsMemory(ins, OP_1)) {
+		/* extract the register operand */
+		reg_dst = INS_OperandReg(ins, OP_0);
+		if ((w = reg_width(reg_dst)) == WIDTH_NUM)
+			return 1;
+
+		/* propagate the tag accordingly */
+		insert(ins,
+			IPOINT_BEFORE,
+			fam_fn[fam][FORM_M2R][w],
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_UINT32, reg_vcpu(reg_dst, w),
+			IARG_MEMORYREAD_EA,
+			IARG_END);
+	}
+	/* 1st operand is memory */
+	else {
+		/* extract the register operand */
+		reg_src = INS_OperandReg(ins, OP_1);
+		if ((w = reg_width(reg_src)) == WIDTH_NUM)
+			return 1;
+
+		/* propagate the tag accordingly */
+		insert(ins,
+			IPOINT_BEFORE,
+			fam_fn[fam][FORM_R2M][w],
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_MEMORYWRITE_EA,
+			IARG_UINT32, reg_vcpu(reg_src, w),
+			IARG_END);
+	}
+
+	/* done */
+	return 1;
+}
+
+/*
+ * instruction inspection (instrumentation function)
+ *
+ * analyze every instruction and instrument it
+ * for propagating the tag bits accordingly
+ *
+ * @ins:	the instruction to be instrumented
+ */
+void
+ins_inspect(INS ins)
+{
+	/* 
+	 * temporaries;
+	 * source, destination, base, and index registers
+	 */
+	REG reg_dst, reg_src, reg_base, reg_indx;
 
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_dst))
-					/* propagate the tag accordingly */
-					INS_InsertPredicatedCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)m2r_xfer_opl,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-					IARG_UINT32, REG32_INDX(reg_dst),
-						IARG_MEMORYREAD_EA,
-						IARG_END);
-				/* 16-bit operands */
-				else
-					/* propagate the tag accordingly */
-					INS_InsertPredicatedCall(ins,
-						IPOINT_BEFORE,
-						(AFUNPTR)m2r_xfer_opw,
-						IARG_FAST_ANALYSIS_CALL,
-						IARG_REG_VALUE, thread_ctx_ptr,
-					IARG_UINT32, REG16_INDX(reg_dst),
-						IARG_MEMORYREAD_EA,
-						IARG_END);
+	/* SIMD shuffles; permutation, immediate, element size, iterator */
+	uint8_t		perm[XMM_LEN];
+	UINT64		imm;
+	uint32_t	len, i;
+
+	/* use XED to decode the instruction and extract its opcode */
+	xed_iclass_enum_t ins_indx = (xed_iclass_enum_t)INS_Opcode(ins);
+	
+	/* sanity check */
+	if (unlikely(ins_indx <= XED_ICLASS_INVALID || 
+				ins_indx >= XED_ICLASS_LAST)) {
+		LOG(string(__func__) + ": unknown opcode (opcode=" + 
+				decstr(ins_indx) + ")\n");
+
+		/* done */
+		return;
+	}
+
+#ifdef DEBUG_MEMOPS
+	(void)fprintf(stderr, "0x%x: %s\n", INS_Address(ins), INS_Disassemble(ins).c_str());
+	if(INS_IsMemoryRead(ins) || INS_IsMemoryWrite(ins)) {
+		for(uint32_t memOp = 0; memOp < INS_MemoryOperandCount(ins); memOp++) {
+			if(INS_MemoryOperandIsRead(ins, memOp)) {
+				INS_InsertPredicatedCall(
+					ins, IPOINT_BEFORE, (AFUNPTR)log_memory_read,
+					IARG_INST_PTR, IARG_MEMORYOP_EA, memOp, IARG_END);
+			} else if(INS_MemoryOperandIsWritten(ins, memOp)) {
+				INS_InsertPredicatedCall(
+					ins, IPOINT_BEFORE, (AFUNPTR)log_memory_write,
+					IARG_INST_PTR, IARG_MEMORYOP_EA, memOp, IARG_END);
 			}
+		}
+	}
+#endif
 
-			/* done */
-			break;
+	/* table-driven families (see ins_ops[]) */
+	if (ins_dispatch(ins, ins_indx))
+		return;
+
+	/* analyze the instruction */
+	switch (ins_indx) {
 		/* 
 		 * cbw;
 		 * move the tag associated with AL to AH
@@ -2992,6 +5511,46 @@ ins_inspect(INS ins)
 
 			/* done */
 			break;
+#if defined(TARGET_IA32E)
+		/* 
+		 * cdqe;
+		 * move the tag associated with EAX to RAX
+		 *
+		 * NOTE: sign extension generates data that
+		 * are dependent to the source operand
+		 */
+		case XED_ICLASS_CDQE:
+			/* propagate the tag accordingly */
+			INS_InsertCall(ins,
+				IPOINT_BEFORE,
+				(AFUNPTR)_cdqe,
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE, thread_ctx_ptr,
+				IARG_END);
+
+			/* done */
+			break;
+		/*
+		 * cqo;
+		 * move the tag associated with RAX to RDX
+		 *
+		 * NOTE: sign extension generates data that
+		 * are dependent to the source operand
+		 */
+		case XED_ICLASS_CQO:
+			/* propagate the tag accordingly */
+			INS_InsertCall(ins,
+				IPOINT_BEFORE,
+				(AFUNPTR)r2r_xfer_opq,
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE, thread_ctx_ptr,
+				IARG_UINT32, REG32_INDX(REG_RDX),
+				IARG_UINT32, REG32_INDX(REG_RAX),
+				IARG_END);
+
+			/* done */
+			break;
+#endif
 		/* 
 		 * movsx;
 		 *
@@ -3036,34 +5595,34 @@ ins_inspect(INS ins)
 						IARG_UINT32, REG8_INDX(reg_src),
 						IARG_END);
 				}
-				/* 32-bit & 16-bit operands */
+				/* 32/64-bit & 16-bit operands */
 				else if (REG_is_gr16(reg_src))
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)_movsx_r2r_oplw,
+						OPLS(_movsx_r2r_op, w, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
 					IARG_UINT32, REG16_INDX(reg_src),
 						IARG_END);
-				/* 32-bit & 8-bit operands (upper 8-bit) */
+				/* 32/64-bit & 8-bit operands (upper 8-bit) */
 				else if (REG_is_Upper8(reg_src))
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)_movsx_r2r_oplb_u,
+						OPLS(_movsx_r2r_op, b_u, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
 						IARG_UINT32, REG8_INDX(reg_src),
 						IARG_END);
-				/* 32-bit & 8-bit operands (lower 8-bit) */
+				/* 32/64-bit & 8-bit operands (lower 8-bit) */
 				else
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)_movsx_r2r_oplb_l,
+						OPLS(_movsx_r2r_op, b_l, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
@@ -3086,24 +5645,24 @@ ins_inspect(INS ins)
 					IARG_UINT32, REG16_INDX(reg_dst),
 						IARG_MEMORYREAD_EA,
 						IARG_END);
-				/* 32-bit & 16-bit operands */
-				else if (INS_MemoryWriteSize(ins) ==
+				/* 32/64-bit & 16-bit operands */
+				else if (INS_MemoryReadSize(ins) ==
 						BIT2BYTE(MEM_WORD_LEN))
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)_movsx_m2r_oplw,
+						OPLS(_movsx_m2r_op, w, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
 						IARG_MEMORYREAD_EA,
 						IARG_END);
-				/* 32-bit & 8-bit operands */
+				/* 32/64-bit & 8-bit operands */
 				else
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)_movsx_m2r_oplb,
+						OPLS(_movsx_m2r_op, b, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
@@ -3120,7 +5679,55 @@ ins_inspect(INS ins)
 		 * clearing the tags associated with the
 		 * higher bytes of the destination operand
 		 */
+#if defined(TARGET_IA32E)
+		/* 
+		 * movsxd;
+		 *
+		 * NOTE: sign extension generates data that
+		 * are dependent to the source operand
+		 */
+		case XED_ICLASS_MOVSXD:
+			/* both operands are registers */
+			if (INS_MemoryOperandCount(ins) == 0) {
+				/* extract the operands */
+				reg_dst = INS_OperandReg(ins, OP_0);
+				reg_src = INS_OperandReg(ins, OP_1);
+
+				/* propagate the tag accordingly */
+				INS_InsertCall(ins,
+					IPOINT_BEFORE,
+					(AFUNPTR)_movsx_r2r_opql,
+					IARG_FAST_ANALYSIS_CALL,
+					IARG_REG_VALUE, thread_ctx_ptr,
+					IARG_UINT32, REG32_INDX(reg_dst),
+					IARG_UINT32, REG32_INDX(reg_src),
+					IARG_END);
+			}
+			/* 2nd operand is memory */
+			else {
+				/* extract the operands */
+				reg_dst = INS_OperandReg(ins, OP_0);
+
+				/* propagate the tag accordingly */
+				INS_InsertCall(ins,
+					IPOINT_BEFORE,
+					(AFUNPTR)_movsx_m2r_opql,
+					IARG_FAST_ANALYSIS_CALL,
+					IARG_REG_VALUE, thread_ctx_ptr,
+					IARG_UINT32, REG32_INDX(reg_dst),
+					IARG_MEMORYREAD_EA,
+					IARG_END);
+			}
+
+			/* done */
+			break;
+#endif
 		case XED_ICLASS_MOVZX:
+			/*
+			 * NOTE: the 32-bit handlers below assign the
+			 * whole VCPU register, and hence they are used
+			 * as is for 64-bit destinations (x86-64)
+			 */
 			/*
 			 * the general format of these instructions
 			 * is the following: dst = src. We move the
@@ -3209,7 +5816,7 @@ ins_inspect(INS ins)
 						IARG_MEMORYREAD_EA,
 						IARG_END);
 				/* 32-bit & 16-bit operands */
-				else if (INS_MemoryWriteSize(ins) ==
+				else if (INS_MemoryReadSize(ins) ==
 						BIT2BYTE(MEM_WORD_LEN))
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
@@ -3251,7 +5858,22 @@ ins_inspect(INS ins)
 			/* memory operand */
 			if (INS_OperandIsMemory(ins, OP_0))
 				/* differentiate based on the memory size */
-				switch (INS_MemoryWriteSize(ins)) {
+				switch (INS_MemoryReadSize(ins)) {
+#if defined(TARGET_IA32E)
+					/* 8 bytes */
+					case BIT2BYTE(MEM_QUAD_LEN):
+					/* propagate the tag accordingly */
+						INS_InsertCall(ins,
+							IPOINT_BEFORE,
+						(AFUNPTR)m2r_ternary_opq,
+							IARG_FAST_ANALYSIS_CALL,
+						IARG_REG_VALUE, thread_ctx_ptr,
+							IARG_MEMORYREAD_EA,
+							IARG_END);
+
+						/* done */
+						break;
+#endif
 					/* 4 bytes */
 					case BIT2BYTE(MEM_LONG_LEN):
 					/* propagate the tag accordingly */
@@ -3298,12 +5920,12 @@ ins_inspect(INS ins)
 				/* extract the operand */
 				reg_src = INS_OperandReg(ins, OP_0);
 				
-				/* 32-bit operand */
-				if (REG_is_gr32(reg_src))
+				/* 32/64-bit operand */
+				if (REG_is_grl(reg_src))
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)r2r_ternary_opl,
+						OPL(r2r_ternary_op, reg_src),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_src),
@@ -3355,7 +5977,22 @@ ins_inspect(INS ins)
 				/* memory operand */
 				if (INS_OperandIsMemory(ins, OP_0))
 				/* differentiate based on the memory size */
-				switch (INS_MemoryWriteSize(ins)) {
+				switch (INS_MemoryReadSize(ins)) {
+#if defined(TARGET_IA32E)
+					/* 8 bytes */
+					case BIT2BYTE(MEM_QUAD_LEN):
+					/* propagate the tag accordingly */
+						INS_InsertCall(ins,
+							IPOINT_BEFORE,
+						(AFUNPTR)m2r_ternary_opq,
+							IARG_FAST_ANALYSIS_CALL,
+						IARG_REG_VALUE, thread_ctx_ptr,
+							IARG_MEMORYREAD_EA,
+							IARG_END);
+
+						/* done */
+						break;
+#endif
 					/* 4 bytes */
 					case BIT2BYTE(MEM_LONG_LEN):
 					/* propagate the tag accordingly */
@@ -3402,12 +6039,12 @@ ins_inspect(INS ins)
 				/* extract the operand */
 				reg_src = INS_OperandReg(ins, OP_0);
 				
-				/* 32-bit operand */
-				if (REG_is_gr32(reg_src))
+				/* 32/64-bit operand */
+				if (REG_is_grl(reg_src))
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)r2r_ternary_opl,
+						OPL(r2r_ternary_op, reg_src),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_src),
@@ -3456,12 +6093,12 @@ ins_inspect(INS ins)
 					reg_dst = INS_OperandReg(ins, OP_0);
 					reg_src = INS_OperandReg(ins, OP_1);
 				
-					/* 32-bit operands */
-					if (REG_is_gr32(reg_dst))
+					/* 32/64-bit operands */
+					if (REG_is_grl(reg_dst))
 					/* propagate the tag accordingly */
 						INS_InsertCall(ins,
 							IPOINT_BEFORE,
-							(AFUNPTR)r2r_binary_opl,
+							OPL(r2r_binary_op, reg_dst),
 							IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
@@ -3490,12 +6127,12 @@ ins_inspect(INS ins)
 					/* extract the register operand */
 					reg_dst = INS_OperandReg(ins, OP_0);
 
-					/* 32-bit operands */
-					if (REG_is_gr32(reg_dst))
+					/* 32/64-bit operands */
+					if (REG_is_grl(reg_dst))
 					/* propagate the tag accordingly */
 						INS_InsertCall(ins,
 							IPOINT_BEFORE,
-							(AFUNPTR)m2r_binary_opl,
+							OPL(m2r_binary_op, reg_dst),
 							IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
@@ -3741,22 +6378,22 @@ ins_inspect(INS ins)
 				reg_dst = INS_OperandReg(ins, OP_0);
 				reg_src = INS_OperandReg(ins, OP_1);
 
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_dst)) {
+				/* 32/64-bit operands */
+				if (REG_is_grl(reg_dst)) {
 				/* propagate tag accordingly; fast path */
 					INS_InsertIfCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)_cmpxchg_r2r_opl_fast,
+						OPLS(_cmpxchg_r2r_op, _fast, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_REG_VALUE, REG_EAX,
+						IARG_REG_VALUE, REG_GAX,
 					IARG_UINT32, REG32_INDX(reg_dst),
 						IARG_REG_VALUE, reg_dst,
 						IARG_END);
 				/* propagate tag accordingly; slow path */
 					INS_InsertThenCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)_cmpxchg_r2r_opl_slow,
+						OPLS(_cmpxchg_r2r_op, _slow, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
@@ -3796,21 +6433,21 @@ ins_inspect(INS ins)
 				/* extract the operand */
 				reg_src = INS_OperandReg(ins, OP_1);
 
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_src)) {
+				/* 32/64-bit operands */
+				if (REG_is_grl(reg_src)) {
 				/* propagate tag accordingly; fast path */
 					INS_InsertIfCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)_cmpxchg_m2r_opl_fast,
+						OPLS(_cmpxchg_m2r_op, _fast, reg_src),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_REG_VALUE, REG_EAX,
+						IARG_REG_VALUE, REG_GAX,
 						IARG_MEMORYREAD_EA,
 						IARG_END);
 				/* propagate tag accordingly; slow path */
 					INS_InsertThenCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)_cmpxchg_r2m_opl_slow,
+						OPLS(_cmpxchg_r2m_op, _slow, reg_src),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 						IARG_MEMORYWRITE_EA,
@@ -3858,20 +6495,20 @@ ins_inspect(INS ins)
 				reg_dst = INS_OperandReg(ins, OP_0);
 				reg_src = INS_OperandReg(ins, OP_1);
 				
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_dst)) {
+				/* 32/64-bit operands */
+				if (REG_is_grl(reg_dst)) {
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opl,
+						OPL(r2r_xfer_op, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 					IARG_UINT32, REG32_INDX(reg_dst),
 						IARG_END);
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opl,
+						OPL(r2r_xfer_op, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
@@ -3879,11 +6516,11 @@ ins_inspect(INS ins)
 						IARG_END);
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opl,
+						OPL(r2r_xfer_op, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_src),
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_END);
 				}
 				/* 16-bit operands */
@@ -3894,7 +6531,7 @@ ins_inspect(INS ins)
 						(AFUNPTR)r2r_xfer_opw,
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 					IARG_UINT32, REG16_INDX(reg_dst),
 						IARG_END);
 					INS_InsertCall(ins,
@@ -3911,7 +6548,7 @@ ins_inspect(INS ins)
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG16_INDX(reg_src),
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_END);
 				}
 				/* 8-bit operands */
@@ -3925,7 +6562,7 @@ ins_inspect(INS ins)
 						(AFUNPTR)r2r_xfer_opb_l,
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_UINT32, REG8_INDX(reg_dst),
 						IARG_END);
 					INS_InsertCall(ins,
@@ -3942,7 +6579,7 @@ ins_inspect(INS ins)
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_END);
 					}
 					else if(REG_is_Upper8(reg_dst) &&
@@ -3953,7 +6590,7 @@ ins_inspect(INS ins)
 						(AFUNPTR)r2r_xfer_opb_u,
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_UINT32, REG8_INDX(reg_dst),
 						IARG_END);
 					INS_InsertCall(ins,
@@ -3970,7 +6607,7 @@ ins_inspect(INS ins)
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_END);
 					}
 					else if (REG_is_Lower8(reg_dst)) {
@@ -3985,7 +6622,7 @@ ins_inspect(INS ins)
 						(AFUNPTR)r2r_xfer_opb_l,
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_UINT32, REG8_INDX(reg_dst),
 						IARG_END);
 					INS_InsertCall(ins,
@@ -4002,7 +6639,7 @@ ins_inspect(INS ins)
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_END);
 					}
 					else {
@@ -4017,7 +6654,7 @@ ins_inspect(INS ins)
 						(AFUNPTR)r2r_xfer_opb_u,
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_UINT32, REG8_INDX(reg_dst),
 						IARG_END);
 					INS_InsertCall(ins,
@@ -4034,7 +6671,7 @@ ins_inspect(INS ins)
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_END);
 					}
 				}
@@ -4050,12 +6687,12 @@ ins_inspect(INS ins)
 				/* extract the register operand */
 				reg_dst = INS_OperandReg(ins, OP_0);
 				
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_dst))
+				/* 32/64-bit operands */
+				if (REG_is_grl(reg_dst))
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)_xchg_r2m_opl,
+						OPL(_xchg_r2m_op, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 						IARG_MEMORYREAD_EA,
@@ -4100,12 +6737,12 @@ ins_inspect(INS ins)
 				/* extract the register operand */
 				reg_src = INS_OperandReg(ins, OP_1);
 
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_src))
+				/* 32/64-bit operands */
+				if (REG_is_grl(reg_src))
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)_xchg_r2m_opl,
+						OPL(_xchg_r2m_op, reg_src),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 						IARG_MEMORYWRITE_EA,
@@ -4160,20 +6797,20 @@ ins_inspect(INS ins)
 				reg_dst = INS_OperandReg(ins, OP_0);
 				reg_src = INS_OperandReg(ins, OP_1);
 				
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_dst)) {
+				/* 32/64-bit operands */
+				if (REG_is_grl(reg_dst)) {
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opl,
+						OPL(r2r_xfer_op, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 					IARG_UINT32, REG32_INDX(reg_dst),
 						IARG_END);
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opl,
+						OPL(r2r_xfer_op, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
@@ -4181,15 +6818,15 @@ ins_inspect(INS ins)
 						IARG_END);
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opl,
+						OPL(r2r_xfer_op, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_src),
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_END);
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)r2r_binary_opl,
+						OPL(r2r_binary_op, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
@@ -4204,7 +6841,7 @@ ins_inspect(INS ins)
 						(AFUNPTR)r2r_xfer_opw,
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 					IARG_UINT32, REG16_INDX(reg_dst),
 						IARG_END);
 					INS_InsertCall(ins,
@@ -4221,7 +6858,7 @@ ins_inspect(INS ins)
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG16_INDX(reg_src),
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_END);
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
@@ -4243,7 +6880,7 @@ ins_inspect(INS ins)
 						(AFUNPTR)r2r_xfer_opb_l,
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_UINT32, REG8_INDX(reg_dst),
 						IARG_END);
 					INS_InsertCall(ins,
@@ -4260,7 +6897,7 @@ ins_inspect(INS ins)
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_END);
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
@@ -4279,7 +6916,7 @@ ins_inspect(INS ins)
 						(AFUNPTR)r2r_xfer_opb_u,
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_UINT32, REG8_INDX(reg_dst),
 						IARG_END);
 					INS_InsertCall(ins,
@@ -4296,7 +6933,7 @@ ins_inspect(INS ins)
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_END);
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
@@ -4319,7 +6956,7 @@ ins_inspect(INS ins)
 						(AFUNPTR)r2r_xfer_opb_l,
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_UINT32, REG8_INDX(reg_dst),
 						IARG_END);
 					INS_InsertCall(ins,
@@ -4336,7 +6973,7 @@ ins_inspect(INS ins)
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_END);
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
@@ -4359,7 +6996,7 @@ ins_inspect(INS ins)
 						(AFUNPTR)r2r_xfer_opb_u,
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_UINT32, REG8_INDX(reg_dst),
 						IARG_END);
 					INS_InsertCall(ins,
@@ -4376,7 +7013,7 @@ ins_inspect(INS ins)
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 						IARG_UINT32, REG8_INDX(reg_src),
-						IARG_UINT32, 8,
+						IARG_UINT32, GPR_SCRATCH,
 						IARG_END);
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
@@ -4394,12 +7031,12 @@ ins_inspect(INS ins)
 				/* extract the register operand */
 				reg_src = INS_OperandReg(ins, OP_1);
 
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_src))
+				/* 32/64-bit operands */
+				if (REG_is_grl(reg_src))
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)_xadd_r2m_opl,
+						OPL(_xadd_r2m_op, reg_src),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 						IARG_MEMORYWRITE_EA,
@@ -4498,6 +7135,22 @@ ins_inspect(INS ins)
 
 			/* done */
 			break;
+#if defined(TARGET_IA32E)
+		/* lodsq; similar to a mov between a memory location and RAX */
+		case XED_ICLASS_LODSQ:
+			/* propagate the tag accordingly */
+			INS_InsertPredicatedCall(ins,
+				IPOINT_BEFORE,
+				(AFUNPTR)m2r_xfer_opq,
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE, thread_ctx_ptr,
+				IARG_UINT32, REG32_INDX(REG_RAX),
+				IARG_MEMORYREAD_EA,
+				IARG_END);
+
+			/* done */
+			break;
+#endif
 		/* 
 		 * stosb;
 		 * the opposite of lodsb; however, since the instruction can
@@ -4507,7 +7160,6 @@ ins_inspect(INS ins)
 		 * inlined code
 		 */
 		case XED_ICLASS_STOSB:
-#if 0
 			/* the instruction is rep prefixed */
 			if (INS_RepPrefix(ins)) {
 				/* propagate the tag accordingly */
@@ -4524,34 +7176,109 @@ ins_inspect(INS ins)
 					IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_MEMORYWRITE_EA,
 				IARG_REG_VALUE, INS_RepCountRegister(ins),
-				IARG_REG_VALUE, INS_OperandReg(ins, OP_4),
+				IARG_REG_VALUE, REG_GFLAGS,
+					IARG_END);
+			}
+			/* no rep prefix */
+			else
+				/* the instruction is not rep prefixed */
+				INS_InsertPredicatedCall(ins,
+					IPOINT_BEFORE,
+					(AFUNPTR)r2m_xfer_opb_l,
+					IARG_FAST_ANALYSIS_CALL,
+					IARG_REG_VALUE, thread_ctx_ptr,
+					IARG_MEMORYWRITE_EA,
+					IARG_UINT32, REG8_INDX(REG_AL),
+					IARG_END);
+
+			/* done */
+			break;
+		/* 
+		 * stosw; 
+		 * the opposite of lodsw; however, since the instruction can
+		 * also be prefixed with 'rep', the analysis code moves the
+		 * tag information, accordingly, only once (i.e., before the
+		 * first repetition) -- typically this will not lead in
+		 * inlined code
+		 */
+		case XED_ICLASS_STOSW:
+			/* the instruction is rep prefixed */
+			if (INS_RepPrefix(ins)) {
+				/* propagate the tag accordingly */
+				INS_InsertIfPredicatedCall(ins,
+					IPOINT_BEFORE,
+					(AFUNPTR)rep_predicate,
+					IARG_FAST_ANALYSIS_CALL,
+					IARG_FIRST_REP_ITERATION,
+					IARG_END);
+				INS_InsertThenPredicatedCall(ins,
+					IPOINT_BEFORE,
+					(AFUNPTR)r2m_xfer_opwn,
+					IARG_FAST_ANALYSIS_CALL,
+					IARG_REG_VALUE, thread_ctx_ptr,
+					IARG_MEMORYWRITE_EA,
+				IARG_REG_VALUE, INS_RepCountRegister(ins),
+				IARG_REG_VALUE, REG_GFLAGS,
 					IARG_END);
 			}
 			/* no rep prefix */
 			else
-#endif
 				/* the instruction is not rep prefixed */
 				INS_InsertPredicatedCall(ins,
 					IPOINT_BEFORE,
-					(AFUNPTR)r2m_xfer_opb_l,
+					(AFUNPTR)r2m_xfer_opw,
+					IARG_FAST_ANALYSIS_CALL,
+					IARG_REG_VALUE, thread_ctx_ptr,
+					IARG_MEMORYWRITE_EA,
+					IARG_UINT32, REG16_INDX(REG_AX),
+					IARG_END);
+
+			/* done */
+			break;
+		/* 
+		 * stosd;
+		 * the opposite of lodsd; however, since the instruction can
+		 * also be prefixed with 'rep', the analysis code moves the
+		 * tag information, accordingly, only once (i.e., before the
+		 * first repetition) -- typically this will not lead in
+		 * inlined code
+		 */
+		case XED_ICLASS_STOSD:
+			/* the instruction is rep prefixed */
+			if (INS_RepPrefix(ins)) {
+				/* propagate the tag accordingly */
+				INS_InsertIfPredicatedCall(ins,
+					IPOINT_BEFORE,
+					(AFUNPTR)rep_predicate,
+					IARG_FAST_ANALYSIS_CALL,
+					IARG_FIRST_REP_ITERATION,
+					IARG_END);
+				INS_InsertThenPredicatedCall(ins,
+					IPOINT_BEFORE,
+					(AFUNPTR)r2m_xfer_opln,
+					IARG_FAST_ANALYSIS_CALL,
+					IARG_REG_VALUE, thread_ctx_ptr,
+					IARG_MEMORYWRITE_EA,
+				IARG_REG_VALUE, INS_RepCountRegister(ins),
+				IARG_REG_VALUE, REG_GFLAGS,
+					IARG_END);
+			}
+			/* no rep prefix */
+			else
+				INS_InsertPredicatedCall(ins,
+					IPOINT_BEFORE,
+					(AFUNPTR)r2m_xfer_opl,
 					IARG_FAST_ANALYSIS_CALL,
 					IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_MEMORYWRITE_EA,
-					IARG_UINT32, REG8_INDX(REG_AL),
+					IARG_UINT32, REG32_INDX(REG_EAX),
 					IARG_END);
 
 			/* done */
 			break;
-		/* 
-		 * stosw; 
-		 * the opposite of lodsw; however, since the instruction can
-		 * also be prefixed with 'rep', the analysis code moves the
-		 * tag information, accordingly, only once (i.e., before the
-		 * first repetition) -- typically this will not lead in
-		 * inlined code
-		 */
-		case XED_ICLASS_STOSW:
-#if 0
+#if defined(TARGET_IA32E)
+		/* stosq; the opposite of lodsq (see stosd) */
+		case XED_ICLASS_STOSQ:
 			/* the instruction is rep prefixed */
 			if (INS_RepPrefix(ins)) {
 				/* propagate the tag accordingly */
@@ -4563,39 +7290,31 @@ ins_inspect(INS ins)
 					IARG_END);
 				INS_InsertThenPredicatedCall(ins,
 					IPOINT_BEFORE,
-					(AFUNPTR)r2m_xfer_opwn,
+					(AFUNPTR)r2m_xfer_opqn,
 					IARG_FAST_ANALYSIS_CALL,
 					IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_MEMORYWRITE_EA,
 				IARG_REG_VALUE, INS_RepCountRegister(ins),
-				IARG_REG_VALUE, INS_OperandReg(ins, OP_4),
+				IARG_REG_VALUE, REG_GFLAGS,
 					IARG_END);
 			}
 			/* no rep prefix */
 			else
-#endif
 				/* the instruction is not rep prefixed */
 				INS_InsertPredicatedCall(ins,
 					IPOINT_BEFORE,
-					(AFUNPTR)r2m_xfer_opw,
+					(AFUNPTR)r2m_xfer_opq,
 					IARG_FAST_ANALYSIS_CALL,
 					IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_MEMORYWRITE_EA,
-					IARG_UINT32, REG16_INDX(REG_AX),
+					IARG_UINT32, REG32_INDX(REG_RAX),
 					IARG_END);
 
 			/* done */
 			break;
-		/* 
-		 * stosd;
-		 * the opposite of lodsd; however, since the instruction can
-		 * also be prefixed with 'rep', the analysis code moves the
-		 * tag information, accordingly, only once (i.e., before the
-		 * first repetition) -- typically this will not lead in
-		 * inlined code
-		 */
-		case XED_ICLASS_STOSD:
-#if 0
+#endif
+		/* movsd */
+		case XED_ICLASS_MOVSD:
 			/* the instruction is rep prefixed */
 			if (INS_RepPrefix(ins)) {
 				/* propagate the tag accordingly */
@@ -4607,30 +7326,30 @@ ins_inspect(INS ins)
 					IARG_END);
 				INS_InsertThenPredicatedCall(ins,
 					IPOINT_BEFORE,
-					(AFUNPTR)r2m_xfer_opln,
+					(AFUNPTR)m2m_xfer_opln,
 					IARG_FAST_ANALYSIS_CALL,
-					IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_MEMORYWRITE_EA,
+					IARG_MEMORYREAD_EA,
 				IARG_REG_VALUE, INS_RepCountRegister(ins),
-				IARG_REG_VALUE, INS_OperandReg(ins, OP_4),
+				IARG_REG_VALUE, INS_OperandReg(ins, OP_5),
 					IARG_END);
 			}
 			/* no rep prefix */
-			else
-#endif
-				INS_InsertPredicatedCall(ins,
+			else 
+				/* propagate the tag accordingly */
+				INS_InsertCall(ins,
 					IPOINT_BEFORE,
-					(AFUNPTR)r2m_xfer_opl,
+					(AFUNPTR)m2m_xfer_opl,
 					IARG_FAST_ANALYSIS_CALL,
-					IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_MEMORYWRITE_EA,
-					IARG_UINT32, REG32_INDX(REG_EAX),
+					IARG_MEMORYREAD_EA,
 					IARG_END);
 
 			/* done */
 			break;
-		/* movsd */
-		case XED_ICLASS_MOVSD:
+#if defined(TARGET_IA32E)
+		/* movsq */
+		case XED_ICLASS_MOVSQ:
 			/* the instruction is rep prefixed */
 			if (INS_RepPrefix(ins)) {
 				/* propagate the tag accordingly */
@@ -4642,7 +7361,7 @@ ins_inspect(INS ins)
 					IARG_END);
 				INS_InsertThenPredicatedCall(ins,
 					IPOINT_BEFORE,
-					(AFUNPTR)m2m_xfer_opln,
+					(AFUNPTR)m2m_xfer_opqn,
 					IARG_FAST_ANALYSIS_CALL,
 					IARG_MEMORYWRITE_EA,
 					IARG_MEMORYREAD_EA,
@@ -4655,7 +7374,7 @@ ins_inspect(INS ins)
 				/* propagate the tag accordingly */
 				INS_InsertCall(ins,
 					IPOINT_BEFORE,
-					(AFUNPTR)m2m_xfer_opl,
+					(AFUNPTR)m2m_xfer_opq,
 					IARG_FAST_ANALYSIS_CALL,
 					IARG_MEMORYWRITE_EA,
 					IARG_MEMORYREAD_EA,
@@ -4663,6 +7382,7 @@ ins_inspect(INS ins)
 
 			/* done */
 			break;
+#endif
 		/* movsw */
 		case XED_ICLASS_MOVSW:
 			/* the instruction is rep prefixed */
@@ -4729,6 +7449,23 @@ ins_inspect(INS ins)
 					IARG_MEMORYREAD_EA,
 					IARG_END);
 
+			/* done */
+			break;
+		/*
+		 * scas, cmps (also REPE/REPNE prefixed);
+		 * they update only EFLAGS and the address/count registers,
+		 * which are not tracked -- hence, nothing is propagated and
+		 * no analysis code runs, on any repetition (see also
+		 * ins_rep_cmp() in libdft_api.c)
+		 */
+		case XED_ICLASS_SCASB:
+		case XED_ICLASS_SCASW:
+		case XED_ICLASS_SCASD:
+		case XED_ICLASS_SCASQ:
+		case XED_ICLASS_CMPSB:
+		case XED_ICLASS_CMPSW:
+		case XED_ICLASS_CMPSD:
+		case XED_ICLASS_CMPSQ:
 			/* done */
 			break;
 		/* sal */
@@ -4773,11 +7510,11 @@ ins_inspect(INS ins)
 				reg_dst = INS_OperandReg(ins, OP_0);
 
 				/* 32-bit operand */
-				if (REG_is_gr32(reg_dst))
+				if (REG_is_grl(reg_dst))
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)m2r_xfer_opl,
+						OPL(m2r_xfer_op, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
@@ -4797,6 +7534,20 @@ ins_inspect(INS ins)
 			}
 			/* memory operand */
 			else if (INS_OperandIsMemory(ins, OP_0)) {
+#if defined(TARGET_IA32E)
+				/* 64-bit operand */
+				if (INS_MemoryWriteSize(ins) ==
+						BIT2BYTE(MEM_QUAD_LEN))
+					/* propagate the tag accordingly */
+					INS_InsertCall(ins,
+						IPOINT_BEFORE,
+						(AFUNPTR)m2m_xfer_opq,
+						IARG_FAST_ANALYSIS_CALL,
+						IARG_MEMORYWRITE_EA,
+						IARG_MEMORYREAD_EA,
+						IARG_END);
+				else
+#endif
 				/* 32-bit operand */
 				if (INS_MemoryWriteSize(ins) ==
 						BIT2BYTE(MEM_LONG_LEN))
@@ -4829,12 +7580,12 @@ ins_inspect(INS ins)
 				/* extract the operand */
 				reg_src = INS_OperandReg(ins, OP_0);
 
-				/* 32-bit operand */
-				if (REG_is_gr32(reg_src))
+				/* 32/64-bit operand */
+				if (REG_is_grl(reg_src))
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)r2m_xfer_opl,
+						OPL(r2m_xfer_op, reg_src),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 						IARG_MEMORYWRITE_EA,
@@ -4854,6 +7605,20 @@ ins_inspect(INS ins)
 			}
 			/* memory operand */
 			else if (INS_OperandIsMemory(ins, OP_0)) {
+#if defined(TARGET_IA32E)
+				/* 64-bit operand */
+				if (INS_MemoryWriteSize(ins) ==
+						BIT2BYTE(MEM_QUAD_LEN))
+					/* propagate the tag accordingly */
+					INS_InsertCall(ins,
+						IPOINT_BEFORE,
+						(AFUNPTR)m2m_xfer_opq,
+						IARG_FAST_ANALYSIS_CALL,
+						IARG_MEMORYWRITE_EA,
+						IARG_MEMORYREAD_EA,
+						IARG_END);
+				else
+#endif
 				/* 32-bit operand */
 				if (INS_MemoryWriteSize(ins) ==
 						BIT2BYTE(MEM_LONG_LEN))
@@ -4878,6 +7643,22 @@ ins_inspect(INS ins)
 			}
 			/* immediate or segment operand; clean */
 			else {
+#if defined(TARGET_IA32E)
+				/* 8 bytes (sign-extended immediate) */
+				if (INS_MemoryWriteSize(ins) ==
+						BIT2BYTE(MEM_QUAD_LEN)) {
+				/* propagate the tag accordingly */
+					INS_InsertCall(ins,
+						IPOINT_BEFORE,
+						(AFUNPTR)tagmap_clrq,
+						IARG_FAST_ANALYSIS_CALL,
+						IARG_MEMORYWRITE_EA,
+						IARG_END);
+
+					/* done */
+					break;
+				}
+#endif
 				/* clear n-bytes */
 				switch (INS_OperandWidth(ins, OP_0)) {
 					/* 4 bytes */
@@ -5013,8 +7794,38 @@ ins_inspect(INS ins)
 
 			/* done */
 			break;
+#if defined(TARGET_IA32E)
+		/* pushfq; clear a quad memory word (i.e., 64-bits) */
+		case XED_ICLASS_PUSHFQ:
+			/* propagate the tag accordingly */
+			INS_InsertCall(ins,
+				IPOINT_BEFORE,
+				(AFUNPTR)tagmap_clrq,
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_MEMORYWRITE_EA,
+				IARG_END);
+
+			/* done */
+			break;
+#endif
 		/* call (near); similar to push (see above) */
 		case XED_ICLASS_CALL_NEAR:
+#if defined(TARGET_IA32E)
+			/* 64-bit return address; clear a quad memory word */
+			if (INS_MemoryWriteSize(ins) ==
+					BIT2BYTE(MEM_QUAD_LEN)) {
+				/* propagate the tag accordingly */
+				INS_InsertCall(ins,
+					IPOINT_BEFORE,
+					(AFUNPTR)tagmap_clrq,
+					IARG_FAST_ANALYSIS_CALL,
+					IARG_MEMORYWRITE_EA,
+					IARG_END);
+
+				/* done */
+				break;
+			}
+#endif
 			/* relative target */
 			if (INS_OperandIsImmediate(ins, OP_0)) {
 				/* 32-bit operand */
@@ -5041,8 +7852,8 @@ ins_inspect(INS ins)
 				/* extract the source register */
 				reg_src = INS_OperandReg(ins, OP_0);
 
-				/* 32-bit operand */
-				if (REG_is_gr32(reg_src))
+				/* 32/64-bit operand */
+				if (REG_is_grl(reg_src))
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
@@ -5095,11 +7906,11 @@ ins_inspect(INS ins)
 			reg_src = INS_OperandReg(ins, OP_2);
 
 			/* 32-bit operands */	
-			if (REG_is_gr32(reg_dst)) {
+			if (REG_is_grl(reg_dst)) {
 				/* propagate the tag accordingly */
 				INS_InsertCall(ins,
 					IPOINT_BEFORE,
-					(AFUNPTR)r2r_xfer_opl,
+					OPL(r2r_xfer_op, reg_dst),
 					IARG_FAST_ANALYSIS_CALL,
 					IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
@@ -5107,7 +7918,7 @@ ins_inspect(INS ins)
 					IARG_END);
 				INS_InsertCall(ins,
 					IPOINT_BEFORE,
-					(AFUNPTR)m2r_xfer_opl,
+					OPL(m2r_xfer_op, reg_dst),
 					IARG_FAST_ANALYSIS_CALL,
 					IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_src),
@@ -5155,12 +7966,12 @@ ins_inspect(INS ins)
 			/* no base or index register; clear the destination */
 			if (reg_base == REG_INVALID() &&
 					reg_indx == REG_INVALID()) {
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_dst))
+				/* 32/64-bit operands */
+				if (REG_is_grl(reg_dst))
 					/* clear */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)r_clrl,
+						OPL(r_clr, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 						IARG_UINT32,
@@ -5181,12 +7992,12 @@ ins_inspect(INS ins)
 			/* base register exists; no index register */
 			if (reg_base != REG_INVALID() &&
 					reg_indx == REG_INVALID()) {
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_dst))
+				/* 32/64-bit operands */
+				if (REG_is_grl(reg_dst))
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opl,
+						OPL(r2r_xfer_op, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
@@ -5207,12 +8018,12 @@ ins_inspect(INS ins)
 			/* index register exists; no base register */
 			if (reg_base == REG_INVALID() &&
 					reg_indx != REG_INVALID()) {
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_dst))
+				/* 32/64-bit operands */
+				if (REG_is_grl(reg_dst))
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)r2r_xfer_opl,
+						OPL(r2r_xfer_op, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
@@ -5233,12 +8044,12 @@ ins_inspect(INS ins)
 			/* base and index registers exist */
 			if (reg_base != REG_INVALID() &&
 					reg_indx != REG_INVALID()) {
-				/* 32-bit operands */
-				if (REG_is_gr32(reg_dst))
+				/* 32/64-bit operands */
+				if (REG_is_grl(reg_dst))
 					/* propagate the tag accordingly */
 					INS_InsertCall(ins,
 						IPOINT_BEFORE,
-						(AFUNPTR)_lea_r2r_opl,
+						OPL(_lea_r2r_op, reg_dst),
 						IARG_FAST_ANALYSIS_CALL,
 						IARG_REG_VALUE, thread_ctx_ptr,
 					IARG_UINT32, REG32_INDX(reg_dst),
@@ -5259,6 +8070,723 @@ ins_inspect(INS ins)
 						IARG_END);
 			}
 			
+			/* done */
+			break;
+		/*
+		 * SSE/SSE2/SSSE3/SSE4 and MMX moves;
+		 * t[dst] = t[src] (see ins_vxfer())
+		 */
+		case XED_ICLASS_MOVDQA:
+		case XED_ICLASS_MOVDQU:
+		case XED_ICLASS_MOVAPS:
+		case XED_ICLASS_MOVUPS:
+		case XED_ICLASS_MOVAPD:
+		case XED_ICLASS_MOVUPD:
+		case XED_ICLASS_LDDQU:
+		case XED_ICLASS_MOVNTDQ:
+		case XED_ICLASS_MOVNTDQA:
+		case XED_ICLASS_MOVNTPS:
+		case XED_ICLASS_MOVNTPD:
+		case XED_ICLASS_MOVNTQ:
+			ins_vxfer(ins, 0, 1, 0, 0);
+
+			/* done */
+			break;
+		/* movd, movq; the destination register is zero-extended */
+		case XED_ICLASS_MOVD:
+			ins_vxfer(ins, 4, 1, 0, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_MOVQ:
+		case XED_ICLASS_MOVQ2DQ:
+		case XED_ICLASS_MOVDQ2Q:
+			ins_vxfer(ins, 8, 1, 0, 0);
+
+			/* done */
+			break;
+		/* movss, movsd; zero-extended only when loaded */
+		case XED_ICLASS_MOVSS:
+			ins_vxfer(ins, 4, INS_OperandIsMemory(ins, OP_1), 0, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_MOVSD_XMM:
+			ins_vxfer(ins, 8, INS_OperandIsMemory(ins, OP_1), 0, 0);
+
+			/* done */
+			break;
+		/* the low (high) quad word */
+		case XED_ICLASS_MOVLPS:
+		case XED_ICLASS_MOVLPD:
+			ins_vxfer(ins, 8, 0, 0, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_MOVHPS:
+		case XED_ICLASS_MOVHPD:
+			if (INS_OperandIsReg(ins, OP_0))
+				ins_vxfer(ins, 8, 0, 8, 0);
+			else
+				ins_vxfer(ins, 8, 0, 0, 8);
+
+			/* done */
+			break;
+		case XED_ICLASS_MOVHLPS:
+			ins_vxfer(ins, 8, 0, 0, 8);
+
+			/* done */
+			break;
+		case XED_ICLASS_MOVLHPS:
+			ins_vxfer(ins, 8, 0, 8, 0);
+
+			/* done */
+			break;
+		/* extract an element; the destination is zero-extended */
+		case XED_ICLASS_PEXTRB:
+		case XED_ICLASS_PEXTRW:
+		case XED_ICLASS_PEXTRD:
+		case XED_ICLASS_PEXTRQ:
+			/* the element size */
+			switch (ins_indx) {
+				case XED_ICLASS_PEXTRB:
+					len = 1;
+					break;
+				case XED_ICLASS_PEXTRW:
+					len = 2;
+					break;
+				case XED_ICLASS_PEXTRD:
+					len = 4;
+					break;
+				default:
+					len = 8;
+					break;
+			}
+			imm = INS_OperandImmediate(ins, OP_2) &
+				(REG_Size(INS_OperandReg(ins, OP_1)) / len - 1);
+			ins_vxfer(ins, len, 1, 0, imm * len);
+
+			/* done */
+			break;
+		/* insert an element */
+		case XED_ICLASS_PINSRB:
+		case XED_ICLASS_PINSRW:
+		case XED_ICLASS_PINSRD:
+		case XED_ICLASS_PINSRQ:
+			/* the element size */
+			switch (ins_indx) {
+				case XED_ICLASS_PINSRB:
+					len = 1;
+					break;
+				case XED_ICLASS_PINSRW:
+					len = 2;
+					break;
+				case XED_ICLASS_PINSRD:
+					len = 4;
+					break;
+				default:
+					len = 8;
+					break;
+			}
+			imm = INS_OperandImmediate(ins, OP_2) &
+				(REG_Size(INS_OperandReg(ins, OP_0)) / len - 1);
+			ins_vxfer(ins, len, 0, imm * len, 0);
+
+			/* done */
+			break;
+		/*
+		 * SIMD logical, arithmetic, and comparison operations;
+		 * t[dst] |= t[src] per element (see ins_vbinary()).
+		 * The ones that yield a constant when both operands
+		 * are the same register clear the destination
+		 */
+		case XED_ICLASS_PXOR:
+		case XED_ICLASS_XORPS:
+		case XED_ICLASS_XORPD:
+		case XED_ICLASS_PANDN:
+		case XED_ICLASS_ANDNPS:
+		case XED_ICLASS_ANDNPD:
+		case XED_ICLASS_PCMPEQB:
+		case XED_ICLASS_PCMPGTB:
+		case XED_ICLASS_PSUBB:
+		case XED_ICLASS_PSUBSB:
+		case XED_ICLASS_PSUBUSB:
+			ins_vbinary(ins, 0, 1, 1);
+
+			/* done */
+			break;
+		case XED_ICLASS_PCMPEQW:
+		case XED_ICLASS_PCMPGTW:
+		case XED_ICLASS_PSUBW:
+		case XED_ICLASS_PSUBSW:
+		case XED_ICLASS_PSUBUSW:
+			ins_vbinary(ins, 0, 2, 1);
+
+			/* done */
+			break;
+		case XED_ICLASS_PCMPEQD:
+		case XED_ICLASS_PCMPGTD:
+		case XED_ICLASS_PSUBD:
+			ins_vbinary(ins, 0, 4, 1);
+
+			/* done */
+			break;
+		case XED_ICLASS_PCMPEQQ:
+		case XED_ICLASS_PCMPGTQ:
+		case XED_ICLASS_PSUBQ:
+			ins_vbinary(ins, 0, 8, 1);
+
+			/* done */
+			break;
+		case XED_ICLASS_POR:
+		case XED_ICLASS_ORPS:
+		case XED_ICLASS_ORPD:
+		case XED_ICLASS_PAND:
+		case XED_ICLASS_ANDPS:
+		case XED_ICLASS_ANDPD:
+		case XED_ICLASS_PADDB:
+		case XED_ICLASS_PADDSB:
+		case XED_ICLASS_PADDUSB:
+		case XED_ICLASS_PMINUB:
+		case XED_ICLASS_PMAXUB:
+		case XED_ICLASS_PMINSB:
+		case XED_ICLASS_PMAXSB:
+		case XED_ICLASS_PAVGB:
+		case XED_ICLASS_PABSB:
+		case XED_ICLASS_PBLENDVB:
+			ins_vbinary(ins, 0, 1, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_PADDW:
+		case XED_ICLASS_PADDSW:
+		case XED_ICLASS_PADDUSW:
+		case XED_ICLASS_PMINUW:
+		case XED_ICLASS_PMAXUW:
+		case XED_ICLASS_PMINSW:
+		case XED_ICLASS_PMAXSW:
+		case XED_ICLASS_PAVGW:
+		case XED_ICLASS_PMULLW:
+		case XED_ICLASS_PMULHW:
+		case XED_ICLASS_PMULHUW:
+		/* shifts; t[dst] is mixed per element */
+		case XED_ICLASS_PSLLW:
+		case XED_ICLASS_PSRLW:
+		case XED_ICLASS_PSRAW:
+			ins_vbinary(ins, 0, 2, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_PADDD:
+		case XED_ICLASS_PMINUD:
+		case XED_ICLASS_PMAXUD:
+		case XED_ICLASS_PMINSD:
+		case XED_ICLASS_PMAXSD:
+		case XED_ICLASS_PMULLD:
+		case XED_ICLASS_PMADDWD:
+		case XED_ICLASS_PSLLD:
+		case XED_ICLASS_PSRLD:
+		case XED_ICLASS_PSRAD:
+		case XED_ICLASS_ADDPS:
+		case XED_ICLASS_SUBPS:
+		case XED_ICLASS_MULPS:
+		case XED_ICLASS_DIVPS:
+		case XED_ICLASS_MINPS:
+		case XED_ICLASS_MAXPS:
+		case XED_ICLASS_CMPPS:
+		case XED_ICLASS_BLENDVPS:
+			ins_vbinary(ins, 0, 4, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_PADDQ:
+		case XED_ICLASS_PMULUDQ:
+		case XED_ICLASS_PSADBW:
+		case XED_ICLASS_PSLLQ:
+		case XED_ICLASS_PSRLQ:
+		case XED_ICLASS_ADDPD:
+		case XED_ICLASS_SUBPD:
+		case XED_ICLASS_MULPD:
+		case XED_ICLASS_DIVPD:
+		case XED_ICLASS_MINPD:
+		case XED_ICLASS_MAXPD:
+		case XED_ICLASS_CMPPD:
+		case XED_ICLASS_BLENDVPD:
+			ins_vbinary(ins, 0, 8, 0);
+
+			/* done */
+			break;
+		/* scalar; the low element only */
+		case XED_ICLASS_ADDSS:
+		case XED_ICLASS_SUBSS:
+		case XED_ICLASS_MULSS:
+		case XED_ICLASS_DIVSS:
+		case XED_ICLASS_MINSS:
+		case XED_ICLASS_MAXSS:
+		case XED_ICLASS_CMPSS:
+			ins_vbinary(ins, 4, 4, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_ADDSD:
+		case XED_ICLASS_SUBSD:
+		case XED_ICLASS_MULSD:
+		case XED_ICLASS_DIVSD:
+		case XED_ICLASS_MINSD:
+		case XED_ICLASS_MAXSD:
+		case XED_ICLASS_CMPSD_XMM:
+			ins_vbinary(ins, 8, 8, 0);
+
+			/* done */
+			break;
+		/* packs, pshufb, horizontal operations; all the bytes */
+		case XED_ICLASS_PACKSSWB:
+		case XED_ICLASS_PACKUSWB:
+		case XED_ICLASS_PACKSSDW:
+		case XED_ICLASS_PACKUSDW:
+		case XED_ICLASS_PSHUFB:
+		case XED_ICLASS_PHADDW:
+			ins_vbinary(ins, 0, 0, 0);
+
+			/* done */
+			break;
+		/* unary; t[dst] = t[src], mixed per element */
+		case XED_ICLASS_SQRTPS:
+		case XED_ICLASS_CVTDQ2PS:
+		case XED_ICLASS_CVTPS2DQ:
+		case XED_ICLASS_CVTTPS2DQ:
+			ins_vxfer(ins, 0, 0, 0, 0);
+			ins_vbinary(ins, 0, 4, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_SQRTPD:
+			ins_vxfer(ins, 0, 0, 0, 0);
+			ins_vbinary(ins, 0, 8, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_SQRTSS:
+			ins_vxfer(ins, 4, 0, 0, 0);
+			ins_vbinary(ins, 4, 4, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_SQRTSD:
+			ins_vxfer(ins, 8, 0, 0, 0);
+			ins_vbinary(ins, 8, 8, 0);
+
+			/* done */
+			break;
+		/* conversions; mix the bytes of the source */
+		case XED_ICLASS_CVTSI2SS:
+		case XED_ICLASS_CVTSD2SS:
+			ins_vfold(ins, 0, 4, 0, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_CVTSI2SD:
+			ins_vfold(ins, 0, 8, 0, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_CVTSS2SD:
+			ins_vfold(ins, 0, 8, 4, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_CVTSS2SI:
+		case XED_ICLASS_CVTTSS2SI:
+			ins_vfold(ins, 0, 0, 4, 1);
+
+			/* done */
+			break;
+		case XED_ICLASS_CVTSD2SI:
+		case XED_ICLASS_CVTTSD2SI:
+			ins_vfold(ins, 0, 0, 8, 1);
+
+			/* done */
+			break;
+		case XED_ICLASS_CVTDQ2PD:
+		case XED_ICLASS_CVTPS2PD:
+			ins_vfold(ins, 0, XMM_LEN, 8, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_CVTPD2DQ:
+		case XED_ICLASS_CVTTPD2DQ:
+		case XED_ICLASS_CVTPD2PS:
+			ins_vfold(ins, 0, 8, XMM_LEN, 1);
+
+			/* done */
+			break;
+		/* masks; a bit per byte (element) of the source */
+		case XED_ICLASS_PMOVMSKB:
+			ins_vfold(ins, 8, 0, 0, 1);
+
+			/* done */
+			break;
+		case XED_ICLASS_MOVMSKPS:
+		case XED_ICLASS_MOVMSKPD:
+			ins_vfold(ins, XMM_LEN, 0, 0, 1);
+
+			/* done */
+			break;
+		/*
+		 * shuffles; every byte of the destination gets the
+		 * tag of a byte of the destination or of the source
+		 * (see ins_vshuffle())
+		 */
+		case XED_ICLASS_PUNPCKLBW:
+		case XED_ICLASS_PUNPCKLWD:
+		case XED_ICLASS_PUNPCKLDQ:
+		case XED_ICLASS_PUNPCKLQDQ:
+		case XED_ICLASS_UNPCKLPS:
+		case XED_ICLASS_UNPCKLPD:
+		case XED_ICLASS_PUNPCKHBW:
+		case XED_ICLASS_PUNPCKHWD:
+		case XED_ICLASS_PUNPCKHDQ:
+		case XED_ICLASS_PUNPCKHQDQ:
+		case XED_ICLASS_UNPCKHPS:
+		case XED_ICLASS_UNPCKHPD:
+			len = REG_Size(INS_OperandReg(ins, OP_0));
+
+			/* the element size, and the half */
+			switch (ins_indx) {
+				case XED_ICLASS_PUNPCKLBW:
+					perm_unpck(perm, len, 1, 0);
+					break;
+				case XED_ICLASS_PUNPCKLWD:
+					perm_unpck(perm, len, 2, 0);
+					break;
+				case XED_ICLASS_PUNPCKLDQ:
+				case XED_ICLASS_UNPCKLPS:
+					perm_unpck(perm, len, 4, 0);
+					break;
+				case XED_ICLASS_PUNPCKLQDQ:
+				case XED_ICLASS_UNPCKLPD:
+					perm_unpck(perm, len, 8, 0);
+					break;
+				case XED_ICLASS_PUNPCKHBW:
+					perm_unpck(perm, len, 1, 1);
+					break;
+				case XED_ICLASS_PUNPCKHWD:
+					perm_unpck(perm, len, 2, 1);
+					break;
+				case XED_ICLASS_PUNPCKHDQ:
+				case XED_ICLASS_UNPCKHPS:
+					perm_unpck(perm, len, 4, 1);
+					break;
+				default:
+					perm_unpck(perm, len, 8, 1);
+					break;
+			}
+			ins_vshuffle(ins, perm, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_PSHUFD:
+			perm_pshuf(perm, XMM_LEN, 4, 0,
+					INS_OperandImmediate(ins, OP_2));
+			ins_vshuffle(ins, perm, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_PSHUFLW:
+			perm_pshuf(perm, XMM_LEN, 2, 0,
+					INS_OperandImmediate(ins, OP_2));
+			ins_vshuffle(ins, perm, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_PSHUFHW:
+			perm_pshuf(perm, XMM_LEN, 2, 4,
+					INS_OperandImmediate(ins, OP_2));
+			ins_vshuffle(ins, perm, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_PSHUFW:
+			perm_pshuf(perm, MMX_LEN, 2, 0,
+					INS_OperandImmediate(ins, OP_2));
+			ins_vshuffle(ins, perm, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_SHUFPS:
+			/* dwords 0-1 from the destination, 2-3 from the source */
+			imm = INS_OperandImmediate(ins, OP_2);
+			for (i = 0; i < XMM_LEN; i++)
+				perm[i] = ((i < 8) ? 0 : VEC_PERM_SRC) +
+					((imm >> (2 * (i / 4))) & 3) * 4 + i % 4;
+			ins_vshuffle(ins, perm, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_SHUFPD:
+			/* qword 0 from the destination, 1 from the source */
+			imm = INS_OperandImmediate(ins, OP_2);
+			for (i = 0; i < XMM_LEN; i++)
+				perm[i] = ((i < 8) ? 0 : VEC_PERM_SRC) +
+					((imm >> (i / 8)) & 1) * 8 + i % 8;
+			ins_vshuffle(ins, perm, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_PALIGNR:
+			/* the bytes imm ... of the source:destination pair */
+			len = REG_Size(INS_OperandReg(ins, OP_0));
+			imm = INS_OperandImmediate(ins, OP_2);
+			for (i = 0; i < len; i++)
+				perm[i] = (i + imm < len) ?
+					VEC_PERM_SRC + i + imm :
+					((i + imm < 2 * len) ?
+					i + imm - len : VEC_PERM_ZERO);
+			ins_vshuffle(ins, perm, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_PSLLDQ:
+		case XED_ICLASS_PSRLDQ:
+			/* byte shifts of the destination */
+			imm = INS_OperandImmediate(ins, OP_1);
+			for (i = 0; i < XMM_LEN; i++)
+				if (ins_indx == XED_ICLASS_PSLLDQ)
+					perm[i] = (i >= imm) ?
+						i - imm : VEC_PERM_ZERO;
+				else
+					perm[i] = (i + imm < XMM_LEN) ?
+						i + imm : VEC_PERM_ZERO;
+			ins_vshuffle(ins, perm, 1);
+
+			/* done */
+			break;
+		case XED_ICLASS_MOVDDUP:
+			for (i = 0; i < XMM_LEN; i++)
+				perm[i] = VEC_PERM_SRC + i % 8;
+			ins_vshuffle(ins, perm, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_MOVSLDUP:
+		case XED_ICLASS_MOVSHDUP:
+			/* the even (odd) dwords, duplicated */
+			for (i = 0; i < XMM_LEN; i++)
+				perm[i] = VEC_PERM_SRC + i % 4 + 4 *
+					(((i / 4) & ~1U) |
+					(ins_indx == XED_ICLASS_MOVSHDUP));
+			ins_vshuffle(ins, perm, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_BLENDPS:
+		case XED_ICLASS_BLENDPD:
+		case XED_ICLASS_PBLENDW:
+			/* the elements selected by the immediate */
+			len = (ins_indx == XED_ICLASS_BLENDPS) ? 4 :
+				((ins_indx == XED_ICLASS_BLENDPD) ? 8 : 2);
+			imm = INS_OperandImmediate(ins, OP_2);
+			for (i = 0; i < XMM_LEN; i++)
+				perm[i] = ((imm >> (i / len)) & 1) ?
+					VEC_PERM_SRC + i : i;
+			ins_vshuffle(ins, perm, 0);
+
+			/* done */
+			break;
+		/* string comparisons (SSE4.2) */
+		case XED_ICLASS_PCMPISTRI:
+			ins_vpcmpstr(ins, REG_ECX, 1, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_PCMPESTRI:
+			ins_vpcmpstr(ins, REG_ECX, 1, 1);
+
+			/* done */
+			break;
+		case XED_ICLASS_PCMPISTRM:
+			ins_vpcmpstr(ins, REG_XMM0, XMM_LEN, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_PCMPESTRM:
+			ins_vpcmpstr(ins, REG_XMM0, XMM_LEN, 1);
+
+			/* done */
+			break;
+		/*
+		 * AVX/AVX2 moves; t[dst] = t[src] (see ins_vxfer()), and
+		 * the upper half of a VEX.128 destination is cleared
+		 */
+		case XED_ICLASS_VMOVDQA:
+		case XED_ICLASS_VMOVDQU:
+		case XED_ICLASS_VMOVAPS:
+		case XED_ICLASS_VMOVUPS:
+		case XED_ICLASS_VMOVAPD:
+		case XED_ICLASS_VMOVUPD:
+		case XED_ICLASS_VLDDQU:
+		case XED_ICLASS_VMOVNTDQ:
+		case XED_ICLASS_VMOVNTDQA:
+		case XED_ICLASS_VMOVNTPS:
+		case XED_ICLASS_VMOVNTPD:
+			ins_vxfer(ins, 0, 1, 0, 0);
+			ins_vzx(ins);
+
+			/* done */
+			break;
+		case XED_ICLASS_VMOVD:
+			ins_vxfer(ins, 4, 1, 0, 0);
+			ins_vzx(ins);
+
+			/* done */
+			break;
+		case XED_ICLASS_VMOVQ:
+			ins_vxfer(ins, 8, 1, 0, 0);
+			ins_vzx(ins);
+
+			/* done */
+			break;
+		/* broadcasts; mix the element into every byte */
+		case XED_ICLASS_VPBROADCASTB:
+			ins_vfold(ins, 0, 0, 1, 1);
+			ins_vzx(ins);
+
+			/* done */
+			break;
+		case XED_ICLASS_VPBROADCASTW:
+			ins_vfold(ins, 0, 0, 2, 1);
+			ins_vzx(ins);
+
+			/* done */
+			break;
+		case XED_ICLASS_VPBROADCASTD:
+		case XED_ICLASS_VBROADCASTSS:
+			ins_vfold(ins, 0, 0, 4, 1);
+			ins_vzx(ins);
+
+			/* done */
+			break;
+		case XED_ICLASS_VPBROADCASTQ:
+		case XED_ICLASS_VBROADCASTSD:
+			ins_vfold(ins, 0, 0, 8, 1);
+			ins_vzx(ins);
+
+			/* done */
+			break;
+		/*
+		 * AVX/AVX2 logical, arithmetic, and comparison operations;
+		 * t[dst] = t[src1] | t[src2] per element (see ins_vbinary3())
+		 */
+		case XED_ICLASS_VPXOR:
+		case XED_ICLASS_VXORPS:
+		case XED_ICLASS_VXORPD:
+		case XED_ICLASS_VPANDN:
+		case XED_ICLASS_VANDNPS:
+		case XED_ICLASS_VANDNPD:
+		case XED_ICLASS_VPCMPEQB:
+		case XED_ICLASS_VPCMPGTB:
+		case XED_ICLASS_VPSUBB:
+			ins_vbinary3(ins, 1, 1);
+
+			/* done */
+			break;
+		case XED_ICLASS_VPCMPEQW:
+		case XED_ICLASS_VPCMPGTW:
+		case XED_ICLASS_VPSUBW:
+			ins_vbinary3(ins, 2, 1);
+
+			/* done */
+			break;
+		case XED_ICLASS_VPCMPEQD:
+		case XED_ICLASS_VPCMPGTD:
+		case XED_ICLASS_VPSUBD:
+			ins_vbinary3(ins, 4, 1);
+
+			/* done */
+			break;
+		case XED_ICLASS_VPCMPEQQ:
+		case XED_ICLASS_VPCMPGTQ:
+		case XED_ICLASS_VPSUBQ:
+			ins_vbinary3(ins, 8, 1);
+
+			/* done */
+			break;
+		case XED_ICLASS_VPOR:
+		case XED_ICLASS_VORPS:
+		case XED_ICLASS_VORPD:
+		case XED_ICLASS_VPAND:
+		case XED_ICLASS_VANDPS:
+		case XED_ICLASS_VANDPD:
+		case XED_ICLASS_VPADDB:
+		case XED_ICLASS_VPMINUB:
+		case XED_ICLASS_VPMAXUB:
+		case XED_ICLASS_VPMINSB:
+		case XED_ICLASS_VPMAXSB:
+			ins_vbinary3(ins, 1, 0);
+
+			/* done */
+			break;
+		/* masks; a bit per byte (element) of the source */
+		case XED_ICLASS_VPMOVMSKB:
+			ins_vfold(ins, 8, 0, 0, 1);
+
+			/* done */
+			break;
+		case XED_ICLASS_VMOVMSKPS:
+		case XED_ICLASS_VMOVMSKPD:
+			ins_vfold(ins, XMM_LEN, 0, 0, 1);
+
+			/* done */
+			break;
+		/* string comparisons; VEX.128 (see ins_vpcmpstr()) */
+		case XED_ICLASS_VPCMPISTRI:
+			ins_vpcmpstr(ins, REG_ECX, 1, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_VPCMPESTRI:
+			ins_vpcmpstr(ins, REG_ECX, 1, 1);
+
+			/* done */
+			break;
+		case XED_ICLASS_VPCMPISTRM:
+			ins_vpcmpstr(ins, REG_YMM0, XMM_LEN, 0);
+
+			/* done */
+			break;
+		case XED_ICLASS_VPCMPESTRM:
+			ins_vpcmpstr(ins, REG_YMM0, XMM_LEN, 1);
+
+			/* done */
+			break;
+		/* vzeroupper, vzeroall */
+		case XED_ICLASS_VZEROUPPER:
+		case XED_ICLASS_VZEROALL:
+			/* propagate the tag accordingly */
+			INS_InsertCall(ins,
+				IPOINT_BEFORE,
+				(AFUNPTR)v_zeroupper,
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE, thread_ctx_ptr,
+				IARG_UINT32, ins_indx == XED_ICLASS_VZEROALL,
+				IARG_END);
+
+			/* done */
+			break;
+		/* EFLAGS only, or no data; do nothing */
+		case XED_ICLASS_PTEST:
+		case XED_ICLASS_COMISS:
+		case XED_ICLASS_COMISD:
+		case XED_ICLASS_UCOMISS:
+		case XED_ICLASS_UCOMISD:
+		case XED_ICLASS_EMMS:
+		case XED_ICLASS_VPTEST:
+		case XED_ICLASS_VTESTPS:
+		case XED_ICLASS_VTESTPD:
+		case XED_ICLASS_VCOMISS:
+		case XED_ICLASS_VCOMISD:
+		case XED_ICLASS_VUCOMISS:
+		case XED_ICLASS_VUCOMISD:
 			/* done */
 			break;
 		/* cmpxchg */
@@ -5274,8 +8802,549 @@ ins_inspect(INS ins)
 		 * default handler
 		 */
 		default:
+			/* x87 */
+			if (INS_Category(ins) == XED_CATEGORY_X87_ALU)
+				ins_x87(ins);
+			/* AVX/AVX2; clear the destination */
+			else if (ins_is_avx(ins))
+				ins_vclr(ins);
 			/* (void)fprintf(stdout, "%s\n",
 				INS_Disassemble(ins).c_str()); */
 			break;
 	}
 }
+
+#ifndef	TAGMAP_LABEL
+/*
+ * check if an instruction has no tag effect; it neither writes memory
+ * nor any register other than EFLAGS and EIP (e.g., cmp, test, jcc), or
+ * it is a binary ALU one with an immediate (see ins_dispatch()), unless
+ * it zero-extends a 32-bit destination (x86-64)
+ *
+ * @ins:	the instruction
+ *
+ * returns:	1 if it has no tag effect, 0 otherwise
+ */
+static int
+ins_transparent(INS ins)
+{
+	REG	reg;	/* a register	*/
+	UINT32	i;	/* iterator	*/
+
+	switch (INS_Opcode(ins)) {
+		case XED_ICLASS_ADC:
+		case XED_ICLASS_ADD:
+		case XED_ICLASS_AND:
+		case XED_ICLASS_OR:
+		case XED_ICLASS_XOR:
+		case XED_ICLASS_SBB:
+		case XED_ICLASS_SUB:
+#if defined(TARGET_IA32E)
+			/* a 32-bit destination is zero-extended */
+			if (INS_OperandIsReg(ins, OP_0) &&
+					REG_is_gr32(INS_OperandReg(ins, OP_0)))
+				return 0;
+#endif
+			if (INS_OperandIsImmediate(ins, OP_1))
+				return 1;
+			break;
+		default:
+			break;
+	}
+
+	if (INS_IsMemoryWrite(ins))
+		return 0;
+	for (i = 0; i < INS_MaxNumWRegs(ins); i++) {
+		reg = REG_FullRegName(INS_RegW(ins, i));
+		if (reg != REG_GFLAGS && reg != REG_INST_PTR)
+			return 0;
+	}
+
+	return 1;
+}
+
+/*
+ * describe the tag effect of a register-to-register instruction as
+ * t[dst] = (keep ? t[dst] : 0) | t[srcs]; on x86-64, the 32-bit ones
+ * zero-extend the result (see VCPU_ZX32())
+ *
+ * @ins:	the instruction
+ * @dst:	the destination (VCPU)
+ * @srcs:	the sources (VCPU); a bitmap
+ * @keep:	set if the destination is also a source
+ * @trunc:	set if the result is zero-extended
+ *
+ * returns:	1 if it can be described, 0 otherwise
+ */
+static int
+ins_ir_reg(INS ins, uint32_t *dst, uint32_t *srcs, int *keep, int *trunc)
+{
+	REG	reg_dst, reg_src, reg_base, reg_indx;
+
+	if (INS_IsPredicated(ins) || INS_OperandCount(ins) < 2 ||
+			!INS_OperandIsReg(ins, OP_0) ||
+			!REG_is_grl(reg_dst = INS_OperandReg(ins, OP_0)))
+		return 0;
+
+	*dst	= REG32_INDX(REG_FullRegName(reg_dst));
+	*srcs	= 0;
+	*keep	= 0;
+#if defined(TARGET_IA32E)
+	*trunc	= REG_is_gr32(reg_dst);
+#else
+	*trunc	= 0;
+#endif
+
+	switch (INS_Opcode(ins)) {
+		case XED_ICLASS_MOV:
+			/* clear */
+			if (INS_OperandIsImmediate(ins, OP_1))
+				return 1;
+
+			/* t[dst] = t[src] */
+			if (INS_OperandIsReg(ins, OP_1) &&
+				REG_is_grl(reg_src = INS_OperandReg(ins, OP_1))) {
+				*srcs = 1U << REG32_INDX(REG_FullRegName(reg_src));
+				return 1;
+			}
+			break;
+		case XED_ICLASS_ADC:
+		case XED_ICLASS_ADD:
+		case XED_ICLASS_AND:
+		case XED_ICLASS_OR:
+		case XED_ICLASS_XOR:
+		case XED_ICLASS_SBB:
+		case XED_ICLASS_SUB:
+			if (INS_MemoryOperandCount(ins) != 0)
+				break;
+
+			/* t[dst] |= 0; zero-extends a 32-bit dst (x86-64) */
+			if (INS_OperandIsImmediate(ins, OP_1)) {
+				*keep = 1;
+				return 1;
+			}
+
+			if (!INS_OperandIsReg(ins, OP_1) ||
+				!REG_is_grl(reg_src = INS_OperandReg(ins, OP_1)))
+				break;
+
+			/* x86 clear register idiom */
+			if (reg_dst == reg_src &&
+				(INS_Opcode(ins) == XED_ICLASS_XOR ||
+				INS_Opcode(ins) == XED_ICLASS_SUB ||
+				INS_Opcode(ins) == XED_ICLASS_SBB))
+				return 1;
+
+			/* t[dst] |= t[src] */
+			*srcs = 1U << REG32_INDX(REG_FullRegName(reg_src));
+			*keep = 1;
+			return 1;
+		case XED_ICLASS_LEA:
+			/* t[dst] = t[base] | t[index] */
+			reg_base = INS_MemoryBaseReg(ins);
+			reg_indx = INS_MemoryIndexReg(ins);
+
+			if (reg_base != REG_INVALID()) {
+				if (!REG_is_grl(reg_base))
+					break;
+				*srcs |= 1U << REG32_INDX(REG_FullRegName(reg_base));
+			}
+			if (reg_indx != REG_INVALID()) {
+				if (!REG_is_grl(reg_indx))
+					break;
+				*srcs |= 1U << REG32_INDX(REG_FullRegName(reg_indx));
+			}
+			return 1;
+		default:
+			break;
+	}
+
+	return 0;
+}
+
+/*
+ * describe the tag effect of an instruction that moves a (32/64-bit)
+ * register, or an immediate, to/from the memory (mov, push, pop) at
+ * base + disp, where base is a register (REG_INVALID() if the address
+ * is absolute, including the EIP-relative ones)
+ *
+ * @ins:	the instruction
+ * @kind:	the operation (IR_MEM_{LD, ST, CLR})
+ * @reg:	the register (VCPU)
+ * @len:	the operand size in bytes
+ * @base:	the base register
+ * @disp:	the displacement
+ * @adj:	the adjustment of the base register (push, pop)
+ *
+ * returns:	1 if it can be described, 0 otherwise
+ */
+static int
+ins_ir_mem(INS ins, uint32_t *kind, uint32_t *reg, size_t *len, REG *base,
+		ADDRINT *disp, ADDRINT *adj)
+{
+	REG	reg_op;	/* the register operand */
+
+	if (INS_IsPredicated(ins) || INS_HasRealRep(ins) ||
+			INS_SegmentRegPrefix(ins) != REG_INVALID() ||
+			INS_OperandCount(ins) == 0)
+		return 0;
+
+	*reg	= 0;
+	*adj	= 0;
+
+	switch (INS_Opcode(ins)) {
+		case XED_ICLASS_PUSH:
+			*len	= INS_MemoryWriteSize(ins);
+			*base	= REG_STACK_PTR;
+			*disp	= -(ADDRINT)*len;
+			*adj	= -(ADDRINT)*len;
+
+			/* clear */
+			if (INS_OperandIsImmediate(ins, OP_0)) {
+				*kind = IR_MEM_CLR;
+				return 1;
+			}
+
+			/* t[esp - len] = t[src] */
+			if (INS_OperandIsReg(ins, OP_0) &&
+				REG_is_grl(reg_op = INS_OperandReg(ins, OP_0))) {
+				*kind	= IR_MEM_ST;
+				*reg	= REG32_INDX(REG_FullRegName(reg_op));
+				return 1;
+			}
+			return 0;
+		case XED_ICLASS_POP:
+			/* t[dst] = t[esp]; not for esp itself */
+			if (INS_OperandIsReg(ins, OP_0) &&
+				REG_is_grl(reg_op = INS_OperandReg(ins, OP_0)) &&
+				REG_FullRegName(reg_op) != REG_STACK_PTR) {
+				*kind	= IR_MEM_LD;
+				*reg	= REG32_INDX(REG_FullRegName(reg_op));
+				*len	= INS_MemoryReadSize(ins);
+				*base	= REG_STACK_PTR;
+				*disp	= 0;
+				*adj	= *len;
+				return 1;
+			}
+			return 0;
+		case XED_ICLASS_MOV:
+			if (INS_MemoryOperandCount(ins) != 1 ||
+				INS_MemoryIndexReg(ins) != REG_INVALID())
+				return 0;
+
+			/* t[dst] = t[mem] */
+			if (INS_OperandIsReg(ins, OP_0) &&
+				INS_OperandIsMemory(ins, OP_1) &&
+				REG_is_grl(reg_op = INS_OperandReg(ins, OP_0))) {
+				*kind	= IR_MEM_LD;
+				*len	= INS_MemoryReadSize(ins);
+			}
+			/* t[mem] = t[src] */
+			else if (INS_OperandIsMemory(ins, OP_0) &&
+				INS_OperandIsReg(ins, OP_1) &&
+				REG_is_grl(reg_op = INS_OperandReg(ins, OP_1))) {
+				*kind	= IR_MEM_ST;
+				*len	= INS_MemoryWriteSize(ins);
+			}
+			/* clear */
+			else if (INS_OperandIsMemory(ins, OP_0) &&
+				INS_OperandIsImmediate(ins, OP_1)) {
+				reg_op	= REG_INVALID();
+				*kind	= IR_MEM_CLR;
+				*len	= INS_MemoryWriteSize(ins);
+			}
+			else
+				return 0;
+
+			if (reg_op != REG_INVALID())
+				*reg = REG32_INDX(REG_FullRegName(reg_op));
+
+			/* the address */
+			*base	= INS_MemoryBaseReg(ins);
+			*disp	= (ADDRINT)INS_MemoryDisplacement(ins);
+
+			/* absolute */
+			if (*base == REG_INVALID())
+				return 1;
+			if (*base == REG_INST_PTR) {
+				*base	= REG_INVALID();
+				*disp	+= INS_NextAddress(ins);
+				return 1;
+			}
+
+			/* full-width base register (no address-size override) */
+			return (REG_is_grl(*base) && REG_FullRegName(*base) == *base);
+		default:
+			break;
+	}
+
+	return 0;
+}
+
+/*
+ * coalesce the register run that starts at an instruction of a trace
+ * (see ir_reg_t); the instructions without a tag effect, and the dead
+ * ones, do not break a run, whereas every other instruction and the
+ * end of the BBL do
+ *
+ * @inss:	the instructions of the trace
+ * @state:	their state (INS_*)
+ * @i:		the first instruction of the run
+ *
+ * returns:	the number of coalesced instructions
+ */
+static size_t
+reg_coalesce(vector<INS> &inss, vector<char> &state, size_t i)
+{
+	ir_set_t	regs[GRP_NUM];	/* the tag of every register	*/
+	ir_set_t	tag;		/* new tag			*/
+	vector<size_t>	run;		/* the instructions of the run	*/
+	ir_reg_t	ir;		/* the summary			*/
+	uint32_t	dst, srcs, s;	/* destination, sources		*/
+	int		keep, trunc;	/* see ins_ir_reg()		*/
+	size_t		j;		/* iterator			*/
+
+	for (j = 0; j < GRP_NUM; j++) {
+		regs[j].full	= 1U << j;
+		regs[j].low	= 0;
+	}
+
+	for (j = i; j < inss.size(); j++) {
+		if (state[j] == INS_PLAIN &&
+			ins_ir_reg(inss[j], &dst, &srcs, &keep, &trunc)) {
+			/* fold it; over the tags of the start of the run */
+			tag.full	= keep ? regs[dst].full : 0;
+			tag.low		= keep ? regs[dst].low : 0;
+			for (s = srcs; s != 0; s &= s - 1) {
+				tag.full	|= regs[__builtin_ctz(s)].full;
+				tag.low		|= regs[__builtin_ctz(s)].low;
+			}
+			tag.low	&= ~tag.full;
+			if (trunc) {
+				tag.low		|= tag.full;
+				tag.full	= 0;
+			}
+			regs[dst] = tag;
+			run.push_back(j);
+		}
+		else if (j == i || (state[j] != INS_DEAD &&
+				(state[j] != INS_PLAIN ||
+				!ins_transparent(inss[j]))))
+			break;
+
+		/* the end of a BBL */
+		if (!INS_Valid(INS_Next(inss[j])))
+			break;
+	}
+
+	/* nothing to coalesce */
+	if (run.size() < 2)
+		return 0;
+
+	/* the registers whose tag changes */
+	for (ir.n = 0, j = 0; j < GRP_NUM; j++)
+		if (regs[j].full != (1U << j) || regs[j].low != 0) {
+			ir.op[ir.n].dst	= j;
+			ir.op[ir.n++].src	= regs[j];
+		}
+#ifdef	DEBUG_COALESCE
+	LOG(string(__func__) + ": " + hexstr(INS_Address(inss[run[0]])) +
+		": " + decstr(run.size()) + " instructions -> " +
+		decstr(ir.n) + " assignments\n");
+#endif
+
+	/* clear, or t[dst] = t[src]; the existing handlers suffice */
+	if (ir.n == 1 && ir.op[0].src.low == 0 &&
+			(ir.op[0].src.full & (ir.op[0].src.full - 1)) == 0) {
+		if (ir.op[0].src.full == 0)
+			INS_InsertCall(inss[run[0]],
+				IPOINT_BEFORE,
+#if defined(TARGET_IA32E)
+				(AFUNPTR)r_clrq,
+#else
+				(AFUNPTR)r_clrl,
+#endif
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE, thread_ctx_ptr,
+				IARG_UINT32, ir.op[0].dst,
+				IARG_END);
+		else
+			INS_InsertCall(inss[run[0]],
+				IPOINT_BEFORE,
+#if defined(TARGET_IA32E)
+				(AFUNPTR)r2r_xfer_opq,
+#else
+				(AFUNPTR)r2r_xfer_opl,
+#endif
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE, thread_ctx_ptr,
+				IARG_UINT32, ir.op[0].dst,
+				IARG_UINT32, __builtin_ctz(ir.op[0].src.full),
+				IARG_END);
+	}
+	/* the general case */
+	else if (ir.n != 0)
+		INS_InsertCall(inss[run[0]],
+			IPOINT_BEFORE,
+			(AFUNPTR)r_summary,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_PTR, ir_intern(&ir, IR_REG_SZ(ir.n)),
+			IARG_END);
+	/* else no effect (e.g., mov eax, eax) */
+
+	for (j = 0; j < run.size(); j++)
+		state[run[j]] = INS_COALESCED;
+
+	return run.size();
+}
+
+/*
+ * coalesce the memory run that starts at an instruction of a trace
+ * (see ir_mem_t); its instructions are consecutive, within a BBL, and
+ * address the memory via the same base register, which only they
+ * adjust (push, pop)
+ *
+ * @inss:	the instructions of the trace
+ * @state:	their state (INS_*)
+ * @i:		the first instruction of the run
+ *
+ * returns:	the number of coalesced instructions
+ */
+static size_t
+mem_coalesce(vector<INS> &inss, vector<char> &state, size_t i)
+{
+	ir_mem_t	ir;		/* the summary			*/
+	const void	*pir;		/* the summary (interned)	*/
+	REG		base = REG_INVALID(), b; /* the base register	*/
+	ADDRINT		delta = 0;	/* its adjustment so far	*/
+	ADDRINT		disp, adj;	/* see ins_ir_mem()		*/
+	uint32_t	kind, reg;	/* the operation, the register	*/
+	size_t		len, j, n;	/* size, iterator, instructions	*/
+	int		last;		/* the last one of the run	*/
+
+	/* zero the padding too; see ir_intern() */
+	(void)memset(&ir, 0, sizeof(ir));
+
+	for (ir.n = 0, j = i; j < inss.size(); j++) {
+		if (state[j] != INS_PLAIN ||
+			!ins_ir_mem(inss[j], &kind, &reg, &len, &b, &disp, &adj))
+			break;
+
+		/* the base register of the run */
+		if (j == i)
+			base = b;
+		else if (b != base)
+			break;
+
+		/* a load that overwrites the base register ends the run */
+		last = (kind == IR_MEM_LD && base != REG_INVALID() &&
+				reg == REG32_INDX(base));
+		if (last && j == i)
+			break;
+
+		/* merge the adjacent clears */
+		if (kind == IR_MEM_CLR && ir.n != 0 &&
+				ir.op[ir.n - 1].kind == IR_MEM_CLR &&
+				ir.op[ir.n - 1].off + ir.op[ir.n - 1].len ==
+				delta + disp)
+			ir.op[ir.n - 1].len += len;
+		else if (kind == IR_MEM_CLR && ir.n != 0 &&
+				ir.op[ir.n - 1].kind == IR_MEM_CLR &&
+				delta + disp + len == ir.op[ir.n - 1].off) {
+			ir.op[ir.n - 1].off = delta + disp;
+			ir.op[ir.n - 1].len += len;
+		}
+		/* full */
+		else if (ir.n == IR_MEM_MAX)
+			break;
+		else {
+			ir.op[ir.n].kind	= kind;
+			ir.op[ir.n].reg		= reg;
+			ir.op[ir.n].len		= len;
+			ir.op[ir.n++].off	= delta + disp;
+		}
+		delta += adj;
+
+		/* the base register is overwritten, or the end of a BBL */
+		if (last || !INS_Valid(INS_Next(inss[j]))) {
+			j++;
+			break;
+		}
+	}
+
+	/* nothing to coalesce */
+	if ((n = j - i) < 2)
+		return 0;
+
+	pir = ir_intern(&ir, IR_MEM_SZ(ir.n));
+
+	/* absolute addresses */
+	if (base == REG_INVALID())
+		INS_InsertCall(inss[i],
+			IPOINT_BEFORE,
+			(AFUNPTR)m_summary,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_ADDRINT, (ADDRINT)0,
+			IARG_PTR, pir,
+			IARG_END);
+	else
+		INS_InsertCall(inss[i],
+			IPOINT_BEFORE,
+			(AFUNPTR)m_summary,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_REG_VALUE, thread_ctx_ptr,
+			IARG_REG_VALUE, base,
+			IARG_PTR, pir,
+			IARG_END);
+
+#ifdef	DEBUG_COALESCE
+	LOG(string(__func__) + ": " + hexstr(INS_Address(inss[i])) + ": " +
+		decstr(n) + " instructions -> " + decstr(ir.n) +
+		" operations\n");
+#endif
+	for (j = i; j < i + n; j++)
+		state[j] = INS_COALESCED;
+
+	return n;
+}
+#endif
+
+/*
+ * BBL-level coalescing (instrumentation function)
+ *
+ * propagate the runs of simple data movement instructions of a trace
+ * with a single summary call each (see ir_reg_t and ir_mem_t), which
+ * is placed before the first instruction of the run. Where that is the
+ * head of the slow version of a trace, the summary follows the version
+ * switch (see ins_check()), and it is skipped if the trace switches to
+ * the fast version; a switch thus never splits a run. The instructions
+ * that the tool instruments (INS_TOOL) are never coalesced, and hence
+ * their callbacks see the tags at their own boundaries; the rest are
+ * left to ins_inspect() (INS_PLAIN)
+ *
+ * @inss:	the instructions of the trace
+ * @state:	their state; updated with INS_COALESCED
+ *
+ * returns:	the number of coalesced instructions
+ */
+size_t
+ins_coalesce(vector<INS> &inss, vector<char> &state)
+{
+	size_t	n = 0;	/* coalesced instructions	*/
+#ifndef	TAGMAP_LABEL
+	size_t	i, c;	/* iterator, coalesced (run)	*/
+
+	for (i = 0; i < inss.size(); i++) {
+		if (state[i] != INS_PLAIN)
+			continue;
+
+		/* register runs first, then memory runs */
+		if ((c = reg_coalesce(inss, state, i)) == 0)
+			c = mem_coalesce(inss, state, i);
+		n += c;
+	}
+#endif
+	return n;
+}
@@ -33,12 +33,15 @@
 #ifndef __LIBDFT_CORE_H__
 #define __LIBDFT_CORE_H__
 
+#include <vector>
+
 #define R32_ALIGN	12			/* alignment offset for 
 						   mapping 32-bit PIN registers
 						   to VCPU registers */
 #define VCPU_MASK32	0xFFU			/* 32-bit VCPU mask */
 #define VCPU_MASK16	0xFFFFU			/* 16-bit VCPU mask */
 #define VCPU_MASK8	0x01			/* 8-bit VCPU mask */
+#define MEM_QUAD_LEN	64			/* quad size (64-bit) */
 #define MEM_LONG_LEN	32			/* long size (32-bit) */
 #define MEM_WORD_LEN	16			/* word size (16-bit) */
 #define MEM_BYTE_LEN	8			/* byte size (8-bit) */
@@ -47,6 +50,31 @@
 /* extract the EFLAGS.DF bit by applying the corresponding mask */
 #define EFLAGS_DF(eflags)	((eflags & 0x0400))
 
+/*
+ * 32-bit register writes clear the upper half of
+ * the (64-bit) VCPU register on x86-64
+ */
+#define VCPU_ZX32(tag)		((uint32_t)(tag))
+
+/*
+ * long word register operands; on x86-64 the 64-bit registers are
+ * handled by the same code paths as the 32-bit ones (REG32_INDX()
+ * accepts both), and OPL() (OPLS(), for suffixed names) picks the
+ * quad word analysis function (fn##q) for them instead of the long
+ * word one (fn##l)
+ */
+#if defined(TARGET_IA32E)
+#define REG_is_grl(reg)		(REG_is_gr32(reg) || REG_is_gr64(reg))
+#define OPL(fn, reg)		(REG_is_gr64(reg) ?			\
+					(AFUNPTR)fn##q : (AFUNPTR)fn##l)
+#define OPLS(fn, sfx, reg)	(REG_is_gr64(reg) ?			\
+				(AFUNPTR)fn##q##sfx : (AFUNPTR)fn##l##sfx)
+#else
+#define REG_is_grl(reg)		REG_is_gr32(reg)
+#define OPL(fn, reg)		((AFUNPTR)fn##l)
+#define OPLS(fn, sfx, reg)	((AFUNPTR)fn##l##sfx)
+#endif
+
 enum {
 /* #define */ OP_0 = 0,			/* 0th (1st) operand index */
 /* #define */ OP_1 = 1,			/* 1st (2nd) operand index */
@@ -56,8 +84,18 @@ enum {
 /* #define */ OP_5 = 5			/* 5rd (6th) operand index */
 };
 
+/* the instructions of a BBL, as seen by ins_coalesce() */
+enum {
+/* #define */ INS_PLAIN = 0,		/* propagated on its own */
+/* #define */ INS_DEAD = 1,		/* dead propagation; ignored */
+/* #define */ INS_TOOL = 2,		/* instrumented by the tool */
+/* #define */ INS_COALESCED = 3		/* propagated by a summary call */
+};
+
 
 /* core API */
-void ins_inspect(INS);
+void	ins_dispatch_init(void);
+void	ins_inspect(INS);
+size_t	ins_coalesce(vector<INS>&, vector<char>&);
 
 #endif /* __LIBDFT_CORE_H__ */
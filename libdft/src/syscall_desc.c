@@ -37,6 +37,7 @@
 #include <sys/sem.h>
 #include <sys/shm.h>
 #include <sys/socket.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/uio.h>
 
@@ -54,59 +55,729 @@
 
 #include <map>
 
+#ifndef	MREMAP_DONTUNMAP
+#define	MREMAP_DONTUNMAP	4	/* Linux >= 5.7 */
+#endif
+#ifndef	MAP_FIXED_NOREPLACE
+#define	MAP_FIXED_NOREPLACE	0x100000	/* Linux >= 4.17 */
+#endif
 
 /* ``hardcoded'' tagmap segments */
 #ifdef TAGMAP_COLLAPSE
 extern void *zero_seg;
 #endif
-extern void *null_seg;
-
-/* STAB */
-extern uint32_t *STAB;
-
-/* program break */
-extern size_t brk_start, brk_end;
-
-/* shared memory segments (address -> size) */
-map<size_t, size_t> shm;
-
-/* callbacks declaration */
-static void post_read_hook(syscall_ctx_t*);
-static void post_uselib_hook(syscall_ctx_t*);
-static void post_brk_hook(syscall_ctx_t*);
-static void post_fcntl_hook(syscall_ctx_t*);
-static void post_getgroups16_hook(syscall_ctx_t*);
-static void post_mmap_hook(syscall_ctx_t*);
-static void post_munmap_hook(syscall_ctx_t*);
-static void post_socketcall_hook(syscall_ctx_t*);
-static void post_syslog_hook(syscall_ctx_t*);
-static void post_ipc_hook(syscall_ctx_t*);
-static void post_modify_ldt_hook(syscall_ctx_t*);
-#ifdef TAGMAP_COLLAPSE
-static void post_mprotect_hook(syscall_ctx_t*);
+extern void *null_seg;
+
+/* program break */
+extern size_t brk_start, brk_end;
+
+/* shared memory segments (address -> size) */
+map<size_t, size_t> shm;
+
+/* callbacks declaration */
+static void post_read_hook(syscall_ctx_t*);
+static void post_uselib_hook(syscall_ctx_t*);
+static void post_brk_hook(syscall_ctx_t*);
+static void post_fcntl_hook(syscall_ctx_t*);
+#if !defined(TARGET_IA32E)
+static void post_getgroups16_hook(syscall_ctx_t*);
+#endif
+static void post_mmap_hook(syscall_ctx_t*);
+static void post_munmap_hook(syscall_ctx_t*);
+static void post_socketcall_hook(syscall_ctx_t*);
+static void post_syslog_hook(syscall_ctx_t*);
+static void post_ipc_hook(syscall_ctx_t*);
+static void post_modify_ldt_hook(syscall_ctx_t*);
+#ifdef TAGMAP_COLLAPSE
+static void post_mprotect_hook(syscall_ctx_t*);
+#endif
+static void post_quotactl_hook(syscall_ctx_t *ctx);
+static void post_readv_hook(syscall_ctx_t*);
+static void post__sysctl_hook(syscall_ctx_t*);
+static void post_mremap_hook(syscall_ctx_t*);
+static void post_poll_hook(syscall_ctx_t *ctx);
+static void post_rt_sigpending_hook(syscall_ctx_t *ctx);
+static void post_getcwd_hook(syscall_ctx_t *ctx);
+static void post_getgroups_hook(syscall_ctx_t*);
+static void post_mincore_hook(syscall_ctx_t *ctx);
+static void post_getdents_hook(syscall_ctx_t *ctx);
+static void post_getxattr_hook(syscall_ctx_t *ctx);
+static void post_listxattr_hook(syscall_ctx_t *ctx);
+static void post_io_getevents_hook(syscall_ctx_t *ctx);
+static void post_get_mempolicy_hook(syscall_ctx_t *ctx);
+static void post_lookup_dcookie_hook(syscall_ctx_t *ctx);
+static void post_mq_timedreceive_hook(syscall_ctx_t *ctx);
+static void post_readlinkat_hook(syscall_ctx_t*);
+static void post_epoll_wait_hook(syscall_ctx_t *ctx);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,33)
+static void post_recvmmsg_hook(syscall_ctx_t *ctx);
+#endif
+#if defined(TARGET_IA32E)
+static void post_accept_hook(syscall_ctx_t*);
+static void post_socketpair_hook(syscall_ctx_t*);
+static void post_recvfrom_hook(syscall_ctx_t*);
+static void post_recvmsg_hook(syscall_ctx_t*);
+static void post_getsockopt_hook(syscall_ctx_t*);
+static void post_semctl_hook(syscall_ctx_t*);
+static void post_msgrcv_hook(syscall_ctx_t*);
+static void post_msgctl_hook(syscall_ctx_t*);
+static void post_shmat_hook(syscall_ctx_t*);
+static void post_shmdt_hook(syscall_ctx_t*);
+static void post_shmctl_hook(syscall_ctx_t*);
+#endif
+
+#if defined(TARGET_IA32E)
+/* syscall descriptors (x86-64) */
+syscall_desc_t syscall_desc[SYSCALL_MAX] = {
+	/* __NR_read */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_read_hook },
+	/* __NR_write */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_open */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_close */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_stat */
+	{ 2, 0, 1, { 0, sizeof(struct stat), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_fstat */
+	{ 2, 0, 1, { 0, sizeof(struct stat), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_lstat */
+	{ 2, 0, 1, { 0, sizeof(struct stat), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_poll */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_poll_hook },
+	/* __NR_lseek */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_mmap */
+	{ 6, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_mmap_hook },
+	/* __NR_mprotect */
+#ifdef TAGMAP_COLLAPSE
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_mprotect_hook },
+#else
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+#endif
+	/* __NR_munmap */
+	{ 2, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_munmap_hook },
+	/* __NR_brk */
+	{ 1, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_brk_hook },
+	/* __NR_rt_sigaction */
+	{ 4, 0, 1, { 0, 0, sizeof(struct sigaction), 0, 0, 0 }, NULL, NULL },
+	/* __NR_rt_sigprocmask */
+	{ 4, 0, 1, { 0, 0, sizeof(sigset_t), 0, 0, 0 }, NULL, NULL },
+	/* __NR_rt_sigreturn */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_ioctl */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_pread64 */
+	{ 4, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_read_hook },
+	/* __NR_pwrite64 */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_readv */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_readv_hook },
+	/* __NR_writev */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 20 */
+	/* __NR_access */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_pipe */
+	{ 1, 0, 1, { sizeof(int) * 2, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_select */
+	{ 5, 0, 1, { 0, sizeof(fd_set), sizeof(fd_set), sizeof(fd_set), 
+	sizeof(struct timeval), 0 }, NULL, NULL },
+	/* __NR_sched_yield */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_mremap */
+	{ 5, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_mremap_hook },
+	/* __NR_msync */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_mincore */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_mincore_hook },
+	/* __NR_madvise */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_shmget */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_shmat */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_shmat_hook }, /* 30 */
+	/* __NR_shmctl */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_shmctl_hook },
+	/* __NR_dup */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_dup2 */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_pause */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_nanosleep */
+	{ 2, 0, 1, { 0, sizeof(struct timespec), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_getitimer */
+	{ 2, 0, 1, { 0, sizeof(struct itimerval), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_alarm */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_setitimer */
+	{ 3, 0, 1, { 0, 0, sizeof(struct itimerval), 0, 0, 0 }, NULL, NULL },
+	/* __NR_getpid */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_sendfile */
+	{ 4, 0, 1, { 0, 0, sizeof(off_t), 0, 0, 0 }, NULL, NULL }, /* 40 */
+	/* __NR_socket */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_connect */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_accept */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_accept_hook },
+	/* __NR_sendto */
+	{ 6, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_recvfrom */
+	{ 6, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_recvfrom_hook },
+	/* __NR_sendmsg */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_recvmsg */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_recvmsg_hook },
+	/* __NR_shutdown */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_bind */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_listen */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 50 */
+	/* __NR_getsockname */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_accept_hook },
+	/* __NR_getpeername */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_accept_hook },
+	/* __NR_socketpair */
+	{ 4, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_socketpair_hook },
+	/* __NR_setsockopt */
+	{ 5, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_getsockopt */
+	{ 5, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_getsockopt_hook },
+	/* __NR_clone */
+	{ 5, 0, 1, { 0, 0, sizeof(int), 0, 0, 0 }, NULL, NULL },
+	/* __NR_fork */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_vfork */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_execve */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_exit */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 60 */
+	/* __NR_wait4 */
+	{ 4, 0, 1, { 0, sizeof(int), 0, sizeof(struct rusage), 0, 0 },
+	NULL, NULL },
+	/* __NR_kill */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_uname */
+	{ 1, 0, 1, { sizeof(struct new_utsname), 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_semget */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_semop */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_semctl */
+	{ 4, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_semctl_hook },
+	/* __NR_shmdt */
+	{ 1, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_shmdt_hook },
+	/* __NR_msgget */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_msgsnd */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_msgrcv */
+	{ 5, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_msgrcv_hook }, /* 70 */
+	/* __NR_msgctl */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_msgctl_hook },
+	/* __NR_fcntl */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_fcntl_hook },
+	/* __NR_flock */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_fsync */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_fdatasync */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_truncate */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_ftruncate */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_getdents */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_getdents_hook },
+	/* __NR_getcwd */
+	{ 2, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_getcwd_hook },
+	/* __NR_chdir */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 80 */
+	/* __NR_fchdir */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_rename */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_mkdir */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_rmdir */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_creat */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_link */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_unlink */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_symlink */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_readlink */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_read_hook },
+	/* __NR_chmod */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 90 */
+	/* __NR_fchmod */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_chown */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_fchown */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_lchown */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_umask */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_gettimeofday */
+	{ 2, 0, 1, { sizeof(struct timeval), sizeof(struct timezone), 0, 0, 0, 0 },
+	NULL, NULL },
+	/* __NR_getrlimit */
+	{ 2, 0, 1, { 0, sizeof(struct rlimit), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_getrusage */
+	{ 2, 0, 1, { 0, sizeof(struct rusage), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_sysinfo */
+	{ 1, 0, 1, { sizeof(struct sysinfo), 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_times */
+	{ 1, 0, 1, { sizeof(struct tms), 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_ptrace */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_getuid */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_syslog */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_syslog_hook },
+	/* __NR_getgid */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_setuid */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_setgid */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_geteuid */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_getegid */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_setpgid */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_getppid */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 110 */
+	/* __NR_getpgrp */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_setsid */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_setreuid */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_setregid */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_getgroups */
+	{ 2, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_getgroups_hook },
+	/* __NR_setgroups */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_setresuid */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_getresuid */
+	{ 3, 0, 1, { sizeof(uid_t), sizeof(uid_t), sizeof(uid_t), 0, 0, 0 },
+	NULL, NULL },
+	/* __NR_setresgid */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_getresgid */
+	{ 3, 0, 1, { sizeof(gid_t), sizeof(gid_t), sizeof(gid_t), 0, 0, 0 },
+	NULL, NULL },
+	/* __NR_getpgid */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_setfsuid */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_setfsgid */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_getsid */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_capget */
+	{ 2, 0, 1, { sizeof(cap_user_header_t), sizeof(cap_user_data_t), 0, 0,
+	0, 0 }, NULL, NULL },
+	/* __NR_capset */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_rt_sigpending */
+	{ 2, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_rt_sigpending_hook },
+	/* __NR_rt_sigtimedwait */
+	{ 4, 0, 1, { 0, sizeof(siginfo_t), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_rt_sigqueueinfo */
+	{ 3, 0, 1, { 0, 0, sizeof(siginfo_t), 0, 0, 0 }, NULL, NULL },
+	/* __NR_rt_sigsuspend */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 130 */
+	/* __NR_sigaltstack */
+	{ 2, 0, 1, { 0, sizeof(stack_t), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_utime */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_mknod */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_uselib */
+	{ 1, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_uselib_hook },
+	/* __NR_personality */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_ustat */
+	{ 2, 0, 1, { 0, sizeof(struct ustat), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_statfs */
+	{ 2, 0, 1, { 0, sizeof(struct statfs), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_fstatfs */
+	{ 2, 0, 1, { 0, sizeof(struct statfs), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_sysfs */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_getpriority */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 140 */
+	/* __NR_setpriority */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_sched_setparam */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_sched_getparam */
+	{ 2, 0, 1, { 0, sizeof(struct sched_param), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_sched_setscheduler */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_sched_getscheduler */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_sched_get_priority_max */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_sched_get_priority_min */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_sched_rr_get_interval */
+	{ 2, 0, 1, { 0, sizeof(struct timespec), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_mlock */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_munlock */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 150 */
+	/* __NR_mlockall */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_munlockall */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_vhangup */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_modify_ldt */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_modify_ldt_hook },
+	/* __NR_pivot_root */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR__sysctl */
+	{ 1, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post__sysctl_hook },
+	/* __NR_prctl */
+	{ 5, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_arch_prctl */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_adjtimex */
+	{ 1, 0, 1, { sizeof(struct timex), 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_setrlimit */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 160 */
+	/* __NR_chroot */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_sync */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_acct */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_settimeofday */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_mount */
+	{ 5, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_umount2 */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_swapon */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_swapoff */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_reboot */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_sethostname */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 170 */
+	/* __NR_setdomainname */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_iopl */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_ioperm */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_create_module; not implemented */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_init_module */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_delete_module */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_get_kernel_syms; not implemented */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_query_module; not implemented */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_quotactl */
+	{ 4, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_quotactl_hook },
+	/* __NR_nfsservctl; not implemented */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_getpmsg; not implemented */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_putpmsg; not implemented */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_afs_syscall; not implemented */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_tuxcall; not implemented */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_security; not implemented */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_gettid */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_readahead */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_setxattr */
+	{ 5, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_lsetxattr */
+	{ 5, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_fsetxattr */
+	{ 5, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 190 */
+	/* __NR_getxattr */
+	{ 4, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_getxattr_hook },
+	/* __NR_lgetxattr */
+	{ 4, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_getxattr_hook },
+	/* __NR_fgetxattr */
+	{ 4, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_getxattr_hook },
+	/* __NR_listxattr */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_listxattr_hook },
+	/* __NR_llistxattr */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_listxattr_hook },
+	/* __NR_flistxattr */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_listxattr_hook },
+	/* __NR_removexattr */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_lremovexattr */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_fremovexattr */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_tkill */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 200 */
+	/* __NR_time */
+	{ 1, 0, 1, { sizeof(time_t), 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_futex */
+	{ 6, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_sched_setaffinity */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_sched_getaffinity */
+	{ 3, 0, 1, { 0, 0, sizeof(cpu_set_t), 0, 0, 0 }, NULL, NULL },
+	/* __NR_set_thread_area */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_io_setup */
+	{ 2, 0, 1, { 0, sizeof(aio_context_t), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_io_destroy */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_io_getevents */
+	{ 5, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_io_getevents_hook },
+	/* __NR_io_submit */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_io_cancel */
+	{ 3, 0, 1, { 0, 0, sizeof(struct io_event), 0, 0, 0 }, NULL, NULL },
+	/* __NR_get_thread_area */
+	{ 1, 0, 1, { sizeof(struct user_desc), 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_lookup_dcookie */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_lookup_dcookie_hook },
+	/* __NR_epoll_create */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_epoll_ctl_old; not implemented */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_epoll_wait_old; not implemented */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_remap_file_pages */
+	{ 5, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_getdents64 */
+	{ 3, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_getdents_hook },
+	/* __NR_set_tid_address */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_restart_syscall */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_semtimedop */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 220 */
+	/* __NR_fadvise64 */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_timer_create */
+	{ 3, 0, 1, { 0, 0, sizeof(timer_t), 0, 0, 0 }, NULL, NULL },
+	/* __NR_timer_settime */
+	{ 4, 0, 1, { 0, 0, 0, sizeof(struct itimerspec), 0, 0 }, NULL, NULL },
+	/* __NR_timer_gettime */
+	{ 2, 0, 1, { 0, sizeof(struct itimerspec), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_timer_getoverrun */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_timer_delete */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_clock_settime */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_clock_gettime */
+	{ 2, 0, 1, { 0, sizeof(struct timespec), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_clock_getres */
+	{ 2, 0, 1, { 0, sizeof(struct timespec), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_clock_nanosleep */
+	{ 4, 0, 1, { 0, 0, 0, sizeof(struct timespec), 0, 0 }, NULL, NULL },
+	/* __NR_exit_group */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_epoll_wait */
+	{ 4, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_epoll_wait_hook },
+	/* __NR_epoll_ctl */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_tgkill */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_utimes */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_vserver; not implemented */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_mbind */
+	{ 6, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_set_mempolicy */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_get_mempolicy */
+	{ 5, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_get_mempolicy_hook },
+	/* __NR_mq_open */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 240 */
+	/* __NR_mq_unlink */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_mq_timedsend */
+	{ 5, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_mq_timedreceive */
+	{ 5, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_mq_timedreceive_hook },
+	/* __NR_mq_notify */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_mq_getsetattr */
+	{ 3, 0, 1, { 0, 0, sizeof(struct mq_attr), 0, 0, 0 }, NULL, NULL },
+	/* __NR_kexec_load */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_waitid */
+	{ 4, 0, 1, { 0, 0, sizeof(siginfo_t), 0, sizeof(struct rusage), 0 },
+	NULL, NULL },
+	/* __NR_add_key */
+	{ 5, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_request_key */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_keyctl */
+	{ 5, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 250 */
+	/* __NR_ioprio_set */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_ioprio_get */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_inotify_init */
+	{ 0, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_inotify_add_watch */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_inotify_rm_watch */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_migrate_pages */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_openat */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_mkdirat */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_mknodat */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_fchownat */
+	{ 5, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 260 */
+	/* __NR_futimesat */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_newfstatat */
+	{ 4, 0, 1, { 0, 0, sizeof(struct stat), 0, 0, 0 }, NULL, NULL },
+	/* __NR_unlinkat */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_renameat */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_linkat */
+	{ 5, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_symlinkat */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_readlinkat */
+	{ 4, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_readlinkat_hook },
+	/* __NR_fchmodat */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_faccessat */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_pselect6 */
+	{ 6, 0, 1, { 0, sizeof(fd_set), sizeof(fd_set), sizeof(fd_set), 0, 0 },
+	NULL, NULL },
+	/* __NR_ppoll */
+	{ 5, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_poll_hook },
+	/* __NR_unshare */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_set_robust_list */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_get_robust_list */
+	{ 3, 0, 1, { 0, sizeof(struct robust_list_head*), sizeof(size_t), 0, 0, 0 },
+	NULL, NULL },
+	/* __NR_splice */
+	{ 6, 0, 1, { 0, sizeof(loff_t), 0, sizeof(loff_t), 0, 0 }, NULL, NULL },
+	/* __NR_tee */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_sync_file_range */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_vmsplice */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_move_pages */
+	{ 6, 0, 1, { 0, 0, 0, 0, sizeof(int), 0 }, NULL, NULL },
+	/* __NR_utimensat */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 280 */
+	/* __NR_epoll_pwait */
+	{ 6, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_epoll_wait_hook },
+	/* __NR_signalfd */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_timerfd_create */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_eventfd */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_fallocate */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_timerfd_settime */
+	{ 4, 0, 1, { 0, 0, 0, sizeof(struct itimerspec), 0, 0 }, NULL, NULL },
+	/* __NR_timerfd_gettime */
+	{ 2, 0, 1, { 0, sizeof(struct itimerspec), 0, 0, 0, 0 }, NULL, NULL },
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,27)
+	/* __NR_accept4 */
+	{ 4, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_accept_hook },
+	/* __NR_signalfd4 */
+	{ 4, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_eventfd2 */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 290 */
+	/* __NR_epoll_create1 */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_dup3 */
+	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_pipe2 */
+	{ 2, 0, 1, { sizeof(int) * 2, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_inotify_init1 */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+#endif
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,30)
+	/* __NR_preadv */
+	{ 5, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_readv_hook },
+	/* __NR_pwritev */
+	{ 5, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+#endif
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,31)
+	/* __NR_rt_tgsigqueueinfo */
+	{ 4, 0, 1, { 0, 0, 0, sizeof(siginfo_t), 0, 0 }, NULL, NULL },
+#if LINUX_VERSION_CODE == KERNEL_VERSION(2,6,31)
+	/* __NR_perf_counter_open */
+	{ 5, 0, 1, { sizeof(struct perf_counter_attr), 0, 0, 0, 0, 0 }, NULL,
+	NULL },
+#else
+	/* __NR_perf_event_open */
+	{ 5, 0, 1, { sizeof(struct perf_event_attr), 0, 0, 0, 0, 0 }, NULL,
+	NULL },
+#endif
 #endif
-static void post_quotactl_hook(syscall_ctx_t *ctx);
-static void post_readv_hook(syscall_ctx_t*);
-static void post__sysctl_hook(syscall_ctx_t*);
-static void post_mremap_hook(syscall_ctx_t*);
-static void post_poll_hook(syscall_ctx_t *ctx);
-static void post_rt_sigpending_hook(syscall_ctx_t *ctx);
-static void post_getcwd_hook(syscall_ctx_t *ctx);
-static void post_getgroups_hook(syscall_ctx_t*);
-static void post_mincore_hook(syscall_ctx_t *ctx);
-static void post_getdents_hook(syscall_ctx_t *ctx);
-static void post_getxattr_hook(syscall_ctx_t *ctx);
-static void post_listxattr_hook(syscall_ctx_t *ctx);
-static void post_io_getevents_hook(syscall_ctx_t *ctx);
-static void post_get_mempolicy_hook(syscall_ctx_t *ctx);
-static void post_lookup_dcookie_hook(syscall_ctx_t *ctx);
-static void post_mq_timedreceive_hook(syscall_ctx_t *ctx);
-static void post_readlinkat_hook(syscall_ctx_t*);
-static void post_epoll_wait_hook(syscall_ctx_t *ctx);
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,33)
-static void post_recvmmsg_hook(syscall_ctx_t *ctx);
+	/* __NR_recvmmsg */
+	{ 5, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_recvmmsg_hook },
 #endif
-
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,36)
+	/* __NR_fanotify_init */
+	{ 2, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL }, /* 300 */
+	/* __NR_fanotify_mark */
+	{ 5, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_prlimit64 */
+	{ 4, 0, 1, { 0, 0, 0, sizeof(struct rlimit64), 0, 0 }, NULL, NULL },
+#endif
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,39)
+	/* __NR_name_to_handle_at */
+	{ 5, 0, 1, { 0, 0, sizeof(struct file_handle), sizeof(int), 0, 0 },
+	NULL, NULL },
+	/* __NR_open_by_handle_at */
+	{ 3, 0, 1, { 0, sizeof(struct file_handle), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_clock_adjtime */
+	{ 2, 0, 1, { 0, sizeof(struct timex), 0, 0, 0, 0 }, NULL, NULL },
+	/* __NR_syncfs */
+	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
+#endif
+};
+#else
 /* syscall descriptors */
 syscall_desc_t syscall_desc[SYSCALL_MAX] = {
 	/* __NR_restart_syscall */
@@ -449,7 +1120,7 @@ syscall_desc_t syscall_desc[SYSCALL_MAX] = {
 	{ 2, 0, 1, { 0, sizeof(struct timespec), 0, 0, 0, 0 }, NULL, NULL },
 	/* __NR_nanosleep */
 	{ 2, 0, 1, { 0, sizeof(struct timespec), 0, 0, 0, 0 }, NULL, NULL },
-	/* __NR_mremap; TODO */
+	/* __NR_mremap */
 	{ 5, 1, 0, { 0, 0, 0, 0, 0, 0 }, NULL, post_mremap_hook },
 	/* __NR_setresuid16 */
 	{ 3, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
@@ -850,6 +1521,7 @@ syscall_desc_t syscall_desc[SYSCALL_MAX] = {
 	{ 1, 0, 0, { 0, 0, 0, 0, 0, 0 }, NULL, NULL },
 #endif
 };
+#endif
 
 /*
  * add a new pre-syscall callback into a syscall descriptor
@@ -957,6 +1629,73 @@ syscall_clr_post(syscall_desc_t *desc)
 	return 0;
 }
 
+#ifdef	TAGMAP_DIRECT
+/*
+ * make room for the fixed mapping of a system call (if any), before
+ * the system call is invoked (see tagmap_direct_fixed())
+ *
+ * @tid:	the thread id
+ * @ctx:	the syscall context
+ */
+void
+syscall_fixed(THREADID tid, syscall_ctx_t *ctx)
+{
+	size_t	addr	= 0;	/* fixed address	*/
+	size_t	len	= 0;	/* mapping size		*/
+	int	shmid	= -1;	/* shared memory id	*/
+
+	/* shared memory segment */
+	struct shmid_ds buf;
+
+	switch (ctx->nr) {
+#if !defined(TARGET_IA32E)
+		case __NR_mmap2:
+#endif
+		case __NR_mmap:
+			if ((ctx->arg[SYSCALL_ARG3] &
+				(MAP_FIXED | MAP_FIXED_NOREPLACE)) != 0) {
+				addr	= ctx->arg[SYSCALL_ARG0];
+				len	= ctx->arg[SYSCALL_ARG1];
+			}
+			break;
+		case __NR_mremap:
+			if ((ctx->arg[SYSCALL_ARG3] & MREMAP_FIXED) != 0) {
+				addr	= ctx->arg[SYSCALL_ARG4];
+				len	= ctx->arg[SYSCALL_ARG2];
+			}
+			break;
+#if defined(TARGET_IA32E)
+		case __NR_shmat:
+			shmid	= (int)ctx->arg[SYSCALL_ARG0];
+			addr	= ctx->arg[SYSCALL_ARG1];
+			break;
+#else
+		/* ipc() is a demultiplexer for all SYSV IPC calls */
+		case __NR_ipc:
+			if ((int)ctx->arg[SYSCALL_ARG0] == SHMAT) {
+				shmid	= (int)ctx->arg[SYSCALL_ARG1];
+				addr	= ctx->arg[SYSCALL_ARG4];
+			}
+			break;
+#endif
+		default:
+			/* nothing to do */
+			return;
+	}
+
+	/* shmat(2) at a given address; the size of the segment */
+	if (shmid != -1 && addr != 0 && shmctl(shmid, IPC_STAT, &buf) == 0)
+		len = buf.shm_segsz;
+
+	/* no fixed mapping; optimized branch */
+	if (likely(len == 0))
+		return;
+
+	tagmap_direct_fixed(tid, PAGE_ALIGN(addr),
+		PAGE_ALIGN(PAGE_OFFSET(addr) + len + PAGE_SZ - 1));
+}
+#endif
+
 /* __NR_(p)read(64) and __NR_readlink post syscall hook */
 static void
 post_read_hook(syscall_ctx_t *ctx)
@@ -965,7 +1704,7 @@ post_read_hook(syscall_ctx_t *ctx)
 	if (unlikely((long)ctx->ret <= 0))
 		return;
 	
-	/* clear the tag bits */
+	/* clear the tag bits; no-op if the buffer is clean (e.g., fresh) */
 	tagmap_clrn(ctx->arg[SYSCALL_ARG1], (size_t)ctx->ret);
 }
 
@@ -980,12 +1719,12 @@ post_uselib_hook(syscall_ctx_t *ctx)
 static void
 post_brk_hook(syscall_ctx_t *ctx)
 {
-	/* iterators */
-	size_t i, j;
-
 	/* tagmap segment */
 	void *tseg = NULL;
 
+	/* iterators */
+	size_t	STAB_start, STAB_end;
+
 	/* 
 	 * brk() return value; in Linux brk returns
 	 * the address of the new program break, or
@@ -997,92 +1736,66 @@ post_brk_hook(syscall_ctx_t *ctx)
 	if (unlikely(addr == brk_end))
 		return;
 	
-	/* the first segment is allocated with calloc(3) */
-	if (unlikely(brk_start == brk_end)) {
-#ifdef DEBUG_MEMTRACK
-		/* verbose */
-		LOG(string(__func__) + ": expand mapping "
-			+ hexstr(brk_start) + "-" + hexstr(addr) + "\n");
-#endif
-		/*
-		 * allocate space for a new tagmap
-		 * segment by invoking calloc(3)
-		 */
-		if (unlikely((tseg = calloc(PAGE_ALIGN(addr) -
-				PAGE_ALIGN(brk_start) + PAGE_SZ, 1)) == NULL)) {
-			/* error message */
-			LOG(string(__func__) +
-				": tagmap segment allocation failed (" +
-				string(strerror(errno)) + ")\n");
-
-			/* die */
-			libdft_die();
-		}
-	}
-	/* expand */
-	else if (likely(PAGE_ALIGN(addr) > PAGE_ALIGN(brk_end))) {
+	/*
+	 * expand; the program break is not shadowed by a single
+	 * segment, and every expansion gets a new segment for the
+	 * pages that it adds (the page of the current break is
+	 * already mapped, unless this is the first expansion)
+	 */
+	if (likely(addr > brk_end)) {
+		STAB_start	= VIRT2STAB(brk_end);
+		STAB_end	= VIRT2STAB(addr);
+		if (STAB_SEG(STAB_start) != (size_t)null_seg)
+			STAB_start++;
 #ifdef DEBUG_MEMTRACK
 		/* verbose */
 		LOG(string(__func__) + ": expand mapping "
 			+ hexstr(brk_start) + "-" + hexstr(addr) + "\n");
 #endif
-		/* additional segments are allocated with realloc(3) */
-		if (unlikely((tseg = realloc((void *)
-			(brk_start + STAB[VIRT2STAB(brk_start)]),
-			PAGE_ALIGN(addr) - PAGE_ALIGN(brk_start) + PAGE_SZ))
-							== NULL)) {
-			/* error message */
-			LOG(string(__func__) +
+		/* same page; nothing to map */
+		if (STAB_start <= STAB_end) {
+			/*
+			 * allocate space for a new tagmap
+			 * segment by invoking tagmap_seg_alloc()
+			 */
+			if (unlikely((tseg = tagmap_seg_alloc(
+				TAG_SEG_SZ(STAB2VIRT(STAB_end - STAB_start + 1)),
+				TAGMAP_KIND_HEAP)) == MAP_FAILED)) {
+				/* error message */
+				LOG(string(__func__) +
 				": tagmap segment allocation failed (" +
 				string(strerror(errno)) + ")\n");
 
 				/* die */
 				libdft_die();
+			}
+
+			/* STAB setup */
+			stab_map(STAB_start, STAB_end, tseg);
+#ifdef DEBUG_MEMTRACK
+			/* verbose */
+			LOG(string(__func__) + ": mapping segment [" +
+				hexstr(tseg) + "-" +
+				hexstr(VIRT2TAG(addr)) + "]\n");
+#endif
 		}
-				
-		/* cleanup the new tagmap segment */
-		(void)memset(((char *)tseg) + PAGE_ALIGN(brk_end) -
-			PAGE_ALIGN(brk_start) + PAGE_SZ, 0,
-			PAGE_ALIGN(addr) - PAGE_ALIGN(brk_end));
 	}
 	/* shrink */
-	else if (PAGE_ALIGN(addr) < PAGE_ALIGN(brk_end)) {
+	else if (VIRT2STAB(addr) < VIRT2STAB(brk_end)) {
 #ifdef DEBUG_MEMTRACK
 		/* verbose */
 		LOG(string(__func__) + ": shrink mapping "
 			+ hexstr(brk_start) + "-" + hexstr(addr) + "\n");
 #endif
-		/* segments are deallocated with realloc(3) */
-		if (unlikely((tseg = realloc((void *)
-			(brk_start + STAB[VIRT2STAB(brk_start)]),
-			PAGE_ALIGN(addr) - PAGE_ALIGN(brk_start) + PAGE_SZ))
-							== NULL)) {
-			/* error message */
-			LOG(string(__func__) +
-				": tagmap segment allocation failed (" +
-				string(strerror(errno)) + ")\n");
-
-				/* die */
-				libdft_die();
-		}
-			/* STAB setup */
-		for (i = VIRT2STAB(brk_end); i > VIRT2STAB(addr); i--)
-			STAB[i] = (uint32_t)null_seg - STAB2VIRT(i);
+		/* the released pages are deallocated; STAB setup */
+		stab_unmap(VIRT2STAB(addr) + 1, VIRT2STAB(brk_end), null_seg);
 	}
-	
-	/* STAB setup */
-	for (i = VIRT2STAB(brk_start), j = 0; i <= VIRT2STAB(addr); i++, j++)
-		STAB[i] = (uint32_t)tseg - STAB2VIRT(i) + (j * PAGE_SZ);
-#ifdef DEBUG_MEMTRACK
-	/* verbose */
-	LOG(string(__func__) + ": mapping segment [" +
-			hexstr(brk_start + STAB[VIRT2STAB(brk_start)]) +
-			"-" + hexstr(addr + STAB[VIRT2STAB(addr)]) + "]\n");
-#endif
+
 	/* update brk end with the new value */
 	brk_end = addr;
 }
 
+#if !defined(TARGET_IA32E)
 /* __NR_getgroups16 post syscall_hook */
 static void
 post_getgroups16_hook(syscall_ctx_t *ctx)
@@ -1095,6 +1808,7 @@ post_getgroups16_hook(syscall_ctx_t *ctx)
 	tagmap_clrn(ctx->arg[SYSCALL_ARG1],
 			(sizeof(old_gid_t) * (size_t)ctx->ret));
 }
+#endif
 
 /* __NR_getgroups post syscall_hook */
 static void
@@ -1121,6 +1835,72 @@ post_readlinkat_hook(syscall_ctx_t *ctx)
 	tagmap_clrn(ctx->arg[SYSCALL_ARG2], (size_t)ctx->ret);
 }
 
+/*
+ * get the region kind of an mmap(2)-ed
+ * region (tagmap accounting)
+ *
+ * @flags:	the mmap(2) flags
+ */
+static inline int
+mmap_kind(int flags)
+{
+	/* thread stacks */
+	if ((flags & MAP_GROWSDOWN) != 0)
+		return TAGMAP_KIND_STACK;
+
+	/* file mappings (e.g., shared libraries) */
+	if ((flags & MAP_ANONYMOUS) == 0)
+		return TAGMAP_KIND_IMAGE;
+
+	return TAGMAP_KIND_MMAP;
+}
+
+/*
+ * shadow a MAP_SHARED mapping with a shared
+ * tagmap segment (see tagmap_share_file())
+ *
+ * @ctx:	the mmap(2) context
+ *
+ * returns:	0 on success, 1 if the mapping needs a private segment
+ */
+static int
+mmap_share(syscall_ctx_t *ctx)
+{
+	/* mmap parameters (size, flags, file, and offset) */
+	size_t	size	= PAGE_ALIGN(ctx->arg[SYSCALL_ARG1] + PAGE_SZ - 1);
+	int	flags	= (int)ctx->arg[SYSCALL_ARG3];
+	int	fd	= ((flags & MAP_ANONYMOUS) != 0) ?
+				-1 : (int)ctx->arg[SYSCALL_ARG4];
+	size_t	off	= ctx->arg[SYSCALL_ARG5];
+
+#if !defined(TARGET_IA32E)
+	/* mmap2(2); the offset is in pages */
+	if (ctx->nr == __NR_mmap2) {
+		/* beyond 4 GB; optimized branch */
+		if (unlikely(off >= (1U << (32 - PAGE_SHIFT)))) {
+			/* issue a warning */
+			LOG(string(__func__) + ": shared mapping at " +
+				hexstr(ctx->ret) + " is not shared (offset)\n");
+			return 1;
+		}
+		off <<= PAGE_SHIFT;
+	}
+#endif
+
+	if (unlikely(tagmap_share_file(ctx->ret, size, fd, off) != 0)) {
+		/* error message */
+		LOG(string(__func__) +
+			": shared tagmap segment allocation failed (" +
+			string(strerror(errno)) + ")\n");
+
+		/* die */
+		libdft_die();
+	}
+
+	/* success */
+	return 0;
+}
+
 /* __NR_mmap post syscall hook */
 #ifdef TAGMAP_COLLAPSE
 static void
@@ -1132,32 +1912,28 @@ post_mmap_hook(syscall_ctx_t *ctx)
 	int	flags	= (int)ctx->arg[SYSCALL_ARG3];
 
 	/* iterators */
-	size_t	i, j, STAB_start, STAB_end;
+	size_t	STAB_start, STAB_end;
 
 	/* tagmap segment */
 	void	*tseg = NULL;
 
 	/* mmap() was not successful; optimized branch */
 	if (unlikely((void *)ctx->ret == MAP_FAILED))
-		return;
-
-	/* 
-	 * MAP_SHARED has been specified
-	 * TODO: handle shared memory mappings
-	 */
-	if (unlikely((flags & MAP_SHARED) != 0))
-		/* issue a warning */
-	       LOG(string(__func__) + ": shared mapping via mmap(2) at " +
-			       hexstr(ctx->ret) + "\n");
-	
-	/* 
-	 * MAP_FIXED has been specified
-	 * TODO: handle fixed memory mappings
+		return;
+
+	/*
+	 * MAP_FIXED has been specified; the new mapping replaces
+	 * (part of) an existing one (e.g., the dynamic linker maps
+	 * the writeable segments of an image over its reservation),
+	 * so release the tagmap segments of the replaced pages
 	 */
 	if (unlikely((flags & MAP_FIXED) != 0))
-		/* issue a warning */
-	       LOG(string(__func__) + ": fixed mapping via mmap(2) at " +
-			       hexstr(ctx->arg[SYSCALL_ARG0]) + "\n");
+		stab_unmap(VIRT2STAB(ctx->ret),
+			VIRT2STAB(ctx->ret + size - 1), null_seg);
+
+	/* MAP_SHARED; the tags are shared with other processes */
+	if (unlikely((flags & MAP_SHARED) != 0) && mmap_share(ctx) == 0)
+		return;
 	
 	/* MAP_GROWSDOWN has been specified */
 	if (unlikely((flags & MAP_GROWSDOWN) != 0)) {
@@ -1194,12 +1970,11 @@ post_mmap_hook(syscall_ctx_t *ctx)
 	if ((prot & PROT_WRITE) != 0) {
 		/*
 		 * allocate space for a new tagmap
-		 * segment by invoking mmap(2)
+		 * segment by invoking tagmap_seg_alloc()
 		 */
-		if (unlikely(((tseg = mmap(NULL, size,
-			/* RW- */
-			PROT_READ | PROT_WRITE | ~PROT_EXEC,
-			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED))) {
+		if (unlikely(((tseg = tagmap_seg_alloc(TAG_SEG_SZ(size),
+						mmap_kind(flags)))
+						== MAP_FAILED))) {
 				/* error message */
 				LOG(string(__func__) +
 					": tagmap segment allocation failed (" +
@@ -1210,23 +1985,19 @@ post_mmap_hook(syscall_ctx_t *ctx)
 		}
 
 		/* STAB setup */
-		for (i = STAB_start, j = 0; i <= STAB_end; i++, j++)
-			STAB[i] = (uint32_t)tseg - STAB2VIRT(i) + (j * PAGE_SZ);
+		stab_map(STAB_start, STAB_end, tseg);
 #ifdef DEBUG_MEMTRACK
 		if (unlikely((flags & MAP_GROWSDOWN) != 0)) {
 			/* verbose */
 			LOG(string(__func__) + ": mapping writeable segment [" +
-				hexstr(ctx->ret - size + 1 +
-				STAB[VIRT2STAB(ctx->ret - size + 1)]) +
-				"-" + hexstr(ctx->ret +
-					STAB[VIRT2STAB(ctx->ret)]) + "]\n");
+				hexstr(VIRT2TAG(ctx->ret - size + 1)) +
+				"-" + hexstr(VIRT2TAG(ctx->ret)) + "]\n");
 		}
 		else {
 			/* verbose */
 			LOG(string(__func__) + ": mapping writeable segment [" +
-				hexstr(ctx->ret + STAB[VIRT2STAB(ctx->ret)]) +
-				"-" + hexstr(ctx->ret + size - 1 +
-				STAB[VIRT2STAB(ctx->ret + size - 1)]) + "]\n");
+				hexstr(VIRT2TAG(ctx->ret)) +
+				"-" + hexstr(VIRT2TAG(ctx->ret + size - 1)) + "]\n");
 		}
 #endif
 	}
@@ -1247,23 +2018,19 @@ post_mmap_hook(syscall_ctx_t *ctx)
 		 */
 	
 		/* STAB setup */
-		for (i = STAB_start; i <= STAB_end; i++)
-			STAB[i] = (uint32_t)zero_seg - STAB2VIRT(i);
+		stab_map(STAB_start, STAB_end, zero_seg);
 #ifdef DEBUG_MEMTRACK
 		if (unlikely((flags & MAP_GROWSDOWN) != 0)) {
 			/* verbose */
 			LOG(string(__func__) + ": mapping read-only segment [" +
-				hexstr(ctx->ret - size + 1 +
-				STAB[VIRT2STAB(ctx->ret - size + 1)]) +
-				"-" + hexstr(ctx->ret +
-					STAB[VIRT2STAB(ctx->ret)]) + "]\n");
+				hexstr(VIRT2TAG(ctx->ret - size + 1)) +
+				"-" + hexstr(VIRT2TAG(ctx->ret)) + "]\n");
 		}
 		else {
 			/* verbose */
 			LOG(string(__func__) + ": mapping read-only segment [" +
-				hexstr(ctx->ret + STAB[VIRT2STAB(ctx->ret)]) +
-				"-" + hexstr(ctx->ret + size - 1 +
-				STAB[VIRT2STAB(ctx->ret + size - 1)]) + "]\n");
+				hexstr(VIRT2TAG(ctx->ret)) +
+				"-" + hexstr(VIRT2TAG(ctx->ret + size - 1)) + "]\n");
 		}
 #endif
 	}
@@ -1277,7 +2044,7 @@ post_mmap_hook(syscall_ctx_t *ctx)
 	int	flags	= (int)ctx->arg[SYSCALL_ARG3];
 
 	/* iterators */
-	size_t	i, j, STAB_start, STAB_end;
+	size_t	STAB_start, STAB_end;
 
 	/* tagmap segment */
 	void	*tseg = NULL;
@@ -1286,23 +2053,19 @@ post_mmap_hook(syscall_ctx_t *ctx)
 	if (unlikely((void *)ctx->ret == MAP_FAILED))
 		return;
 
-	/* 
-	 * MAP_SHARED has been specified
-	 * TODO: handle shared memory mappings
-	 */
-	if (unlikely((flags & MAP_SHARED) != 0))
-		/* issue a warning */
-	       LOG(string(__func__) + ": shared mapping via mmap(2) at " +
-			       hexstr(ctx->ret) + "\n");
-	
-	/* 
-	 * MAP_FIXED has been specified
-	 * TODO: handle fixed memory mappings
+	/*
+	 * MAP_FIXED has been specified; the new mapping replaces
+	 * (part of) an existing one (e.g., the dynamic linker maps
+	 * the writeable segments of an image over its reservation),
+	 * so release the tagmap segments of the replaced pages
 	 */
 	if (unlikely((flags & MAP_FIXED) != 0))
-		/* issue a warning */
-	       LOG(string(__func__) + ": fixed mapping via mmap(2) at " +
-			       hexstr(ctx->arg[SYSCALL_ARG0]) + "\n");
+		stab_unmap(VIRT2STAB(ctx->ret),
+			VIRT2STAB(ctx->ret + size - 1), null_seg);
+
+	/* MAP_SHARED; the tags are shared with other processes */
+	if (unlikely((flags & MAP_SHARED) != 0) && mmap_share(ctx) == 0)
+		return;
 	
 	/* MAP_GROWSDOWN has been specified */
 	if (unlikely((flags & MAP_GROWSDOWN) != 0)) {
@@ -1327,12 +2090,11 @@ post_mmap_hook(syscall_ctx_t *ctx)
 
 	/*
 	 * allocate space for a new tagmap
-	 * segment by invoking mmap(2)
+	 * segment by invoking tagmap_seg_alloc()
 	 */
-	if (unlikely(((tseg = mmap(NULL, size,
-		/* RW- */
-		PROT_READ | PROT_WRITE | ~PROT_EXEC,
-		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED))) {
+	if (unlikely(((tseg = tagmap_seg_alloc(TAG_SEG_SZ(size),
+					mmap_kind(flags)))
+					== MAP_FAILED))) {
 			/* error message */
 			LOG(string(__func__) +
 				": tagmap segment allocation failed (" +
@@ -1343,89 +2105,25 @@ post_mmap_hook(syscall_ctx_t *ctx)
 	}
 
 	/* STAB setup */
-	for (i = STAB_start, j = 0; i <= STAB_end; i++, j++)
-		STAB[i] = (uint32_t)tseg - STAB2VIRT(i) + (j * PAGE_SZ);
+	stab_map(STAB_start, STAB_end, tseg);
 #ifdef DEBUG_MEMTRACK
 	if (unlikely((flags & MAP_GROWSDOWN) != 0)) {
 		/* verbose */
 		LOG(string(__func__) + ": mapping segment [" +
-			hexstr(ctx->ret - size + 1 +
-			STAB[VIRT2STAB(ctx->ret - size + 1)]) +
-			"-" + hexstr(ctx->ret +
-			STAB[VIRT2STAB(ctx->ret)]) + "]\n");
+			hexstr(VIRT2TAG(ctx->ret - size + 1)) +
+			"-" + hexstr(VIRT2TAG(ctx->ret)) + "]\n");
 	}
 	else {
 		/* verbose */
 		LOG(string(__func__) + ": mapping segment [" +
-			hexstr(ctx->ret + STAB[VIRT2STAB(ctx->ret)]) +
-			"-" + hexstr(ctx->ret + size - 1 +
-			STAB[VIRT2STAB(ctx->ret + size - 1)]) + "]\n");
+			hexstr(VIRT2TAG(ctx->ret)) +
+			"-" + hexstr(VIRT2TAG(ctx->ret + size - 1)) + "]\n");
 	}
 #endif
 }
 #endif
 
 /* __NR_munmap post syscall hook */
-#ifdef TAGMAP_COLLAPSE
-static void
-post_munmap_hook(syscall_ctx_t *ctx)
-{
-	/* munmap address and size */
-	size_t 	addr	= ctx->arg[SYSCALL_ARG0];
-	size_t	size	= ctx->arg[SYSCALL_ARG1];
-
-	/* iterator */
-	size_t	i;
-
-	/* munmap() was not successful; optimized branch */
-	if (unlikely((int)ctx->ret == -1))
-		return;
-#ifdef DEBUG_MEMTRACK
-	/* verbose */
-	LOG(string(__func__) + ": " + hexstr(addr) + "-" +
-		hexstr(addr + size - 1) + "\n");
-#endif
-	/* STAB setup */
-	for (i = VIRT2STAB(addr); i <= VIRT2STAB(addr + size - 1); i++) {
-		/* handle a previously writeable mapping */
-		if ((STAB2VIRT(i) + STAB[i] != (uint32_t)zero_seg) &&
-			(STAB2VIRT(i) + STAB[i] != (uint32_t)null_seg)) {
-
-			/*
-			 * deallocate the space of the corresponding
-			 * tagmap segment by invoking munmap(2)
-			 */
-			if (unlikely(
-				munmap((void *)(STAB2VIRT(i) + STAB[i]),
-					PAGE_SZ) == -1)) {
-				/* error message */
-				LOG(string(__func__) +
-					": tagmap segment deallocation failed ("
-					+ string(strerror(errno)) + ")\n");
-		
-				/* die */
-				libdft_die();
-			}
-#ifdef DEBUG_MEMTRACK
-			/* verbose */
-			LOG(string(__func__) + ": unmapping segment [" +
-				hexstr(STAB2VIRT(i) + STAB[i]) + "-" +
-				hexstr(STAB2VIRT(i) + STAB[i] + PAGE_SZ - 1) +
-				"]\n");
-#endif
-		}
-		
-		STAB[i] = (uint32_t)null_seg - STAB2VIRT(i);
-	}
-#ifdef DEBUG_MEMTRACK
-	/* verbose */
-	LOG(string(__func__) + ": re-mapped segment [" +
-	hexstr(addr + STAB[VIRT2STAB(addr)]) +
-	"-" + hexstr(addr + size - 1 + STAB[VIRT2STAB(addr + size - 1)]) +
-	"]\n");
-#endif
-}
-#else
 static void
 post_munmap_hook(syscall_ctx_t *ctx)
 {
@@ -1433,9 +2131,6 @@ post_munmap_hook(syscall_ctx_t *ctx)
 	size_t 	addr	= ctx->arg[SYSCALL_ARG0];
 	size_t	size	= ctx->arg[SYSCALL_ARG1];
 
-	/* iterator */
-	size_t	i;
-
 	/* munmap() was not successful; optimized branch */
 	if (unlikely((int)ctx->ret == -1))
 		return;
@@ -1446,38 +2141,17 @@ post_munmap_hook(syscall_ctx_t *ctx)
 #endif
 	/*
 	 * deallocate the space of the corresponding
-	 * tagmap segment by invoking munmap(2)
+	 * tagmap segments and setup the STAB
 	 */
-	if (unlikely(munmap((void *)(addr + STAB[VIRT2STAB(addr)]),
-					size) == -1)) {
-		/* error message */
-		LOG(string(__func__) +
-			": tagmap segment deallocation failed ("
-			+ string(strerror(errno)) + ")\n");
-
-		/* die */
-		libdft_die();
-	}
-#ifdef DEBUG_MEMTRACK
-	/* verbose */
-	LOG(string(__func__) + ": unmapping segment [" +
-		hexstr(addr + STAB[VIRT2STAB(addr)]) + "-" +
-		hexstr(addr + size - 1 + STAB[VIRT2STAB(addr + size - 1)]) +
-		"]\n");
-#endif
-	/* STAB setup */
-	for (i = VIRT2STAB(addr); i <= VIRT2STAB(addr + size - 1); i++)
-		STAB[i] = (uint32_t)null_seg - STAB2VIRT(i);
-
+	stab_unmap(VIRT2STAB(addr), VIRT2STAB(addr + size - 1), null_seg);
 #ifdef DEBUG_MEMTRACK
 	/* verbose */
 	LOG(string(__func__) + ": re-mapped segment [" +
-	hexstr(addr + STAB[VIRT2STAB(addr)]) +
-	"-" + hexstr(addr + size - 1 + STAB[VIRT2STAB(addr + size - 1)]) +
+	hexstr(VIRT2TAG(addr)) +
+	"-" + hexstr(VIRT2TAG(addr + size - 1)) +
 	"]\n");
 #endif
 }
-#endif
 
 /* __NR_readv and __NR_preadv post syscall hook */
 static void
@@ -1794,12 +2468,6 @@ post_mprotect_hook(syscall_ctx_t *ctx)
 	size_t	size	= ctx->arg[SYSCALL_ARG1];
 	int	prot	= ctx->arg[SYSCALL_ARG2];
 
-	/* iterators */
-	size_t	i, j;
-
-	/* tagmap segment */
-	void	*tseg = NULL;
-
 	/* mprotect() was not successful; optimized branch */
 	if (unlikely((int)ctx->ret == -1))
 		return;
@@ -1813,100 +2481,33 @@ post_mprotect_hook(syscall_ctx_t *ctx)
 	if ((prot & PROT_EXEC) != 0) LOG("X"); else LOG("-");
 	LOG(" (" + decstr(size) + ")\n");
 #endif
+	/* empty range; optimized branch */
+	if (unlikely(size == 0))
+		return;
+
 	/* writeable mapping */
-	if ((prot & PROT_WRITE) != 0) {
+	if ((prot & PROT_WRITE) != 0)
 		/*
-		 * allocate space for a new tagmap
-		 * segment by invoking mmap(2)
+		 * commit tagmap segments to the chunks that
+		 * were collapsed to zero_seg; the rest of the
+		 * range keeps its tags
 		 */
-		if (unlikely(((tseg = mmap(NULL, size,
-			/* RW- */
-			PROT_READ | PROT_WRITE | ~PROT_EXEC,
-			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED))) {
-				/* error message */
-				LOG(string(__func__) +
-					": tagmap segment allocation failed (" +
-					string(strerror(errno)) + ")\n");
-
-				/* die */
-				libdft_die();
-		}
-
-		/* STAB setup */
-		for (i = VIRT2STAB(addr), j = 0;
-				i <= VIRT2STAB(addr + size - 1);
-				i++, j++) {
-			/* handle a writeable segment */
-			if ((STAB2VIRT(i) + STAB[i] != (uint32_t)zero_seg) &&
-			(STAB2VIRT(i) + STAB[i] != (uint32_t)null_seg)) {
-				/*
-				 * deallocate the space of the corresponding
-				 * tagmap segment by invoking munmap(2)
-				 */
-				if (unlikely(
-					munmap((void *)(STAB2VIRT(i) + STAB[i]),
-						PAGE_SZ) == -1)) {
-					/* error message */
-					LOG(string(__func__) +
-					": tagmap segment deallocation failed ("
-					+ string(strerror(errno)) + ")\n");
-		
-					/* die */
-					libdft_die();
-				}
-#ifdef DEBUG_MEMTRACK
-				/* verbose */
-				LOG(string(__func__) + ": unmapping segment [" +
-				hexstr(STAB2VIRT(i) + STAB[i]) + "-" +
-				hexstr(STAB2VIRT(i) + STAB[i] + PAGE_SZ - 1) +
-				"]\n");
-#endif
-			}
-		
-			STAB[i] = (uint32_t)tseg - STAB2VIRT(i) + (j * PAGE_SZ);
-		}
-	}
+		stab_commit(VIRT2STAB(addr), VIRT2STAB(addr + size - 1),
+				TAGMAP_KIND_MMAP);
 	/* non-writeable mapping */
-	else {
-		/* STAB setup */
-		for (i = VIRT2STAB(addr);
-				i <= VIRT2STAB(addr + size - 1);
-				i++) {
-			/* handle a writeable segment */
-			if ((STAB2VIRT(i) + STAB[i] != (uint32_t)zero_seg) &&
-			(STAB2VIRT(i) + STAB[i] != (uint32_t)null_seg)) {
-				/*
-				 * deallocate the space of the corresponding
-				 * tagmap segment by invoking munmap(2)
-				 */
-				if (unlikely(
-					munmap((void *)(STAB2VIRT(i) + STAB[i]),
-						PAGE_SZ) == -1)) {
-					/* error message */
-					LOG(string(__func__) +
-					": tagmap segment deallocation failed ("
-					+ string(strerror(errno)) + ")\n");
-		
-					/* die */
-					libdft_die();
-				}
-#ifdef DEBUG_MEMTRACK
-				/* verbose */
-				LOG(string(__func__) + ": unmapping segment [" +
-				hexstr(STAB2VIRT(i) + STAB[i]) + "-" +
-				hexstr(STAB2VIRT(i) + STAB[i] + PAGE_SZ - 1) +
-				"]\n");
-#endif
-			}
-		
-			STAB[i] = (uint32_t)zero_seg - STAB2VIRT(i);
-		}
-	}
+	else
+		/*
+		 * (tagmap collapse optimization)
+		 *
+		 * collapse the clean chunks to zero_seg; the
+		 * tainted ones keep their tagmap segments
+		 */
+		stab_collapse(VIRT2STAB(addr), VIRT2STAB(addr + size - 1));
 #ifdef DEBUG_MEMTRACK
 		/* verbose */
 		LOG(string(__func__) + ": re-mapped segment [" +
-		hexstr(addr + STAB[VIRT2STAB(addr)]) + "-" +
-		hexstr(addr + size - 1 + STAB[VIRT2STAB(addr + size - 1)]) +
+		hexstr(VIRT2TAG(addr)) + "-" +
+		hexstr(VIRT2TAG(addr + size - 1)) +
 		"]\n");
 #endif
 }
@@ -1925,15 +2526,9 @@ post_ipc_hook(syscall_ctx_t *ctx)
 	/* attach address */
 	size_t shm_addr;
 
-	/* tagmap segment */
-	void *tseg = NULL;
-	
 	/* segment size */
 	size_t size;
 
-	/* iterators */
-	size_t i, j;
-
 	/* ipc() is a demultiplexer for all SYSV IPC calls */
 	switch ((int)ctx->arg[SYSCALL_ARG0]) {
 		/* msgctl() */
@@ -1987,6 +2582,10 @@ post_ipc_hook(syscall_ctx_t *ctx)
 					tagmap_clrn(ctx->arg[SYSCALL_ARG4],
 						sizeof(struct shminfo));
 					break;
+				case IPC_RMID:
+					/* a new segment (same id) starts clean */
+					tagmap_share_rmid((int)ctx->arg[SYSCALL_ARG1]);
+					break;
 				default:
 					/* nothing to do */
 					return;
@@ -2054,125 +2653,34 @@ post_ipc_hook(syscall_ctx_t *ctx)
 				libdft_die();
 			}
 
-#ifdef TAGMAP_COLLAPSE
-#ifdef DEBUG_MEMTRACK
-			/* verbose */
-			LOG(string(__func__) + ": " + hexstr(shm_addr) + "-" +
-				hexstr(shm_addr + buf.shm_segsz - 1) + " ");
-			if (((buf.shm_perm.mode & O_RDWR) != 0) &&
-				((ctx->arg[SYSCALL_ARG2] & SHM_RDONLY) == 0))
-				LOG("R W -");
-			else
-				LOG("R - -");
-			LOG(" (" + decstr(buf.shm_segsz) + ")\n");
-#endif
-			/* writeable mapping */
-			if (((buf.shm_perm.mode & O_RDWR) != 0)
-			&& ((ctx->arg[SYSCALL_ARG2] & SHM_RDONLY) == 0)) {
-				/*
-				 * allocate space for a new tagmap
-				 * segment by invoking mmap(2)
-			 	*/
-				if (unlikely(((tseg = mmap(NULL, buf.shm_segsz,
-					/* RW- */
-					PROT_READ | PROT_WRITE | ~PROT_EXEC,
-					MAP_PRIVATE | MAP_ANONYMOUS, -1, 0))
-							== MAP_FAILED))) {
-					/* error message */
-					LOG(string(__func__) +
-					": tagmap segment allocation failed (" +
-					string(strerror(errno)) + ")\n");
-
-					/* die */
-					libdft_die();
-				}
-
-				/* STAB setup */
-				for (i = VIRT2STAB(shm_addr), j = 0;
-				i <= VIRT2STAB(shm_addr + buf.shm_segsz - 1);
-				i++, j++)
-					STAB[i] = (uint32_t)tseg - STAB2VIRT(i)
-						+ (j * PAGE_SZ);
-#ifdef DEBUG_MEMTRACK
-				/* verbose */
-				LOG(string(__func__) +
-				": mapping writeable segment [" +
-				hexstr(shm_addr + STAB[VIRT2STAB(shm_addr)]) +
-				"-" + hexstr(shm_addr + buf.shm_segsz - 1 +
-				STAB[VIRT2STAB(shm_addr + buf.shm_segsz - 1)]) +
-				"]\n");
-#endif
-			}
-		/* 
-		 * read-only mapping;
-		 * in x86, execute (X) implies read (R) as well, so we handle
-		 * these two cases similarly. Moreover, pages with PROT_NONE
-		 * are mapped to tagmap_zero, since they are still part of the
-		 * process's address space
-		 */
-			else {
-		/*
-		 * (tagmap collapse optimization)
-		 *
-		 * read-only mappings are mapped to zero_seg for reducing
-		 * address space waste; reading from zero_seg always results
-		 * in clear tags
-		 */
-	
-				/* STAB setup */
-				for (i = VIRT2STAB(shm_addr);
-				i <= VIRT2STAB(shm_addr + buf.shm_segsz - 1);
-				i++)
-					STAB[i] = (uint32_t)zero_seg -
-						STAB2VIRT(i);
-#ifdef DEBUG_MEMTRACK
-				/* verbose */
-				LOG(string(__func__) +
-					": mapping read-only segment [" +
-				hexstr(shm_addr + STAB[VIRT2STAB(shm_addr)]) +
-				"-" + hexstr(shm_addr + buf.shm_segsz - 1 +
-				STAB[VIRT2STAB(shm_addr + buf.shm_segsz - 1)]) + 				"]\n");
-#endif
-			}
-#else
 #ifdef DEBUG_MEMTRACK
 			/* verbose */
 			LOG(string(__func__) + ": " + hexstr(shm_addr) + "-" +
 				hexstr(shm_addr + buf.shm_segsz - 1) + "\n");
 #endif
 			/*
-			 * allocate space for a new tagmap
-			 * segment by invoking mmap(2)
+			 * map the shared tagmap segment of the shm id;
+			 * the tags are shared with the other processes
+			 * that attach it (even read-only ones)
 			 */
-			if (unlikely(((tseg = mmap(NULL, buf.shm_segsz,
-				/* RW- */
-				PROT_READ | PROT_WRITE | ~PROT_EXEC,
-				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0))
-						== MAP_FAILED))) {
+			if (unlikely(tagmap_share_shm(shm_addr,
+					PAGE_ALIGN(buf.shm_segsz + PAGE_SZ - 1),
+					(int)ctx->arg[SYSCALL_ARG1]) != 0)) {
 				/* error message */
 				LOG(string(__func__) +
-				": tagmap segment allocation failed (" +
+				": shared tagmap segment allocation failed (" +
 				string(strerror(errno)) + ")\n");
 
 				/* die */
 				libdft_die();
 			}
-
-			/* STAB setup */
-			for (i = VIRT2STAB(shm_addr), j = 0;
-				i <= VIRT2STAB(shm_addr + buf.shm_segsz - 1);
-				i++, j++)
-				STAB[i] = (uint32_t)tseg - STAB2VIRT(i)
-					+ (j * PAGE_SZ);
 #ifdef DEBUG_MEMTRACK
 			/* verbose */
 			LOG(string(__func__) +
-				": mapping segment [" +
-				hexstr(shm_addr + STAB[VIRT2STAB(shm_addr)]) +
-				"-" + hexstr(shm_addr + buf.shm_segsz - 1 +
-				STAB[VIRT2STAB(shm_addr + buf.shm_segsz - 1)]) +
+				": mapping shared segment [" +
+				hexstr(VIRT2TAG(shm_addr)) +
+				"-" + hexstr(VIRT2TAG(shm_addr + buf.shm_segsz - 1)) +
 				"]\n");
-#endif
 #endif
 			/* 
 			 * associate the attach address
@@ -2195,49 +2703,17 @@ post_ipc_hook(syscall_ctx_t *ctx)
 			LOG(string(__func__) + ": " + hexstr(shm_addr) + "-" +
 				hexstr(shm_addr + size - 1) + "\n");
 #endif
-#ifdef TAGMAP_COLLAPSE
-			/* handle a previously writeable mapping */
-			if (PAGE_ALIGN(shm_addr + STAB[VIRT2STAB(shm_addr)])
-						!= (uint32_t)zero_seg) {
-#endif
-#ifdef DEBUG_MEMTRACK
-				/* verbose */
-				LOG(string(__func__) + ": unmapping segment [" +
-				hexstr(shm_addr + STAB[VIRT2STAB(shm_addr)]) +
-				"-" + hexstr(shm_addr + size - 1 +
-				STAB[VIRT2STAB(shm_addr + size - 1)]) +
-				"]\n");
-#endif
-				/*
-				 * deallocate the space of the corresponding
-				 * tagmap segment by invoking munmap(2)
-				 */
-				if (unlikely(munmap((void *)(shm_addr +
-					STAB[VIRT2STAB(shm_addr)]),
-					PAGE_ALIGN(size) + PAGE_SZ) == -1)) {
-					/* error message */
-					LOG(string(__func__) +
-					": tagmap segment deallocation failed ("
-						+ string(strerror(errno)) +
-						")\n");
-				
-					/* die */
-					libdft_die();
-				}
-#ifdef TAGMAP_COLLAPSE
-			}
-#endif
-
-			/* STAB setup */
-			for (i = VIRT2STAB(shm_addr);
-				i <= VIRT2STAB(shm_addr + size - 1); i++)
-				STAB[i] = (uint32_t)null_seg - STAB2VIRT(i);
+			/*
+			 * deallocate the space of the corresponding
+			 * tagmap segment and setup the STAB
+			 */
+			stab_unmap(VIRT2STAB(shm_addr),
+				VIRT2STAB(shm_addr + size - 1), null_seg);
 #ifdef DEBUG_MEMTRACK
 			/* verbose */
 			LOG(string(__func__) + ": re-mapped segment [" +
-			hexstr(shm_addr + STAB[VIRT2STAB(shm_addr)]) +
-			"-" + hexstr(shm_addr + size - 1 +
-			STAB[VIRT2STAB(shm_addr + size - 1)]) + "]\n");
+			hexstr(VIRT2TAG(shm_addr)) +
+			"-" + hexstr(VIRT2TAG(shm_addr + size - 1)) + "]\n");
 #endif
 			/* cleanup */
 			shm.erase(shm_addr);
@@ -2250,6 +2726,109 @@ post_ipc_hook(syscall_ctx_t *ctx)
 	}
 }
 
+#if defined(TARGET_IA32E)
+/*
+ * x86-64 has no ipc(2); the SysV IPC syscalls are
+ * repackaged the way ipc(2) passes them (see post_ipc_hook())
+ *
+ * ipc(2) arguments: call, first, second, third, ptr, fifth
+ */
+
+/* __NR_semctl post syscall hook */
+static void
+post_semctl_hook(syscall_ctx_t *ctx)
+{
+	/* ipc(2) context */
+	syscall_ctx_t	ictx = *ctx;
+
+	/* semun is passed by value */
+	union semun	su;
+
+	su.buf = (struct semid_ds *)ctx->arg[SYSCALL_ARG3];
+
+	ictx.arg[SYSCALL_ARG0] = SEMCTL;
+	ictx.arg[SYSCALL_ARG1] = ctx->arg[SYSCALL_ARG0];
+	ictx.arg[SYSCALL_ARG2] = ctx->arg[SYSCALL_ARG1];
+	ictx.arg[SYSCALL_ARG3] = ctx->arg[SYSCALL_ARG2] + IPC_FIX;
+	ictx.arg[SYSCALL_ARG4] = (ADDRINT)&su;
+
+	post_ipc_hook(&ictx);
+}
+
+/* __NR_msgrcv post syscall hook */
+static void
+post_msgrcv_hook(syscall_ctx_t *ctx)
+{
+	/* ipc(2) context */
+	syscall_ctx_t	ictx = *ctx;
+
+	ictx.arg[SYSCALL_ARG0] = MSGRCV;
+	ictx.arg[SYSCALL_ARG4] = ctx->arg[SYSCALL_ARG1];
+
+	post_ipc_hook(&ictx);
+}
+
+/* __NR_msgctl post syscall hook */
+static void
+post_msgctl_hook(syscall_ctx_t *ctx)
+{
+	/* ipc(2) context */
+	syscall_ctx_t	ictx = *ctx;
+
+	ictx.arg[SYSCALL_ARG0] = MSGCTL;
+	ictx.arg[SYSCALL_ARG1] = ctx->arg[SYSCALL_ARG0];
+	ictx.arg[SYSCALL_ARG2] = ctx->arg[SYSCALL_ARG1] + IPC_FIX;
+	ictx.arg[SYSCALL_ARG4] = ctx->arg[SYSCALL_ARG2];
+
+	post_ipc_hook(&ictx);
+}
+
+/* __NR_shmat post syscall hook */
+static void
+post_shmat_hook(syscall_ctx_t *ctx)
+{
+	/* ipc(2) context */
+	syscall_ctx_t	ictx = *ctx;
+
+	/* the attach address is returned directly */
+	size_t		shm_addr = (size_t)ctx->ret;
+
+	ictx.arg[SYSCALL_ARG0] = SHMAT;
+	ictx.arg[SYSCALL_ARG1] = ctx->arg[SYSCALL_ARG0];
+	ictx.arg[SYSCALL_ARG3] = (ADDRINT)&shm_addr;
+
+	post_ipc_hook(&ictx);
+}
+
+/* __NR_shmdt post syscall hook */
+static void
+post_shmdt_hook(syscall_ctx_t *ctx)
+{
+	/* ipc(2) context */
+	syscall_ctx_t	ictx = *ctx;
+
+	ictx.arg[SYSCALL_ARG0] = SHMDT;
+	ictx.arg[SYSCALL_ARG4] = ctx->arg[SYSCALL_ARG0];
+
+	post_ipc_hook(&ictx);
+}
+
+/* __NR_shmctl post syscall hook */
+static void
+post_shmctl_hook(syscall_ctx_t *ctx)
+{
+	/* ipc(2) context */
+	syscall_ctx_t	ictx = *ctx;
+
+	ictx.arg[SYSCALL_ARG0] = SHMCTL;
+	ictx.arg[SYSCALL_ARG1] = ctx->arg[SYSCALL_ARG0];
+	ictx.arg[SYSCALL_ARG2] = ctx->arg[SYSCALL_ARG1] + IPC_FIX;
+	ictx.arg[SYSCALL_ARG4] = ctx->arg[SYSCALL_ARG2];
+
+	post_ipc_hook(&ictx);
+}
+#endif
+
 /* __NR_fcntl post syscall hook */
 static void
 post_fcntl_hook(syscall_ctx_t *ctx)
@@ -2266,12 +2845,14 @@ post_fcntl_hook(syscall_ctx_t *ctx)
 			tagmap_clrn(ctx->arg[SYSCALL_ARG2],
 					sizeof(struct flock));
 			break;
+#if !defined(TARGET_IA32E)
 		/* F_GETLK64 */
 		case F_GETLK64:
 			/* clear the tag bits */
 			tagmap_clrn(ctx->arg[SYSCALL_ARG2],
 					sizeof(struct flock64));
 			break;
+#endif
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,32)
 		/* F_GETOWN_EX */
 		case F_GETOWN_EX:
@@ -2443,6 +3024,74 @@ post_socketcall_hook(syscall_ctx_t *ctx)
 	}
 }
 
+#if defined(TARGET_IA32E)
+/*
+ * x86-64 has no socketcall(2); repackage the arguments
+ * of the direct socket syscalls the way socketcall(2)
+ * passes them and reuse its post syscall hook
+ *
+ * @ctx:	the syscall context
+ * @call:	the socketcall(2) demux index
+ */
+static inline void
+post_socket_demux(syscall_ctx_t *ctx, int call)
+{
+	/* socketcall(2) context */
+	syscall_ctx_t	sctx = *ctx;
+
+	/* socket call arguments */
+	unsigned long	args[SYSCALL_ARG_NUM];
+
+	/* iterator */
+	size_t	i;
+
+	/* copy the arguments */
+	for (i = 0; i < SYSCALL_ARG_NUM; i++)
+		args[i] = ctx->arg[i];
+
+	/* demux index and argument block */
+	sctx.arg[SYSCALL_ARG0] = call;
+	sctx.arg[SYSCALL_ARG1] = (ADDRINT)args;
+
+	post_socketcall_hook(&sctx);
+}
+
+/* __NR_accept(4), __NR_getsockname, and __NR_getpeername post syscall hook */
+static void
+post_accept_hook(syscall_ctx_t *ctx)
+{
+	post_socket_demux(ctx, SYS_ACCEPT);
+}
+
+/* __NR_socketpair post syscall hook */
+static void
+post_socketpair_hook(syscall_ctx_t *ctx)
+{
+	post_socket_demux(ctx, SYS_SOCKETPAIR);
+}
+
+/* __NR_recvfrom post syscall hook */
+static void
+post_recvfrom_hook(syscall_ctx_t *ctx)
+{
+	post_socket_demux(ctx, SYS_RECVFROM);
+}
+
+/* __NR_recvmsg post syscall hook */
+static void
+post_recvmsg_hook(syscall_ctx_t *ctx)
+{
+	post_socket_demux(ctx, SYS_RECVMSG);
+}
+
+/* __NR_getsockopt post syscall hook */
+static void
+post_getsockopt_hook(syscall_ctx_t *ctx)
+{
+	post_socket_demux(ctx, SYS_GETSOCKOPT);
+}
+#endif
+
 /* 
  * __NR_syslog post syscall hook
  *
@@ -2501,7 +3150,24 @@ post__sysctl_hook(syscall_ctx_t *ctx)
 static void
 post_mremap_hook(syscall_ctx_t *ctx)
 {
-	LOG(string(__func__) + ": unhandled mremap(2)\n");
+	/* mremap parameters (addresses, sizes, and flags) */
+	size_t	oaddr	= ctx->arg[SYSCALL_ARG0];
+	size_t	osize	= PAGE_ALIGN(ctx->arg[SYSCALL_ARG1] + PAGE_SZ - 1);
+	size_t	nsize	= PAGE_ALIGN(ctx->arg[SYSCALL_ARG2] + PAGE_SZ - 1);
+	int	flags	= (int)ctx->arg[SYSCALL_ARG3];
+
+	/* mremap() was not successful; optimized branch */
+	if (unlikely((void *)ctx->ret == MAP_FAILED))
+		return;
+#ifdef DEBUG_MEMTRACK
+	/* verbose */
+	LOG(string(__func__) + ": " + hexstr(oaddr) + "-" +
+		hexstr(oaddr + osize - 1) + " -> " + hexstr(ctx->ret) + "-" +
+		hexstr(ctx->ret + nsize - 1) + "\n");
+#endif
+	/* relocate the tags */
+	tagmap_remap(oaddr, osize, ctx->ret, nsize,
+			(flags & MREMAP_DONTUNMAP) != 0);
 }
 
 #if LINUX_VERSION_CODE >= KERNEL_VERSION(2,6,33)
@@ -40,7 +40,9 @@
 #include <sys/timex.h>
 #include <sys/types.h>
 #include <sys/vfs.h>
+#if !defined(TARGET_IA32E)
 #include <sys/vm86.h>
+#endif
 
 #include <asm/ldt.h>
 #include <asm/posix_types.h>
@@ -228,5 +230,8 @@ int syscall_set_pre(syscall_desc_t*, void (*)(syscall_ctx_t*));
 int syscall_clr_pre(syscall_desc_t*);
 int syscall_set_post(syscall_desc_t*, void (*)(syscall_ctx_t*));
 int syscall_clr_post(syscall_desc_t*);
+#ifdef	TAGMAP_DIRECT
+void syscall_fixed(THREADID, syscall_ctx_t*);
+#endif
 
 #endif /* __SYSCALL_DESC_H__ */
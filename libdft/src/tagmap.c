@@ -30,25 +30,51 @@
  * POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <sys/file.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 
+#include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <stdio.h>
 #include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
 
 #include "libdft_api.h"
 #include "tagmap.h"
 #include "branch_pred.h"
 
-#ifdef	HUGE_TLB
 #ifndef	MAP_HUGETLB
 #define	MAP_HUGETLB	0x40000	/* architecture specific */
 #endif
+#ifndef	MADV_HUGEPAGE
+#define	MADV_HUGEPAGE	14	/* Linux >= 2.6.38 */
+#endif
+
+#ifdef	HUGE_TLB
 #define MAP_FLAGS	MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB
+#define HUGE_DFL	"hugetlb"
 #else
 #define MAP_FLAGS	MAP_PRIVATE | MAP_ANONYMOUS
+#define HUGE_DFL	"none"
 #endif
 
+/* smallest tagmap clear that is released with madvise(2); 64 KB */
+#define DONTNEED_MIN	(PAGE_SZ << 4)
+
+/* tagmap arenas (see arena_alloc()) */
+#define ARENA_SHIFT	26			/* arena alignment (bits)	*/
+#define ARENA_SZ	((size_t)1 << ARENA_SHIFT)	/* arena size; 64 MB	*/
+#define ARENA_NUM	((size_t)1 << (VIRT_BITS - ARENA_SHIFT))	/* slots */
+#define ARENA_MAX	(ARENA_SZ >> 4)		/* largest arena segment; 4 MB	*/
+#define ARENA_CLASSES	(ARENA_SHIFT - PAGE_SHIFT + 1)	/* size classes	*/
+#define ARENA_FIT_MAX	8			/* first-fit scan limit		*/
+
 
 /*
  * tagmap
@@ -67,15 +93,52 @@
  *
  * the segment table (STAB) keeps the necessary information for translating
  * virtual addresses to their ``shadowed'' addresses. In the 32-bit x86
- * architecture (i386), it is implemented using a single level page-table-like
- * structure with 4 GB/PAGE_SZ entries. Each entry, translates all the
- * addresses of a PAGE_SZ chunk to their shadowed bytes in a tagmap segment,
- * and the translation is performed as follows:
+ * architecture (i386), it is implemented using a two level page-table-like
+ * structure; a directory of STAB_DIR_SIZE leaves, each one holding
+ * STAB_LEAF_SIZE entries. Every entry keeps the tagmap segment (page) that
+ * shadows a PAGE_SZ chunk, and the translation is performed as follows:
+ *
+ * 	taddr = STAB[vaddr >> 22][(vaddr >> 12) & 0x3FF] + (vaddr & 0xFFF)
  *
- * 	taddr = vaddr + STAB[vaddr >> lg(PAGE_SZ)]
+ * leaves are allocated lazily (i.e., the first time that a segment is
+ * assigned to a chunk that they cover); until then, the directory points
+ * to one of the two shared default leaves (null_leaf, zero_leaf). In
+ * x86-64 the directory itself is split in middles (STAB_MID_SIZE leaves
+ * each), which are allocated lazily too, and the top level points to one
+ * of the two shared default middles (null_mid, zero_mid) until then
+ */
+#ifdef	STAB_MID_SHIFT
+size_t		***STAB		= NULL;
+#else
+size_t		**STAB		= NULL;
+#endif
+
+/*
+ * taint summary
+ *
+ * a bitmap with one bit for every SUM_SZ bytes of the address space; the
+ * bit is set by every tagmap writer that stores a non-zero tag, and it is
+ * cleared only when the whole unit is untagged (or unmapped). Hence, a
+ * clear bit guarantees that the corresponding unit is clean, whereas a set
+ * bit means that the unit ``may be tainted''. The leaves are allocated on
+ * demand, and the missing ones are clean (see tag_sum_byte())
+ */
+uint8_t		**tagmap_sum	= NULL;
+
+#ifdef	TAGMAP_DIRECT
+/*
+ * direct shadow (TAGMAP_DIRECT)
  *
+ * a DIRECT_SZ region that is reserved at startup and populated on demand
+ * (i.e., by the kernel, on the first write to each page); the tag of
+ * vaddr is at tagmap_direct + (vaddr >> TAG_SHIFT). The STAB is still
+ * maintained, since it records which chunks are mapped (and how), but
+ * its entries point to the direct region. The region is relocated if
+ * the application asks for a fixed mapping on top of it (see
+ * tagmap_direct_fixed())
  */
-uint32_t	*STAB		= NULL;
+size_t		tagmap_direct	= 0;
+#endif
 
 /* program break */
 size_t		brk_start	= 0;
@@ -85,6 +148,230 @@ size_t		brk_end		= 0;
 void		*null_seg	= NULL;
 void		*zero_seg	= NULL;
 
+/* default (shared) STAB leaves; all entries point to null_seg/zero_seg */
+static size_t	*null_leaf	= NULL;
+static size_t	*zero_leaf	= NULL;
+
+#ifdef	STAB_MID_SHIFT
+/* default (shared) STAB middles; all entries point to null_leaf/zero_leaf */
+static size_t	**null_mid	= NULL;
+static size_t	**zero_mid	= NULL;
+#endif
+
+#ifdef	TAGMAP_1BIT
+/* 4 tag bits to 4 tag bytes (see tag_ldw()/tag_ldl()) */
+const uint32_t	tag_bit2byte[16] = {
+	0x00000000U, 0x00000001U, 0x00000100U, 0x00000101U,
+	0x00010000U, 0x00010001U, 0x00010100U, 0x00010101U,
+	0x01000000U, 0x01000001U, 0x01000100U, 0x01000101U,
+	0x01010000U, 0x01010001U, 0x01010100U, 0x01010101U
+};
+#endif
+
+/* number of private STAB leaves */
+static size_t	stab_leaves	= 0;
+
+/* number of private STAB middles (x86-64) */
+static size_t	stab_mids	= 0;
+
+/*
+ * per-page tables; one byte for every tagmap page, indexed by
+ * VIRT2STAB(page). They are sparse, like the taint summary; a
+ * directory of STAB_DIR_SIZE leaves (STAB_LEAF_SIZE bytes each),
+ * which are allocated on demand (see ptab_set()). The entries
+ * of the missing leaves are 0
+ */
+#define PTAB_DIR_SZ	(STAB_DIR_SIZE * sizeof(uint8_t *))
+
+/* size of the leaves of the sparse tables (summary included) */
+static size_t	sparse_bytes	= 0;
+
+/* the region kind of every tagmap page (per-page table) */
+static uint8_t	**page_kind	= NULL;
+
+/* shadow memory accounting; indexed by region kind */
+static tagmap_acct_t	kind_acct[TAGMAP_KIND_NUM];
+
+/* region kind names */
+static const char	*kind_name[TAGMAP_KIND_NUM] = {
+	"none", "image", "stack", "heap", "mmap", "shm"
+};
+
+/* signal that triggers an accounting report (0: none) */
+static KNOB<int> acct_sig(KNOB_MODE_WRITEONCE, "pintool", "acct_sig",
+		"0", "signal that dumps the tagmap usage (e.g., 12: SIGUSR2)");
+
+/* page_kind flag; the tagmap page is shared with other processes */
+#define KIND_SHARED	0x80
+#define KIND_MASK	0x7F
+
+/*
+ * shared tagmap segments of files and SysV segments (see
+ * tagmap_share_file()); off by default. The shadow objects are kept in
+ * a directory under share_dir, which is named after the namespace of
+ * the processes that share them: by default, the instrumented process
+ * tree of a single run, whose root removes the directory on exit (see
+ * share_init()); a given share_ns is kept across runs instead
+ */
+static KNOB<string> share_dir(KNOB_MODE_WRITEONCE, "pintool", "share_dir",
+		"", "directory of the shared tagmap segments (e.g., /dev/shm; "
+		"\"\": off)");
+static KNOB<string> share_ns(KNOB_MODE_WRITEONCE, "pintool", "share_ns",
+		"", "namespace of the shared tagmap segments (\"\": this run)");
+
+/* the directory of the shadow objects (see share_init()) */
+static string	share_path_ns;
+
+/* the process that removes it on exit (0: none) */
+static pid_t	share_root	= 0;
+
+/* number of shared tagmap pages */
+static size_t	shared_pages	= 0;
+
+/* shared tagmap segments are mapped on the direct shadow (TAGMAP_DIRECT) */
+#ifdef	TAGMAP_DIRECT
+#define SHARE_FIXED	MAP_FIXED
+#else
+#define SHARE_FIXED	0
+#endif
+
+/* the tag bytes of a summary unit */
+#define SUM_TAG_SZ	TAG_SEG_SZ(SUM_SZ)
+
+/*
+ * checkpoint (see tagmap_checkpoint()); the address
+ * and the tags of every (possibly) tainted unit
+ */
+static size_t	*ckpt_addr	= NULL;	/* unit addresses		*/
+static uint8_t	*ckpt_tags	= NULL;	/* unit tags; SUM_TAG_SZ each	*/
+static size_t	ckpt_num	= 0;	/* number of units		*/
+static size_t	ckpt_max	= 0;	/* capacity (units)		*/
+
+/*
+ * tagmap dumps (see tagmap_dump()); the non-clean pages of the previous
+ * dump, and the tagmap pages that have been written since then (i.e.,
+ * the soft-dirty bits of /proc/self/pagemap)
+ */
+#define PM_SOFT_DIRTY	(1ULL << 55)	/* written since clear_refs	*/
+#define PM_SWAP		(1ULL << 62)	/* swapped			*/
+#define PM_PRESENT	(1ULL << 63)	/* present			*/
+#define PM_CACHE	(PAGE_SZ / sizeof(uint64_t))	/* entries per read */
+
+typedef struct {
+	size_t	vaddr;	/* the page			*/
+	size_t	seg;	/* its tagmap segment (tags)	*/
+} dump_page_t;
+
+static vector<dump_page_t>	dump_prev;	/* previous dump	*/
+static uint64_t	dump_seq	= 0;	/* dumps so far			*/
+static int	dump_sd		= 1;	/* soft-dirty bits work		*/
+static int	pm_fd		= -1;	/* /proc/self/pagemap		*/
+static uint64_t	pm_cache[PM_CACHE];	/* pagemap entries		*/
+static size_t	pm_first	= (size_t)-1;	/* first cached entry	*/
+#ifdef	TAGMAP_LABEL
+static uint32_t	dump_lbl	= 0;	/* labels in the previous dump	*/
+#endif
+
+/* the pending run of a dump; tagmap pages [rstart, rend) at roff */
+static int	dump_fd;		/* the dump file		*/
+static size_t	dump_rstart, dump_rend;	/* the pending run		*/
+static uint64_t	dump_roff;		/* its file offset		*/
+
+#ifdef	TAGMAP_LABEL
+/*
+ * label table; every label (but 0 and the provenance labels, which are
+ * not kept in the table) is either a source ({0, 0, 0, 0}), the union of
+ * two smaller labels ({a, b, 0, 0}; 0 < a < b), or an input range
+ * ({0, TAG_PROV_LBL(src, 0), start, end}). The unions and the ranges are
+ * hash-consed in lbl_hash (open addressing), and hence every pair of
+ * labels is combined at most once
+ */
+#define LBL_HASH_SZ	(TAG_LBL_MAX << 1)	/* hash slots; load <= 1/2	*/
+#define LBL_HASH(a, b, c, d)						\
+	((((a) * 0x9E3779B1U) ^ ((b) * 0x85EBCA6BU) ^			\
+	  ((c) * 0xC2B2AE35U) ^ ((d) * 0x27D4EB2FU)) & (LBL_HASH_SZ - 1))
+
+#define LBL_UNION(lbl)							\
+	(((lbl) & TAG_PROV) == 0 && (lbl) != TAG_LBL_ALL &&		\
+	 lbl_tab[(lbl)][0] != TAG_ZERO)
+
+static uint32_t	(*lbl_tab)[4]	= NULL;	/* the labels			*/
+static uint32_t	*lbl_hash	= NULL;	/* unions/ranges; 0 if free	*/
+static uint32_t	lbl_next	= 1;	/* next free label		*/
+static int	lbl_full	= 0;	/* the table is full		*/
+#endif
+
+/*
+ * huge page policy for the tagmap segments (see tagmap_seg_alloc());
+ * HUGE_TLB selects MAP_HUGETLB by default
+ *
+ * none		: regular pages
+ * thp		: 2 MB aligned segments, backed by transparent huge pages
+ * hugetlb	: MAP_HUGETLB segments; thp if the hugetlb pool is empty
+ */
+static KNOB<string> huge_knob(KNOB_MODE_WRITEONCE, "pintool", "huge",
+		HUGE_DFL, "huge pages for the tagmap (none, thp, hugetlb)");
+
+/* the selected policy */
+static int	huge_policy	= TAGMAP_HUGE_NONE;
+
+/* huge page usage */
+static struct {
+	size_t	thp;		/* bytes advised as THP			*/
+	size_t	hugetlb;	/* bytes backed by MAP_HUGETLB		*/
+	size_t	fallback;	/* requests that fell back (pages/THP)	*/
+	size_t	pinned;		/* hugetlb bytes that cannot be released*/
+} huge_stats;
+
+/*
+ * lazy tagmap segments (see tagmap_commit()); segments of at least lazy_min
+ * bytes are reserved read-only, and they read as clean (i.e., the pages are
+ * backed by the zero page of the kernel) until they are written for the
+ * first time. The write faults, and the page (along with the rest of its
+ * LAZY_BLOCK) is committed by the exception handler of libdft
+ */
+static KNOB<size_t> lazy_min(KNOB_MODE_WRITEONCE, "pintool", "lazy",
+		"4194304", "min tagmap segment committed on write (0: off)");
+
+#define LAZY_NONE	0	/* not a lazy page			*/
+#define LAZY_RSV	1	/* reserved; reads as clean		*/
+#define LAZY_COMMIT	2	/* committed				*/
+#define LAZY_BLOCK	(16 * PAGE_SZ)	/* commit unit; 64 KB		*/
+
+/* the lazy state of every tagmap page (per-page table) */
+static uint8_t	**lazy_state	= NULL;
+
+/* lazy segment usage */
+static struct {
+	size_t	reserved;	/* reserved bytes			*/
+	size_t	committed;	/* committed bytes			*/
+	size_t	faults;		/* write faults				*/
+} lazy_stats;
+
+/* a run of free tagmap pages inside an arena */
+typedef struct arena_run {
+	size_t			addr;	/* the first page	*/
+	size_t			npages;	/* number of pages	*/
+	struct arena_run	*next;	/* next run		*/
+} arena_run_t;
+
+/*
+ * free runs; the runs of size class c have [2^c, 2^(c + 1))
+ * pages, and the unused run descriptors are kept in arena_nodes
+ */
+static arena_run_t	*arena_free[ARENA_CLASSES];
+static arena_run_t	*arena_nodes	= NULL;
+
+/* arena slots in the address space; 1 if the slot is an arena */
+static uint8_t		arena_map[ARENA_NUM];
+
+/* the unused part of the current arena; [arena_top, arena_end) */
+static size_t		arena_top	= 0;
+static size_t		arena_end	= 0;
+
+/* number of arenas */
+static size_t		arena_cnt	= 0;
+
 /*
  * track when the dynamic linker/loader
  * is loaded into the address space of
@@ -93,739 +380,4544 @@ void		*zero_seg	= NULL;
 static
 size_t dynldlnk_loaded	= 0;
 
-static void
-stackrange_alloc(uint32_t addrstart, uint32_t addrend)
+/*
+ * get a leaf of a sparse table (i.e., the taint summary or a per-page
+ * table), and allocate it (zero-filled) if it is missing. The new leaf
+ * is installed atomically, since the summary is updated by every thread
+ *
+ * @dir:	the directory of the table
+ * @dindx:	the directory offset
+ * @lsize:	the leaf size in bytes
+ *
+ * returns:	the leaf
+ */
+static uint8_t *
+sparse_leaf(uint8_t **dir, size_t dindx, size_t lsize)
 {
-	size_t	i, j;	/* iterators		*/
-	size_t size = addrend - addrstart;
+	uint8_t	*leaf;	/* the new leaf */
 
-	void	*stack_seg	= NULL;
-	/* stack_seg; zero_seg, null_seg; default segments */
-	if((stack_seg = mmap(NULL, size, /* RW- */
-		PROT_READ | PROT_WRITE, MAP_FLAGS, -1, 0)) == MAP_FAILED) {
-		perror("mmap");
-		exit(1);
+	/* already allocated; optimized branch */
+	if (likely(dir[dindx] != NULL))
+		return dir[dindx];
+
+	/* allocate space for the leaf by invoking mmap(2) */
+	if (unlikely((leaf = (uint8_t *)mmap(NULL, lsize,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)) {
+		/* error message */
+		LOG(string(__func__) +
+			": sparse table leaf allocation failed (" +
+			string(strerror(errno)) + ")\n");
+
+		/* die */
+		libdft_die();
 	}
 
-	/* 
-	 * stack mapping
-	 */
-	for (i = VIRT2STAB(addrstart), j = 0;
-			i <= VIRT2STAB(addrend-1); i++, j++) {
-		STAB[i] = (uint32_t)stack_seg - STAB2VIRT(i) + (j * PAGE_SZ);
+	/* install it, unless another thread did so first */
+	if (__sync_bool_compare_and_swap(&dir[dindx], (uint8_t *)NULL, leaf))
+		(void)__sync_fetch_and_add(&sparse_bytes, lsize);
+	else
+		(void)munmap(leaf, lsize);
 
-#ifdef DEBUG_MEMTRACK
-		/* verbose */
-		LOG(string(__func__) + ": stack range " + hexstr(addrstart) + "-" + hexstr(addrend) + ": stack_seg\n");
-#endif
+	/* return the leaf */
+	return dir[dindx];
+}
 
-	}
+/*
+ * get a leaf of the taint summary (see tag_sum_set1());
+ * it is allocated the first time that it is needed
+ *
+ * @dindx:	the summary directory offset
+ *
+ * returns:	the leaf
+ */
+uint8_t *
+tagmap_sum_leaf(size_t dindx)
+{
+	return sparse_leaf(tagmap_sum, dindx, SUM_LEAF_SZ);
+}
 
-#ifdef DEBUG_MEMTRACK
-	/* verbose */
-	LOG(string(__func__) + ": stack range " + hexstr(addrstart) + "-" + hexstr(addrend) + ": stack_seg\n");
-#endif
+/*
+ * get an entry of a per-page table
+ *
+ * @tab:	the table
+ * @indx:	the entry; VIRT2STAB(page)
+ *
+ * returns:	the entry (0 if its leaf is missing)
+ */
+static inline uint8_t
+ptab_get(uint8_t **tab, size_t indx)
+{
+	uint8_t	*leaf	= tab[STAB2DIR(indx)];
 
+	return (leaf != NULL) ? leaf[STAB2LEAF(indx)] : 0;
 }
 
 /*
- * get the starting and ending
- * addresses of the vDSO mapping
+ * get the address of an entry of a per-page
+ * table; its leaf is allocated if missing
  *
+ * @tab:	the table
+ * @indx:	the entry; VIRT2STAB(page)
  *
- * @saddr: 	the starting address of vDSO
- * @eaddr:	the ending address of VDSO
+ * returns:	the address of the entry
+ */
+static inline uint8_t *
+ptab_ref(uint8_t **tab, size_t indx)
+{
+	return sparse_leaf(tab, STAB2DIR(indx), STAB_LEAF_SIZE) +
+		STAB2LEAF(indx);
+}
+
+/*
+ * set an entry of a per-page table; clearing
+ * an entry of a missing leaf is a no-op
  *
- * returbs:	saddr and eaddr have the appropriate
- * 		values after invocation; if vDSO
- * 		is not found saddr and eaddr will
- * 		be zero
+ * @tab:	the table
+ * @indx:	the entry; VIRT2STAB(page)
+ * @val:	the value
  */
-static inline
-void get_vdso(size_t *saddr, size_t *eaddr)
+static inline void
+ptab_set(uint8_t **tab, size_t indx, uint8_t val)
 {
-	/* file pointer */
-	FILE	*fp		= NULL;
-	/* path to /proc/<pid>/maps */
-	char	maps_path[PATH_MAX];
-	/* line buffer */
-	char	lbuf[MAPS_ENTRY_MAX];
-	
-	/* initialization */
-	*saddr = *eaddr = 0;
+	if (val != 0 || tab[STAB2DIR(indx)] != NULL)
+		*ptab_ref(tab, indx) = val;
+}
 
-	/* cleanup */
-	(void)memset(maps_path, 0, PATH_MAX);
+/*
+ * set or clear a range of summary bits inside a single leaf; the
+ * partial summary bytes are updated atomically, since other threads
+ * may update their other bits
+ *
+ * @leaf:	the summary leaf
+ * @sbit:	the first summary bit
+ * @ebit:	the last summary bit (inclusive)
+ * @val:	0 (clear) or 1 (set)
+ */
+static void
+sum_fill_leaf(uint8_t *leaf, size_t sbit, size_t ebit, int val)
+{
+	/* head; up to the next summary byte */
+	for (; sbit <= ebit && (sbit & 7) != 0; sbit++)
+		if (val)
+			(void)__sync_fetch_and_or(&leaf[SUM2BYTE(sbit)],
+					(uint8_t)(1U << (sbit & 7)));
+		else
+			(void)__sync_fetch_and_and(&leaf[SUM2BYTE(sbit)],
+					(uint8_t)~(1U << (sbit & 7)));
 
-	/* prepare the pathname for /proc/<pid>/maps */
-	if (snprintf(maps_path, PATH_MAX, "/proc/%d/maps",
-				PIN_GetPid()) > PATH_MAX) {
-		/* failed */
-		LOG(string(__func__) + ": failed while trying to assemble "
-				+ string(maps_path) + " -- (" +
-				string(strerror(errno)) + ")\n");
-		return;
+	/* whole summary bytes */
+	if (sbit <= ebit && ebit - sbit + 1 >= 8) {
+		(void)memset(&leaf[SUM2BYTE(sbit)], val ? 0xFF : 0x00,
+				(ebit - sbit + 1) >> 3);
+		sbit += (ebit - sbit + 1) & ~7U;
 	}
 
-	/* open /proc/<pid>/maps */
-	if ((fp = fopen(maps_path, "r")) == NULL) {
-		/* failed */
-		LOG(string(__func__) + ": failed while trying to open "
-				+ string(maps_path) + " -- (" +
-				string(strerror(errno)) + ")\n");
-		return;
-	}
-	
-	/* read the file */
-	while(!feof(fp)) {
-		/* buffer cleanup */
-		(void)memset(lbuf, 0, MAPS_ENTRY_MAX);
-	
-		/* read a line */
-		if (fgets(lbuf, MAPS_ENTRY_MAX, fp) == NULL) {
-			/* something went wrong */
-			if (ferror(fp)) {
-				/* verbose */
-				LOG(string(__func__) +
-					": failed while trying to read"
-					+ string(maps_path) + " -- (" +
-					string(strerror(errno)) + ")\n");
-				break;
-			}
-		}
+	/* tail */
+	for (; sbit <= ebit; sbit++)
+		if (val)
+			(void)__sync_fetch_and_or(&leaf[SUM2BYTE(sbit)],
+					(uint8_t)(1U << (sbit & 7)));
+		else
+			(void)__sync_fetch_and_and(&leaf[SUM2BYTE(sbit)],
+					(uint8_t)~(1U << (sbit & 7)));
+}
 
-		LOG(string(__func__) + ": map: " + lbuf);
+/*
+ * set or clear a range of summary bits; the missing leaves
+ * are allocated when setting, and skipped when clearing
+ *
+ * @sbit:	the first summary bit
+ * @ebit:	the last summary bit (inclusive)
+ * @val:	0 (clear) or 1 (set)
+ */
+static void
+sum_fill(size_t sbit, size_t ebit, int val)
+{
+	size_t	lend;	/* the last bit of the current leaf */
 
-		/* check for the vDSO entry */
-		if (strstr(lbuf, VDSO_STR) != NULL) {
-			/* update saddr and eaddr */
-			(void)sscanf(lbuf, "%x-%x %*s:4 %*x %*s:5 %*u%*s\n",
-					saddr, eaddr);
-			/* done */
-//			break;
-		}
+	for (; sbit <= ebit; sbit = lend + 1) {
+		lend	= sbit | (((size_t)1 << SUM_LEAF_SHIFT) - 1);
+		if (lend > ebit)
+			lend = ebit;
 
-		/* check for the stack entry */
-		if (strstr(lbuf, "[stack:") != NULL || strstr(lbuf, " rw-") != NULL) {
-			size_t s1, s2;
-			/* update saddr and eaddr */
-			(void)sscanf(lbuf, "%x-%x %*s:4 %*x %*s:5 %*u%*s\n",
-					&s1, &s2);
-			stackrange_alloc(s1, s2);
-		}
+		/* missing leaf; already clean */
+		if (!val && tagmap_sum[SUM2DIR(sbit)] == NULL)
+			continue;
 
+		sum_fill_leaf(tagmap_sum_leaf(SUM2DIR(sbit)), sbit, lend,
+				val);
 	}
-
-	/* cleanup */
-	(void)fclose(fp);
 }
 
-#ifdef TAGMAP_COLLAPSE
 /*
- * ELF image loading callback
+ * check if a range of the address space is
+ * backed (even partially) by shared tagmap pages
  *
- * capture the loading of an image and setup the tagmap accordingly;
- * read-only sections are mapped to zero_seg, whereas for each writeable
- * section we allocate a tagmap segment and adjust the STAB
+ * @addr:	the virtual address
+ * @num:	the number of bytes
  *
- * @img:	image handle
- * @v:		callback value
+ * returns:	1 if shared, 0 otherwise
  */
-static void
-elf_load(IMG img, VOID *v)
+static int
+sum_shared(size_t addr, size_t num)
 {
-	SEC	sec;	/* section iterator		*/
-	SEC	lread;	/* last read-only section	*/
-	size_t	i, j;	/* STAB iterators		*/
-	void*	tseg;	/* tagmap segment		*/
-	size_t	slen;	/* segment length 		*/
+	size_t	i;	/* iterator		*/
+	size_t	seg;	/* the tagmap segment	*/
 
-		LOG(string(__func__) + ": tagmap_collapse yes\n");
+	for (i = VIRT2STAB(addr); i <= VIRT2STAB(addr + num - 1); i++) {
+		seg = STAB_SEG(i);
+		if (seg != (size_t)null_seg && seg != (size_t)zero_seg &&
+				(ptab_get(page_kind, VIRT2STAB(seg)) &
+				 KIND_SHARED) != 0)
+			return 1;
+	}
 
-	/* 
-	 * after the dynamic linker/loaded is mapped into
-	 * the address space of the process, the image loading
-	 * is handled via mmap(2). However, we cannot unregister
-	 * elf_load, so we rely on this ugly hack; optimized branch
-	 */ 
-	if (likely(dynldlnk_loaded == 1))
+	/* private */
+	return 0;
+}
+
+/*
+ * clear the summary bits of the units that are wholly
+ * covered by an (untagged) range of the address space
+ *
+ * the units that are backed by shared tagmap pages stay set,
+ * since other processes may tag them at any time
+ *
+ * @addr:	the virtual address
+ * @num:	the number of bytes
+ */
+static inline void
+sum_clrn(size_t addr, size_t num)
+{
+	/* first (inclusive) and last (exclusive) unit that are covered */
+	size_t	sbit	= VIRT2SUM(addr + SUM_SZ - 1);
+	size_t	ebit	= VIRT2SUM(addr + num);
+
+	/* shared tagmap pages; optimized branch */
+	if (unlikely(shared_pages != 0) && sum_shared(addr, num))
 		return;
 
-#ifdef DEBUG_MEMTRACK
-	/* verbose */
-	LOG(string(__func__) + ": " +
-		IMG_Name(img) + " " +
-		hexstr(IMG_LowAddress(img)) + "-" +
-		hexstr(IMG_HighAddress(img)) + "\n");
+	if (sbit < ebit)
+		sum_fill(sbit, ebit - 1, 0);
+}
 
-	for (sec = IMG_SecHead(img); SEC_Valid(sec); sec = SEC_Next(sec)) {
-		LOG("\t" + SEC_Name(sec) + ": " +
-			hexstr(SEC_Address(sec)) + "-" +
-			hexstr(SEC_Address(sec) + SEC_Size(sec) - 1) + " ");
-		if (SEC_IsReadable(sec)) LOG("R"); else LOG("-");
-		if (SEC_IsWriteable(sec)) LOG("W"); else LOG("-");
-		if (SEC_IsExecutable(sec)) LOG("X"); else LOG("-");
-		if (!SEC_Mapped(sec)) LOG(" (not mapped)");
-		LOG("\n");
-	}
-#endif
-	
-	/* 
-	 * iterate the sections in the ELF image (forward pass)
-	 * until the first writeable section is encountered
-	 */
-	for (sec = IMG_SecHead(img), lread = SEC_Invalid();
-			SEC_Valid(sec) && !SEC_IsWriteable(sec);
-			sec = SEC_Next(sec)) {
-		/* ignore unmapped sections; optimized branch */
-		if (unlikely(!SEC_Mapped(sec)))
-			continue;
+/*
+ * set a STAB directory entry
+ *
+ * with a middle level (x86-64), a default middle is
+ * copied the first time that one of its entries changes
+ *
+ * @dindx:	the STAB directory offset
+ * @leaf:	the leaf
+ */
+static inline void
+stab_dir_set(size_t dindx, size_t *leaf)
+{
+#ifdef	STAB_MID_SHIFT
+	size_t	**mid	= STAB[DIR2TOP(dindx)];	/* the middle	*/
 
-		/* update the last read-only section */
-		lread = sec;
-	}
-	
-	/* read-only sections exist; optimized branch */
-	if (likely(SEC_Valid(lread))) {
-		/* get the last read-only section
-		 * (tagmap collapse optimization)
-		 * 
-		 * read-only sections are mapped to zero_seg for reducing
-		 * address space waste; reading from zero_seg always results
-		 * in clear tags
-		 */
-		
-		/* STAB setup */
-		for (i = VIRT2STAB(IMG_LowAddress(img));
-		i <= VIRT2STAB(SEC_Address(lread) + SEC_Size(lread) - 1); i++)
-			STAB[i] = (uint32_t)zero_seg - STAB2VIRT(i);
-#ifdef DEBUG_MEMTRACK
-		/* verbose */
-		LOG(string(__func__) + ": mapping read sections " +
-			hexstr(IMG_LowAddress(img)) + "-" + 
-			hexstr(SEC_Address(lread) + SEC_Size(lread) - 1) +
-			" [" +
-			hexstr(STAB[VIRT2STAB(IMG_LowAddress(img))] + 
-					IMG_LowAddress(img)) + "-" +
-			hexstr(STAB[VIRT2STAB(SEC_Address(lread) +
-					SEC_Size(lread) - 1)] +
-			       SEC_Address(lread) + SEC_Size(lread) - 1) +
-			"]\n");	
-#endif
-	}
-	
-	/* writeable sections exist; optimized branch */
-	if (likely(SEC_IsWriteable(sec))) {
-		/* estimate the length of the tagmap segment */
-		slen	= PAGE_ALIGN(IMG_HighAddress(img)) -
-				PAGE_ALIGN(SEC_Address(sec)) + PAGE_SZ;
-	
-		/*
-		 * allocate space for a new tagmap
-		 * segment by invoking mmap(2)
-		 */
-		if (unlikely(((tseg = mmap(NULL, slen,
-			/* RW- */
-			PROT_READ | PROT_WRITE,
-			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED))) {
-			
+	/* default middle; copy it on first use */
+	if (mid == null_mid || mid == zero_mid) {
+		/* no change; optimized branch */
+		if (likely(mid[DIR2MID(dindx)] == leaf))
+			return;
+
+		/* allocate space for the middle by invoking mmap(2) */
+		if (unlikely((mid = (size_t **)mmap(NULL,
+				STAB_MID_SIZE * sizeof(size_t *),
+				/* RW- */
+				PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) ==
+					MAP_FAILED)) {
 			/* error message */
 			LOG(string(__func__) +
-				": tagmap segment allocation failed (" +
+				": STAB middle allocation failed (" +
 				string(strerror(errno)) + ")\n");
 
 			/* die */
 			libdft_die();
 		}
-		
-		/* STAB setup */	
-		for (i = VIRT2STAB(SEC_Address(sec)), j = 0;
-			i <= VIRT2STAB(IMG_HighAddress(img)); i++, j++)
-			STAB[i] = (uint32_t)tseg - STAB2VIRT(i) + (j * PAGE_SZ);
-#ifdef DEBUG_MEMTRACK
-		/* verbose */
-		LOG(string(__func__) + ": mapping write sections " +
-			hexstr(SEC_Address(sec)) + "-" + 
-			hexstr(IMG_HighAddress(img)) + " [" +
-			hexstr(STAB[VIRT2STAB(SEC_Address(sec))] +
-			       SEC_Address(sec)) + "-" +
-			hexstr(STAB[VIRT2STAB(IMG_HighAddress(img))] + 
-					IMG_HighAddress(img)) + "]\n");
-#endif
-	}
-	
-	/* setup the program break */
-	if (brk_end == 0) {
-		brk_start = brk_end =
-			PAGE_ALIGN(IMG_HighAddress(img)) + PAGE_SZ;
-#ifdef DEBUG_MEMTRACK
-		/* verbose */
-		LOG(string(__func__) + ": brk is set at " +
-				hexstr(brk_end) + "\n");
-#endif
+
+		/* inherit the leaves of the default middle, and install it */
+		(void)memcpy(mid, STAB[DIR2TOP(dindx)],
+				STAB_MID_SIZE * sizeof(size_t *));
+		STAB[DIR2TOP(dindx)] = mid;
+		stab_mids++;
 	}
 
-	/* check if the loaded image was the dynamic linker/loader */
-	if (IMG_Name(img).compare(DYNLDLNK) == 0 ||
-			IMG_Type(img) == IMG_TYPE_STATIC)
-		/* set the corresponding flag accordingly */
-		dynldlnk_loaded = 1;
-}
+	mid[DIR2MID(dindx)] = leaf;
 #else
+	STAB[dindx] = leaf;
+#endif
+}
+
 /*
- * ELF image loading callback
+ * get the first private STAB leaf, starting from the given
+ * directory offset; default middles (x86-64) are skipped
  *
- * capture the loading of an image and setup the tagmap; we
- * allocate a tagmap segment and adjust the STAB accordingly 
+ * @dindx:	the STAB directory offset
  *
- * @img:	image handle
- * @v:		callback value
+ * returns:	the directory offset of the leaf, or STAB_DIR_SIZE
  */
-static void
-elf_load(IMG img, VOID *v)
+static size_t
+stab_leaf_next(size_t dindx)
 {
-	size_t	i, j;	/* STAB iterators		*/
-	void*	tseg;	/* tagmap segment		*/
-	size_t	slen;	/* segment length 		*/
+	size_t	*leaf;	/* current leaf */
 
-		LOG(string(__func__) + ": tagmap_collapse no\n");
+	while (dindx < STAB_DIR_SIZE) {
+#ifdef	STAB_MID_SHIFT
+		/* default middle; optimized branch */
+		if (likely(STAB[DIR2TOP(dindx)] == null_mid ||
+				STAB[DIR2TOP(dindx)] == zero_mid)) {
+			dindx = (DIR2TOP(dindx) + 1) << STAB_MID_SHIFT;
+			continue;
+		}
+#endif
+		/* private leaf */
+		leaf = STAB_LEAF(dindx);
+		if (leaf != null_leaf && leaf != zero_leaf)
+			return dindx;
+		dindx++;
+	}
 
-	/* 
-	 * after the dynamic linker/loaded is mapped into
-	 * the address space of the process, the image loading
-	 * is handled via mmap(2). However, we cannot unregister
-	 * elf_load, so we rely on this ugly hack; optimized branch
-	 */ 
-	if (likely(dynldlnk_loaded == 1))
-		return;
+	/* none */
+	return STAB_DIR_SIZE;
+}
 
-#ifdef DEBUG_MEMTRACK
-	/* verbose */
-	LOG(string(__func__) + ": image " +
-		IMG_Name(img) + " low-high range: " +
-		hexstr(IMG_LowAddress(img)) + "-" +
-		hexstr(IMG_HighAddress(img)) + "\n");
+/*
+ * get the size of the STAB in bytes; the directory (x86-64:
+ * the top level and the middles) and the leaves
+ */
+static size_t
+stab_bytes(void)
+{
+#ifdef	STAB_MID_SHIFT
+	return STAB_TOP_SIZE * sizeof(*STAB) +
+		(stab_mids + 2) * STAB_MID_SIZE * sizeof(size_t *) +
+		(stab_leaves + 2) * STAB_LEAF_SIZE * sizeof(size_t);
+#else
+	return STAB_DIR_SIZE * sizeof(*STAB) +
+		(stab_leaves + 2) * STAB_LEAF_SIZE * sizeof(size_t);
 #endif
-	
-	/* estimate the length of the tagmap segment */
-	slen	= PAGE_ALIGN(IMG_HighAddress(img)) -
-			PAGE_ALIGN(IMG_LowAddress(img)) + PAGE_SZ;
-	
-	/*
-	 * allocate space for a new tagmap
-	 * segment by invoking mmap(2)
-	 */
-	if (unlikely(((tseg = mmap(NULL, slen,
-		/* RW- */
-		PROT_READ | PROT_WRITE,
-		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED))) {
-			
+}
+
+/*
+ * allocate a private STAB leaf
+ *
+ * the new leaf is a copy of the default leaf that
+ * it replaces, and it is installed in the directory
+ *
+ * @dindx:	the STAB directory offset
+ *
+ * returns:	the new leaf
+ */
+static size_t *
+stab_leaf_alloc(size_t dindx)
+{
+	size_t	*leaf;	/* the new leaf */
+
+	/* allocate space for the leaf by invoking mmap(2) */
+	if (unlikely((leaf = (size_t *)mmap(NULL,
+			STAB_LEAF_SIZE * sizeof(size_t),
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)) {
 		/* error message */
 		LOG(string(__func__) +
-			": tagmap segment allocation failed (" +
+			": STAB leaf allocation failed (" +
 			string(strerror(errno)) + ")\n");
 
 		/* die */
 		libdft_die();
 	}
 
-#ifdef DEBUG_MEMTRACK
-	LOG(string(__func__) + ": stab region for ELF image is " + hexstr(tseg) + "\n");
-#endif
-		
-	/* STAB setup */	
-	for (i = VIRT2STAB(IMG_LowAddress(img)), j = 0;
-		i <= VIRT2STAB(IMG_HighAddress(img)); i++, j++) {
-		STAB[i] = (uint32_t)tseg - STAB2VIRT(i) + (j * PAGE_SZ);
-        }
-#ifdef DEBUG_MEMTRACK
-		/* verbose */
-		LOG(string(__func__) + ": mapping sections " +
-			hexstr(IMG_LowAddress(img)) + "-" + 
-			hexstr(IMG_HighAddress(img)) + " [" +
-			hexstr(STAB[VIRT2STAB(IMG_LowAddress(img))] +
-			       IMG_LowAddress(img)) + "-" +
-			hexstr(STAB[VIRT2STAB(IMG_HighAddress(img))] + 
-					IMG_HighAddress(img)) + "]\n");
-#endif
-	/* setup the program break */
-	if (brk_end == 0) {
-		brk_start = brk_end =
-			PAGE_ALIGN(IMG_HighAddress(img)) + PAGE_SZ;
-#ifdef DEBUG_MEMTRACK
-		/* verbose */
-		LOG(string(__func__) + ": brk is set at " +
-				hexstr(brk_end) + "\n");
-#endif
+	/* inherit the mappings of the default leaf */
+	(void)memcpy(leaf, STAB_LEAF(dindx), STAB_LEAF_SIZE * sizeof(size_t));
+
+	/* install it */
+	stab_dir_set(dindx, leaf);
+	stab_leaves++;
+
+	/* return the leaf */
+	return leaf;
+}
+
+/*
+ * release a private STAB leaf
+ *
+ * the directory entry is reverted to the given default leaf
+ *
+ * @dindx:	the STAB directory offset
+ * @dleaf:	the default leaf (i.e., null_leaf or zero_leaf)
+ */
+static inline void
+stab_leaf_free(size_t dindx, size_t *dleaf)
+{
+	size_t	*leaf	= STAB_LEAF(dindx);	/* the leaf */
+
+	/* private leaf; deallocate it */
+	if (leaf != null_leaf && leaf != zero_leaf) {
+		(void)munmap(leaf, STAB_LEAF_SIZE * sizeof(size_t));
+		stab_leaves--;
 	}
 
-	/* check if the loaded image was the dynamic linker/loader */
-	if (IMG_Name(img).compare(DYNLDLNK) == 0 ||
-			IMG_Type(img) == IMG_TYPE_STATIC)
-		/* set the corresponding flag accordingly */
-		dynldlnk_loaded = 1;
+	/* revert to the default leaf */
+	stab_dir_set(dindx, dleaf);
 }
-#endif
 
+/*
+ * record that a (resized) tagmap segment
+ * backs a region of the given kind
+ *
+ * @kind:	the region kind
+ * @seg:	the segment
+ * @olen:	the old segment size in bytes (0 if new)
+ * @nlen:	the segment size in bytes
+ */
+void
+tagmap_seg_acct(int kind, void *seg, size_t olen, size_t nlen)
+{
+	size_t	i;	/* iterator */
+
+	/* mark the tagmap pages */
+	for (i = VIRT2STAB((size_t)seg);
+		i <= VIRT2STAB((size_t)seg + nlen - 1) && nlen > 0; i++)
+		ptab_set(page_kind, i, (uint8_t)kind);
+
+	/* update the counters */
+	if (olen == 0)
+		kind_acct[kind].segs++;
+	kind_acct[kind].bytes += nlen - olen;
+	if (kind_acct[kind].bytes > kind_acct[kind].peak)
+		kind_acct[kind].peak = kind_acct[kind].bytes;
+}
 
 /*
- * initialize the STAB/tagmap
+ * account for the release of the tagmap pages
+ * in a (page aligned) range
+ *
+ * @start:	the first tagmap page
+ * @end:	the end of the range (exclusive)
+ */
+static void
+seg_unacct(size_t start, size_t end)
+{
+	size_t	i;	/* iterator */
+
+	for (i = VIRT2STAB(start); i < VIRT2STAB(end); i++) {
+		if ((ptab_get(page_kind, i) & KIND_SHARED) != 0)
+			shared_pages--;
+		kind_acct[ptab_get(page_kind, i) & KIND_MASK].bytes -= PAGE_SZ;
+		ptab_set(page_kind, i, TAGMAP_KIND_NONE);
+	}
+}
+
+#ifdef	TAGMAP_DIRECT
+/*
+ * clear the direct shadow of a region
  *
- * allocate space for the STAB structure and the three ``hardcoded''
- * tagmap segments: zero_seg (PAGE_SZ), null_seg (PAGE_SZ)
+ * the tagmap pages that are wholly covered by the region are replaced
+ * with fresh (zero-filled, unpopulated) ones, which also detaches them
+ * from any shadow object (see share_map()); the partially covered ones
+ * are cleared in place, unless they are shared. Clean regions are
+ * skipped (see tagmap_sumn())
  *
- * returns:	0 on success, 1 on error 
+ * @vaddr:	the region (page aligned)
+ * @len:	the region size in bytes (page aligned)
  */
-int
-tagmap_alloc(void)
+static void
+direct_clr(size_t vaddr, size_t len)
 {
-	size_t	i;	/* iterators		*/
-			/* STAB size in bytes	*/
-	size_t 	len		= STAB_SIZE * sizeof(uint32_t);
-			/* vDSO handling */
-	size_t	vdso_start, vdso_end;
-			/* stack segment */
+	size_t	tstart	= VIRT2TAG(vaddr);		/* first tag byte	*/
+	size_t	tend	= tstart + TAG_SEG_SZ(len);	/* end of the tags	*/
+	size_t	pstart	= PAGE_ALIGN(tstart + PAGE_SZ - 1); /* whole pages */
+	size_t	pend	= PAGE_ALIGN(tend);
+	size_t	i;					/* iterator		*/
 
+	/* clean region; optimized branch */
+	if (likely(tagmap_sumn(vaddr, len) == 0))
+		return;
 
-	/*
-	 * allocate space for STAB/zero_seg/null_seg by invoking
-	 * mmap(2); if HUGE_TLB is defined, then the mapping is done using
-	 * ``huge pages''
-	 */
-	if (unlikely(
-		/* STAB */
-		((STAB = (uint32_t *)mmap(NULL, len,
-			/* RW- */
-			PROT_READ | PROT_WRITE,
-			MAP_FLAGS, -1, 0)) == MAP_FAILED)		||
-		((zero_seg = mmap(NULL, PAGE_SZ,
-			/* R-- */
-			PROT_READ,
-		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)	||
-		((null_seg = mmap(NULL, PAGE_SZ,
-			/* --- */
-			PROT_NONE, 
-		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED))) {
+	/* a single, partially covered page */
+	if (pstart >= pend) {
+		if ((ptab_get(page_kind, VIRT2STAB(tstart)) &
+					KIND_SHARED) == 0)
+			(void)memset((void *)tstart, 0, tend - tstart);
+		return;
+	}
+
+	/* the edges */
+	if (tstart < pstart &&
+		(ptab_get(page_kind, VIRT2STAB(tstart)) & KIND_SHARED) == 0)
+		(void)memset((void *)tstart, 0, pstart - tstart);
+	if (pend < tend &&
+		(ptab_get(page_kind, VIRT2STAB(pend)) & KIND_SHARED) == 0)
+		(void)memset((void *)pend, 0, tend - pend);
+
+	/* fresh pages */
+	if (unlikely(mmap((void *)pstart, pend - pstart,
+		/* RW- */
+		PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED,
+		-1, 0) == MAP_FAILED)) {
 		/* error message */
-		LOG(string(__func__) +
-			": tagmap segment allocation failed (" +
+		LOG(string(__func__) + ": direct shadow reset failed (" +
 			string(strerror(errno)) + ")\n");
-	
-		/* failed */
-		goto err;
+
+		/* die */
+		libdft_die();
 	}
 
-		LOG(string(__func__) + ": zero_seg ok\n");
-	
-	/* setup the STAB */
+	/* accounting; shared pages only */
+	for (i = VIRT2STAB(pstart); shared_pages > 0 && i < VIRT2STAB(pend);
+			i++)
+		if ((ptab_get(page_kind, i) & KIND_SHARED) != 0) {
+			kind_acct[ptab_get(page_kind, i) & KIND_MASK].bytes -=
+				PAGE_SZ;
+			ptab_set(page_kind, i, TAGMAP_KIND_NONE);
+			shared_pages--;
+		}
+}
+#endif
 
-	/* 
-	 * the upper 1G of the address space is mapped to zero_seg;
-	 * this is how we handle vsyscall (i.e., reading from a
-	 * kernel address will result in always reading clear tags)
-	 */
-	for (i = VIRT2STAB(KERN_START); i <= VIRT2STAB(KERN_END); i++)
-		STAB[i] = (uint32_t)zero_seg - STAB2VIRT(i);
+/*
+ * assign a tagmap segment to a range of STAB entries
+ *
+ * null_seg and zero_seg are TAG_PAGE_SZ segments that are shared
+ * by every chunk that maps to them; any other segment is
+ * assumed to be contiguous (i.e., the j-th chunk of the
+ * range maps to the j-th page of the segment). Leaves are
+ * allocated on demand, and ranges that cover a whole leaf
+ * with null_seg/zero_seg revert to the default leaves
+ *
+ * @sindx:	the first STAB offset
+ * @eindx:	the last STAB offset (inclusive)
+ * @seg:	the tagmap segment
+ */
+void
+stab_map(size_t sindx, size_t eindx, void *seg)
+{
+	size_t	i;			/* iterator		*/
+	size_t	*leaf;			/* current leaf		*/
+	size_t	tseg	= (size_t)seg;	/* current segment page	*/
+	size_t	tinc	= TAG_PAGE_SZ;	/* segment increment	*/
+	size_t	*dleaf	= NULL;		/* default leaf		*/
+
+	/* shared segments */
+	if (seg == null_seg) {
+		tinc	= 0;
+		dleaf	= null_leaf;
+	}
+	else if (seg == zero_seg) {
+		tinc	= 0;
+		dleaf	= zero_leaf;
+	}
+#ifdef	TAGMAP_DIRECT
+	/* the rest are in place (see tagmap_seg_alloc()) */
+	else
+		tseg	= VIRT2TAG(STAB2VIRT(sindx));
+#endif
+
+	for (i = sindx; i <= eindx; i++, tseg += tinc) {
+		/* whole leaf mapped to a shared segment */
+		if (dleaf != NULL && STAB2LEAF(i) == 0 &&
+				eindx - i >= STAB_LEAF_SIZE - 1) {
+			stab_leaf_free(STAB2DIR(i), dleaf);
+			i += STAB_LEAF_SIZE - 1;
+			continue;
+		}
+
+		/* get the leaf */
+		leaf = STAB_LEAF(STAB2DIR(i));
+
+		/* default leaf; copy it on first use */
+		if (leaf == null_leaf || leaf == zero_leaf) {
+			/* no change; optimized branch */
+			if (likely(leaf == dleaf))
+				continue;
+			leaf = stab_leaf_alloc(STAB2DIR(i));
+		}
+
+		/* update the entry */
+		leaf[STAB2LEAF(i)] = tseg;
+	}
+}
+
+/*
+ * release the tagmap segments of a range of STAB entries
+ *
+ * the tagmap pages that back the range are deallocated, and the
+ * range is assigned to the given segment (see stab_map()). Contiguous
+ * entries are released with a single tagmap_seg_free(); with
+ * TAGMAP_1BIT a tagmap page shadows more than one chunk, and only the
+ * pages that are wholly covered by the range are deallocated
+ *
+ * @sindx:	the first STAB offset
+ * @eindx:	the last STAB offset (inclusive)
+ * @seg:	the tagmap segment (i.e., null_seg or zero_seg)
+ */
+void
+stab_unmap(size_t sindx, size_t eindx, void *seg)
+{
+#ifdef	TAGMAP_DIRECT
+	/* the tags are in place */
+	direct_clr(STAB2VIRT(sindx), STAB2VIRT(eindx - sindx + 1));
+#else
+	size_t	i;		/* iterator			*/
+	size_t	rstart, rend;	/* run of tagmap pages		*/
+
+	for (i = sindx; i <= eindx;) {
+		/* get the segment */
+		rstart	= STAB_SEG(i);
+		i++;
+
+		/* shared segments are never deallocated */
+		if (rstart == (size_t)null_seg || rstart == (size_t)zero_seg)
+			continue;
+
+		/* merge the contiguous entries */
+		for (rend = rstart + TAG_PAGE_SZ;
+			i <= eindx && STAB_SEG(i) == rend &&
+			rend != (size_t)null_seg && rend != (size_t)zero_seg;
+			i++, rend += TAG_PAGE_SZ);
+
+		/* the tagmap pages that are wholly covered */
+		rstart	= PAGE_ALIGN(rstart + PAGE_SZ - 1);
+		rend	= PAGE_ALIGN(rend);
+
+		/* nothing to deallocate */
+		if (rstart >= rend)
+			continue;
+#ifdef DEBUG_MEMTRACK
+		/* verbose */
+		LOG(string(__func__) + ": unmapping segment [" +
+			hexstr(rstart) + "-" + hexstr(rend - 1) + "]\n");
+#endif
+		/*
+		 * deallocate the space of the corresponding
+		 * tagmap segment by invoking tagmap_seg_free()
+		 */
+		if (unlikely(tagmap_seg_free((void *)rstart,
+						rend - rstart) != 0)) {
+			/* error message */
+			LOG(string(__func__) +
+				": tagmap segment deallocation failed (" +
+				string(strerror(errno)) + ")\n");
+			
+			/* die */
+			libdft_die();
+		}
+	}
+#endif
+
+	/* STAB setup */
+	stab_map(sindx, eindx, seg);
+
+	/* the range is clean */
+	sum_clrn(STAB2VIRT(sindx), STAB2VIRT(eindx - sindx + 1));
+}
+
+/*
+ * commit tagmap segments to the entries of a range that map to
+ * zero_seg/null_seg (e.g., when it becomes writeable); the rest
+ * keep their segments (and tags). Every run of such entries gets
+ * a segment of its own
+ *
+ * @sindx:	the first STAB offset
+ * @eindx:	the last STAB offset (inclusive)
+ * @kind:	the region kind (see tagmap_seg_acct())
+ */
+void
+stab_commit(size_t sindx, size_t eindx, int kind)
+{
+	size_t	i, j;	/* iterators		*/
+	void	*tseg;	/* tagmap segment	*/
+
+	for (i = sindx; i <= eindx; i = j) {
+		/* private segment; optimized branch */
+		if (likely(STAB_SEG(i) != (size_t)zero_seg &&
+				STAB_SEG(i) != (size_t)null_seg)) {
+			j = i + 1;
+			continue;
+		}
+
+		/* the run of shared entries */
+		for (j = i + 1; j <= eindx &&
+			(STAB_SEG(j) == (size_t)zero_seg ||
+			 STAB_SEG(j) == (size_t)null_seg); j++);
+
+		/*
+		 * allocate space for a new tagmap
+		 * segment by invoking tagmap_seg_alloc()
+		 */
+		if (unlikely((tseg = tagmap_seg_alloc(
+				TAG_SEG_SZ(STAB2VIRT(j - i)), kind)) ==
+					MAP_FAILED)) {
+			/* error message */
+			LOG(string(__func__) +
+				": tagmap segment allocation failed (" +
+				string(strerror(errno)) + ")\n");
+
+			/* die */
+			libdft_die();
+		}
+
+		/* STAB setup */
+		stab_map(i, j - 1, tseg);
+	}
+}
+
+/*
+ * collapse the entries of a range to zero_seg (e.g., when it becomes
+ * read-only); only the chunks that are clean are collapsed, and the
+ * tainted (or shared) ones keep their segments, since their tags
+ * are still live
+ *
+ * @sindx:	the first STAB offset
+ * @eindx:	the last STAB offset (inclusive)
+ */
+void
+stab_collapse(size_t sindx, size_t eindx)
+{
+	size_t	i, j;	/* iterators	*/
+	size_t	seg;	/* segment	*/
+
+	for (i = sindx; i <= eindx; i = j) {
+		/* the run of clean (private) chunks */
+		for (j = i; j <= eindx; j++) {
+			seg = STAB_SEG(j);
+			if (seg == (size_t)zero_seg)
+				continue;
+			if (seg != (size_t)null_seg &&
+				((ptab_get(page_kind, VIRT2STAB(seg)) &
+				  KIND_SHARED) != 0 ||
+				 tagmap_anyn(STAB2VIRT(j), PAGE_SZ) != 0))
+				break;
+		}
+
+		/* release the run */
+		if (j > i)
+			stab_unmap(i, j - 1, zero_seg);
+
+		/* skip the live chunk */
+		if (j == i)
+			j++;
+	}
+}
+
+/*
+ * record a huge page fallback
+ *
+ * @what:	the mechanism that failed
+ */
+static void
+huge_fallback(const char *what)
+{
+	/* report only the first one; the rest are counted */
+	if (huge_stats.fallback++ == 0)
+		LOG(string(__func__) + ": " + string(what) +
+			" failed (" + string(strerror(errno)) +
+			"); falling back\n");
+}
+
+/*
+ * report the huge page usage
+ */
+static void
+huge_report(void)
+{
+	LOG(string(__func__) + ": " + huge_knob.Value() + " (THP: " +
+		decstr(huge_stats.thp) + " bytes, hugetlb: " +
+		decstr(huge_stats.hugetlb) + " bytes, fallbacks: " +
+		decstr(huge_stats.fallback) + ", pinned: " +
+		decstr(huge_stats.pinned) + " bytes)\n");
+}
+
+/*
+ * report the tagmap usage on exit
+ *
+ * @code:	the exit code of the application
+ * @v:		callback value
+ */
+static void
+acct_fini(INT32 code, VOID *v)
+{
+	tagmap_acct_report();
+}
+
+/*
+ * report the tagmap usage on demand (signal)
+ *
+ * @tid:	thread id
+ * @sig:	the signal
+ * @ctx:	CPU context
+ * @handler:	the application has a handler for the signal
+ * @info:	exception information
+ * @v:		callback value
+ *
+ * returns:	FALSE; the signal is not delivered to the application
+ */
+static BOOL
+acct_signal(THREADID tid, INT32 sig, CONTEXT *ctx, BOOL handler,
+		const EXCEPTION_INFO *info, VOID *v)
+{
+	tagmap_acct_report();
+
+	return FALSE;
+}
+
+/*
+ * release the lazy state of (page aligned) tagmap pages
+ *
+ * @addr:	the first page
+ * @len:	the number of bytes
+ */
+static void
+lazy_release(size_t addr, size_t len)
+{
+	size_t	i;	/* iterator */
+
+	/* no lazy segments; optimized branch */
+	if (likely(lazy_state == NULL))
+		return;
+
+	for (i = VIRT2STAB(addr); i < VIRT2STAB(addr + len); i++) {
+		if (ptab_get(lazy_state, i) == LAZY_NONE)
+			continue;
+		if (ptab_get(lazy_state, i) == LAZY_COMMIT)
+			lazy_stats.committed -= PAGE_SZ;
+		lazy_stats.reserved	-= PAGE_SZ;
+		ptab_set(lazy_state, i, LAZY_NONE);
+	}
+}
+
+/*
+ * check if a range of the tagmap is reserved (lazy), and
+ * not committed yet; such pages are already clean
+ *
+ * @taddr:	the tagmap address
+ * @len:	the number of bytes
+ */
+static inline int
+lazy_clean(size_t taddr, size_t len)
+{
+	size_t	i;	/* iterator */
+
+	/* no lazy segments; optimized branch */
+	if (likely(lazy_state == NULL || len == 0))
+		return 0;
+
+	for (i = VIRT2STAB(taddr); i <= VIRT2STAB(taddr + len - 1); i++)
+		if (ptab_get(lazy_state, i) != LAZY_RSV)
+			return 0;
+
+	return 1;
+}
+
+/*
+ * report the lazy segment usage
+ */
+static void
+lazy_report(void)
+{
+	LOG(string(__func__) + ": reserved: " +
+		decstr(lazy_stats.reserved) + " bytes, committed: " +
+		decstr(lazy_stats.committed) + " bytes (" +
+		decstr(lazy_stats.faults) + " faults)\n");
+}
+
+/*
+ * get the size class of a run
+ *
+ * @npages:	the number of pages in the run
+ */
+static inline size_t
+arena_class(size_t npages)
+{
+	return (sizeof(unsigned int) << 3) - 1 -
+		__builtin_clz((unsigned int)npages);
+}
+
+/*
+ * add a run of (zero-filled) pages to the free runs
+ *
+ * @addr:	the first page
+ * @npages:	the number of pages
+ */
+static void
+arena_put(size_t addr, size_t npages)
+{
+	arena_run_t	*run;	/* run descriptor */
+
+	/* nothing to add */
+	if (npages == 0)
+		return;
+
+	/* the top of the current arena; merge it back */
+	if (addr + (npages << PAGE_SHIFT) == arena_top) {
+		arena_top = addr;
+		return;
+	}
+
+	/* get a run descriptor */
+	if ((run = arena_nodes) != NULL)
+		arena_nodes = run->next;
+	else if (unlikely((run = (arena_run_t *)malloc(
+					sizeof(arena_run_t))) == NULL))
+		/* leak the run */
+		return;
+
+	/* insert it */
+	run->addr			= addr;
+	run->npages			= npages;
+	run->next			= arena_free[arena_class(npages)];
+	arena_free[arena_class(npages)]	= run;
+}
+
+/*
+ * remove a run of at least npages pages from the free runs
+ *
+ * @npages:	the number of pages
+ *
+ * returns:	the first page, or 0 if there is no such run
+ */
+static size_t
+arena_get(size_t npages)
+{
+	arena_run_t	**prev;		/* iterator	*/
+	arena_run_t	*run;		/* the run	*/
+	size_t		c;		/* size class	*/
+	size_t		i;		/* scan limit	*/
+	size_t		addr;		/* the run	*/
+
+	/* first fit in the size class of the request (bounded) */
+	c = arena_class(npages);
+	for (prev = &arena_free[c], i = 0;
+		*prev != NULL && i < ARENA_FIT_MAX;
+		prev = &(*prev)->next, i++)
+		if ((*prev)->npages >= npages)
+			goto found;
+
+	/* any run of a larger size class fits */
+	for (c++; c < ARENA_CLASSES; c++)
+		if (arena_free[c] != NULL) {
+			prev = &arena_free[c];
+			goto found;
+		}
+
+	/* no run */
+	return 0;
+
+found:	/* unlink the run and recycle its descriptor */
+	run		= *prev;
+	*prev		= run->next;
+	addr		= run->addr;
+	run->next	= arena_nodes;
+	arena_nodes	= run;
+
+	/* give back the remainder */
+	arena_put(addr + (npages << PAGE_SHIFT), run->npages - npages);
+
+	return addr;
+}
+
+/*
+ * allocate tagmap pages from the arenas
+ *
+ * tagmap segments of up to ARENA_MAX bytes are carved out of large
+ * ARENA_SZ (aligned) reservations; freed runs are released with
+ * madvise(2), and they are kept in free lists by size class. Hence,
+ * allocating and freeing segments does not create new mappings
+ * (VMAs), and it costs at most one madvise(2) call
+ *
+ * @npages:	the number of pages
+ *
+ * returns:	the first page, or 0 on error
+ */
+static size_t
+arena_alloc(size_t npages)
+{
+	size_t	len	= npages << PAGE_SHIFT;	/* the request		*/
+	size_t	addr;				/* the segment		*/
+	size_t	seg;				/* new reservation	*/
+
+	/* reuse a free run; optimized branch */
+	if (likely((addr = arena_get(npages)) != 0))
+		return addr;
+
+	/* the current arena is exhausted */
+	if (arena_end - arena_top < len) {
+		/* reserve a new ARENA_SZ aligned arena */
+		if (unlikely((seg = (size_t)mmap(NULL,
+			ARENA_SZ << 1,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+			-1, 0)) == (size_t)MAP_FAILED))
+			return 0;
+
+		/* trim it */
+		addr = (seg + ARENA_SZ - 1) & ~(ARENA_SZ - 1);
+		if (addr > seg)
+			(void)munmap((void *)seg, addr - seg);
+		(void)munmap((void *)(addr + ARENA_SZ),
+				seg + ARENA_SZ - addr);
+
+		/* keep the rest of the current arena */
+		arena_put(arena_top, (arena_end - arena_top) >> PAGE_SHIFT);
+
+		/* switch to the new arena */
+		arena_map[addr >> ARENA_SHIFT]	= 1;
+		arena_top			= addr;
+		arena_end			= addr + ARENA_SZ;
+		arena_cnt++;
+	}
+
+	/* carve the segment */
+	addr		= arena_top;
+	arena_top	+= len;
+
+	return addr;
+}
+
+/*
+ * allocate a tagmap segment
+ *
+ * segments of up to ARENA_MAX bytes are carved out of the arenas (see
+ * arena_alloc()), and larger ones are mapped with mmap(2). Segments of
+ * at least HUGE_PAGE_SZ bytes are backed by huge pages, according to
+ * the selected policy; MAP_HUGETLB segments fall back to THP, and THP
+ * segments to regular pages
+ *
+ * @len:	the segment size in bytes
+ * @kind:	the region kind (accounting)
+ *
+ * returns:	the segment, or MAP_FAILED on error
+ */
+void *
+tagmap_seg_alloc(size_t len, int kind)
+{
+	size_t	seg;		/* the mapping		*/
+	size_t	base;		/* the segment		*/
+	size_t	plen;		/* page aligned length	*/
+	size_t	alen;		/* mapping length	*/
+	size_t	i;		/* iterator		*/
+
+#ifdef	TAGMAP_DIRECT
+	/* the tags are in place; nothing to allocate (see stab_map()) */
+	return (void *)tagmap_direct;
+#endif
+#ifdef	TAGMAP_LABEL
+	/* whole chunks; a chunk is shadowed by more than one page */
+	len	= (len + TAG_PAGE_SZ - 1) & ~(TAG_PAGE_SZ - 1);
+#endif
+	/* page aligned length */
+	plen	= PAGE_ALIGN(len + PAGE_SZ - 1);
+
+	/* lazy; committed on first write (huge pages take precedence) */
+	if (lazy_state != NULL && len >= lazy_min.Value() &&
+		(huge_policy == TAGMAP_HUGE_NONE || len < HUGE_PAGE_SZ)) {
+		if (likely((seg = (size_t)mmap(NULL, plen,
+			/* R-- */
+			PROT_READ,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+			-1, 0)) != (size_t)MAP_FAILED)) {
+			for (i = VIRT2STAB(seg); i < VIRT2STAB(seg + plen);
+					i++)
+				ptab_set(lazy_state, i, LAZY_RSV);
+			lazy_stats.reserved += plen;
+			tagmap_seg_acct(kind, (void *)seg, 0, plen);
+		}
+		return (void *)seg;
+	}
+
+	/* regular pages, from the arenas; optimized branch */
+	if (likely((huge_policy == TAGMAP_HUGE_NONE ||
+			len < HUGE_PAGE_SZ) && plen <= ARENA_MAX)) {
+		if (unlikely((seg = arena_alloc(plen >> PAGE_SHIFT)) == 0))
+			return MAP_FAILED;
+		tagmap_seg_acct(kind, (void *)seg, 0, plen);
+		return (void *)seg;
+	}
+
+	/* regular pages; large segment */
+	if (huge_policy == TAGMAP_HUGE_NONE || len < HUGE_PAGE_SZ) {
+		if (likely((seg = (size_t)mmap(NULL, plen,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS,
+			-1, 0)) != (size_t)MAP_FAILED))
+			tagmap_seg_acct(kind, (void *)seg, 0, plen);
+		return (void *)seg;
+	}
+
+	/* hugetlb */
+	if (huge_policy == TAGMAP_HUGE_HUGETLB) {
+		alen = HUGE_ALIGN(len + HUGE_PAGE_SZ - 1);
+		if ((seg = (size_t)mmap(NULL, alen,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+			-1, 0)) != (size_t)MAP_FAILED) {
+			huge_stats.hugetlb += alen;
+			tagmap_seg_acct(kind, (void *)seg, 0, alen);
+			return (void *)seg;
+		}
+		huge_fallback("MAP_HUGETLB");
+	}
+
+	/* THP; over-allocate, and trim to a HUGE_PAGE_SZ boundary */
+	alen	= plen + HUGE_PAGE_SZ - PAGE_SZ;
+	if (unlikely((seg = (size_t)mmap(NULL, alen,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS,
+			-1, 0)) == (size_t)MAP_FAILED))
+		return MAP_FAILED;
+
+	base = HUGE_ALIGN(seg + HUGE_PAGE_SZ - 1);
+	if (base > seg)
+		(void)munmap((void *)seg, base - seg);
+	if (seg + alen > base + plen)
+		(void)munmap((void *)(base + plen), seg + alen - (base + plen));
+
+	/* ask for huge pages */
+	tagmap_seg_advise((void *)base, plen);
+	tagmap_seg_acct(kind, (void *)base, 0, plen);
+
+	/* return the segment */
+	return (void *)base;
+}
+
+/*
+ * release (page aligned) tagmap pages
+ *
+ * arena pages are released with madvise(2) and they are added to the
+ * free runs; the rest are deallocated with munmap(2). MAP_HUGETLB
+ * segments can only be released in HUGE_PAGE_SZ units; the rest of
+ * their pages stay allocated (pinned)
+ *
+ * @seg:	the first page
+ * @len:	the number of bytes
+ *
+ * returns:	0 on success, 1 on error
+ */
+int
+tagmap_seg_free(void *seg, size_t len)
+{
+	size_t	addr	= (size_t)seg;	/* iterator		*/
+	size_t	end	= addr + len;	/* end of the range	*/
+	size_t	n;			/* bytes in the slot	*/
+	size_t	hstart, hend;		/* hugetlb pages	*/
+
+	/* one arena slot at a time */
+	for (; addr < end; addr += n) {
+		n = ARENA_SZ - (addr & (ARENA_SZ - 1));
+		n = (n < end - addr) ? n : end - addr;
+
+		/* arena; optimized branch */
+		if (likely(arena_map[addr >> ARENA_SHIFT] != 0)) {
+			if (unlikely(madvise((void *)addr, n,
+						MADV_DONTNEED) != 0))
+				(void)memset((void *)addr, 0, n);
+			arena_put(addr, n >> PAGE_SHIFT);
+			seg_unacct(addr, addr + n);
+			continue;
+		}
+
+		/* mmap(2)-ed segment */
+		if (likely(munmap((void *)addr, n) == 0)) {
+			seg_unacct(addr, addr + n);
+			lazy_release(addr, n);
+			continue;
+		}
+
+		/* failed */
+		if (huge_policy != TAGMAP_HUGE_HUGETLB || errno != EINVAL)
+			return 1;
+
+		/* hugetlb; release the HUGE_PAGE_SZ aligned part */
+		huge_stats.pinned	+= n;
+		hstart			= HUGE_ALIGN(addr + HUGE_PAGE_SZ - 1);
+		hend			= HUGE_ALIGN(addr + n);
+		if (hstart < hend && munmap((void *)hstart,
+					hend - hstart) == 0) {
+			huge_stats.pinned -= hend - hstart;
+			seg_unacct(hstart, hend);
+		}
+	}
+
+	/* success */
+	return 0;
+}
+
+/*
+ * commit a lazy tagmap page; invoked on the first write to the page
+ * (i.e., by the exception handler of libdft), which faults because
+ * lazy segments are reserved read-only. The reserved pages that follow
+ * the faulting one, up to the end of its LAZY_BLOCK, are committed too
+ *
+ * @taddr:	the faulting tagmap address
+ *
+ * returns:	0 on success, 1 if the page is not lazy (or on error)
+ */
+int
+tagmap_commit(size_t taddr)
+{
+	size_t	start	= PAGE_ALIGN(taddr);			/* first page */
+	size_t	end	= (start & ~(LAZY_BLOCK - 1)) + LAZY_BLOCK; /* block */
+	size_t	addr;						/* iterator */
+
+	/* not a lazy page; optimized branch */
+	if (likely(lazy_state == NULL ||
+			ptab_get(lazy_state, VIRT2STAB(start)) == LAZY_NONE))
+		return 1;
+
+	/* already committed (e.g., by another thread) */
+	if (ptab_get(lazy_state, VIRT2STAB(start)) == LAZY_COMMIT)
+		return 0;
+
+	/* the reserved pages of the block that follow */
+	for (addr = start + PAGE_SZ;
+		addr < end && ptab_get(lazy_state, VIRT2STAB(addr)) == LAZY_RSV;
+		addr += PAGE_SZ);
+
+	/* make them writable; they are populated on demand */
+	if (unlikely(mprotect((void *)start, addr - start,
+					PROT_READ | PROT_WRITE) != 0)) {
+		/* error message */
+		LOG(string(__func__) + ": commit of " + hexstr(start) +
+			" failed (" + string(strerror(errno)) + ")\n");
+
+		/* failed */
+		return 1;
+	}
+
+	/* accounting */
+	for (end = addr, addr = start; addr < end; addr += PAGE_SZ)
+		if (__sync_bool_compare_and_swap(
+					ptab_ref(lazy_state, VIRT2STAB(addr)),
+					LAZY_RSV, LAZY_COMMIT))
+			(void)__sync_fetch_and_add(&lazy_stats.committed,
+					PAGE_SZ);
+	(void)__sync_fetch_and_add(&lazy_stats.faults, 1);
+
+	/* success */
+	return 0;
+}
+
+#ifndef	TAGMAP_DIRECT
+/*
+ * move (and resize) a tagmap segment with mremap(2)
+ *
+ * arena pages that are moved out of their arena are replaced with
+ * fresh (zero-filled) ones, which are added to the free runs
+ *
+ * @seg:	the segment (page aligned)
+ * @olen:	the segment size in bytes (page aligned)
+ * @nlen:	the new segment size in bytes (page aligned)
+ *
+ * returns:	the new segment, or 0 on error
+ */
+static size_t
+seg_remap(size_t seg, size_t olen, size_t nlen)
+{
+	int	kind	= ptab_get(page_kind, VIRT2STAB(seg)) &
+				KIND_MASK;			/* region kind	*/
+	int	arena	= arena_map[seg >> ARENA_SHIFT];	/* arena pages	*/
+	size_t	nseg;					/* new segment	*/
+
+	/* the segment spans more than one arena slot */
+	if (unlikely((seg >> ARENA_SHIFT) !=
+			((seg + olen - 1) >> ARENA_SHIFT)))
+		return 0;
+
+	/* move the pages */
+	if (unlikely((nseg = (size_t)mremap((void *)seg, olen, nlen,
+				MREMAP_MAYMOVE)) == (size_t)MAP_FAILED))
+		return 0;
+
+	/* plug the hole in the arena */
+	if (arena != 0 && nseg != seg) {
+		if (unlikely(mmap((void *)seg, olen,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE |
+			MAP_FIXED, -1, 0) == MAP_FAILED)) {
+			/* error message */
+			LOG(string(__func__) +
+				": arena allocation failed (" +
+				string(strerror(errno)) + ")\n");
+
+			/* die */
+			libdft_die();
+		}
+		else
+			arena_put(seg, olen >> PAGE_SHIFT);
+	}
+
+	/* lazy segment; the pages keep their state, new pages are reserved */
+	if (lazy_state != NULL &&
+			ptab_get(lazy_state, VIRT2STAB(seg)) != LAZY_NONE) {
+		size_t	i, n = ((olen < nlen) ? olen : nlen) >> PAGE_SHIFT;
+		vector<uint8_t>	st(n);
+
+		for (i = 0; i < n; i++)
+			st[i] = ptab_get(lazy_state, VIRT2STAB(seg) + i);
+		lazy_release(seg, olen);
+		for (i = 0; i < (nlen >> PAGE_SHIFT); i++) {
+			ptab_set(lazy_state, VIRT2STAB(nseg) + i,
+				(i < n) ? st[i] : LAZY_RSV);
+			lazy_stats.reserved += PAGE_SZ;
+			if (i < n && st[i] == LAZY_COMMIT)
+				lazy_stats.committed += PAGE_SZ;
+		}
+	}
+
+	/* accounting */
+	seg_unacct(seg, seg + olen);
+	tagmap_seg_acct(kind, (void *)nseg, 0, nlen);
+
+	/* return the new segment */
+	return nseg;
+}
+#endif
+
+/*
+ * relocate the tags of a remapped region (see mremap(2))
+ *
+ * a region that moves takes its tags along, without copying them,
+ * by moving its tagmap segment with mremap(2); this is possible if
+ * the region is shadowed by a contiguous run of tagmap pages that it
+ * does not share with other regions, otherwise the tags are copied
+ * to a new segment. Regions that grow in place are shadowed by a single
+ * (extended or copied) segment, and regions that shrink release their
+ * tail
+ *
+ * @oaddr:	the old virtual address (page aligned)
+ * @osize:	the old size in bytes (page aligned)
+ * @naddr:	the new virtual address (page aligned)
+ * @nsize:	the new size in bytes (page aligned)
+ * @keep:	keep the old region mapped (MREMAP_DONTUNMAP)
+ *
+ * NOTE: with TAGMAP_DIRECT the tags are always copied
+ */
+void
+tagmap_remap(size_t oaddr, size_t osize, size_t naddr, size_t nsize,
+		int keep)
+{
+#ifndef	TAGMAP_DIRECT
+	size_t	i;					/* iterator	*/
+	size_t	tseg	= STAB_SEG(VIRT2STAB(oaddr));	/* old segment	*/
+#endif
+	size_t	indx	= VIRT2STAB(oaddr);		/* STAB offset	*/
+	size_t	nseg	= 0;				/* new segment	*/
+	size_t	len	= (osize < nsize) ? osize : nsize;	/* moved bytes	*/
+	int	tainted;				/* taint	*/
+
+	/* nothing to do */
+	if (unlikely(nsize == 0))
+		return;
+
+	/* a new mapping of the same (shared) pages; clean tags */
+	if (unlikely(osize == 0)) {
+		stab_unmap(VIRT2STAB(naddr), VIRT2STAB(naddr + nsize - 1),
+				null_seg);
+		if (unlikely((nseg = (size_t)tagmap_seg_alloc(
+			TAG_SEG_SZ(nsize),
+			TAGMAP_KIND_MMAP)) == (size_t)MAP_FAILED))
+			goto err;
+		stab_map(VIRT2STAB(naddr), VIRT2STAB(naddr + nsize - 1),
+				(void *)nseg);
+		return;
+	}
+
+	/* in place */
+	if (naddr == oaddr) {
+		/* shrink; release the tail */
+		if (nsize < osize)
+			stab_unmap(VIRT2STAB(oaddr + nsize),
+				VIRT2STAB(oaddr + osize - 1), null_seg);
+		/* grow; the tags are in place */
+#ifdef	TAGMAP_DIRECT
+		else if (nsize > osize) {
+			if (unlikely((nseg = (size_t)tagmap_seg_alloc(
+				TAG_SEG_SZ(nsize - osize),
+				TAGMAP_KIND_MMAP)) == (size_t)MAP_FAILED))
+				goto err;
+			stab_map(VIRT2STAB(oaddr + osize),
+				VIRT2STAB(oaddr + nsize - 1), (void *)nseg);
+		}
+#else
+		/*
+		 * grow; one contiguous segment for the whole region, since
+		 * the multi-byte tag accessors assume that adjacent pages
+		 * of a region have adjacent tags
+		 */
+		else if (nsize > osize) {
+			/* a contiguous, page aligned run of private pages */
+			if (tseg != (size_t)null_seg &&
+				tseg != (size_t)zero_seg &&
+				(ptab_get(page_kind, VIRT2STAB(tseg)) &
+				 KIND_SHARED) == 0 &&
+				PAGE_OFFSET(tseg) == 0 &&
+				PAGE_OFFSET(TAG_SEG_SZ(osize)) == 0) {
+				for (i = 1; i < VIRT2STAB(osize); i++)
+					if (STAB_SEG(indx + i) !=
+						tseg + i * TAG_PAGE_SZ)
+						break;
+
+				/* zero-copy; extend (or move) the segment */
+				if (i == VIRT2STAB(osize))
+					nseg = seg_remap(tseg,
+						TAG_SEG_SZ(osize),
+						PAGE_ALIGN(TAG_SEG_SZ(nsize) +
+							PAGE_SZ - 1));
+			}
+
+			/* copy; a new segment that takes the old tags */
+			if (nseg == 0) {
+				if (unlikely((nseg = (size_t)tagmap_seg_alloc(
+					TAG_SEG_SZ(nsize),
+					TAGMAP_KIND_MMAP)) ==
+						(size_t)MAP_FAILED))
+					goto err;
+
+				tainted = tagmap_sumn(oaddr, osize);
+				for (i = 0; tainted && i < VIRT2STAB(osize);
+						i++) {
+					tseg = STAB_SEG(indx + i);
+
+					/* shared pages are clean */
+					if (tseg == (size_t)null_seg ||
+						tseg == (size_t)zero_seg)
+						continue;
+
+					(void)memcpy((void *)
+						(nseg + i * TAG_PAGE_SZ),
+						(void *)tseg, TAG_PAGE_SZ);
+				}
+
+				/* release the old segment(s) */
+				stab_unmap(indx, VIRT2STAB(oaddr + osize - 1),
+						null_seg);
+			}
+
+			stab_map(indx, VIRT2STAB(oaddr + nsize - 1),
+					(void *)nseg);
+		}
+#endif
+		return;
+	}
+
+	/* the new region replaces whatever was mapped there */
+	stab_unmap(VIRT2STAB(naddr), VIRT2STAB(naddr + nsize - 1), null_seg);
+
+	/* the old region may be tainted */
+	tainted = tagmap_sumn(oaddr, len);
+
+#ifndef	TAGMAP_DIRECT
+	/* a contiguous, page aligned run of private tagmap pages */
+	if (tseg != (size_t)null_seg && tseg != (size_t)zero_seg &&
+			(ptab_get(page_kind, VIRT2STAB(tseg)) &
+			 KIND_SHARED) == 0 &&
+			PAGE_OFFSET(tseg) == 0 &&
+			PAGE_OFFSET(TAG_SEG_SZ(len)) == 0) {
+		for (i = 1; i < VIRT2STAB(len); i++)
+			if (STAB_SEG(indx + i) != tseg + i * TAG_PAGE_SZ)
+				break;
+
+		/* zero-copy; move the tagmap pages */
+		if (i == VIRT2STAB(len))
+			nseg = seg_remap(tseg, TAG_SEG_SZ(len),
+					PAGE_ALIGN(TAG_SEG_SZ(nsize) +
+						PAGE_SZ - 1));
+	}
+#endif
+
+	/* moved */
+	if (likely(nseg != 0)) {
+		stab_map(VIRT2STAB(naddr), VIRT2STAB(naddr + nsize - 1),
+				(void *)nseg);
+
+		/* the tags are gone from the old region */
+		stab_map(indx, VIRT2STAB(oaddr + len - 1), null_seg);
+		sum_clrn(oaddr, len);
+
+		/* and they are in the new one */
+		if (tainted)
+			sum_fill(VIRT2SUM(naddr), VIRT2SUM(naddr + len - 1), 1);
+	}
+	/* copy */
+	else {
+		if (unlikely((nseg = (size_t)tagmap_seg_alloc(
+			TAG_SEG_SZ(nsize),
+			TAGMAP_KIND_MMAP)) == (size_t)MAP_FAILED))
+			goto err;
+		stab_map(VIRT2STAB(naddr), VIRT2STAB(naddr + nsize - 1),
+				(void *)nseg);
+		if (tainted)
+			tagmap_copyn(naddr, oaddr, len);
+	}
+
+	/* release the old region */
+	stab_unmap(indx, VIRT2STAB(oaddr + osize - 1), null_seg);
+
+	/* the old region stays mapped (empty); clean tags */
+	if (keep) {
+		if (unlikely((nseg = (size_t)tagmap_seg_alloc(
+			TAG_SEG_SZ(osize),
+			TAGMAP_KIND_MMAP)) == (size_t)MAP_FAILED))
+			goto err;
+		stab_map(indx, VIRT2STAB(oaddr + osize - 1), (void *)nseg);
+	}
+
+	/* done */
+	return;
+
+err:	/* error message */
+	LOG(string(__func__) + ": tagmap segment allocation failed (" +
+		string(strerror(errno)) + ")\n");
+
+	/* die */
+	libdft_die();
+}
+
+#ifdef	TAGMAP_DIRECT
+/*
+ * make room for a fixed mapping (TAGMAP_DIRECT)
+ *
+ * invoked before every system call that places a mapping at a fixed
+ * address (e.g., mmap(2) with MAP_FIXED); if the mapping overlaps the
+ * direct shadow, the shadow is moved, along with its tags, to a new
+ * region with mremap(2), and the STAB entries that point to it are
+ * rebased. The tag address is computed at run time (see VIRT2TAG()),
+ * hence the instrumented code is not affected; the rest of the threads
+ * are stopped while the shadow is moving
+ *
+ * @tid:	the thread id
+ * @addr:	the fixed address
+ * @len:	the mapping size in bytes
+ */
+void
+tagmap_direct_fixed(THREADID tid, size_t addr, size_t len)
+{
+	size_t	ostart	= tagmap_direct;	/* old region		*/
+	size_t	oend	= ostart + DIRECT_SZ;
+	size_t	nstart;				/* new region		*/
+	size_t	start, end;			/* a mapping		*/
+	size_t	i, j;				/* iterators		*/
+	size_t	*leaf;				/* STAB leaf		*/
+	int	stopped;			/* other threads	*/
+	vector<size_t>	vma;			/* old region mappings	*/
+	vector<size_t>	taken;			/* unusable regions	*/
+	FILE	*fp;				/* /proc/self/maps	*/
+	char	lbuf[MAPS_ENTRY_MAX];		/* line buffer		*/
+	char	perm[5];			/* mapping permissions	*/
+
+	/* no overlap; optimized branch */
+	if (likely(len == 0 || addr + len <= ostart || addr >= oend))
+		return;
+
+	/* verbose */
+	LOG(string(__func__) + ": fixed mapping at " + hexstr(addr) +
+		" overlaps the direct shadow; relocating\n");
+
+	/* stop the rest of the threads */
+	if (unlikely((stopped = PIN_StopApplicationThreads(tid)) == 0))
+		LOG(string(__func__) +
+			": failed to stop the application threads\n");
+
+	/* a new region; not on top of the fixed mapping */
+	for (;;) {
+		if (unlikely((nstart = (size_t)mmap(NULL, DIRECT_SZ,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+			-1, 0)) == (size_t)MAP_FAILED))
+			goto err;
+		if (addr + len <= nstart || addr >= nstart + DIRECT_SZ)
+			break;
+		taken.push_back(nstart);
+	}
+	for (i = 0; i < taken.size(); i++)
+		(void)munmap((void *)taken[i], DIRECT_SZ);
+
+	/* the mappings of the old region (e.g., shared tagmap segments) */
+	if (unlikely((fp = fopen("/proc/self/maps", "r")) == NULL))
+		goto err;
+	while (fgets(lbuf, MAPS_ENTRY_MAX, fp) != NULL) {
+		if (sscanf(lbuf, "%zx-%zx %4s", &start, &end, perm) != 3 ||
+				end <= ostart || start >= oend)
+			continue;
+		vma.push_back((start < ostart) ? ostart : start);
+		vma.push_back((end > oend) ? oend : end);
+		vma.push_back(perm[3] == 's');
+	}
+	(void)fclose(fp);
+
+	/* move them; the pages (and the tags) are not copied */
+	for (i = 0; i < vma.size(); i += 3) {
+		start	= vma[i];
+		end	= vma[i + 1];
+		if (unlikely(mremap((void *)start, end - start, end - start,
+				MREMAP_MAYMOVE | MREMAP_FIXED,
+				(void *)(nstart + start - ostart)) ==
+					MAP_FAILED))
+			goto err;
+
+		/* shared tagmap pages; accounting */
+		for (j = VIRT2STAB(start); vma[i + 2] && j < VIRT2STAB(end);
+				j++) {
+			ptab_set(page_kind,
+				j - VIRT2STAB(ostart) + VIRT2STAB(nstart),
+				ptab_get(page_kind, j));
+			ptab_set(page_kind, j, TAGMAP_KIND_NONE);
+		}
+	}
+
+	/* rebase the STAB; the private leaves only */
+	for (i = stab_leaf_next(0); i < STAB_DIR_SIZE;
+			i = stab_leaf_next(i + 1)) {
+		leaf = STAB_LEAF(i);
+
+		for (j = 0; j < STAB_LEAF_SIZE; j++)
+			if (leaf[j] >= ostart && leaf[j] < oend)
+				leaf[j] += nstart - ostart;
+	}
+
+	/* switch */
+	tagmap_direct = nstart;
+
+	/* resume the threads */
+	if (likely(stopped))
+		PIN_ResumeApplicationThreads(tid);
+
+	/* verbose */
+	LOG(string(__func__) + ": direct shadow at " + hexstr(nstart) + "\n");
+
+	/* done */
+	return;
+
+err:	/* error message */
+	LOG(string(__func__) + ": direct shadow relocation failed (" +
+		string(strerror(errno)) + ")\n");
+
+	/* die */
+	libdft_die();
+}
+#endif
+
+/*
+ * ask for transparent huge pages on the HUGE_PAGE_SZ
+ * aligned part of an already allocated tagmap segment
+ * (e.g., the program break segment)
+ *
+ * @seg:	the segment
+ * @len:	the segment size in bytes
+ */
+void
+tagmap_seg_advise(void *seg, size_t len)
+{
+	size_t	hstart	= HUGE_ALIGN((size_t)seg + HUGE_PAGE_SZ - 1);
+	size_t	hend	= HUGE_ALIGN((size_t)seg + len);
+
+	/* no huge pages, or nothing to advise; optimized branch */
+	if (likely(huge_policy == TAGMAP_HUGE_NONE || hstart >= hend))
+		return;
+
+	if (unlikely(madvise((void *)hstart, hend - hstart,
+					MADV_HUGEPAGE) != 0))
+		huge_fallback("MADV_HUGEPAGE");
+	else
+		huge_stats.thp += hend - hstart;
+}
+
+/*
+ * get the parent and the start time of a process (see proc(5))
+ *
+ * @pid:	the process
+ * @ppid:	its parent
+ * @start:	its start time (clock ticks since boot)
+ *
+ * returns:	0 on success, 1 on error
+ */
+static int
+proc_stat(pid_t pid, pid_t *ppid, unsigned long long *start)
+{
+	char	path[PATH_MAX];	/* /proc/<pid>/stat	*/
+	char	buf[1024];	/* its contents		*/
+	char	*p;		/* past the command	*/
+	ssize_t	n;		/* bytes read		*/
+	int	fd;		/* the file		*/
+
+	(void)snprintf(path, PATH_MAX, "/proc/%d/stat", pid);
+	if ((fd = open(path, O_RDONLY)) == -1)
+		return 1;
+	n = read(fd, buf, sizeof(buf) - 1);
+	(void)close(fd);
+	if (n <= 0)
+		return 1;
+	buf[n] = '\0';
+
+	/* the command may contain anything; skip it */
+	if ((p = strrchr(buf, ')')) == NULL)
+		return 1;
+
+	/* fields 3 (state), 4 (ppid), ..., 22 (starttime) */
+	return sscanf(p + 1, " %*c %d %*d %*d %*d %*d %*u %*u %*u %*u %*u "
+			"%*u %*u %*d %*d %*d %*d %*d %*d %llu",
+			ppid, start) != 2;
+}
+
+/*
+ * get the namespace directory of a process
+ *
+ * @pid:	the process
+ * @ppid:	its parent
+ *
+ * returns:	the directory, or an empty string on error
+ */
+static string
+share_ns_of(pid_t pid, pid_t *ppid)
+{
+	unsigned long long	start;	/* start time */
+
+	if (proc_stat(pid, ppid, &start) != 0)
+		return "";
+
+	return share_dir.Value() + "/libdft." + decstr(pid) + "." +
+		decstr((UINT64)start);
+}
+
+/*
+ * set up the namespace of the shadow objects
+ *
+ * without a given share_ns, the namespace is the instrumented process
+ * tree of the run, and it is named after its root (pid and start time,
+ * which never repeat); every process looks for the directory of its
+ * nearest ancestor that has one, and uses it, otherwise it is the root
+ * and it creates its own. The root removes the directory on exit, while
+ * the processes that still use its objects keep them (unlinked); the
+ * ones that start afterwards fall back to private tagmap segments
+ *
+ * returns:	0 on success, 1 on error
+ */
+static int
+share_init(void)
+{
+	struct stat	st;	/* directory	*/
+	string		dir;	/* ditto	*/
+	pid_t		pid, ppid;
+
+	/* a given namespace; kept across runs */
+	if (!share_ns.Value().empty()) {
+		share_path_ns = share_dir.Value() + "/libdft." +
+			share_ns.Value();
+		return mkdir(share_path_ns.c_str(), 0700) != 0 &&
+			errno != EEXIST;
+	}
+
+	/* the nearest ancestor with a namespace */
+	for (pid = getppid(); pid > 1; pid = ppid) {
+		dir = share_ns_of(pid, &ppid);
+		if (dir.empty())
+			break;
+		if (stat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+			share_path_ns = dir;
+			return 0;
+		}
+	}
+
+	/* the root of the process tree */
+	if (unlikely((dir = share_ns_of(getpid(), &ppid)).empty() ||
+			mkdir(dir.c_str(), 0700) != 0))
+		return 1;
+	share_path_ns	= dir;
+	share_root	= getpid();
+
+	return 0;
+}
+
+/*
+ * remove the namespace of the shadow objects on exit
+ * (only its root does; see share_init())
+ *
+ * @code:	the exit code of the application
+ * @v:		callback value
+ */
+static void
+share_fini(INT32 code, VOID *v)
+{
+	DIR		*dir;	/* the directory	*/
+	struct dirent	*ent;	/* its entries		*/
+	string		path;	/* an entry		*/
+
+	/* not the root (e.g., a forked child); optimized branch */
+	if (likely(share_root != getpid()))
+		return;
+
+	if ((dir = opendir(share_path_ns.c_str())) != NULL) {
+		while ((ent = readdir(dir)) != NULL)
+			if (strncmp(ent->d_name, "libdft.", 7) == 0) {
+				path = share_path_ns + "/" + ent->d_name;
+				(void)unlink(path.c_str());
+			}
+		(void)closedir(dir);
+	}
+	(void)rmdir(share_path_ns.c_str());
+}
+
+/*
+ * get the path of a shadow object
+ *
+ * @path:	the path (PATH_MAX bytes)
+ * @key:	the key of the shared object (file or SysV segment)
+ *
+ * returns:	0 on success, 1 on error
+ */
+static int
+share_path(char *path, const char *key)
+{
+	return snprintf(path, PATH_MAX, "%s/libdft.%s",
+			share_path_ns.c_str(), key) >= PATH_MAX;
+}
+
+/*
+ * map a private tagmap segment to a
+ * region of the address space (no sharing)
+ *
+ * @addr:	the region (page aligned)
+ * @len:	the region size in bytes
+ *
+ * returns:	0 on success, 1 on error
+ */
+static int
+share_none(size_t addr, size_t len)
+{
+	void	*tseg;	/* the segment */
+
+	if (unlikely((tseg = tagmap_seg_alloc(TAG_SEG_SZ(len),
+					TAGMAP_KIND_SHM)) == MAP_FAILED))
+		return 1;
+
+	/* STAB setup */
+	stab_map(VIRT2STAB(addr), VIRT2STAB(addr + len - 1), tseg);
+
+	/* success */
+	return 0;
+}
+
+/*
+ * map a shared tagmap segment to a region of the address space
+ *
+ * the segment is a MAP_SHARED mapping of a shadow object, which is
+ * created on first use; with TAG_SEG_SZ(off) being the tags of the
+ * region in the object, every process that maps the same object (part)
+ * sees (and propagates) the same tags. Anonymous segments (i.e., without
+ * a path) are shared with the children of the process. The summary bits
+ * of the region stay set (see sum_clrn())
+ *
+ * @addr:	the region (page aligned)
+ * @len:	the region size in bytes
+ * @path:	the shadow object, or NULL (anonymous)
+ * @off:	the offset of the region in the shared object (page aligned)
+ *
+ * returns:	0 on success, 1 on error
+ */
+static int
+share_map(size_t addr, size_t len, const char *path, size_t off)
+{
+	size_t	toff	= TAG_SEG_SZ(off);	/* tags in the object	*/
+	size_t	moff	= PAGE_ALIGN(toff);	/* mapping offset	*/
+	size_t	mlen;				/* mapping length	*/
+	size_t	seg;				/* the mapping		*/
+	size_t	i;				/* iterator		*/
+	int	fd;				/* shadow object	*/
+	struct	stat st;			/* object size		*/
+
+	/* the tagmap pages that cover the region */
+	mlen = PAGE_ALIGN(toff + TAG_SEG_SZ(len) + PAGE_SZ - 1) - moff;
+#ifdef	TAGMAP_DIRECT
+	/*
+	 * the object is mapped on the direct shadow of the region; this
+	 * is possible only if the tags of the region (and their offset in
+	 * the object) are whole tagmap pages, otherwise the tags are private
+	 */
+	if (unlikely(PAGE_OFFSET(VIRT2TAG(addr)) != 0 || toff != moff ||
+				PAGE_OFFSET(TAG_SEG_SZ(len)) != 0)) {
+		/* issue a warning */
+		LOG(string(__func__) + ": shared mapping at " +
+			hexstr(addr) + " is not shared (alignment)\n");
+		return share_none(addr, len);
+	}
+	seg = VIRT2TAG(addr);
+#else
+	seg = 0;
+#endif
+
+	/* anonymous */
+	if (path == NULL)
+		seg = (size_t)mmap((void *)seg, mlen,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS | SHARE_FIXED,
+			-1, 0);
+	else {
+		if (unlikely((fd = open(path, O_RDWR | O_CREAT, 0600)) == -1))
+			/* the namespace is gone (see share_init()) */
+			return (errno == ENOENT) ? share_none(addr, len) : 1;
+
+		/*
+		 * grow the (sparse) object; it is never truncated, since
+		 * other processes may be using it (hence, the lock)
+		 */
+		if (unlikely(flock(fd, LOCK_EX) != 0 || fstat(fd, &st) != 0 ||
+			((size_t)st.st_size < moff + mlen &&
+			ftruncate(fd, moff + mlen) != 0))) {
+			(void)close(fd);
+			return 1;
+		}
+		(void)flock(fd, LOCK_UN);
+
+		seg = (size_t)mmap((void *)seg, mlen,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+			MAP_SHARED | SHARE_FIXED,
+			fd, moff);
+		(void)close(fd);
+	}
+
+	/* failed */
+	if (unlikely(seg == (size_t)MAP_FAILED))
+		return 1;
+
+	/* accounting */
+	tagmap_seg_acct(TAGMAP_KIND_SHM, (void *)seg, 0, mlen);
+	for (i = VIRT2STAB(seg); i < VIRT2STAB(seg + mlen); i++)
+		*ptab_ref(page_kind, i) |= KIND_SHARED;
+	shared_pages += mlen >> PAGE_SHIFT;
+
+	/* STAB setup */
+	stab_map(VIRT2STAB(addr), VIRT2STAB(addr + len - 1),
+			(void *)(seg + toff - moff));
+
+	/* other processes may tag the region at any time */
+	sum_fill(VIRT2SUM(addr), VIRT2SUM(addr + len - 1), 1);
+
+	/* success */
+	return 0;
+}
+
+/*
+ * shadow a MAP_SHARED mapping with a shared tagmap segment
+ *
+ * the shadow object is keyed on the device and the inode of the mapped
+ * file, within the namespace of the process (see share_init()), and
+ * files are shared only if share_dir is given; anonymous mappings
+ * (fd == -1) are always shared with the children of the process. Note
+ * that writes from uninstrumented processes (or write(2)) do not update
+ * the tags of a file
+ *
+ * @addr:	the mapping
+ * @len:	the mapping size in bytes
+ * @fd:		the mapped file, or -1 (anonymous)
+ * @off:	the file offset
+ *
+ * returns:	0 on success, 1 on error
+ */
+int
+tagmap_share_file(size_t addr, size_t len, int fd, size_t off)
+{
+	struct	stat st;		/* file identity	*/
+	char	key[NAME_MAX];		/* shadow object key	*/
+	char	path[PATH_MAX];		/* shadow object path	*/
+
+	/* anonymous */
+	if (fd == -1)
+		return share_map(addr, len, NULL, 0);
+
+	/* sharing is off; optimized branch */
+	if (unlikely(share_path_ns.empty()))
+		return share_none(addr, len);
+
+	/* the file */
+	if (unlikely(fstat(fd, &st) != 0))
+		return 1;
+	(void)snprintf(key, NAME_MAX, "f.%llx.%llx",
+			(unsigned long long)st.st_dev,
+			(unsigned long long)st.st_ino);
+
+	if (unlikely(share_path(path, key) != 0)) {
+		errno = ENAMETOOLONG;
+		return 1;
+	}
+
+	return share_map(addr, len, path, off);
+}
+
+/*
+ * shadow a SysV shared memory segment
+ * with a shared tagmap segment
+ *
+ * the shadow object is keyed on the shm id
+ * (see tagmap_share_rmid())
+ *
+ * @addr:	the attach address
+ * @len:	the segment size in bytes
+ * @shmid:	the shm id
+ *
+ * returns:	0 on success, 1 on error
+ */
+int
+tagmap_share_shm(size_t addr, size_t len, int shmid)
+{
+	char	key[NAME_MAX];		/* shadow object key	*/
+	char	path[PATH_MAX];		/* shadow object path	*/
+
+	/* sharing is off; optimized branch */
+	if (unlikely(share_path_ns.empty()))
+		return share_none(addr, len);
+
+	(void)snprintf(key, NAME_MAX, "s.%d", shmid);
+	if (unlikely(share_path(path, key) != 0)) {
+		errno = ENAMETOOLONG;
+		return 1;
+	}
+
+	return share_map(addr, len, path, 0);
+}
+
+/*
+ * remove the shadow object of a SysV shared memory segment
+ * (IPC_RMID); the processes that have it mapped keep using
+ * it, while a new segment with the same shm id starts clean
+ *
+ * @shmid:	the shm id
+ */
+void
+tagmap_share_rmid(int shmid)
+{
+	char	key[NAME_MAX];		/* shadow object key	*/
+	char	path[PATH_MAX];		/* shadow object path	*/
+
+	/* sharing is off; optimized branch */
+	if (unlikely(share_path_ns.empty()))
+		return;
+
+	(void)snprintf(key, NAME_MAX, "s.%d", shmid);
+	if (share_path(path, key) == 0)
+		(void)unlink(path);
+}
+
+static void
+stackrange_alloc(size_t addrstart, size_t addrend)
+{
+	size_t size = addrend - addrstart;
+
+	void	*stack_seg	= NULL;
+	/* stack_seg; zero_seg, null_seg; default segments */
+	if((stack_seg = tagmap_seg_alloc(TAG_SEG_SZ(size),
+				TAGMAP_KIND_STACK)) == MAP_FAILED) {
+		perror("mmap");
+		exit(1);
+	}
+
+	/* 
+	 * stack mapping
+	 */
+	stab_map(VIRT2STAB(addrstart), VIRT2STAB(addrend - 1), stack_seg);
+
+#ifdef DEBUG_MEMTRACK
+	/* verbose */
+	LOG(string(__func__) + ": stack range " + hexstr(addrstart) + "-" + hexstr(addrend) + ": stack_seg\n");
+#endif
+
+}
+
+/*
+ * get the starting and ending
+ * addresses of the vDSO mapping
+ *
+ *
+ * @saddr: 	the starting address of vDSO
+ * @eaddr:	the ending address of VDSO
+ *
+ * returbs:	saddr and eaddr have the appropriate
+ * 		values after invocation; if vDSO
+ * 		is not found saddr and eaddr will
+ * 		be zero
+ */
+static inline
+void get_vdso(size_t *saddr, size_t *eaddr)
+{
+	/* file pointer */
+	FILE	*fp		= NULL;
+	/* path to /proc/<pid>/maps */
+	char	maps_path[PATH_MAX];
+	/* line buffer */
+	char	lbuf[MAPS_ENTRY_MAX];
+	
+	/* initialization */
+	*saddr = *eaddr = 0;
+
+	/* cleanup */
+	(void)memset(maps_path, 0, PATH_MAX);
+
+	/* prepare the pathname for /proc/<pid>/maps */
+	if (snprintf(maps_path, PATH_MAX, "/proc/%d/maps",
+				PIN_GetPid()) > PATH_MAX) {
+		/* failed */
+		LOG(string(__func__) + ": failed while trying to assemble "
+				+ string(maps_path) + " -- (" +
+				string(strerror(errno)) + ")\n");
+		return;
+	}
+
+	/* open /proc/<pid>/maps */
+	if ((fp = fopen(maps_path, "r")) == NULL) {
+		/* failed */
+		LOG(string(__func__) + ": failed while trying to open "
+				+ string(maps_path) + " -- (" +
+				string(strerror(errno)) + ")\n");
+		return;
+	}
+	
+	/* read the file */
+	while(!feof(fp)) {
+		/* buffer cleanup */
+		(void)memset(lbuf, 0, MAPS_ENTRY_MAX);
+	
+		/* read a line */
+		if (fgets(lbuf, MAPS_ENTRY_MAX, fp) == NULL) {
+			/* something went wrong */
+			if (ferror(fp)) {
+				/* verbose */
+				LOG(string(__func__) +
+					": failed while trying to read"
+					+ string(maps_path) + " -- (" +
+					string(strerror(errno)) + ")\n");
+				break;
+			}
+		}
+
+		LOG(string(__func__) + ": map: " + lbuf);
+
+		/* check for the vDSO entry */
+		if (strstr(lbuf, VDSO_STR) != NULL) {
+			/* update saddr and eaddr */
+			(void)sscanf(lbuf, "%zx-%zx %*s:4 %*x %*s:5 %*u%*s\n",
+					saddr, eaddr);
+			/* done */
+//			break;
+		}
+
+		/* check for the stack entry */
+		if (strstr(lbuf, "[stack:") != NULL || strstr(lbuf, " rw-") != NULL) {
+			size_t s1, s2;
+			/* update saddr and eaddr */
+			(void)sscanf(lbuf, "%zx-%zx %*s:4 %*x %*s:5 %*u%*s\n",
+					&s1, &s2);
+			stackrange_alloc(s1, s2);
+		}
+
+	}
+
+	/* cleanup */
+	(void)fclose(fp);
+}
+
+#ifdef TAGMAP_COLLAPSE
+/*
+ * ELF image loading callback
+ *
+ * capture the loading of an image and setup the tagmap accordingly;
+ * read-only sections are mapped to zero_seg, whereas for each writeable
+ * section we allocate a tagmap segment and adjust the STAB
+ *
+ * @img:	image handle
+ * @v:		callback value
+ */
+static void
+elf_load(IMG img, VOID *v)
+{
+	SEC	sec;	/* section iterator		*/
+	SEC	lread;	/* last read-only section	*/
+	void*	tseg;	/* tagmap segment		*/
+	size_t	slen;	/* segment length 		*/
+
+		LOG(string(__func__) + ": tagmap_collapse yes\n");
+
+	/* 
+	 * after the dynamic linker/loaded is mapped into
+	 * the address space of the process, the image loading
+	 * is handled via mmap(2). However, we cannot unregister
+	 * elf_load, so we rely on this ugly hack; optimized branch
+	 */ 
+	if (likely(dynldlnk_loaded == 1))
+		return;
+
+#ifdef DEBUG_MEMTRACK
+	/* verbose */
+	LOG(string(__func__) + ": " +
+		IMG_Name(img) + " " +
+		hexstr(IMG_LowAddress(img)) + "-" +
+		hexstr(IMG_HighAddress(img)) + "\n");
+
+	for (sec = IMG_SecHead(img); SEC_Valid(sec); sec = SEC_Next(sec)) {
+		LOG("\t" + SEC_Name(sec) + ": " +
+			hexstr(SEC_Address(sec)) + "-" +
+			hexstr(SEC_Address(sec) + SEC_Size(sec) - 1) + " ");
+		if (SEC_IsReadable(sec)) LOG("R"); else LOG("-");
+		if (SEC_IsWriteable(sec)) LOG("W"); else LOG("-");
+		if (SEC_IsExecutable(sec)) LOG("X"); else LOG("-");
+		if (!SEC_Mapped(sec)) LOG(" (not mapped)");
+		LOG("\n");
+	}
+#endif
+	
+	/* 
+	 * iterate the sections in the ELF image (forward pass)
+	 * until the first writeable section is encountered
+	 */
+	for (sec = IMG_SecHead(img), lread = SEC_Invalid();
+			SEC_Valid(sec) && !SEC_IsWriteable(sec);
+			sec = SEC_Next(sec)) {
+		/* ignore unmapped sections; optimized branch */
+		if (unlikely(!SEC_Mapped(sec)))
+			continue;
+
+		/* update the last read-only section */
+		lread = sec;
+	}
+	
+	/* read-only sections exist; optimized branch */
+	if (likely(SEC_Valid(lread))) {
+		/* get the last read-only section
+		 * (tagmap collapse optimization)
+		 * 
+		 * read-only sections are mapped to zero_seg for reducing
+		 * address space waste; reading from zero_seg always results
+		 * in clear tags
+		 */
+		
+		/* STAB setup */
+		stab_map(VIRT2STAB(IMG_LowAddress(img)),
+			VIRT2STAB(SEC_Address(lread) + SEC_Size(lread) - 1),
+			zero_seg);
+#ifdef DEBUG_MEMTRACK
+		/* verbose */
+		LOG(string(__func__) + ": mapping read sections " +
+			hexstr(IMG_LowAddress(img)) + "-" + 
+			hexstr(SEC_Address(lread) + SEC_Size(lread) - 1) +
+			" [" +
+			hexstr(VIRT2TAG(IMG_LowAddress(img))) + "-" +
+			hexstr(VIRT2TAG(SEC_Address(lread) +
+					SEC_Size(lread) - 1)) +
+			"]\n");	
+#endif
+	}
+	
+	/* writeable sections exist; optimized branch */
+	if (likely(SEC_IsWriteable(sec))) {
+		/* estimate the length of the tagmap segment */
+		slen	= PAGE_ALIGN(IMG_HighAddress(img)) -
+				PAGE_ALIGN(SEC_Address(sec)) + PAGE_SZ;
+	
+		/*
+		 * allocate space for a new tagmap
+		 * segment by invoking tagmap_seg_alloc()
+		 */
+		if (unlikely(((tseg = tagmap_seg_alloc(TAG_SEG_SZ(slen),
+						TAGMAP_KIND_IMAGE))
+						== MAP_FAILED))) {
+			
+			/* error message */
+			LOG(string(__func__) +
+				": tagmap segment allocation failed (" +
+				string(strerror(errno)) + ")\n");
+
+			/* die */
+			libdft_die();
+		}
+		
+		/* STAB setup */	
+		stab_map(VIRT2STAB(SEC_Address(sec)),
+			VIRT2STAB(IMG_HighAddress(img)), tseg);
+#ifdef DEBUG_MEMTRACK
+		/* verbose */
+		LOG(string(__func__) + ": mapping write sections " +
+			hexstr(SEC_Address(sec)) + "-" + 
+			hexstr(IMG_HighAddress(img)) + " [" +
+			hexstr(VIRT2TAG(SEC_Address(sec))) + "-" +
+			hexstr(VIRT2TAG(IMG_HighAddress(img))) + "]\n");
+#endif
+	}
+	
+	/* setup the program break */
+	if (brk_end == 0) {
+		brk_start = brk_end =
+			PAGE_ALIGN(IMG_HighAddress(img)) + PAGE_SZ;
+#ifdef DEBUG_MEMTRACK
+		/* verbose */
+		LOG(string(__func__) + ": brk is set at " +
+				hexstr(brk_end) + "\n");
+#endif
+	}
+
+	/* check if the loaded image was the dynamic linker/loader */
+	if (IMG_Name(img).compare(DYNLDLNK) == 0 ||
+			IMG_Type(img) == IMG_TYPE_STATIC)
+		/* set the corresponding flag accordingly */
+		dynldlnk_loaded = 1;
+}
+#else
+/*
+ * ELF image loading callback
+ *
+ * capture the loading of an image and setup the tagmap; we
+ * allocate a tagmap segment and adjust the STAB accordingly 
+ *
+ * @img:	image handle
+ * @v:		callback value
+ */
+static void
+elf_load(IMG img, VOID *v)
+{
+	void*	tseg;	/* tagmap segment		*/
+	size_t	slen;	/* segment length 		*/
+
+		LOG(string(__func__) + ": tagmap_collapse no\n");
+
+	/* 
+	 * after the dynamic linker/loaded is mapped into
+	 * the address space of the process, the image loading
+	 * is handled via mmap(2). However, we cannot unregister
+	 * elf_load, so we rely on this ugly hack; optimized branch
+	 */ 
+	if (likely(dynldlnk_loaded == 1))
+		return;
+
+#ifdef DEBUG_MEMTRACK
+	/* verbose */
+	LOG(string(__func__) + ": image " +
+		IMG_Name(img) + " low-high range: " +
+		hexstr(IMG_LowAddress(img)) + "-" +
+		hexstr(IMG_HighAddress(img)) + "\n");
+#endif
+	
+	/* estimate the length of the tagmap segment */
+	slen	= PAGE_ALIGN(IMG_HighAddress(img)) -
+			PAGE_ALIGN(IMG_LowAddress(img)) + PAGE_SZ;
+	
+	/*
+	 * allocate space for a new tagmap
+	 * segment by invoking tagmap_seg_alloc()
+	 */
+	if (unlikely(((tseg = tagmap_seg_alloc(TAG_SEG_SZ(slen),
+						TAGMAP_KIND_IMAGE))
+					== MAP_FAILED))) {
+			
+		/* error message */
+		LOG(string(__func__) +
+			": tagmap segment allocation failed (" +
+			string(strerror(errno)) + ")\n");
+
+		/* die */
+		libdft_die();
+	}
+
+#ifdef DEBUG_MEMTRACK
+	LOG(string(__func__) + ": stab region for ELF image is " + hexstr(tseg) + "\n");
+#endif
+		
+	/* STAB setup */	
+	stab_map(VIRT2STAB(IMG_LowAddress(img)),
+		VIRT2STAB(IMG_HighAddress(img)), tseg);
+#ifdef DEBUG_MEMTRACK
+		/* verbose */
+		LOG(string(__func__) + ": mapping sections " +
+			hexstr(IMG_LowAddress(img)) + "-" + 
+			hexstr(IMG_HighAddress(img)) + " [" +
+			hexstr(VIRT2TAG(IMG_LowAddress(img))) + "-" +
+			hexstr(VIRT2TAG(IMG_HighAddress(img))) + "]\n");
+#endif
+	/* setup the program break */
+	if (brk_end == 0) {
+		brk_start = brk_end =
+			PAGE_ALIGN(IMG_HighAddress(img)) + PAGE_SZ;
+#ifdef DEBUG_MEMTRACK
+		/* verbose */
+		LOG(string(__func__) + ": brk is set at " +
+				hexstr(brk_end) + "\n");
+#endif
+	}
+
+	/* check if the loaded image was the dynamic linker/loader */
+	if (IMG_Name(img).compare(DYNLDLNK) == 0 ||
+			IMG_Type(img) == IMG_TYPE_STATIC)
+		/* set the corresponding flag accordingly */
+		dynldlnk_loaded = 1;
+}
+#endif
+
+
+/*
+ * initialize the STAB/tagmap
+ *
+ * allocate space for the STAB directory, the two default leaves (and
+ * middles, in x86-64), the directories of the sparse tables, and the
+ * two ``hardcoded'' tagmap segments: zero_seg and null_seg (TAG_PAGE_SZ)
+ *
+ * returns:	0 on success, 1 on error 
+ */
+int
+tagmap_alloc(void)
+{
+	size_t	i;	/* iterators		*/
+			/* STAB directory size in bytes	*/
+	size_t 	len		= STAB_TOP_SIZE * sizeof(*STAB);
+			/* STAB leaf size in bytes	*/
+	size_t	llen		= STAB_LEAF_SIZE * sizeof(size_t);
+#ifdef	STAB_MID_SHIFT
+			/* STAB middle size in bytes	*/
+	size_t	mlen		= STAB_MID_SIZE * sizeof(size_t *);
+#endif
+			/* vDSO handling */
+	size_t	vdso_start, vdso_end;
+
+	/* huge page policy */
+	if (huge_knob.Value() == "thp")
+		huge_policy = TAGMAP_HUGE_THP;
+	else if (huge_knob.Value() == "hugetlb")
+		huge_policy = TAGMAP_HUGE_HUGETLB;
+	else if (unlikely(huge_knob.Value() != "none")) {
+		/* error message */
+		LOG(string(__func__) + ": invalid huge page policy (" +
+			huge_knob.Value() + ")\n");
+
+		/* failed */
+		return 1;
+	}
+
+	/*
+	 * allocate space for STAB/zero_seg/null_seg by invoking
+	 * mmap(2); if HUGE_TLB is defined, then the mapping of the
+	 * STAB directory is done using ``huge pages''
+	 */
+	if (unlikely(
+		/* STAB */
+		((STAB = (__typeof__(STAB))mmap(NULL, len,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+			MAP_FLAGS, -1, 0)) == MAP_FAILED)		||
+		((null_leaf = (size_t *)mmap(NULL, llen,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)	||
+		((zero_leaf = (size_t *)mmap(NULL, llen,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)	||
+#ifdef	STAB_MID_SHIFT
+		((null_mid = (size_t **)mmap(NULL, mlen,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)	||
+		((zero_mid = (size_t **)mmap(NULL, mlen,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)	||
+#endif
+		/* page kinds (accounting); leaves allocated on demand */
+		((page_kind = (uint8_t **)mmap(NULL, PTAB_DIR_SZ,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+		-1, 0)) == MAP_FAILED)					||
+		/* taint summary; leaves allocated on demand */
+		((tagmap_sum = (uint8_t **)mmap(NULL, PTAB_DIR_SZ,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+		-1, 0)) == MAP_FAILED)					||
+		((zero_seg = mmap(NULL, TAG_PAGE_SZ,
+			/* R-- */
+			PROT_READ,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED)	||
+		((null_seg = mmap(NULL, TAG_PAGE_SZ,
+			/* --- */
+			PROT_NONE, 
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED))) {
+		/* error message */
+		LOG(string(__func__) +
+			": tagmap segment allocation failed (" +
+			string(strerror(errno)) + ")\n");
+	
+		/* failed */
+		goto err;
+	}
+
+		LOG(string(__func__) + ": zero_seg ok\n");
+
+#ifdef	TAGMAP_DIRECT
+	/* the direct shadow; populated on demand */
+	if (unlikely((tagmap_direct = (size_t)mmap(NULL, DIRECT_SZ,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+		-1, 0)) == (size_t)MAP_FAILED)) {
+		/* error message */
+		LOG(string(__func__) +
+			": direct shadow allocation failed (" +
+			string(strerror(errno)) + ")\n");
+
+		/* failed */
+		tagmap_direct = 0;
+		goto err;
+	}
+#endif
+	
+#ifdef	TAGMAP_LABEL
+	/* label table; populated on demand */
+	if (unlikely(
+		((lbl_tab = (uint32_t (*)[4])mmap(NULL,
+			TAG_LBL_MAX * sizeof(*lbl_tab),
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+		-1, 0)) == MAP_FAILED)					||
+		((lbl_hash = (uint32_t *)mmap(NULL,
+			LBL_HASH_SZ * sizeof(uint32_t),
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+		-1, 0)) == MAP_FAILED))) {
+		/* error message */
+		LOG(string(__func__) +
+			": label table allocation failed (" +
+			string(strerror(errno)) + ")\n");
+
+		/* failed */
+		goto err;
+	}
+#endif
+
+	/* lazy page states; leaves allocated on demand */
+	if (lazy_min.Value() != 0 &&
+		unlikely((lazy_state = (uint8_t **)mmap(NULL, PTAB_DIR_SZ,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+		-1, 0)) == MAP_FAILED)) {
+		/* error message */
+		LOG(string(__func__) +
+			": lazy state allocation failed (" +
+			string(strerror(errno)) + ")\n");
+
+		/* failed */
+		lazy_state = NULL;
+		goto err;
+	}
+
+	/* setup the default leaves */
+	for (i = 0; i < STAB_LEAF_SIZE; i++) {
+		null_leaf[i]	= (size_t)null_seg;
+		zero_leaf[i]	= (size_t)zero_seg;
+	}
+
+	/* the default leaves are shared; never write to them */
+	(void)mprotect(null_leaf, llen, PROT_READ);
+	(void)mprotect(zero_leaf, llen, PROT_READ);
+
+#ifdef	STAB_MID_SHIFT
+	/* setup the default middles; shared too */
+	for (i = 0; i < STAB_MID_SIZE; i++) {
+		null_mid[i]	= null_leaf;
+		zero_mid[i]	= zero_leaf;
+	}
+	(void)mprotect(null_mid, mlen, PROT_READ);
+	(void)mprotect(zero_mid, mlen, PROT_READ);
+#endif
+
+	/* setup the STAB */
+
+	/* 
+	 * the upper 1G of the address space is mapped to zero_seg;
+	 * this is how we handle vsyscall (i.e., reading from a
+	 * kernel address will result in always reading clear tags)
+	 */
+	for (i = VIRT2TOP(KERN_START); i <= VIRT2TOP(KERN_END); i++)
+#ifdef	STAB_MID_SHIFT
+		STAB[i] = zero_mid;
+#else
+		STAB[i] = zero_leaf;
+#endif
+
+#ifdef DEBUG_MEMTRACK
+		/* verbose */
+		LOG(string(__func__) + ": kernel range " + hexstr(KERN_START) + "-" + hexstr(KERN_END) + ": zero_seg\n");
+		LOG(string(__func__) + ": zero_seg is " +hexstr(zero_seg) + "\n");
+		LOG(string(__func__) + ": null_seg is " +hexstr(null_seg) + "\n");
+#endif
+
+	/* 
+	 * the lower 3G of the address space are considered unmapped, and
+	 * hence they translate to null_seg (i.e., reading/writing from an
+	 * unmapped address will fail)
+	 */
+	for (i = VIRT2TOP(USER_START); i <= VIRT2TOP(USER_END); i++)
+#ifdef	STAB_MID_SHIFT
+		STAB[i] = null_mid;
+#else
+		STAB[i] = null_leaf;
+#endif
+
+#ifdef DEBUG_MEMTRACK
+		/* verbose */
+		LOG(string(__func__) + ": user range " + hexstr(USER_START) + "-" + hexstr(USER_END) + ": null_seg\n");
+#endif
+
+
+	/* try to get the vDSO address */
+	get_vdso(&vdso_start, &vdso_end);
+		
+	/* check if we have the vDSO mapped */
+	if (likely(vdso_start != 0)) {
+		/* STAB setup */	
+		stab_map(VIRT2STAB(vdso_start), VIRT2STAB(vdso_end - 1),
+				zero_seg);
+#ifdef DEBUG_MEMTRACK
+		/* verbose */
+		LOG(string(__func__) + ": mapping vDSO sections " +
+			hexstr(vdso_start) + "-" + 
+			hexstr(vdso_end - 1) + " [" +
+			hexstr(VIRT2TAG(vdso_start)) + "-" +
+			hexstr(VIRT2TAG(vdso_end - 1)) + "]\n");
+#endif
+	}
+
+		LOG(string(__func__) +
+			": tagmap allocation went ok (STAB: " +
+			decstr(stab_bytes()) +
+			" bytes, " + decstr(stab_leaves) +
+			" leaves). hooking elf_load");
+	
+	/* register the ELF image load callback */
+	IMG_AddInstrumentFunction(elf_load, NULL);
+
+	/* the namespace of the shared tagmap segments; optimized branch */
+	if (unlikely(!share_dir.Value().empty())) {
+		if (unlikely(share_init() != 0)) {
+			/* issue a warning; the segments are private */
+			LOG(string(__func__) + ": shared tagmap segments are "
+				"off (" + string(strerror(errno)) + ")\n");
+			share_path_ns.clear();
+		}
+		else
+			PIN_AddFiniFunction(share_fini, NULL);
+	}
+
+	/* report the tagmap usage on exit, or on demand */
+	PIN_AddFiniFunction(acct_fini, NULL);
+	if (acct_sig.Value() != 0)
+		(void)PIN_InterceptSignal(acct_sig.Value(), acct_signal, NULL);
+	
+	/* return with success */
+	return 0;
+
+err:	/* error handling */
+	
+	/* cleanup */
+	if (STAB != NULL)
+		/* deallocate the STAB space */
+		(void)munmap(STAB, len);
+	if (null_leaf != NULL)
+		/* deallocate the default leaves */
+		(void)munmap(null_leaf, llen);
+	if (zero_leaf != NULL)
+		(void)munmap(zero_leaf, llen);
+#ifdef	STAB_MID_SHIFT
+	if (null_mid != NULL)
+		/* deallocate the default middles */
+		(void)munmap(null_mid, mlen);
+	if (zero_mid != NULL)
+		(void)munmap(zero_mid, mlen);
+#endif
+	if (page_kind != NULL)
+		/* deallocate the page kinds */
+		(void)munmap(page_kind, PTAB_DIR_SZ);
+	if (tagmap_sum != NULL)
+		/* deallocate the taint summary */
+		(void)munmap(tagmap_sum, PTAB_DIR_SZ);
+	if (zero_seg != NULL)
+		/* deallocate the zero segment space */
+		(void)munmap(zero_seg, TAG_PAGE_SZ);
+	if (null_seg != NULL)
+		/* deallocate the null segment space */
+		(void)munmap(null_seg, TAG_PAGE_SZ);
+#ifdef	TAGMAP_LABEL
+	if (lbl_tab != NULL)
+		/* deallocate the label table */
+		(void)munmap(lbl_tab, TAG_LBL_MAX * sizeof(*lbl_tab));
+	if (lbl_hash != NULL)
+		(void)munmap(lbl_hash, LBL_HASH_SZ * sizeof(uint32_t));
+#endif
+	if (lazy_state != NULL)
+		/* deallocate the lazy page states */
+		(void)munmap(lazy_state, PTAB_DIR_SZ);
+#ifdef	TAGMAP_DIRECT
+	if (tagmap_direct != 0)
+		/* deallocate the direct shadow */
+		(void)munmap((void *)tagmap_direct, DIRECT_SZ);
+#endif
+
+	/* return with failure */
+	return 1;
+}
+
+/*
+ * get the length of the run, starting from the given virtual address,
+ * that is shadowed by a contiguous range of the tagmap
+ *
+ * adjacent chunks belong to the same run if their tagmap segments
+ * (pages) are contiguous; chunks that map to null_seg/zero_seg always
+ * form runs of their own (up to the end of the page)
+ *
+ * @addr:	the virtual address
+ * @num:	the maximum number of bytes
+ * @seg:	the tagmap segment of the first chunk (output)
+ *
+ * returns:	the number of bytes in the run (up to num)
+ */
+static size_t
+tag_run(size_t addr, size_t num, size_t *seg)
+{
+	size_t	indx	= VIRT2STAB(addr);		/* STAB offset	*/
+	size_t	tseg	= STAB_SEG(indx);		/* segment	*/
+	size_t	len	= PAGE_SZ - PAGE_OFFSET(addr);	/* run length	*/
+	size_t	next;					/* next segment	*/
+
+	/* the segment of the first chunk */
+	*seg = tseg;
+
+	/* merge the contiguous chunks */
+	if (tseg != (size_t)null_seg && tseg != (size_t)zero_seg)
+		for (; len < num; len += PAGE_SZ) {
+			indx++;
+			next	= STAB_SEG(indx);
+			tseg	+= TAG_PAGE_SZ;
+			if (next != tseg || next == (size_t)null_seg ||
+					next == (size_t)zero_seg)
+				break;
+		}
+
+	return (len < num) ? len : num;
+}
+
+/*
+ * fill a contiguous range of the tagmap
+ *
+ * clears that cover at least DONTNEED_MIN bytes of whole tagmap
+ * pages release them with madvise(2), instead of writing zeros;
+ * the pages are zero-filled on their next access. Clears of
+ * reserved lazy pages are skipped, so that they are not committed
+ *
+ * @taddr:	the tag address
+ * @fill:	the tag value
+ * @len:	the number of tag bytes
+ */
+static void
+tag_memset(size_t taddr, uint8_t fill, size_t len)
+{
+	/* the tagmap pages that are wholly covered */
+	size_t	pstart	= PAGE_ALIGN(taddr + PAGE_SZ - 1);
+	size_t	pend	= PAGE_ALIGN(taddr + len);
+
+	/* clear of reserved lazy pages; they are clean already */
+	if (unlikely(fill == TAG_ZERO && lazy_clean(taddr, len)))
+		return;
+
+	/* set, or short clear; optimized branch */
+	if (likely(fill != TAG_ZERO || pend < pstart + DONTNEED_MIN)) {
+		(void)memset((void *)taddr, fill, len);
+		return;
+	}
+
+	/* head and tail */
+	(void)memset((void *)taddr, TAG_ZERO, pstart - taddr);
+	(void)memset((void *)pend, TAG_ZERO, taddr + len - pend);
+
+	/* whole pages; fall back to memset(3) (e.g., with HUGE_TLB) */
+	if (unlikely(madvise((void *)pstart, pend - pstart,
+					MADV_DONTNEED) != 0))
+		(void)memset((void *)pstart, TAG_ZERO, pend - pstart);
+}
+
+#ifdef	TAGMAP_1BIT
+/*
+ * fill the tag bits of an arbitrary number of bytes
+ * in the virtual address space; the bytes must be
+ * shadowed by a contiguous range of the tagmap
+ *
+ * @addr:	the virtual address
+ * @num:	the number of bytes
+ * @fill:	TAG_ZERO (clean) or TAG_ALL8 (tainted)
+ */
+static inline void
+tag_fillbits(size_t addr, size_t num, uint8_t fill)
+{
+	size_t	n;	/* bits */
+
+	/* head; up to the next tag byte */
+	if (VIRT2BIT(addr) != 0 && num > 0) {
+		n = 8 - VIRT2BIT(addr);
+		n = (num < n) ? num : n;
+		tag_stbits(addr, n, fill & ((1U << n) - 1));
+		addr	+= n;
+		num	-= n;
+	}
+
+	/* whole tag bytes */
+	if (num >= 8) {
+		tag_memset(VIRT2TAG(addr), fill, num >> 3);
+		addr	+= num & ~7U;
+		num	&= 7U;
+	}
+
+	/* tail */
+	if (num > 0)
+		tag_stbits(addr, num, fill & ((1U << num) - 1));
+}
+#endif
+
+#ifdef	TAGMAP_LABEL
+/*
+ * fill the labels of an arbitrary number of bytes
+ * in the virtual address space; the bytes must be
+ * shadowed by a contiguous range of the tagmap
+ *
+ * @addr:	the virtual address
+ * @num:	the number of bytes
+ * @fill:	the label
+ */
+static inline void
+tag_filllbls(size_t addr, size_t num, uint32_t fill)
+{
+	uint32_t	*tags	= (uint32_t *)VIRT2TAG(addr);
+	size_t		i;	/* iterator */
+
+	/* clear */
+	if (fill == TAG_ZERO) {
+		tag_memset((size_t)tags, TAG_ZERO, TAG_SEG_SZ(num));
+		return;
+	}
+
+	for (i = 0; i < num; i++)
+		tags[i] = fill;
+}
+#endif
+
+/*
+ * fill the tags of a run (see tag_run())
+ *
+ * @addr:	the virtual address
+ * @num:	the number of bytes
+ * @fill:	the tag value (or label)
+ */
+static inline void
+tag_fillrun(size_t addr, size_t num, uint32_t fill)
+{
+#if	defined(TAGMAP_1BIT)
+	tag_fillbits(addr, num, (fill != TAG_ZERO) ? TAG_ALL8 : TAG_ZERO);
+#elif	defined(TAGMAP_LABEL)
+	tag_filllbls(addr, num, fill);
+#else
+	tag_memset(VIRT2TAG(addr), (uint8_t)fill, num);
+#endif
+}
+
+/*
+ * fill the tags of an arbitrary number of bytes
+ * in the virtual address space
+ *
+ * the range is processed one run at a time; runs that
+ * map to null_seg/zero_seg hold no tags and are skipped
+ *
+ * @addr:	the virtual address
+ * @num:	the number of bytes
+ * @fill:	the tag value (or label)
+ */
+static void
+tag_filln(size_t addr, size_t num, uint32_t fill)
+{
+	size_t	n, seg;	/* run */
+
+	for (; num > 0; addr += n, num -= n) {
+		n = tag_run(addr, num, &seg);
+
+		/* shared segment; optimized branch */
+		if (unlikely(seg == (size_t)null_seg ||
+				seg == (size_t)zero_seg)) {
+#ifdef DEBUG_TAGMAP
+			if (fill != TAG_ZERO)
+				fprintf(stderr,
+					"WARNING: fill of shared segment (0x%x)\n",
+					addr);
+#endif
+			continue;
+		}
+
+		tag_fillrun(addr, n, fill);
+	}
+}
+
+/*
+ * tag a byte in the virtual address space
+ *
+ * @addr:	the virtual address
+ * @color:	the tag value
+ */
+void PIN_FAST_ANALYSIS_CALL
+tagmap_setb(size_t addr, uint8_t color)
+{
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "tagmap_setb(0x%x, 0x%02x): *(uint8_t *)(0x%x + STAB[0x%x]) = 0x%02x; STAB[0x%x] == 0x%x -> *(uint8_t *)(0x%x) = 0x%02x\n",
+			 addr, color, addr, VIRT2STAB(addr), color, VIRT2STAB(addr), STAB_SEG(VIRT2STAB(addr)), VIRT2TAG(addr), color);
+	fprintf(stderr, "STAB page is %x\n", VIRT2TAG(addr));
+	if(STAB_SEG(VIRT2STAB(addr)) == (size_t)zero_seg) { 
+		fprintf(stderr, "WARNING: holy shit setb to zero_seg\n");
+	}
+#endif
+	/* tag the byte that corresponds to the given address */
+	tag_stb(addr, color);
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "set done\n");
+#endif
+}
+
+/*
+ * untag a byte in the virtual address space
+ *
+ * @addr:	the virtual address
+ */
+void PIN_FAST_ANALYSIS_CALL
+tagmap_clrb(size_t addr)
+{
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "tagmap_clrb(0x%x): *(uint8_t *)(0x%x + STAB[0x%x]) = TAG_ZERO; STAB[0x%x] == 0x%x -> *(uint8_t *)(0x%x) = TAG_ZERO\n",
+			 addr, addr, VIRT2STAB(addr), VIRT2STAB(addr), STAB_SEG(VIRT2STAB(addr)), VIRT2TAG(addr));
+	fprintf(stderr, "STAB page is %x\n", VIRT2TAG(addr));
+	if(STAB_SEG(VIRT2STAB(addr)) == (size_t)zero_seg) { 
+		fprintf(stderr, "WARNING: ignoring clrb to zero_seg\n");
+		return;
+	}
+#endif
+	/* clear the byte that corresponds to the given address */
+	tag_stb(addr, TAG_ZERO);
+}
+
+/*
+ * get the tag value of a byte from the tagmap
+ *
+ * @addr:	the virtual address
+ *
+ * returns:	the tag value (e.g., 0, 1,...)
+ */
+uint8_t
+tagmap_getb(size_t addr)
+{
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "tagmap_getb(0x%x): return *(uint8_t *)(0x%x + STAB[0x%x]); STAB[0x%x] == 0x%x -> return *(uint8_t *)(0x%x)\n",
+			 addr, addr, VIRT2STAB(addr), VIRT2STAB(addr), STAB_SEG(VIRT2STAB(addr)), VIRT2TAG(addr));
+	fprintf(stderr, "STAB page is %x\n", VIRT2TAG(addr));
+#endif
+	/* get the byte that corresponds to the address */
+	return tag_ldb(addr);
+}
+
+/*
+ * tag a word (i.e., 2 bytes) in the virtual address space
+ *
+ * @addr:	the virtual address
+ * @color:	the tag value
+ */
+void PIN_FAST_ANALYSIS_CALL
+tagmap_setw(size_t addr, uint16_t color)
+{
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "tagmap_setw(0x%x)\n", addr);
+	fprintf(stderr, "STAB page is %x\n", VIRT2TAG(addr));
+	if(STAB_SEG(VIRT2STAB(addr)) == (size_t)zero_seg) { 
+		fprintf(stderr, "WARNING: holy shit setw to zero_seg\n");
+	}
+#endif
+	/* tag the bytes that correspond to the addresses of the word */
+	tag_stw(addr, color);
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "set done\n");
+#endif
+}
+
+/*
+ * untag a word (i.e., 2 bytes) in the virtual address space
+ *
+ * @addr:	the virtual address
+ */
+void PIN_FAST_ANALYSIS_CALL
+tagmap_clrw(size_t addr)
+{
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "tagmap_clrw(0x%x): *(uint16_t *)(0x%x + STAB[0x%x]) = TAG_ZERO; STAB[0x%x] == 0x%x -> *(uint16_t *)(0x%x) = TAG_ZERO\n",
+			 addr, addr, VIRT2STAB(addr), VIRT2STAB(addr), STAB_SEG(VIRT2STAB(addr)), VIRT2TAG(addr));
+	fprintf(stderr, "STAB page is %x\n", VIRT2TAG(addr));
+	if(STAB_SEG(VIRT2STAB(addr)) == (size_t)zero_seg) { 
+		fprintf(stderr, "WARNING: ignoring clrw to zero_seg\n");
+		return;
+	}
+#endif
+	/* clear the bytes that correspond to the addresses of the word */
+	tag_stw(addr, TAG_ZERO);
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "tagmap_clrw done\n");
+#endif
+}
+
+/*
+ * get the tag value of a word (i.e., 2 bytes) from the tagmap
+ *
+ * @addr:	the virtual address
+ *
+ * returns:	the tag value (e.g., 0, 1,...)
+ */
+uint16_t
+tagmap_getw(size_t addr)
+{
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "line %d: STAB page is %x, returning it\n", __LINE__, VIRT2TAG(addr));
+#endif
+	/* get the bytes that correspond to the addresses of the word */
+	return tag_ldw(addr);
+}
+
+/*
+ * tag a long word (i.e., 4 bytes) in the virtual address space
+ *
+ * @addr:	the virtual address
+ * @color:	the tag value
+ */
+void PIN_FAST_ANALYSIS_CALL
+tagmap_setl(size_t addr, uint32_t color)
+{
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "tagmap_setl(0x%x)\n", addr);
+	fprintf(stderr, "STAB page is %x\n", VIRT2TAG(addr));
+	if(STAB_SEG(VIRT2STAB(addr)) == (size_t)zero_seg) { 
+		fprintf(stderr, "WARNING: holy shit setl to zero_seg\n");
+	}
+#endif
+	/* tag the bytes that correspond to the addresses of the long word */
+	tag_stl(addr, color);
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "set done\n");
+#endif
+}
+
+/*
+ * untag a long word (i.e., 4 bytes) in the virtual address space
+ *
+ * @addr:	the virtual address
+ */
+void PIN_FAST_ANALYSIS_CALL
+tagmap_clrl(size_t addr)
+{
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "tagmap_clrl(0x%x): *(uint32_t *)(0x%x + STAB[0x%x]) = TAG_ZERO; STAB[0x%x] == 0x%x -> *(uint32_t *)(0x%x) = TAG_ZERO\n",
+			 addr, addr, VIRT2STAB(addr), VIRT2STAB(addr), STAB_SEG(VIRT2STAB(addr)), VIRT2TAG(addr));
+	fprintf(stderr, "STAB page is %x\n", VIRT2TAG(addr));
+	if(STAB_SEG(VIRT2STAB(addr)) == (size_t)zero_seg) { 
+		fprintf(stderr, "WARNING: ignoring clrl to zero_seg\n");
+		return;
+	}
+#endif
+	/* clear the bytes that correspond to the addresses of the long word */
+	tag_stl(addr, TAG_ZERO);
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "set done\n");
+#endif
+}
+
+/*
+ * untag a quad word (i.e., 8 bytes) in the virtual address space
+ *
+ * @addr:	the virtual address
+ */
+void PIN_FAST_ANALYSIS_CALL
+tagmap_clrq(size_t addr)
+{
+	/* clear the bytes that correspond to the addresses of the quad word */
+	tag_stq(addr, TAG_ZERO);
+}
+
+/*
+ * get the tag value of a long word (i.e., 4 bytes) from the tagmap
+ *
+ * @addr:	the virtual address
+ *
+ * returns:	the tag value (e.g., 0, 1,...)
+ */
+uint32_t PIN_FAST_ANALYSIS_CALL
+tagmap_getl(size_t addr)
+{
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "line %d: STAB page is %x, returning it\n", __LINE__, VIRT2TAG(addr));
+#endif
+	/* get the bytes that correspond to the addresses of the long word */
+	return tag_ldl(addr);
+}
+
+/* tag an arbitrary number of bytes in the virtual address space
+ *
+ * @addr:	the virtual address
+ * @num:	the number of bytes to tag
+ * @color:	the tag value
+ */
+void
+tagmap_setn(size_t addr, size_t num, uint8_t color)
+{
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "tagmap_setn(0x%x)\n", addr);
+	fprintf(stderr, "STAB page is %x\n", VIRT2TAG(addr));
+	if(STAB_SEG(VIRT2STAB(addr)) == (size_t)zero_seg) { 
+		fprintf(stderr, "WARNING: holy shit setn to zero_seg\n");
+	}
+#endif
+	/* tag the bytes that correspond to the addresses of the num bytes */
+	tag_filln(addr, num, color);
+	/* update the summary */
+	if (color != TAG_ZERO && num > 0)
+		sum_fill(VIRT2SUM(addr), VIRT2SUM(addr + num - 1), 1);
+	else
+		sum_clrn(addr, num);
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "set done\n");
+#endif
+}
+
+/*
+ * untag an arbitrary number of bytes in the virtual address space
+ *
+ * @addr:	the virtual address
+ * @num:	the number of bytes to untag
+ */
+void
+tagmap_clrn(size_t addr, size_t num)
+{
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "tagmap_clrn(0x%x)\n", addr);
+	fprintf(stderr, "STAB page is %x\n", VIRT2TAG(addr));
+#endif
+	/* already clean (e.g., fresh buffers); optimized branch */
+	if (likely(tagmap_sumn(addr, num) == 0))
+		return;
+
+	/* clear the bytes that correspond to the addresses of the num bytes */
+	tag_filln(addr, num, TAG_ZERO);
+	/* update the summary */
+	sum_clrn(addr, num);
+#ifdef DEBUG_TAGMAP
+	fprintf(stderr, "set done\n");
+#endif
+}
+
+/*
+ * copy the tags of an arbitrary number of bytes
+ * in the virtual address space
+ *
+ * @dst:	the destination virtual address
+ * @src:	the source virtual address
+ * @num:	the number of bytes
+ */
+void
+tagmap_copyn(size_t dst, size_t src, size_t num)
+{
+	size_t	n, dseg, sseg;	/* runs */
+#ifdef	TAGMAP_1BIT
+	size_t	k;		/* bits per iteration */
+#endif
+
+	/* the source is clean; optimized branch */
+	if (likely(tagmap_sumn(src, num) == 0)) {
+		tagmap_clrn(dst, num);
+		return;
+	}
+
+	/* the destination may become tainted */
+	sum_fill(VIRT2SUM(dst), VIRT2SUM(dst + num - 1), 1);
+
+	/* one pair of runs at a time */
+	for (; num > 0; dst += n, src += n, num -= n) {
+		n = tag_run(dst, num, &dseg);
+		n = tag_run(src, n, &sseg);
+
+		/* shared destination segment; nowhere to copy */
+		if (unlikely(dseg == (size_t)null_seg ||
+				dseg == (size_t)zero_seg))
+			continue;
+
+		/* shared source segment; clean */
+		if (unlikely(sseg == (size_t)null_seg ||
+				sseg == (size_t)zero_seg)) {
+			tag_fillrun(dst, n, TAG_ZERO);
+			continue;
+		}
+#ifdef	TAGMAP_1BIT
+		/* copy up to a tag byte at a time */
+		for (k = 0; k < n; k += 8)
+			tag_stbits(dst + k, (n - k < 8) ? n - k : 8,
+				tag_ldbits(src + k, (n - k < 8) ? n - k : 8));
+#else
+		/* copy the tags of the run */
+		(void)memcpy((void *)VIRT2TAG(dst), (void *)VIRT2TAG(src),
+				TAG_SEG_SZ(n));
+#endif
+	}
+}
+
+/*
+ * query the taint summary for an arbitrary number
+ * of bytes in the virtual address space
+ *
+ * @addr:	the virtual address
+ * @num:	the number of bytes
+ *
+ * returns:	0 if all the bytes are clean, 1 if (some of)
+ * 		them may be tainted
+ */
+int
+tagmap_sumn(size_t addr, size_t num)
+{
+	size_t	sbit, ebit;	/* summary bits */
+
+	/* nothing to check */
+	if (unlikely(num == 0))
+		return 0;
+
+	/* first and last unit */
+	sbit	= VIRT2SUM(addr);
+	ebit	= VIRT2SUM(addr + num - 1);
+
+	/* head; up to the next summary byte */
+	for (; sbit <= ebit && (sbit & 7) != 0; sbit++)
+		if (tag_sum_byte(sbit) & (1U << (sbit & 7)))
+			return 1;
+
+	/* whole summary bytes; missing leaves are skipped */
+	for (; sbit + 7 <= ebit; sbit += 8) {
+		if (tagmap_sum[SUM2DIR(sbit)] == NULL) {
+			sbit |= ((size_t)1 << SUM_LEAF_SHIFT) - 8;
+			continue;
+		}
+		if (tag_sum_byte(sbit) != 0)
+			return 1;
+	}
+
+	/* tail */
+	for (; sbit <= ebit; sbit++)
+		if (tag_sum_byte(sbit) & (1U << (sbit & 7)))
+			return 1;
+
+	/* clean */
+	return 0;
+}
+
+/*
+ * check if a chunk of the address space is trivially clean; i.e., its
+ * summary unit is clear or it is shadowed by null_seg/zero_seg
+ *
+ * @addr:	the virtual address
+ */
+static inline int
+tag_chunk_clean(size_t addr)
+{
+	size_t	seg = STAB_SEG(VIRT2STAB(addr));
+
+	return (tag_sum_byte(VIRT2SUM(addr)) &
+			(1U << (VIRT2SUM(addr) & 7))) == 0 ||
+		seg == (size_t)null_seg || seg == (size_t)zero_seg;
+}
+
+/*
+ * get the number of bytes, starting from the given virtual address,
+ * up to the end of its chunk (i.e., summary unit), bounded by num
+ *
+ * @addr:	the virtual address
+ * @num:	the number of bytes
+ */
+static inline size_t
+tag_chunk_len(size_t addr, size_t num)
+{
+	size_t	n = SUM_SZ - (addr & (SUM_SZ - 1));
+
+	return (n < num) ? n : num;
+}
+
+/*
+ * find the first non-zero byte in a contiguous
+ * tagmap range; a word at a time
+ *
+ * @tags:	the tag bytes
+ * @num:	the number of tag bytes
+ *
+ * returns:	the offset of the first non-zero byte, or num
+ */
+static size_t
+tag_scan(const uint8_t *tags, size_t num)
+{
+	size_t	i = 0;	/* iterator */
+
+	/* head; up to the next word */
+	for (; i < num && ((size_t)&tags[i] & (sizeof(size_t) - 1)) != 0; i++)
+		if (tags[i] != TAG_ZERO)
+			return i;
+
+	/* whole words; unrolled */
+	for (; i + (sizeof(size_t) << 2) <= num; i += sizeof(size_t) << 2)
+		if ((*(const size_t *)&tags[i] |
+			*(const size_t *)&tags[i + sizeof(size_t)] |
+			*(const size_t *)&tags[i + (sizeof(size_t) << 1)] |
+			*(const size_t *)&tags[i + 3 * sizeof(size_t)]) != 0)
+			break;
+	for (; i + sizeof(size_t) <= num; i += sizeof(size_t))
+		if (*(const size_t *)&tags[i] != 0)
+			break;
+
+	/* tail (or the non-zero word) */
+	for (; i < num; i++)
+		if (tags[i] != TAG_ZERO)
+			return i;
+
+	/* clean */
+	return num;
+}
+
+/*
+ * find the first tainted byte in a chunk
+ * (i.e., inside a single page)
+ *
+ * @addr:	the virtual address
+ * @num:	the number of bytes
+ *
+ * returns:	the offset of the first tainted byte, or num
+ */
+static size_t
+tag_chunk_firstn(size_t addr, size_t num)
+{
+#ifdef	TAGMAP_1BIT
+	size_t		i = 0, j, n;	/* iterators	*/
+	uint32_t	bits;		/* tag bits	*/
+	const uint8_t	*tags;		/* tag bytes	*/
+
+	/* head; up to the next tag byte */
+	if (VIRT2BIT(addr) != 0) {
+		n	= 8 - VIRT2BIT(addr);
+		n	= (n < num) ? n : num;
+		if ((bits = tag_ldbits(addr, n)) != 0)
+			return __builtin_ctz(bits);
+		i	= n;
+	}
+
+	/* whole tag bytes */
+	if ((n = (num - i) >> 3) > 0) {
+		tags = (const uint8_t *)VIRT2TAG(addr + i);
+		if ((j = tag_scan(tags, n)) < n)
+			return i + (j << 3) + __builtin_ctz(tags[j]);
+		i += n << 3;
+	}
+
+	/* tail */
+	if (i < num && (bits = tag_ldbits(addr + i, num - i)) != 0)
+		return i + __builtin_ctz(bits);
+
+	/* clean */
+	return num;
+#elif	defined(TAGMAP_LABEL)
+	/* scan the labels as bytes */
+	return tag_scan((const uint8_t *)VIRT2TAG(addr), TAG_SEG_SZ(num)) >> 2;
+#else
+	return tag_scan((const uint8_t *)VIRT2TAG(addr), num);
+#endif
+}
+
+/*
+ * check if any of an arbitrary number of bytes
+ * in the virtual address space is tainted
+ *
+ * @addr:	the virtual address
+ * @num:	the number of bytes
+ *
+ * returns:	1 if (some of) the bytes are tainted, 0 otherwise
+ */
+int
+tagmap_anyn(size_t addr, size_t num)
+{
+	return tagmap_firstn(addr, num) < num;
+}
+
+/*
+ * find the first tainted byte among an arbitrary number
+ * of bytes in the virtual address space
+ *
+ * the range is processed one chunk (i.e., summary unit) at a
+ * time, and chunks that are known to be clean are skipped
+ *
+ * @addr:	the virtual address
+ * @num:	the number of bytes
+ *
+ * returns:	the offset of the first tainted byte, or num if
+ * 		all the bytes are clean
+ */
+size_t
+tagmap_firstn(size_t addr, size_t num)
+{
+	size_t	off, n, i;	/* iterators */
+
+	for (off = 0; off < num; off += n) {
+		n = tag_chunk_len(addr + off, num - off);
+
+		/* clean chunk; optimized branch */
+		if (likely(tag_chunk_clean(addr + off)))
+			continue;
+
+		/* scan the tags */
+		if ((i = tag_chunk_firstn(addr + off, n)) < n)
+			return off + i;
+	}
+
+	/* clean */
+	return num;
+}
+
+/*
+ * get the union (OR) of the tags of an arbitrary
+ * number of bytes in the virtual address space
+ *
+ * @addr:	the virtual address
+ * @num:	the number of bytes
+ *
+ * returns:	the tag of the range (TAG_ZERO if clean)
+ */
+uint8_t
+tagmap_orn(size_t addr, size_t num)
+{
+#if	defined(TAGMAP_1BIT) || defined(TAGMAP_LABEL)
+	/* one color (see tagmap_lbl_orn()); the first tainted byte suffices */
+	return (tagmap_firstn(addr, num) < num) ? TAG_BIT : TAG_ZERO;
+#else
+	size_t		off, n, i;	/* iterators		*/
+	size_t		word;		/* tags of a word	*/
+	uint8_t		tag = TAG_ZERO;	/* tag of the range	*/
+	const uint8_t	*tags;		/* tag bytes		*/
+
+	for (off = 0; off < num && tag != TAG_ALL8; off += n) {
+		n = tag_chunk_len(addr + off, num - off);
+
+		/* clean chunk; optimized branch */
+		if (likely(tag_chunk_clean(addr + off)))
+			continue;
+
+		/* skip the clean prefix */
+		tags	= (const uint8_t *)VIRT2TAG(addr + off);
+		i	= tag_scan(tags, n);
+
+		/* head; up to the next word */
+		for (; i < n && ((size_t)&tags[i] & (sizeof(size_t) - 1)) != 0;
+				i++)
+			tag |= tags[i];
+
+		/* whole words */
+		for (word = 0; i + sizeof(size_t) <= n; i += sizeof(size_t))
+			word |= *(const size_t *)&tags[i];
+
+		/* tail */
+		for (; i < n; i++)
+			tag |= tags[i];
+
+		/* fold the words */
+		for (i = sizeof(size_t) << 2; i >= 8; i >>= 1)
+			word |= word >> i;
+		tag	|= (uint8_t)word;
+	}
+
+	/* return the tag */
+	return tag;
+#endif
+}
+
+/*
+ * invoke a callback for every (possibly) tainted summary unit
+ *
+ * only the summary of the address space that is covered by private
+ * STAB leaves is scanned; the rest maps to null_seg/zero_seg, and
+ * hence it is always clean
+ *
+ * @fn:		the callback; it gets the address of the unit and
+ * 		it may clear the summary bit of that unit
+ */
+static void
+sum_walk(void (* fn)(size_t))
+{
+	size_t	dindx;			/* STAB directory offset	*/
+	size_t	sbyte;			/* summary byte of a leaf	*/
+	size_t	bit;			/* summary bit			*/
+	uint8_t	*leaf;			/* summary leaf			*/
+	uint8_t	bits;			/* summary byte			*/
+
+	for (dindx = stab_leaf_next(0); dindx < STAB_DIR_SIZE;
+			dindx = stab_leaf_next(dindx + 1)) {
+		/* the summary leaf that covers the STAB leaf; clean if missing */
+		if ((leaf = tagmap_sum[dindx]) == NULL)
+			continue;
+
+		for (sbyte = 0; sbyte < SUM_LEAF_SZ; sbyte++) {
+			/* clean; optimized branch */
+			if (likely((bits = leaf[sbyte]) == 0))
+				continue;
+
+			/* visit the set bits */
+			for (; bits != 0; bits &= bits - 1) {
+				bit = (dindx << SUM_LEAF_SHIFT) +
+					(sbyte << 3) + __builtin_ctz(bits);
+				fn((size_t)bit << TAGMAP_SUM_SHIFT);
+			}
+		}
+	}
+}
+
+/*
+ * save the tags of a summary unit (see tagmap_checkpoint())
+ *
+ * @addr:	the virtual address of the unit
+ */
+static void
+ckpt_save(size_t addr)
+{
+	size_t	seg	= STAB_SEG(VIRT2STAB(addr));
+	size_t	nmax;	/* new capacity	*/
+	size_t	*naddr;	/* new addresses	*/
+	uint8_t	*ntags;	/* new tags	*/
+
+	/* shared segment; clean */
+	if (seg == (size_t)null_seg || seg == (size_t)zero_seg)
+		return;
+
+	/* grow the checkpoint */
+	if (unlikely(ckpt_num == ckpt_max)) {
+		nmax	= (ckpt_max == 0) ? PAGE_SZ : ckpt_max << 1;
+		naddr	= (size_t *)realloc(ckpt_addr, nmax * sizeof(size_t));
+		if (naddr != NULL)
+			ckpt_addr = naddr;
+		ntags	= (uint8_t *)realloc(ckpt_tags, nmax * SUM_TAG_SZ);
+		if (ntags != NULL)
+			ckpt_tags = ntags;
+
+		/* optimized branch */
+		if (unlikely(naddr == NULL || ntags == NULL)) {
+			/* error message */
+			LOG(string(__func__) +
+				": checkpoint allocation failed (" +
+				string(strerror(errno)) + ")\n");
+
+			/* die */
+			libdft_die();
+			return;
+		}
+		ckpt_max = nmax;
+	}
+
+	/* save the unit */
+	ckpt_addr[ckpt_num] = addr;
+	(void)memcpy(&ckpt_tags[ckpt_num * SUM_TAG_SZ],
+			(void *)VIRT2TAG(addr), SUM_TAG_SZ);
+	ckpt_num++;
+}
+
+/*
+ * clear the tags and the summary bit of a summary
+ * unit (see tagmap_reset_to_checkpoint())
+ *
+ * @addr:	the virtual address of the unit
+ */
+static void
+ckpt_clear(size_t addr)
+{
+	size_t	seg	= STAB_SEG(VIRT2STAB(addr));
+
+	/* clear the tags (if any) */
+	if (seg != (size_t)null_seg && seg != (size_t)zero_seg)
+		(void)memset((void *)VIRT2TAG(addr), TAG_ZERO, SUM_TAG_SZ);
+
+	/* clear the summary bit (see sum_fill()) */
+	sum_fill(VIRT2SUM(addr), VIRT2SUM(addr), 0);
+}
+
+/*
+ * take a checkpoint of the tagmap and the register tags
+ *
+ * the tags of every summary unit that may be tainted are saved;
+ * units whose summary bit is clear are clean, and they do not
+ * need to be saved. The cost is proportional to the tainted units
+ *
+ * returns:	0 on success, 1 on error
+ */
+int
+tagmap_checkpoint(void)
+{
+	/* drop the previous checkpoint */
+	ckpt_num = 0;
+
+	/* save the (possibly) tainted units */
+	sum_walk(ckpt_save);
+
+	/* save the register tags */
+	return thread_ctx_checkpoint();
+}
+
+/*
+ * reset the tagmap and the register tags to the last checkpoint
+ *
+ * a unit can differ from its checkpoint only if it was tainted at
+ * the checkpoint (i.e., saved), or it has been tainted since (i.e.,
+ * its summary bit is set). Hence, the (possibly) tainted units are
+ * cleared, and the saved ones are restored; the cost is proportional
+ * to the units that were tainted at or after the checkpoint.
+ *
+ * the address space layout is not restored; saved units that are
+ * no longer mapped are skipped. It must be invoked while the rest
+ * of the application threads are not running (e.g., from a syscall
+ * hook of a single-threaded application)
+ */
+void
+tagmap_reset_to_checkpoint(void)
+{
+	size_t	i;	/* iterator	*/
+	size_t	seg;	/* segment	*/
+
+	/* clear the (possibly) tainted units */
+	sum_walk(ckpt_clear);
+
+	/* restore the saved units */
+	for (i = 0; i < ckpt_num; i++) {
+		seg = STAB_SEG(VIRT2STAB(ckpt_addr[i]));
+
+		/* no longer mapped, or read-only */
+		if (seg == (size_t)null_seg || seg == (size_t)zero_seg)
+			continue;
+
+		(void)memcpy((void *)VIRT2TAG(ckpt_addr[i]),
+				&ckpt_tags[i * SUM_TAG_SZ], SUM_TAG_SZ);
+		tag_sum_set(ckpt_addr[i], 1);
+	}
+
+	/* restore the register tags */
+	thread_ctx_reset();
+}
+
+/*
+ * write a buffer to the dump file
+ *
+ * @buf:	the buffer
+ * @len:	the number of bytes
+ * @off:	the file offset
+ *
+ * returns:	0 on success, 1 on error
+ */
+static int
+dump_pwrite(const void *buf, size_t len, uint64_t off)
+{
+	ssize_t	n;	/* bytes written */
+
+	while (len > 0) {
+		if (unlikely((n = pwrite64(dump_fd, buf, len, off)) <= 0)) {
+			/* retry */
+			if (n < 0 && errno == EINTR)
+				continue;
+
+			/* error message */
+			LOG(string(__func__) + ": write failed (" +
+				string(strerror(errno)) + ")\n");
+
+			/* failed */
+			return 1;
+		}
+		buf	= (const uint8_t *)buf + n;
+		len	-= n;
+		off	+= n;
+	}
+
+	/* success */
+	return 0;
+}
+
+/*
+ * write a buffer that is not page aligned (e.g., a table) to the dump
+ * file; it is padded and bounced through a page aligned buffer, since
+ * the dump file may be opened with O_DIRECT
+ *
+ * @buf:	the buffer
+ * @len:	the number of bytes
+ * @off:	the file offset (page aligned)
+ *
+ * returns:	0 on success, 1 on error
+ */
+static int
+dump_bounce(const void *buf, size_t len, uint64_t off)
+{
+	size_t	plen	= PAGE_ALIGN(len + PAGE_SZ - 1);	/* padded */
+	void	*page;						/* bounce */
+	int	ret;
+
+	/* nothing to write */
+	if (plen == 0)
+		return 0;
+
+	if (unlikely((page = mmap(NULL, plen,
+			/* RW- */
+			PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS,
+			-1, 0)) == MAP_FAILED)) {
+		/* error message */
+		LOG(string(__func__) + ": buffer allocation failed (" +
+			string(strerror(errno)) + ")\n");
+
+		/* failed */
+		return 1;
+	}
+
+	(void)memcpy(page, buf, len);
+	ret = dump_pwrite(page, plen, off);
+	(void)munmap(page, plen);
+
+	return ret;
+}
+
+/*
+ * flush the pending run of a dump
+ *
+ * returns:	0 on success, 1 on error
+ */
+static int
+dump_flush(void)
+{
+	int	ret = dump_pwrite((void *)dump_rstart, dump_rend - dump_rstart,
+				dump_roff);
+
+	dump_roff	+= dump_rend - dump_rstart;
+	dump_rstart	= dump_rend = 0;
+
+	return ret;
+}
+
+/*
+ * add a range of memory (e.g., the tags of a page) to a dump; whole
+ * pages are written, straight from the tagmap (i.e., without copying
+ * them), and the pages that are contiguous are coalesced into a single
+ * write. Pages that are already in the pending run are not added again
+ * (e.g., with TAGMAP_1BIT a tagmap page holds the tags of 8 pages)
+ *
+ * @addr:	the first byte
+ * @len:	the number of bytes
+ * @off:	the file offset of the first byte
+ *
+ * returns:	0 on success, 1 on error
+ */
+static int
+dump_put(size_t addr, size_t len, uint64_t *off)
+{
+	size_t	start	= PAGE_ALIGN(addr);			/* first page */
+	size_t	end	= PAGE_ALIGN(addr + len + PAGE_SZ - 1);	/* end */
+
+	/* not contiguous with the pending run */
+	if (start < dump_rstart || start > dump_rend) {
+		if (unlikely(dump_flush() != 0))
+			return 1;
+		dump_rstart = dump_rend = start;
+	}
+
+	/* extend the pending run */
+	if (end > dump_rend)
+		dump_rend = end;
+
+	*off = dump_roff + (addr - dump_rstart);
+
+	/* success */
+	return 0;
+}
+
+/*
+ * check if the tags of a page changed since the previous dump; i.e., if
+ * any of the tagmap pages that hold them was written (soft-dirty), or
+ * discarded (e.g., with madvise(2))
+ *
+ * @seg:	the tagmap segment of the page
+ *
+ * returns:	1 if it changed (or if unknown), 0 otherwise
+ */
+static int
+dump_changed(size_t seg)
+{
+	size_t		page;	/* tagmap page		*/
+	size_t		indx;	/* pagemap entry	*/
+	uint64_t	pm;	/* pagemap entry	*/
+
+	for (page = PAGE_ALIGN(seg); page < seg + TAG_PAGE_SZ;
+			page += PAGE_SZ) {
+		indx = VIRT2STAB(page);
+
+		/* read the pagemap entries around the page */
+		if (indx < pm_first || indx >= pm_first + PM_CACHE) {
+			pm_first = indx & ~(PM_CACHE - 1);
+			if (unlikely(pread64(pm_fd, pm_cache, sizeof(pm_cache),
+				(off64_t)pm_first * sizeof(uint64_t)) !=
+					(ssize_t)sizeof(pm_cache))) {
+				pm_first = (size_t)-1;
+				return 1;
+			}
+		}
+		pm = pm_cache[indx - pm_first];
+
+		/* written, or discarded */
+		if ((pm & PM_SOFT_DIRTY) != 0 ||
+				(pm & (PM_PRESENT | PM_SWAP)) == 0)
+			return 1;
+	}
+
+	/* the same */
+	return 0;
+}
+
+/*
+ * reset the soft-dirty bits of the address space, so that the next
+ * incremental dump can find the tagmap pages that are written after
+ * this dump (see clear_refs in proc(5))
+ */
+static void
+dump_clear_refs(void)
+{
+	int	fd;	/* /proc/self/clear_refs */
+
+	/* open the pagemap; the first time */
+	if (pm_fd < 0 && dump_sd)
+		pm_fd = open("/proc/self/pagemap", O_RDONLY);
+
+	if (pm_fd < 0 || (fd = open("/proc/self/clear_refs", O_WRONLY)) < 0) {
+		dump_sd = 0;
+		return;
+	}
+	if (write(fd, "4", 1) != 1)
+		dump_sd = 0;
+	(void)close(fd);
+
+	/* drop the cached entries */
+	pm_first = (size_t)-1;
+}
+
+/*
+ * dump the tagmap to a file (see tagmap_dump_hdr_t)
+ *
+ * only the pages that may be tainted (see tagmap_sumn()), and whose tags
+ * differ from zero_seg are dumped; their tags are written straight from
+ * the tagmap, with page aligned writes (O_DIRECT if the file system
+ * supports it), and hence the cost is proportional to the tainted pages.
+ * An incremental dump holds only the pages that changed since the
+ * previous one; the tagmap pages that are written in the meantime are
+ * tracked by the kernel (soft-dirty bits), without any instrumentation
+ * overhead. A full dump is taken instead if there is no previous dump,
+ * or if soft-dirty bits are not supported (e.g., with hugetlb pages).
+ * The register tags are not dumped.
+ *
+ * like tagmap_checkpoint(), it must be invoked while the rest of the
+ * application threads are not running
+ *
+ * @path:	the dump file
+ * @incr:	1 for an incremental dump, 0 for a full one
+ *
+ * returns:	0 on success, 1 on error
+ */
+int
+tagmap_dump(const char *path, int incr)
+{
+	tagmap_dump_hdr_t		hdr;	/* header		*/
+	vector<tagmap_dump_range_t>	rng;	/* shadowed ranges	*/
+	vector<tagmap_dump_page_t>	idx;	/* page index		*/
+	vector<dump_page_t>		cur;	/* non-clean pages	*/
+	tagmap_dump_range_t		r;	/* range		*/
+	tagmap_dump_page_t		p;	/* index entry		*/
+	dump_page_t			d;	/* non-clean page	*/
+	size_t	dindx, indx;			/* STAB offsets		*/
+	size_t	seg;				/* tagmap segment	*/
+	size_t	i, j;				/* iterators		*/
+
+	/* open the dump file; O_DIRECT is optional */
+	if ((dump_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT,
+					0644)) < 0 && errno == EINVAL)
+		dump_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (unlikely(dump_fd < 0)) {
+		/* error message */
+		LOG(string(__func__) + ": failed while trying to open " +
+			string(path) + " (" + string(strerror(errno)) + ")\n");
+
+		/* failed */
+		return 1;
+	}
+
+	/* incremental; only if it can be (optimized branch) */
+	incr = incr && dump_seq != 0 && dump_sd && pm_fd >= 0 &&
+		huge_policy != TAGMAP_HUGE_HUGETLB;
+
+	/* the header */
+	(void)memset(&hdr, 0, sizeof(hdr));
+	hdr.magic	= TAGMAP_DUMP_MAGIC;
+	hdr.version	= TAGMAP_DUMP_VERSION;
+	hdr.tag_page_sz	= TAG_PAGE_SZ;
+	hdr.seq		= dump_seq + 1;
+	hdr.flags	= (incr) ? TAGMAP_DUMP_INCR : 0;
+#ifdef	TAGMAP_1BIT
+	hdr.flags	|= TAGMAP_DUMP_1BIT;
+#endif
+#ifdef	TAGMAP_LABEL
+	hdr.flags	|= TAGMAP_DUMP_LABEL;
+#endif
+
+	/* the data follow the header page */
+	dump_rstart = dump_rend = 0;
+	dump_roff	= PAGE_SZ;
+
+	/* scan the shadowed address space */
+	r.start = r.end = r.flags = 0;
+	for (dindx = stab_leaf_next(0); dindx < STAB_DIR_SIZE;
+			dindx = stab_leaf_next(dindx + 1)) {
+		for (indx = dindx << STAB_LEAF_SHIFT;
+			indx < (dindx + 1) << STAB_LEAF_SHIFT; indx++) {
+			/* unmapped */
+			if ((seg = STAB_SEG(indx)) == (size_t)null_seg)
+				continue;
+
+			/* the shadowed range */
+			if (r.end != STAB2VIRT(indx) ||
+				r.flags != (uint64_t)((seg == (size_t)zero_seg) ?
+					TAGMAP_DUMP_RO : 0)) {
+				if (r.end != 0)
+					rng.push_back(r);
+				r.start	= STAB2VIRT(indx);
+				r.flags	= (seg == (size_t)zero_seg) ?
+						TAGMAP_DUMP_RO : 0;
+			}
+			r.end = (uint64_t)STAB2VIRT(indx) + PAGE_SZ;
+
+			/* clean; optimized branch */
+			if (likely(seg == (size_t)zero_seg ||
+				tagmap_sumn(STAB2VIRT(indx), PAGE_SZ) == 0 ||
+				memcmp((void *)seg, zero_seg,
+					TAG_PAGE_SZ) == 0))
+				continue;
+
+			d.vaddr	= STAB2VIRT(indx);
+			d.seg	= seg;
+			cur.push_back(d);
+		}
+	}
+	if (r.end != 0)
+		rng.push_back(r);
+
+	/* the non-clean pages that changed; merged with the previous dump */
+	for (i = j = 0; i < cur.size() || (incr && j < dump_prev.size());) {
+		/* became clean (or unmapped) */
+		if (incr && j < dump_prev.size() && (i == cur.size() ||
+				dump_prev[j].vaddr < cur[i].vaddr)) {
+			p.vaddr	= dump_prev[j++].vaddr;
+			p.off	= 0;
+			idx.push_back(p);
+			continue;
+		}
+
+		/* non-clean in the previous dump; skip it if it is the same */
+		if (incr && j < dump_prev.size() &&
+				dump_prev[j].vaddr == cur[i].vaddr &&
+				dump_prev[j++].seg == cur[i].seg &&
+				dump_changed(cur[i].seg) == 0) {
+			i++;
+			continue;
+		}
+
+		/* the tags */
+		p.vaddr	= cur[i].vaddr;
+		if (unlikely(dump_put(cur[i].seg, TAG_PAGE_SZ, &p.off) != 0))
+			goto err;
+		idx.push_back(p);
+		i++;
+	}
+	if (unlikely(dump_flush() != 0))
+		goto err;
+
+#ifdef	TAGMAP_LABEL
+	/* the label rows; the table is append-only */
+	hdr.lbl_first	= PAGE_ALIGN(((incr) ? dump_lbl : 0) *
+				sizeof(*lbl_tab)) / sizeof(*lbl_tab);
+	hdr.nlbls	= ((lbl_next < TAG_LBL_ALL) ? lbl_next : TAG_LBL_ALL) -
+				hdr.lbl_first;
+	if (unlikely(dump_put((size_t)lbl_tab[hdr.lbl_first],
+				hdr.nlbls * sizeof(*lbl_tab),
+				&hdr.lbl_off) != 0 || dump_flush() != 0))
+		goto err;
+#endif
+
+	/* the tables, and the header */
+	hdr.range_off	= dump_roff;
+	hdr.nranges	= rng.size();
+	hdr.page_off	= PAGE_ALIGN(hdr.range_off +
+				rng.size() * sizeof(r) + PAGE_SZ - 1);
+	hdr.npages	= idx.size();
+	if (unlikely(
+		(rng.size() > 0 && dump_bounce(&rng[0],
+			rng.size() * sizeof(r), hdr.range_off) != 0)	||
+		(idx.size() > 0 && dump_bounce(&idx[0],
+			idx.size() * sizeof(p), hdr.page_off) != 0)	||
+		dump_bounce(&hdr, sizeof(hdr), 0) != 0))
+		goto err;
+
+	/* cleanup */
+	(void)close(dump_fd);
+
+	/* the next dump builds on this one */
+	dump_prev.swap(cur);
+	dump_seq++;
+#ifdef	TAGMAP_LABEL
+	dump_lbl = hdr.lbl_first + hdr.nlbls;
+#endif
+	dump_clear_refs();
+
+	/* success */
+	return 0;
+
+err:	/* error handling */
+	(void)close(dump_fd);
+
+	/* return with failure */
+	return 1;
+}
+
+/* tainted pages per region kind (see acct_tainted()) */
+static size_t	acct_page;
+
+/*
+ * count a (possibly) tainted summary unit (see tagmap_acct())
+ *
+ * @addr:	the virtual address of the unit
+ */
+static void
+acct_tainted(size_t addr)
+{
+	size_t	seg	= STAB_SEG(VIRT2STAB(addr));
+
+	/* same page as the previous unit */
+	if (PAGE_ALIGN(addr) == acct_page)
+		return;
+	acct_page = PAGE_ALIGN(addr);
+
+	/* shared segment; clean */
+	if (seg == (size_t)null_seg || seg == (size_t)zero_seg)
+		return;
+
+	kind_acct[ptab_get(page_kind, VIRT2STAB(seg)) & KIND_MASK].tainted++;
+}
+
+/*
+ * get the tagmap usage
+ *
+ * the tainted page counts are computed with a scan of the
+ * taint summary (see sum_walk()); the rest are maintained
+ * on every tagmap segment (de)allocation
+ *
+ * @usage:	TAGMAP_KIND_NUM counters; indexed by region kind
+ */
+void
+tagmap_acct(tagmap_acct_t *usage)
+{
+	size_t	i;	/* iterator */
+
+	/* count the tainted pages */
+	for (i = 0; i < TAGMAP_KIND_NUM; i++)
+		kind_acct[i].tainted = 0;
+	acct_page = 1;
+	sum_walk(acct_tainted);
+
+	(void)memcpy(usage, kind_acct, sizeof(kind_acct));
+}
+
+/*
+ * log the tagmap usage; one line per region kind
+ */
+void
+tagmap_acct_report(void)
+{
+	tagmap_acct_t	usage[TAGMAP_KIND_NUM];	/* counters	*/
+	size_t		total = 0;		/* total bytes	*/
+	size_t		i;			/* iterator	*/
 
-#ifdef DEBUG_MEMTRACK
-		/* verbose */
-		LOG(string(__func__) + ": kernel range " + hexstr(KERN_START) + "-" + hexstr(KERN_END) + ": zero_seg\n");
-		LOG(string(__func__) + ": zero_seg is " +hexstr(zero_seg) + "\n");
-		LOG(string(__func__) + ": null_seg is " +hexstr(null_seg) + "\n");
-#endif
+	/* get the counters */
+	tagmap_acct(usage);
 
-	/* 
-	 * the lower 3G of the address space are considered unmapped, and
-	 * hence they translate to null_seg (i.e., reading/writing from an
-	 * unmapped address will fail)
-	 */
-	for (i = VIRT2STAB(USER_START); i <= VIRT2STAB(USER_END); i++)
-		STAB[i] = (uint32_t)null_seg - STAB2VIRT(i);
+	for (i = TAGMAP_KIND_NONE + 1; i < TAGMAP_KIND_NUM; i++) {
+		LOG(string(__func__) + ": " + string(kind_name[i]) + ": " +
+			decstr(usage[i].segs) + " segments, " +
+			decstr(usage[i].bytes) + " bytes (peak: " +
+			decstr(usage[i].peak) + "), " +
+			decstr(usage[i].tainted) + " tainted pages\n");
+		total += usage[i].bytes;
+	}
 
-#ifdef DEBUG_MEMTRACK
-		/* verbose */
-		LOG(string(__func__) + ": user range " + hexstr(USER_START) + "-" + hexstr(USER_END) + ": null_seg\n");
+	LOG(string(__func__) + ": total: " + decstr(total) +
+		" bytes, STAB: " + decstr(stab_bytes()) +
+		" bytes (" + decstr(stab_leaves) + " leaves), summary and "
+		"page tables: " + decstr(sparse_bytes) + " bytes\n");
+
+#ifdef	TAGMAP_LABEL
+	/* labels */
+	LOG(string(__func__) + ": labels: " +
+		decstr((lbl_next < TAG_LBL_ALL) ? lbl_next - 1 : TAG_LBL_ALL) +
+		" (max: " + decstr(TAG_LBL_ALL - 1) + ")\n");
 #endif
 
+	/* huge pages */
+	if (huge_policy != TAGMAP_HUGE_NONE)
+		huge_report();
 
-	/* try to get the vDSO address */
-	get_vdso(&vdso_start, &vdso_end);
-		
-	/* check if we have the vDSO mapped */
-	if (likely(vdso_start != 0)) {
-		/* STAB setup */	
-		for (i = VIRT2STAB(vdso_start);
-				i <= VIRT2STAB(vdso_end - 1); i++)
-			STAB[i] = (uint32_t)zero_seg - STAB2VIRT(i);
-#ifdef DEBUG_MEMTRACK
-		/* verbose */
-		LOG(string(__func__) + ": mapping vDSO sections " +
-			hexstr(vdso_start) + "-" + 
-			hexstr(vdso_end - 1) + " [" +
-			hexstr(STAB[VIRT2STAB(vdso_start)] +
-			       vdso_start) + "-" +
-			hexstr(STAB[VIRT2STAB(vdso_end - 1)] + 
-					vdso_end - 1) + "]\n");
-#endif
-	}
+	/* lazy segments */
+	if (lazy_state != NULL)
+		lazy_report();
+}
 
-		LOG(string(__func__) +
-			": tagmap allocation went ok. hooking elf_load");
-	
-	/* register the ELF image load callback */
-	IMG_AddInstrumentFunction(elf_load, NULL);
-	
-	/* return with success */
-	return 0;
 
-err:	/* error handling */
-	
-	/* cleanup */
-	if (STAB != NULL)
-		/* deallocate the STAB space */
-		(void)munmap(STAB, len);
-	if (zero_seg != NULL)
-		/* deallocate the zero segment space */
-		(void)munmap(zero_seg, PAGE_SZ);
-	if (null_seg != NULL)
-		/* deallocate the null segment space */
-		(void)munmap(null_seg, PAGE_SZ);
+#ifdef	TAGMAP_LABEL
+/*
+ * allocate a label (see lbl_tab)
+ *
+ * returns:	the new label, or TAG_LBL_ALL if the table is full
+ */
+static uint32_t
+lbl_alloc(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+	uint32_t	lbl;	/* the new label */
 
-	/* return with failure */
-	return 1;
+	/* full; optimized branch */
+	if (unlikely(lbl_next >= TAG_LBL_ALL ||
+		(lbl = __sync_fetch_and_add(&lbl_next, 1)) >= TAG_LBL_ALL)) {
+		/* issue a warning (once) */
+		if (__sync_bool_compare_and_swap(&lbl_full, 0, 1))
+			LOG(string(__func__) + ": label table is full\n");
+		return TAG_LBL_ALL;
+	}
+
+	lbl_tab[lbl][0]	= a;
+	lbl_tab[lbl][1]	= b;
+	lbl_tab[lbl][2]	= c;
+	lbl_tab[lbl][3]	= d;
+
+	return lbl;
 }
 
 /*
- * tag a byte in the virtual address space
+ * look up (or insert) a union or a range label in lbl_hash
  *
- * @addr:	the virtual address
- * @color:	the tag value
+ * the hash is updated without locking; a label that
+ * loses an insertion race is never published, and it
+ * stays unused
+ *
+ * returns:	the label, or TAG_LBL_ALL if the table is full
  */
-void PIN_FAST_ANALYSIS_CALL
-tagmap_setb(size_t addr, uint8_t color)
+static uint32_t
+lbl_intern(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
 {
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "tagmap_setb(0x%x, 0x%02x): *(uint8_t *)(0x%x + STAB[0x%x]) = 0x%02x; STAB[0x%x] == 0x%x -> *(uint8_t *)(0x%x) = 0x%02x\n",
-			 addr, color, addr, VIRT2STAB(addr), color, VIRT2STAB(addr), STAB[VIRT2STAB(addr)], (addr + STAB[VIRT2STAB(addr)]), color);
-	fprintf(stderr, "STAB page is %x\n", (addr + STAB[VIRT2STAB(addr)]));
-	if((PAGE_ALIGN(addr) + STAB[VIRT2STAB(addr)]) == (uint32_t) zero_seg) { 
-		fprintf(stderr, "WARNING: holy shit setb to zero_seg\n");
+	uint32_t	h;			/* slot			*/
+	uint32_t	lbl;			/* current label	*/
+	uint32_t	nlbl	= TAG_ZERO;	/* new label		*/
+
+	for (h = LBL_HASH(a, b, c, d);; h = (h + 1) & (LBL_HASH_SZ - 1)) {
+		/* free slot; insert a new label */
+		if ((lbl = lbl_hash[h]) == TAG_ZERO) {
+			if (nlbl == TAG_ZERO &&
+				(nlbl = lbl_alloc(a, b, c, d)) == TAG_LBL_ALL)
+				return TAG_LBL_ALL;
+			if (__sync_bool_compare_and_swap(&lbl_hash[h],
+						TAG_ZERO, nlbl))
+				return nlbl;
+			lbl = lbl_hash[h];
+		}
+
+		/* hit */
+		if (lbl_tab[lbl][0] == a && lbl_tab[lbl][1] == b &&
+			lbl_tab[lbl][2] == c && lbl_tab[lbl][3] == d)
+			return lbl;
 	}
-#endif
-	/* tag the byte that corresponds to the given address */
-	*(uint8_t *)(addr + STAB[VIRT2STAB(addr)]) = color;
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "set done\n");
-#endif
 }
 
 /*
- * untag a byte in the virtual address space
+ * get the input range of a provenance label
  *
- * @addr:	the virtual address
+ * @lbl:	the label
+ * @src:	the input source
+ * @start:	the first offset
+ * @end:	the last offset
+ *
+ * returns:	1 if lbl is a provenance (or range) label, 0 otherwise
  */
-void PIN_FAST_ANALYSIS_CALL
-tagmap_clrb(size_t addr)
+static inline int
+lbl_range(uint32_t lbl, uint32_t *src, uint32_t *start, uint32_t *end)
 {
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "tagmap_clrb(0x%x): *(uint8_t *)(0x%x + STAB[0x%x]) = TAG_ZERO; STAB[0x%x] == 0x%x -> *(uint8_t *)(0x%x) = TAG_ZERO\n",
-			 addr, addr, VIRT2STAB(addr), VIRT2STAB(addr), STAB[VIRT2STAB(addr)], (addr + STAB[VIRT2STAB(addr)]));
-	fprintf(stderr, "STAB page is %x\n", (addr + STAB[VIRT2STAB(addr)]));
-	if((PAGE_ALIGN(addr) + STAB[VIRT2STAB(addr)]) == (uint32_t) zero_seg) { 
-		fprintf(stderr, "WARNING: ignoring clrb to zero_seg\n");
-		return;
+	/* a single byte */
+	if (lbl & TAG_PROV) {
+		*src	= TAG_PROV_SRC(lbl);
+		*start	= *end = TAG_PROV_OFF(lbl);
+		return 1;
 	}
-#endif
-	/* clear the byte that corresponds to the given address */
-	*(uint8_t *)(addr + STAB[VIRT2STAB(addr)]) = TAG_ZERO;
+
+	/* a range */
+	if (lbl != TAG_LBL_ALL &&
+		lbl_tab[lbl][0] == TAG_ZERO && lbl_tab[lbl][1] != TAG_ZERO) {
+		*src	= TAG_PROV_SRC(lbl_tab[lbl][1]);
+		*start	= lbl_tab[lbl][2];
+		*end	= lbl_tab[lbl][3];
+		return 1;
+	}
+
+	return 0;
 }
 
 /*
- * get the tag value of a byte from the tagmap
+ * get the label of an input range
  *
- * @addr:	the virtual address
+ * single bytes (at offsets that fit in TAG_PROV_OFF_BITS) are
+ * encoded in the label; everything else is a range label
+ */
+static inline uint32_t
+lbl_prov(uint32_t src, uint32_t start, uint32_t end)
+{
+	if (start == end && start < TAG_PROV_OFF_MAX)
+		return TAG_PROV_LBL(src, start);
+
+	return lbl_intern(TAG_ZERO, TAG_PROV_LBL(src, 0), start, end);
+}
+
+/*
+ * get a new source label
  *
- * returns:	the tag value (e.g., 0, 1,...)
+ * returns:	the label, or TAG_LBL_ALL if the label table is full
  */
-uint8_t
-tagmap_getb(size_t addr)
+uint32_t
+tagmap_lbl_new(void)
 {
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "tagmap_getb(0x%x): return *(uint8_t *)(0x%x + STAB[0x%x]); STAB[0x%x] == 0x%x -> return *(uint8_t *)(0x%x)\n",
-			 addr, addr, VIRT2STAB(addr), VIRT2STAB(addr), STAB[VIRT2STAB(addr)], (addr + STAB[VIRT2STAB(addr)]));
-	fprintf(stderr, "STAB page is %x\n", (addr + STAB[VIRT2STAB(addr)]));
-#endif
-	/* get the byte that corresponds to the address */
-	return *(uint8_t *)(addr + STAB[VIRT2STAB(addr)]);
+	return lbl_alloc(TAG_ZERO, TAG_ZERO, TAG_ZERO, TAG_ZERO);
 }
 
 /*
- * tag a word (i.e., 2 bytes) in the virtual address space
+ * get the union of two labels (see tag_union())
  *
- * @addr:	the virtual address
- * @color:	the tag value
+ * overlapping (or adjacent) input ranges of the same source are
+ * folded into a single range, also when one of them is the child
+ * of a union; e.g., a checksum over an input buffer ends up with
+ * a single range label, instead of a chain of unions
+ *
+ * @a:		a label (not 0)
+ * @b:		a label (not 0)
+ *
+ * returns:	the union label
  */
-void PIN_FAST_ANALYSIS_CALL
-tagmap_setw(size_t addr, uint16_t color)
+uint32_t
+tagmap_lbl_union(uint32_t a, uint32_t b)
 {
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "tagmap_setw(0x%x)\n", addr);
-	fprintf(stderr, "STAB page is %x\n", (addr + STAB[VIRT2STAB(addr)]));
-	if((PAGE_ALIGN(addr) + STAB[VIRT2STAB(addr)]) == (uint32_t) zero_seg) { 
-		fprintf(stderr, "WARNING: holy shit setw to zero_seg\n");
+	uint32_t	t, i;			/* temporaries		*/
+	uint32_t	sa, xa, ya;		/* range of a		*/
+	uint32_t	sb, xb, yb;		/* range of b		*/
+
+	/* the same label (e.g., after folding a range) */
+	if (a == b)
+		return a;
+
+	/* any source; optimized branch */
+	if (unlikely(a == TAG_LBL_ALL || b == TAG_LBL_ALL))
+		return TAG_LBL_ALL;
+
+	/* input ranges; b is a range, if any of the two is */
+	if (lbl_range(a, &sa, &xa, &ya)) {
+		t	= a;
+		a	= b;
+		b	= t;
 	}
-#endif
-	/* tag the bytes that correspond to the addresses of the word */
-	*(uint16_t *)(addr + STAB[VIRT2STAB(addr)]) = color;
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "set done\n");
-#endif
+	if (lbl_range(b, &sb, &xb, &yb)) {
+		/* fold two ranges of the same source */
+		if (lbl_range(a, &sa, &xa, &ya)) {
+			if (sa == sb && xa <= yb + 1 && xb <= ya + 1)
+				return lbl_prov(sa,
+					(xa < xb) ? xa : xb,
+					(ya > yb) ? ya : yb);
+		}
+		/* fold a range into a child of a union */
+		else if (LBL_UNION(a))
+			for (i = 0; i < 2; i++)
+				if (lbl_range(lbl_tab[a][i], &sa, &xa, &ya) &&
+					sa == sb && xa <= yb + 1 &&
+					xb <= ya + 1)
+					return tagmap_lbl_union(
+						lbl_tab[a][i ^ 1],
+						lbl_prov(sa,
+							(xa < xb) ? xa : xb,
+							(ya > yb) ? ya : yb));
+	}
+
+	/* one of the two is a union that already includes the other */
+	if (LBL_UNION(a) && (lbl_tab[a][0] == b || lbl_tab[a][1] == b))
+		return a;
+	if (LBL_UNION(b) && (lbl_tab[b][0] == a || lbl_tab[b][1] == a))
+		return b;
+
+	/* order the pair */
+	if (a > b) {
+		t	= a;
+		a	= b;
+		b	= t;
+	}
+
+	return lbl_intern(a, b, TAG_ZERO, TAG_ZERO);
 }
 
 /*
- * untag a word (i.e., 2 bytes) in the virtual address space
+ * walk the union labels of a label, and collect the
+ * labels that are not unions (i.e., sources or ranges)
  *
- * @addr:	the virtual address
+ * every union label is visited once; the labels are
+ * hash-consed, and hence a label may be reached by
+ * more than one path
+ *
+ * @lbl:	the label
+ * @leaves:	the labels that are not unions (sorted)
  */
-void PIN_FAST_ANALYSIS_CALL
-tagmap_clrw(size_t addr)
+static void
+lbl_leaves(uint32_t lbl, vector<uint32_t> &leaves)
 {
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "tagmap_clrw(0x%x): *(uint16_t *)(0x%x + STAB[0x%x]) = TAG_ZERO; STAB[0x%x] == 0x%x -> *(uint16_t *)(0x%x) = TAG_ZERO\n",
-			 addr, addr, VIRT2STAB(addr), VIRT2STAB(addr), STAB[VIRT2STAB(addr)], (addr + STAB[VIRT2STAB(addr)]));
-	fprintf(stderr, "STAB page is %x\n", (PAGE_ALIGN(addr) + STAB[VIRT2STAB(addr)]));
-	if((PAGE_ALIGN(addr) + STAB[VIRT2STAB(addr)]) == (uint32_t) zero_seg) { 
-		fprintf(stderr, "WARNING: ignoring clrw to zero_seg\n");
-		return;
+	vector<uint32_t>	stack;	/* labels to visit	*/
+	vector<uint32_t>	seen;	/* visited unions	*/
+
+	if (lbl != TAG_ZERO)
+		stack.push_back(lbl);
+
+	/* walk the unions */
+	while (!stack.empty()) {
+		lbl = stack.back();
+		stack.pop_back();
+
+		/* source, range, or any source */
+		if (!LBL_UNION(lbl)) {
+			leaves.push_back(lbl);
+			continue;
+		}
+
+		/* visited union */
+		if (find(seen.begin(), seen.end(), lbl) != seen.end())
+			continue;
+		seen.push_back(lbl);
+
+		stack.push_back(lbl_tab[lbl][0]);
+		stack.push_back(lbl_tab[lbl][1]);
 	}
-#endif
-	/* clear the bytes that correspond to the addresses of the word */
-	*(uint16_t *)(addr + STAB[VIRT2STAB(addr)]) = TAG_ZERO;
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "tagmap_clrw done\n");
-#endif
+
+	/* a label may be reached more than once */
+	sort(leaves.begin(), leaves.end());
+	leaves.erase(unique(leaves.begin(), leaves.end()), leaves.end());
 }
 
 /*
- * get the tag value of a word (i.e., 2 bytes) from the tagmap
+ * get the source labels of a label
  *
- * @addr:	the virtual address
+ * @lbl:	the label
+ * @src:	the source labels (in ascending order)
+ * @max:	the size of src
  *
- * returns:	the tag value (e.g., 0, 1,...)
+ * returns:	the number of source labels (it may exceed max)
  */
-uint16_t
-tagmap_getw(size_t addr)
+size_t
+tagmap_lbl_sources(uint32_t lbl, uint32_t *src, size_t max)
 {
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "line %d: STAB page is %x, returning it\n", __LINE__, (addr + STAB[VIRT2STAB(addr)]));
-#endif
-	/* get the bytes that correspond to the addresses of the word */
-	return *(uint16_t *)(addr + STAB[VIRT2STAB(addr)]);
+	vector<uint32_t>	found;	/* source labels	*/
+	size_t			i;	/* iterator		*/
+
+	lbl_leaves(lbl, found);
+
+	for (i = 0; i < found.size() && i < max; i++)
+		src[i] = found[i];
+
+	return found.size();
+}
+
+/* order input ranges by source and offset */
+static bool
+range_cmp(const tagmap_range_t &a, const tagmap_range_t &b)
+{
+	return (a.src != b.src) ? a.src < b.src : a.start < b.start;
 }
 
 /*
- * tag a long word (i.e., 4 bytes) in the virtual address space
+ * get the input ranges of a label; overlapping or adjacent
+ * ranges of the same source are merged
  *
- * @addr:	the virtual address
- * @color:	the tag value
+ * @lbl:	the label
+ * @range:	the input ranges (ordered by source and offset)
+ * @max:	the size of range
+ *
+ * returns:	the number of ranges (it may exceed max)
  */
-void PIN_FAST_ANALYSIS_CALL
-tagmap_setl(size_t addr, uint32_t color)
+size_t
+tagmap_lbl_ranges(uint32_t lbl, tagmap_range_t *range, size_t max)
 {
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "tagmap_setl(0x%x)\n", addr);
-	fprintf(stderr, "STAB page is %x\n", (addr + STAB[VIRT2STAB(addr)]));
-	if((PAGE_ALIGN(addr) + STAB[VIRT2STAB(addr)]) == (uint32_t) zero_seg) { 
-		fprintf(stderr, "WARNING: holy shit setl to zero_seg\n");
+	vector<uint32_t>	leaves;	/* sources and ranges	*/
+	vector<tagmap_range_t>	found;	/* input ranges		*/
+	tagmap_range_t		r;	/* current range	*/
+	uint32_t		src, start, end;
+	size_t			i, n;	/* iterators		*/
+
+	lbl_leaves(lbl, leaves);
+
+	for (i = 0; i < leaves.size(); i++)
+		if (lbl_range(leaves[i], &src, &start, &end)) {
+			r.src	= src;
+			r.start	= start;
+			r.end	= end;
+			found.push_back(r);
+		}
+
+	sort(found.begin(), found.end(), range_cmp);
+
+	/* merge */
+	for (i = 0, n = 0; i < found.size(); i++) {
+		if (n > 0 && found[n - 1].src == found[i].src &&
+				found[i].start <= found[n - 1].end + 1) {
+			if (found[i].end > found[n - 1].end)
+				found[n - 1].end = found[i].end;
+			continue;
+		}
+		found[n++] = found[i];
 	}
-#endif
-	/* tag the bytes that correspond to the addresses of the long word */
-	*(uint32_t *)(addr + STAB[VIRT2STAB(addr)]) = color;
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "set done\n");
-#endif
+
+	for (i = 0; i < n && i < max; i++)
+		range[i] = found[i];
+
+	return n;
 }
 
 /*
- * untag a long word (i.e., 4 bytes) in the virtual address space
+ * label an arbitrary number of bytes in the virtual address space
  *
  * @addr:	the virtual address
+ * @num:	the number of bytes to label
+ * @lbl:	the label
  */
-void PIN_FAST_ANALYSIS_CALL
-tagmap_clrl(size_t addr)
+void
+tagmap_lbl_setn(size_t addr, size_t num, uint32_t lbl)
 {
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "tagmap_clrl(0x%x): *(uint32_t *)(0x%x + STAB[0x%x]) = TAG_ZERO; STAB[0x%x] == 0x%x -> *(uint32_t *)(0x%x) = TAG_ZERO\n",
-			 addr, addr, VIRT2STAB(addr), VIRT2STAB(addr), STAB[VIRT2STAB(addr)], (addr + STAB[VIRT2STAB(addr)]));
-	fprintf(stderr, "STAB page is %x\n", (addr + STAB[VIRT2STAB(addr)]));
-	if((PAGE_ALIGN(addr) + STAB[VIRT2STAB(addr)]) == (uint32_t) zero_seg) { 
-		fprintf(stderr, "WARNING: ignoring clrl to zero_seg\n");
-		return;
-	}
-#endif
-	/* clear the bytes that correspond to the addresses of the long word */
-	*(uint32_t *)(addr + STAB[VIRT2STAB(addr)]) = TAG_ZERO;
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "set done\n");
-#endif
+	/* label the bytes */
+	tag_filln(addr, num, lbl);
+
+	/* update the summary */
+	if (lbl != TAG_ZERO && num > 0)
+		sum_fill(VIRT2SUM(addr), VIRT2SUM(addr + num - 1), 1);
+	else
+		sum_clrn(addr, num);
 }
 
 /*
- * get the tag value of a long word (i.e., 4 bytes) from the tagmap
+ * label an arbitrary number of input bytes in the virtual address
+ * space with their provenance (i.e., input source and offset)
  *
  * @addr:	the virtual address
- *
- * returns:	the tag value (e.g., 0, 1,...)
+ * @num:	the number of bytes to label
+ * @src:	the input source (< TAG_PROV_SRC_MAX)
+ * @off:	the input offset of the first byte
  */
-uint32_t PIN_FAST_ANALYSIS_CALL
-tagmap_getl(size_t addr)
+void
+tagmap_lbl_setprov(size_t addr, size_t num, uint32_t src, size_t off)
 {
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "line %d: STAB page is %x, returning it\n", __LINE__, (addr + STAB[VIRT2STAB(addr)]));
-#endif
-	/* get the bytes that correspond to the addresses of the long word */
-	return *(uint32_t *)(addr + STAB[VIRT2STAB(addr)]);
+	size_t		n, seg, i, j;	/* run		*/
+	uint32_t	*tags;		/* labels	*/
+
+	if (unlikely(num == 0))
+		return;
+
+	for (i = 0; i < num; i += n) {
+		n = tag_run(addr + i, num - i, &seg);
+
+		/* shared segment; optimized branch */
+		if (unlikely(seg == (size_t)null_seg ||
+				seg == (size_t)zero_seg))
+			continue;
+
+		/* label the run */
+		tags = (uint32_t *)VIRT2TAG(addr + i);
+		for (j = 0; j < n; j++)
+			tags[j] = lbl_prov(src, off + i + j, off + i + j);
+	}
+
+	/* update the summary */
+	sum_fill(VIRT2SUM(addr), VIRT2SUM(addr + num - 1), 1);
 }
 
-/* tag an arbitrary number of bytes in the virtual address space
+/*
+ * get the label of a byte from the tagmap
  *
  * @addr:	the virtual address
- * @num:	the number of bytes to tag
- * @color:	the tag value
+ *
+ * returns:	the label (0 if clean)
  */
-void
-tagmap_setn(size_t addr, size_t num, uint8_t color)
+uint32_t
+tagmap_lbl_getb(size_t addr)
 {
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "tagmap_setn(0x%x)\n", addr);
-	fprintf(stderr, "STAB page is %x\n", (addr + STAB[VIRT2STAB(addr)]));
-	if((PAGE_ALIGN(addr) + STAB[VIRT2STAB(addr)]) == (uint32_t) zero_seg) { 
-		fprintf(stderr, "WARNING: holy shit setn to zero_seg\n");
-	}
-#endif
-	/* tag the bytes that correspond to the addresses of the num bytes */
-	(void)memset((void *)(addr + STAB[VIRT2STAB(addr)]), color, num);
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "set done\n");
-#endif
+	return tag_ldlbl(addr);
 }
 
 /*
- * untag an arbitrary number of bytes in the virtual address space
+ * get the union of the labels of an arbitrary
+ * number of bytes in the virtual address space
  *
  * @addr:	the virtual address
- * @num:	the number of bytes to untag
+ * @num:	the number of bytes
+ *
+ * returns:	the label of the range (0 if clean)
  */
-void
-tagmap_clrn(size_t addr, size_t num)
+uint32_t
+tagmap_lbl_orn(size_t addr, size_t num)
 {
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "tagmap_clrn(0x%x)\n", addr);
-	fprintf(stderr, "STAB page is %x\n", (addr + STAB[VIRT2STAB(addr)]));
-#endif
-	/* clear the bytes that correspond to the addresses of the num bytes */
-	(void)memset((void *)(addr + STAB[VIRT2STAB(addr)]), TAG_ZERO, num);
-#ifdef DEBUG_TAGMAP
-	fprintf(stderr, "set done\n");
-#endif
+	size_t		off, n, i;		/* iterators		*/
+	uint32_t	lbl = TAG_ZERO;		/* label of the range	*/
+	uint32_t	prev = TAG_ZERO;	/* previous label	*/
+	const uint32_t	*tags;			/* labels		*/
+
+	for (off = 0; off < num; off += n) {
+		n = tag_chunk_len(addr + off, num - off);
+
+		/* clean chunk; optimized branch */
+		if (likely(tag_chunk_clean(addr + off)))
+			continue;
+
+		/* runs of the same label are combined once */
+		tags = (const uint32_t *)VIRT2TAG(addr + off);
+		for (i = 0; i < n; i++)
+			if (tags[i] != prev) {
+				prev	= tags[i];
+				lbl	= tag_union(lbl, prev);
+			}
+	}
+
+	return lbl;
 }
+#endif
@@ -34,40 +34,319 @@
 #define __TAGMAP_H__
 
 #include "pin.H"
+#include "branch_pred.h"
 
 #define PAGE_SHIFT	12		/* page alignment offset (bits) */
-#define PAGE_SZ		(1U << PAGE_SHIFT)	/* page size;
-					   4 KB in x86 (i386) Linux	*/
+#define PAGE_SZ		((size_t)1 << PAGE_SHIFT)	/* page size;
+					   4 KB in x86 Linux		*/
 #define STACK_SZ	(PAGE_SZ << 11)		/* stack size;
-					   8 MB in x86 (i386) Linux	*/
-#define STAB_SIZE	(1U << 20)	/* 1 M items; 4GB / PAGE_SZ	*/
+					   8 MB in x86 Linux		*/
+#if defined(TARGET_IA32E)
+/*
+ * x86-64; the STAB covers 48 bits of address space (2^36 items), and
+ * kernel addresses (e.g., the vsyscall page) are folded into its upper
+ * half (see VIRT2STAB()), which is mapped to zero_seg. The directory
+ * has a middle level (see STAB_LEAF()), and hence only the parts of
+ * it that cover mapped chunks are ever allocated
+ */
+#define VIRT_BITS	48		/* address bits			*/
+#define VIRT_MASK	0xFFFFFFFFFFFFUL	/* address mask		*/
+#define STAB_LEAF_SHIFT	16		/* STAB leaf size (bits)	*/
+#define STAB_MID_SHIFT	10		/* STAB middle size (bits)	*/
+#define USER_START	0x000000000000UL	/* userland starting address */
+#define USER_END	0x7FFFFFFFFFFFUL	/* userland ending address   */
+#define KERN_START	0x800000000000UL	/* kernel starting address   */
+#define KERN_END	0xFFFFFFFFFFFFUL	/* kernel ending address     */
+/* dynamic linker/loader					*/
+#define	DYNLDLNK	"/lib64/ld-linux-x86-64.so.2"
+#else
+#define VIRT_BITS	32		/* address bits			*/
+#define VIRT_MASK	0xFFFFFFFFU	/* address mask			*/
+#define STAB_LEAF_SHIFT	10		/* STAB leaf size (bits)	*/
 #define USER_START	0x00000000U	/* userland starting address	*/
 #define USER_END	0xBFFFFFFFU	/* userland ending address	*/
 #define KERN_START	0xC0000000U	/* kernel starting address	*/
 #define KERN_END	0xFFFFFFFFU	/* kernel ending address	*/
-#define STACK_SEG_ADDR	(KERN_START - STACK_SZ)	/* 0xBF800000		*/
+/* dynamic linker/loader					*/
+#define	DYNLDLNK	"/lib/ld-linux.so.2"
+#endif
+#define STAB_SIZE	((size_t)1 << (VIRT_BITS - PAGE_SHIFT))	/* items;
+					   1 M in x86 (4GB / PAGE_SZ)	*/
+#define STAB_LEAF_SIZE	((size_t)1 << STAB_LEAF_SHIFT)	/* items per leaf;
+					   1 K (4 MB) in x86		*/
+#define STAB_DIR_SIZE	(STAB_SIZE >> STAB_LEAF_SHIFT)	/* leaves	*/
+#ifdef	STAB_MID_SHIFT
+#define STAB_MID_SIZE	((size_t)1 << STAB_MID_SHIFT)	/* leaves per middle;
+					   1 K (8 KB) in x86-64		*/
+#define STAB_TOP_SIZE	(STAB_DIR_SIZE >> STAB_MID_SHIFT)	/* middles */
+#else
+#define STAB_TOP_SIZE	STAB_DIR_SIZE	/* no middle level; leaves	*/
+#endif
+#define STACK_SEG_ADDR	(KERN_START - STACK_SZ)	/* 0xBF800000 in x86	*/
+#define HUGE_PAGE_SHIFT	21		/* huge page alignment (bits)	*/
+#define HUGE_PAGE_SZ	((size_t)1 << HUGE_PAGE_SHIFT)	/* huge page size;
+					   2 MB in x86 (PAE) Linux	*/
 
 /* maximum size on an entry in /proc/<pid>/maps */
 #define MAPS_ENTRY_MAX	128
 /* vDSO string in /proc/<pid>/maps */
 #define VDSO_STR	"[vdso]"
-/* dynamic linker/loader					*/
-#define	DYNLDLNK	"/lib/ld-linux.so.2"
 
 /* get the offset on stlb given a virtual address		*/
-#define VIRT2STAB(vaddr)	((vaddr) >> PAGE_SHIFT)
+#define VIRT2STAB(vaddr)	(((vaddr) & VIRT_MASK) >> PAGE_SHIFT)
 /* get the virtual address (page aligned) given an stlb offset	*/
 #define STAB2VIRT(indx)		((indx) << PAGE_SHIFT)
 /* page align a virtual address					*/
-#define PAGE_ALIGN(vaddr)	((vaddr) & 0xFFFFF000)
+#define PAGE_ALIGN(vaddr)	((vaddr) & ~(PAGE_SZ - 1))
+/* huge page align a virtual address				*/
+#define HUGE_ALIGN(vaddr)	((vaddr) & ~(HUGE_PAGE_SZ - 1))
+/* get the offset of a virtual address inside its page		*/
+#define PAGE_OFFSET(vaddr)	((vaddr) & (PAGE_SZ - 1))
+/* get the STAB directory/leaf offsets given an stlb offset	*/
+#define STAB2DIR(indx)		((indx) >> STAB_LEAF_SHIFT)
+#define STAB2LEAF(indx)		((indx) & (STAB_LEAF_SIZE - 1))
+#ifdef	STAB_MID_SHIFT
+/* get the STAB top/middle offsets given a directory offset	*/
+#define DIR2TOP(dindx)		((dindx) >> STAB_MID_SHIFT)
+#define DIR2MID(dindx)		((dindx) & (STAB_MID_SIZE - 1))
+/* get the STAB leaf given a directory offset			*/
+#define STAB_LEAF(dindx)	(STAB[DIR2TOP(dindx)][DIR2MID(dindx)])
+#else
+#define DIR2TOP(dindx)		(dindx)
+#define STAB_LEAF(dindx)	(STAB[dindx])
+#endif
+/* get the STAB top level offset given a virtual address	*/
+#define VIRT2TOP(vaddr)		DIR2TOP(STAB2DIR(VIRT2STAB(vaddr)))
+/* get the tagmap segment (page) given an stlb offset		*/
+#define STAB_SEG(indx)		(STAB_LEAF(STAB2DIR(indx))[STAB2LEAF(indx)])
+
+/*
+ * tag granularity; with TAGMAP_1BIT every byte of the address space is
+ * shadowed by a single bit (i.e., tainted or not), instead of a byte that
+ * can hold up to 8 different tags. With TAGMAP_LABEL every byte is
+ * shadowed by a 32-bit label (see tag_union())
+ */
+#if	defined(TAGMAP_1BIT) && defined(TAGMAP_LABEL)
+#error	"TAGMAP_1BIT and TAGMAP_LABEL are mutually exclusive"
+#endif
+#ifdef	TAGMAP_LABEL
+/* size of the tagmap segment (page) that shadows a PAGE_SZ chunk	*/
+#define TAG_PAGE_SZ		(PAGE_SZ << 2)
+/* size of the tagmap segment that shadows len bytes			*/
+#define TAG_SEG_SZ(len)		((len) << 2)
+/* get the tag (shadow) address given a virtual address			*/
+#define VIRT2TAG(vaddr)		\
+	(STAB_SEG(VIRT2STAB(vaddr)) + (PAGE_OFFSET(vaddr) << 2))
+/* get the tag bit (inside the tag byte) given a virtual address	*/
+#define VIRT2BIT(vaddr)		0
+#else
+#ifdef	TAGMAP_1BIT
+#define TAG_SHIFT	3		/* 8 bytes per tag byte	*/
+#else
+#define TAG_SHIFT	0		/* 1 byte per tag byte	*/
+#endif
+/* size of the tagmap segment (page) that shadows a PAGE_SZ chunk	*/
+#define TAG_PAGE_SZ		(PAGE_SZ >> TAG_SHIFT)
+/* size of the tagmap segment that shadows len bytes			*/
+#define TAG_SEG_SZ(len)		\
+	(((len) + (1U << TAG_SHIFT) - 1) >> TAG_SHIFT)
+#ifdef	TAGMAP_DIRECT
+/*
+ * direct-offset shadow; the tags of the whole address space are kept in
+ * a single (reserved) region, and the tag address is computed with a
+ * shift and an add (no STAB lookup). The region is DIRECT_SZ bytes, and
+ * hence it is only feasible with TAGMAP_1BIT (512 MB in x86)
+ */
+#ifndef	TAGMAP_1BIT
+#error	"TAGMAP_DIRECT requires TAGMAP_1BIT"
+#endif
+/* size of the direct shadow region					*/
+#define DIRECT_SZ		((size_t)1 << (VIRT_BITS - TAG_SHIFT))
+/* get the tag (shadow) address given a virtual address			*/
+#define VIRT2TAG(vaddr)		\
+	(tagmap_direct + (((vaddr) & VIRT_MASK) >> TAG_SHIFT))
+#else
+/* get the tag (shadow) address given a virtual address			*/
+#define VIRT2TAG(vaddr)		\
+	(STAB_SEG(VIRT2STAB(vaddr)) + (PAGE_OFFSET(vaddr) >> TAG_SHIFT))
+#endif
+/* get the tag bit (inside the tag byte) given a virtual address	*/
+#define VIRT2BIT(vaddr)		((vaddr) & ((1U << TAG_SHIFT) - 1))
+#endif
+
+/*
+ * label table size (TAGMAP_LABEL); up to 2^TAGMAP_LABEL_SHIFT labels,
+ * sources and unions alike. The last label (TAG_LBL_ALL) stands for
+ * ``any source'', and it is used once the table is full
+ */
+#ifndef	TAGMAP_LABEL_SHIFT
+#define TAGMAP_LABEL_SHIFT	20
+#endif
+#define TAG_LBL_MAX	(1U << TAGMAP_LABEL_SHIFT)	/* labels	*/
+#define TAG_LBL_ALL	(TAG_LBL_MAX - 1)		/* any source	*/
+
+/*
+ * provenance labels (TAGMAP_LABEL); the label of the byte at offset off
+ * of input source src (e.g., a descriptor) is encoded in the label itself
+ * (TAG_PROV_LBL()), without a label table entry, for the first 2^24 bytes
+ * of up to 128 sources. Unions of adjacent offsets are folded into range
+ * labels (src, start, end), and hence a run of input bytes that reaches
+ * a sink is reported as a single range (see tagmap_lbl_ranges())
+ */
+#define TAG_PROV		0x80000000U	/* provenance label	*/
+#define TAG_PROV_OFF_BITS	24		/* offset bits		*/
+#define TAG_PROV_SRC_MAX	0x80U		/* sources		*/
+#define TAG_PROV_OFF_MAX	(1U << TAG_PROV_OFF_BITS)
+#define TAG_PROV_LBL(src, off)	\
+	(TAG_PROV | ((src) << TAG_PROV_OFF_BITS) | (off))
+#define TAG_PROV_SRC(lbl)	\
+	(((lbl) & ~TAG_PROV) >> TAG_PROV_OFF_BITS)
+#define TAG_PROV_OFF(lbl)	((lbl) & (TAG_PROV_OFF_MAX - 1))
+
+/*
+ * taint summary granularity; the summary keeps one ``may be tainted'' bit
+ * for every 2^TAGMAP_SUM_SHIFT bytes of the address space (i.e., a page by
+ * default, or a cache line with -DTAGMAP_SUM_SHIFT=6)
+ */
+#ifndef	TAGMAP_SUM_SHIFT
+#define TAGMAP_SUM_SHIFT	PAGE_SHIFT
+#endif
+#if	TAGMAP_SUM_SHIFT > PAGE_SHIFT
+#error	"TAGMAP_SUM_SHIFT cannot be larger than PAGE_SHIFT"
+#endif
+#define SUM_SZ		(1U << TAGMAP_SUM_SHIFT)	/* summary unit	*/
+#define SUM_SIZE	((size_t)1 << (VIRT_BITS - TAGMAP_SUM_SHIFT))	/* bits	*/
+/*
+ * the summary is sparse; a directory of leaves that cover the same chunks
+ * as the STAB leaves (i.e., STAB_DIR_SIZE entries), which are allocated
+ * the first time that one of their bits is set (see tagmap_sum_leaf())
+ */
+#define SUM_LEAF_SHIFT	(STAB_LEAF_SHIFT + PAGE_SHIFT - TAGMAP_SUM_SHIFT)
+#define SUM_LEAF_SZ	((size_t)1 << (SUM_LEAF_SHIFT - 3))	/* bytes */
+/* get the summary bit given a virtual address			*/
+#define VIRT2SUM(vaddr)		(((vaddr) & VIRT_MASK) >> TAGMAP_SUM_SHIFT)
+/* get the summary directory offset/leaf byte given a summary bit	*/
+#define SUM2DIR(sbit)		((sbit) >> SUM_LEAF_SHIFT)
+#define SUM2BYTE(sbit)		\
+	(((sbit) & (((size_t)1 << SUM_LEAF_SHIFT) - 1)) >> 3)
+
+/* huge page policies for the tagmap segments */
+#define TAGMAP_HUGE_NONE	0	/* regular pages		*/
+#define TAGMAP_HUGE_THP		1	/* transparent huge pages	*/
+#define TAGMAP_HUGE_HUGETLB	2	/* MAP_HUGETLB			*/
+
+/* region kinds for the tagmap accounting (see tagmap_acct()) */
+#define TAGMAP_KIND_NONE	0	/* not accounted		*/
+#define TAGMAP_KIND_IMAGE	1	/* ELF images (and file mmaps)	*/
+#define TAGMAP_KIND_STACK	2	/* stacks			*/
+#define TAGMAP_KIND_HEAP	3	/* program break		*/
+#define TAGMAP_KIND_MMAP	4	/* anonymous mmaps		*/
+#define TAGMAP_KIND_SHM		5	/* shared memory		*/
+#define TAGMAP_KIND_NUM		6
+
+/* tagmap usage of a region kind */
+typedef struct {
+	size_t	segs;		/* allocated segments		*/
+	size_t	bytes;		/* live tagmap bytes		*/
+	size_t	peak;		/* peak tagmap bytes		*/
+	size_t	tainted;	/* (possibly) tainted pages	*/
+} tagmap_acct_t;
+
+/* input range; provenance labels (see tagmap_lbl_ranges()) */
+typedef struct {
+	uint32_t	src;		/* input source			*/
+	size_t		start;		/* first offset			*/
+	size_t		end;		/* last offset			*/
+} tagmap_range_t;
+
+/*
+ * tagmap dump (see tagmap_dump()); the file is meant to be mmap(2)-ed and
+ * used as is. A header page is followed by the tags of the non-clean pages
+ * (page aligned), the label table (TAGMAP_LABEL), the shadowed ranges of
+ * the address space, and the page index (sorted by address). Incremental
+ * dumps (TAGMAP_DUMP_INCR) hold only the pages that changed since the
+ * previous dump (seq - 1); pages that became clean are indexed with off 0
+ */
+#define TAGMAP_DUMP_MAGIC	0x504D4454U	/* "TDMP"		*/
+#define TAGMAP_DUMP_VERSION	1
+#define TAGMAP_DUMP_INCR	0x1U	/* incremental dump		*/
+#define TAGMAP_DUMP_1BIT	0x2U	/* TAGMAP_1BIT tags		*/
+#define TAGMAP_DUMP_LABEL	0x4U	/* TAGMAP_LABEL tags		*/
+#define TAGMAP_DUMP_RO		0x1U	/* read-only range (zero_seg)	*/
+
+/* dump header; at offset 0 */
+typedef struct {
+	uint32_t	magic;		/* TAGMAP_DUMP_MAGIC		*/
+	uint32_t	version;	/* TAGMAP_DUMP_VERSION		*/
+	uint32_t	flags;		/* TAGMAP_DUMP_* flags		*/
+	uint32_t	tag_page_sz;	/* tag bytes per page		*/
+	uint64_t	seq;		/* sequence number; 1 is first	*/
+	uint64_t	range_off;	/* shadowed ranges (offset)	*/
+	uint64_t	nranges;	/* shadowed ranges		*/
+	uint64_t	page_off;	/* page index (offset)		*/
+	uint64_t	npages;		/* page index entries		*/
+	uint64_t	lbl_off;	/* label rows (offset)		*/
+	uint64_t	lbl_first;	/* first label row		*/
+	uint64_t	nlbls;		/* label rows; uint32_t[4] each	*/
+} tagmap_dump_hdr_t;
+
+/* dump range; [start, end) is shadowed by the tagmap */
+typedef struct {
+	uint64_t	start;		/* first byte			*/
+	uint64_t	end;		/* last byte + 1		*/
+	uint64_t	flags;		/* TAGMAP_DUMP_RO		*/
+} tagmap_dump_range_t;
+
+/* dump page; the tags of the page at vaddr are at off */
+typedef struct {
+	uint64_t	vaddr;		/* the page			*/
+	uint64_t	off;		/* file offset; 0 if clean	*/
+} tagmap_dump_page_t;
 
 /* tag values */
 #define	TAG_ZERO	0x0U		/* clean		*/
 #define	TAG_ALL8	0xFFU		/* all colors; 1 byte	*/
+#define	TAG_BIT		0x1U		/* tainted; 1 bit	*/
+
 
+/* STAB; directory of leaves (x86-64: top level of middles) */
+#ifdef	STAB_MID_SHIFT
+extern size_t	***STAB;
+#else
+extern size_t	**STAB;
+#endif
+
+/* taint summary; one bit per SUM_SZ bytes (directory of leaves) */
+extern uint8_t	**tagmap_sum;
+
+#ifdef	TAGMAP_DIRECT
+/* the direct shadow region (see VIRT2TAG()) */
+extern size_t	tagmap_direct;
+#endif
 
 /* tagmap API */
 int					tagmap_alloc(void);
+uint8_t					*tagmap_sum_leaf(size_t);
+void					stab_map(size_t, size_t, void *);
+void					stab_unmap(size_t, size_t, void *);
+void					stab_commit(size_t, size_t, int);
+void					stab_collapse(size_t, size_t);
+void					*tagmap_seg_alloc(size_t, int);
+int					tagmap_seg_free(void *, size_t);
+int					tagmap_commit(size_t);
+void					tagmap_remap(size_t, size_t, size_t, size_t,
+						int);
+void					tagmap_seg_acct(int, void *, size_t,
+						size_t);
+void					tagmap_seg_advise(void *, size_t);
+int					tagmap_share_file(size_t, size_t, int,
+						size_t);
+int					tagmap_share_shm(size_t, size_t, int);
+void					tagmap_share_rmid(int);
+#ifdef	TAGMAP_DIRECT
+void					tagmap_direct_fixed(THREADID, size_t,
+						size_t);
+#endif
 void		PIN_FAST_ANALYSIS_CALL	tagmap_setb(size_t, uint8_t);
 void		PIN_FAST_ANALYSIS_CALL	tagmap_clrb(size_t);
 uint8_t					tagmap_getb(size_t);
@@ -77,7 +356,527 @@ uint16_t				tagmap_getw(size_t);
 void		PIN_FAST_ANALYSIS_CALL	tagmap_setl(size_t, uint32_t);
 void		PIN_FAST_ANALYSIS_CALL	tagmap_clrl(size_t);
 uint32_t	PIN_FAST_ANALYSIS_CALL	tagmap_getl(size_t);
+void		PIN_FAST_ANALYSIS_CALL	tagmap_clrq(size_t);
 void					tagmap_setn(size_t, size_t, uint8_t);
 void					tagmap_clrn(size_t, size_t);
+void					tagmap_copyn(size_t, size_t, size_t);
+int					tagmap_sumn(size_t, size_t);
+int					tagmap_anyn(size_t, size_t);
+size_t					tagmap_firstn(size_t, size_t);
+uint8_t					tagmap_orn(size_t, size_t);
+int					tagmap_checkpoint(void);
+void					tagmap_reset_to_checkpoint(void);
+int					tagmap_dump(const char *, int);
+void					tagmap_acct(tagmap_acct_t *);
+void					tagmap_acct_report(void);
+#ifdef	TAGMAP_LABEL
+uint32_t				tagmap_lbl_new(void);
+uint32_t				tagmap_lbl_union(uint32_t, uint32_t);
+size_t					tagmap_lbl_sources(uint32_t, uint32_t *,
+						size_t);
+void					tagmap_lbl_setn(size_t, size_t,
+						uint32_t);
+uint32_t				tagmap_lbl_getb(size_t);
+uint32_t				tagmap_lbl_orn(size_t, size_t);
+void					tagmap_lbl_setprov(size_t, size_t,
+						uint32_t, size_t);
+size_t					tagmap_lbl_ranges(uint32_t,
+						tagmap_range_t *, size_t);
+#endif
+
+/* get the summary byte of a summary unit; missing leaves are clean */
+static inline uint8_t
+tag_sum_byte(size_t sbit)
+{
+	uint8_t	*leaf	= tagmap_sum[SUM2DIR(sbit)];
+
+	return (leaf != NULL) ? leaf[SUM2BYTE(sbit)] : 0;
+}
+
+/* mark a summary unit as (possibly) tainted */
+static inline void
+tag_sum_set1(size_t sbit)
+{
+	uint8_t	bit	= (uint8_t)(1U << (sbit & 7));
+
+	/*
+	 * atomic, since a summary byte covers the units of other threads
+	 * too; it is rarely needed (optimized branch), and so is the
+	 * allocation of the leaf
+	 */
+	if (unlikely((tag_sum_byte(sbit) & bit) == 0))
+		(void)__sync_fetch_and_or(
+			&tagmap_sum_leaf(SUM2DIR(sbit))[SUM2BYTE(sbit)], bit);
+}
+
+/*
+ * mark the summary unit(s) of n bytes, starting from the given
+ * virtual address, as (possibly) tainted
+ */
+static inline void
+tag_sum_set(size_t vaddr, size_t n)
+{
+	tag_sum_set1(VIRT2SUM(vaddr));
+	tag_sum_set1(VIRT2SUM(vaddr + n - 1));
+}
+
+/*
+ * test the summary unit(s) of n bytes (up to SUM_SZ), starting
+ * from the given virtual address; 0 if they are clean
+ */
+static inline uint32_t
+tag_sum_test(size_t vaddr, size_t n)
+{
+	return ((tag_sum_byte(VIRT2SUM(vaddr)) >>
+			(VIRT2SUM(vaddr) & 7)) |
+		(tag_sum_byte(VIRT2SUM(vaddr + n - 1)) >>
+			(VIRT2SUM(vaddr + n - 1) & 7))) & 1U;
+}
+
+#ifdef	TAGMAP_LABEL
+/*
+ * get the union of two labels; the labels of the sources
+ * of both (0 is clean). Unions of the same pair of labels
+ * always result in the same label (see tagmap_lbl_union())
+ */
+static inline uint32_t
+tag_union(uint32_t a, uint32_t b)
+{
+	/* the same label, or a clean one */
+	if (a == b || b == TAG_ZERO)
+		return a;
+	if (a == TAG_ZERO)
+		return b;
+
+	return tagmap_lbl_union(a, b);
+}
+
+/*
+ * label accessors
+ *
+ * load/store/union the labels of n bytes in the virtual address space,
+ * from/to an array of labels (e.g., the bytes of a VCPU register)
+ */
+static inline uint32_t
+tag_ldlbl(size_t vaddr)
+{
+	return *(uint32_t *)VIRT2TAG(vaddr);
+}
+
+static inline void
+tag_stlbl(size_t vaddr, uint32_t lbl)
+{
+	*(uint32_t *)VIRT2TAG(vaddr) = lbl;
+	if (lbl != TAG_ZERO)
+		tag_sum_set(vaddr, 1);
+}
+
+static inline void
+tag_ldlbln(size_t vaddr, uint32_t *lbl, size_t n)
+{
+	const uint32_t	*tags	= (const uint32_t *)VIRT2TAG(vaddr);
+	size_t		i;
+
+	/* the bytes span two chunks */
+	if (PAGE_OFFSET(vaddr) + n > PAGE_SZ)
+		for (i = 0; i < n; i++)
+			lbl[i] = tag_ldlbl(vaddr + i);
+	else
+		for (i = 0; i < n; i++)
+			lbl[i] = tags[i];
+}
+
+static inline void
+tag_stlbln(size_t vaddr, const uint32_t *lbl, size_t n)
+{
+	uint32_t	*tags	= (uint32_t *)VIRT2TAG(vaddr);
+	uint32_t	any	= TAG_ZERO;
+	size_t		i;
+
+	/* the bytes span two chunks */
+	if (PAGE_OFFSET(vaddr) + n > PAGE_SZ)
+		for (i = 0; i < n; i++)
+			tag_stlbl(vaddr + i, lbl[i]);
+	else {
+		for (i = 0; i < n; i++)
+			any |= (tags[i] = lbl[i]);
+		if (any != TAG_ZERO)
+			tag_sum_set(vaddr, n);
+	}
+}
+
+static inline void
+tag_orlbln(size_t vaddr, const uint32_t *lbl, size_t n)
+{
+	size_t	i;
+
+	for (i = 0; i < n; i++)
+		if (lbl[i] != TAG_ZERO)
+			tag_stlbl(vaddr + i,
+				tag_union(tag_ldlbl(vaddr + i), lbl[i]));
+}
+#endif
+
+/*
+ * tag accessors
+ *
+ * load/store/or the tags of a byte, a word (2 bytes), or a long word
+ * (4 bytes) in the virtual address space; the tags are always in the
+ * register format (i.e., one tag byte per byte), regardless of the
+ * tagmap granularity. With TAGMAP_LABEL the loaded tags are TAG_BIT
+ * for every labeled byte, and a stored tag byte is used as the label
+ * of its byte
+ */
+#if	defined(TAGMAP_LABEL)
+static inline uint8_t
+tag_ldb(size_t vaddr)
+{
+	return tag_ldlbl(vaddr) != TAG_ZERO;
+}
+
+static inline uint16_t
+tag_ldw(size_t vaddr)
+{
+	return tag_ldb(vaddr) | (tag_ldb(vaddr + 1) << 8);
+}
+
+static inline uint32_t
+tag_ldl(size_t vaddr)
+{
+	return tag_ldw(vaddr) | (tag_ldw(vaddr + 2) << 16);
+}
+
+static inline void
+tag_stb(size_t vaddr, uint8_t tag)
+{
+	tag_stlbl(vaddr, tag);
+}
+
+static inline void
+tag_stw(size_t vaddr, uint16_t tag)
+{
+	tag_stlbl(vaddr, tag & TAG_ALL8);
+	tag_stlbl(vaddr + 1, tag >> 8);
+}
+
+static inline void
+tag_stl(size_t vaddr, uint32_t tag)
+{
+	tag_stw(vaddr, tag & 0xFFFFU);
+	tag_stw(vaddr + 2, tag >> 16);
+}
+
+static inline void
+tag_orb(size_t vaddr, uint8_t tag)
+{
+	if (tag != TAG_ZERO)
+		tag_stlbl(vaddr, tag_union(tag_ldlbl(vaddr), tag));
+}
+
+static inline void
+tag_orw(size_t vaddr, uint16_t tag)
+{
+	tag_orb(vaddr, tag & TAG_ALL8);
+	tag_orb(vaddr + 1, tag >> 8);
+}
+
+static inline void
+tag_orl(size_t vaddr, uint32_t tag)
+{
+	tag_orw(vaddr, tag & 0xFFFFU);
+	tag_orw(vaddr + 2, tag >> 16);
+}
+#elif	defined(TAGMAP_1BIT)
+/* 4 tag bits to 4 tag bytes */
+extern const uint32_t	tag_bit2byte[16];
+
+/* 4 tag bytes to 4 tag bits */
+static inline uint32_t
+tag_byte2bit(uint32_t tag)
+{
+	/* collapse every tag byte into its lowest bit */
+	tag |= tag >> 4;
+	tag |= tag >> 2;
+	tag |= tag >> 1;
+	tag &= 0x01010101U;
+
+	/* gather the bits */
+	return (tag * 0x01020408U) >> 24;
+}
+
+/* load n (<= 8) tag bits, starting from the given virtual address */
+static inline uint32_t
+tag_ldbits(size_t vaddr, size_t n)
+{
+	size_t		b	= VIRT2BIT(vaddr);
+	uint32_t	bits	= *(uint8_t *)VIRT2TAG(vaddr) >> b;
+
+	/* the bits span two tag bytes (maybe in different pages) */
+	if (b + n > 8)
+		bits |= *(uint8_t *)VIRT2TAG(vaddr + n - 1) << (8 - b);
+	
+	return bits & ((1U << n) - 1);
+}
+
+/*
+ * update the bits of a tag byte that are selected by a mask
+ *
+ * a tag byte holds the tags of 8 bytes, which may be written by different
+ * threads at the same time; partial updates are therefore atomic, so that
+ * they never lose the bits of the other bytes, whereas a whole tag byte
+ * is plainly stored
+ */
+static inline void
+tag_stbyte(uint8_t *taddr, uint8_t mask, uint8_t bits)
+{
+	/* whole tag byte */
+	if (mask == 0xFFU) {
+		*taddr = bits;
+		return;
+	}
+
+	if ((mask & ~bits) != 0)
+		(void)__sync_fetch_and_and(taddr, (uint8_t)~(mask & ~bits));
+	if (bits != 0)
+		(void)__sync_fetch_and_or(taddr, bits);
+}
+
+/* store n (<= 8) tag bits, starting from the given virtual address */
+static inline void
+tag_stbits(size_t vaddr, size_t n, uint32_t bits)
+{
+	size_t		b	= VIRT2BIT(vaddr);
+	uint32_t	mask	= (1U << n) - 1;
+
+	tag_stbyte((uint8_t *)VIRT2TAG(vaddr), (uint8_t)(mask << b),
+			(uint8_t)(bits << b));
+	
+	/* the bits span two tag bytes (maybe in different pages) */
+	if (b + n > 8)
+		tag_stbyte((uint8_t *)VIRT2TAG(vaddr + n - 1),
+				(uint8_t)(mask >> (8 - b)),
+				(uint8_t)(bits >> (8 - b)));
+}
+
+/* set n (<= 8) tag bits, starting from the given virtual address */
+static inline void
+tag_orbits(size_t vaddr, size_t n, uint32_t bits)
+{
+	size_t	b	= VIRT2BIT(vaddr);
+
+	/* atomic; see tag_stbyte() */
+	if ((uint8_t)(bits << b) != 0)
+		(void)__sync_fetch_and_or((uint8_t *)VIRT2TAG(vaddr),
+				(uint8_t)(bits << b));
+	
+	/* the bits span two tag bytes (maybe in different pages) */
+	if (b + n > 8 && (bits >> (8 - b)) != 0)
+		(void)__sync_fetch_and_or((uint8_t *)VIRT2TAG(vaddr + n - 1),
+				(uint8_t)(bits >> (8 - b)));
+}
+
+static inline uint8_t
+tag_ldb(size_t vaddr)
+{
+	return (*(uint8_t *)VIRT2TAG(vaddr) >> VIRT2BIT(vaddr)) & TAG_BIT;
+}
+
+static inline uint16_t
+tag_ldw(size_t vaddr)
+{
+	return tag_bit2byte[tag_ldbits(vaddr, 2)];
+}
+
+static inline uint32_t
+tag_ldl(size_t vaddr)
+{
+	return tag_bit2byte[tag_ldbits(vaddr, 4)];
+}
+
+static inline void
+tag_stb(size_t vaddr, uint8_t tag)
+{
+	tag_stbits(vaddr, 1, (tag != TAG_ZERO) ? TAG_BIT : 0);
+	if (tag != TAG_ZERO)
+		tag_sum_set(vaddr, 1);
+}
+
+static inline void
+tag_stw(size_t vaddr, uint16_t tag)
+{
+	tag_stbits(vaddr, 2, tag_byte2bit(tag));
+	if (tag != TAG_ZERO)
+		tag_sum_set(vaddr, 2);
+}
+
+static inline void
+tag_stl(size_t vaddr, uint32_t tag)
+{
+	tag_stbits(vaddr, 4, tag_byte2bit(tag));
+	if (tag != TAG_ZERO)
+		tag_sum_set(vaddr, 4);
+}
+
+static inline void
+tag_orb(size_t vaddr, uint8_t tag)
+{
+	if (tag != TAG_ZERO) {
+		tag_orbits(vaddr, 1, TAG_BIT);
+		tag_sum_set(vaddr, 1);
+	}
+}
+
+static inline void
+tag_orw(size_t vaddr, uint16_t tag)
+{
+	if (tag != TAG_ZERO) {
+		tag_orbits(vaddr, 2, tag_byte2bit(tag));
+		tag_sum_set(vaddr, 2);
+	}
+}
+
+static inline void
+tag_orl(size_t vaddr, uint32_t tag)
+{
+	if (tag != TAG_ZERO) {
+		tag_orbits(vaddr, 4, tag_byte2bit(tag));
+		tag_sum_set(vaddr, 4);
+	}
+}
+#else
+/*
+ * the tags of an n-byte access span two tag pages (possibly in different,
+ * non-adjacent segments; e.g., successive brk(2) expansions); such accesses
+ * are split into halves, which is always possible since n is a power of 2
+ */
+#define TAG_SPLIT(vaddr, n)	(PAGE_OFFSET(vaddr) > PAGE_SZ - (n))
+
+static inline uint8_t
+tag_ldb(size_t vaddr)
+{
+	return *(uint8_t *)VIRT2TAG(vaddr);
+}
+
+static inline uint16_t
+tag_ldw(size_t vaddr)
+{
+	/* optimized branch */
+	if (unlikely(TAG_SPLIT(vaddr, 2)))
+		return (uint16_t)(tag_ldb(vaddr) | (tag_ldb(vaddr + 1) << 8));
+
+	return *(uint16_t *)VIRT2TAG(vaddr);
+}
+
+static inline uint32_t
+tag_ldl(size_t vaddr)
+{
+	/* optimized branch */
+	if (unlikely(TAG_SPLIT(vaddr, 4)))
+		return tag_ldw(vaddr) | ((uint32_t)tag_ldw(vaddr + 2) << 16);
+
+	return *(uint32_t *)VIRT2TAG(vaddr);
+}
+
+static inline void
+tag_stb(size_t vaddr, uint8_t tag)
+{
+	*(uint8_t *)VIRT2TAG(vaddr) = tag;
+	if (tag != TAG_ZERO)
+		tag_sum_set(vaddr, 1);
+}
+
+static inline void
+tag_stw(size_t vaddr, uint16_t tag)
+{
+	/* optimized branch */
+	if (unlikely(TAG_SPLIT(vaddr, 2))) {
+		tag_stb(vaddr, (uint8_t)tag);
+		tag_stb(vaddr + 1, (uint8_t)(tag >> 8));
+		return;
+	}
+
+	*(uint16_t *)VIRT2TAG(vaddr) = tag;
+	if (tag != TAG_ZERO)
+		tag_sum_set(vaddr, 2);
+}
+
+static inline void
+tag_stl(size_t vaddr, uint32_t tag)
+{
+	/* optimized branch */
+	if (unlikely(TAG_SPLIT(vaddr, 4))) {
+		tag_stw(vaddr, (uint16_t)tag);
+		tag_stw(vaddr + 2, (uint16_t)(tag >> 16));
+		return;
+	}
+
+	*(uint32_t *)VIRT2TAG(vaddr) = tag;
+	if (tag != TAG_ZERO)
+		tag_sum_set(vaddr, 4);
+}
+
+static inline void
+tag_orb(size_t vaddr, uint8_t tag)
+{
+	*(uint8_t *)VIRT2TAG(vaddr) |= tag;
+	if (tag != TAG_ZERO)
+		tag_sum_set(vaddr, 1);
+}
+
+static inline void
+tag_orw(size_t vaddr, uint16_t tag)
+{
+	/* optimized branch */
+	if (unlikely(TAG_SPLIT(vaddr, 2))) {
+		tag_orb(vaddr, (uint8_t)tag);
+		tag_orb(vaddr + 1, (uint8_t)(tag >> 8));
+		return;
+	}
+
+	*(uint16_t *)VIRT2TAG(vaddr) |= tag;
+	if (tag != TAG_ZERO)
+		tag_sum_set(vaddr, 2);
+}
+
+static inline void
+tag_orl(size_t vaddr, uint32_t tag)
+{
+	/* optimized branch */
+	if (unlikely(TAG_SPLIT(vaddr, 4))) {
+		tag_orw(vaddr, (uint16_t)tag);
+		tag_orw(vaddr + 2, (uint16_t)(tag >> 16));
+		return;
+	}
+
+	*(uint32_t *)VIRT2TAG(vaddr) |= tag;
+	if (tag != TAG_ZERO)
+		tag_sum_set(vaddr, 4);
+}
+#endif
+
+/*
+ * quad word (8 bytes) variants; composed from the long word ones, since
+ * the tags of a quad word may span two (possibly unrelated) tag pages
+ * only at the same points as two adjacent long words do
+ */
+static inline uint64_t
+tag_ldq(size_t vaddr)
+{
+	return tag_ldl(vaddr) | ((uint64_t)tag_ldl(vaddr + 4) << 32);
+}
+
+static inline void
+tag_stq(size_t vaddr, uint64_t tag)
+{
+	tag_stl(vaddr, (uint32_t)tag);
+	tag_stl(vaddr + 4, (uint32_t)(tag >> 32));
+}
+
+static inline void
+tag_orq(size_t vaddr, uint64_t tag)
+{
+	tag_orl(vaddr, (uint32_t)tag);
+	tag_orl(vaddr + 4, (uint32_t)(tag >> 32));
+}
 
 #endif /* __TAGMAP_H__ */
@@ -40,12 +40,15 @@
 #include <errno.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <limits.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <map>
 #include <set>
+#include <vector>
 
 #include "branch_pred.h"
 #include "libdft_api.h"
@@ -54,6 +57,7 @@
 #include "tagmap.h"
 
 #define WORD_LEN	4	/* size in bytes of a word value */
+#define QUAD_LEN	8	/* size in bytes of a quad word value */
 #define SYS_SOCKET	1	/* socket(2) demux index for socketcall */
 
 /* default path for the log file (audit) */
@@ -63,6 +67,9 @@
 #define DLIB_SUFF	".so"
 #define DLIB_SUFF_ALT	".so."
 
+/* max input ranges in an alert (TAGMAP_LABEL) */
+#define RANGE_MAX	32
+
 
 /* thread context */
 extern REG thread_ctx_ptr;
@@ -76,10 +83,30 @@ extern syscall_desc_t syscall_desc[SYSCALL_MAX];
 /* set of interesting descriptors (sockets) */
 static set<int> fdset;
 
+#ifdef	TAGMAP_LABEL
+/* input stream of an interesting descriptor (provenance) */
+typedef struct {
+	uint32_t	src;	/* input source (see srcname)	*/
+	size_t		off;	/* offset of the next byte	*/
+} stream_t;
+
+/* input streams of the interesting descriptors */
+static map<int, stream_t> fdstream;
+
+/* input sources; the path of every descriptor that was read */
+static vector<string> srcname;
+
+/* label of the operands of the last tainted branch */
+static uint32_t sink_lbl;
+#endif
+
 /* log file path (auditing) */
 static KNOB<string> logpath(KNOB_MODE_WRITEONCE, "pintool", "l",
 		LOGFILE_DFL, "");
 
+/* tagmap dump path; taken on alert (disabled by default) */
+static KNOB<string> dumppath(KNOB_MODE_WRITEONCE, "pintool", "d", "", "");
+
 /*
  * flag variables
  *
@@ -96,6 +123,128 @@ static KNOB<size_t> fs(KNOB_MODE_WRITEONCE, "pintool", "f", "1", "");
 /* track net (enabled by default) */
 static KNOB<size_t> net(KNOB_MODE_WRITEONCE, "pintool", "n", "1", "");
 
+#ifdef	TAGMAP_LABEL
+/*
+ * report the input ranges of a label (provenance)
+ *
+ * @logfile:	the log file
+ * @lbl:	the label
+ */
+static void
+report_ranges(FILE *logfile, uint32_t lbl)
+{
+	tagmap_range_t range[RANGE_MAX];
+	size_t i, n;
+
+	n = tagmap_lbl_ranges(lbl, range, RANGE_MAX);
+	for (i = 0; i < n && i < RANGE_MAX; i++)
+		(void)fprintf(logfile, "\t%s: [%zu, %zu]\n",
+				(range[i].src < srcname.size()) ?
+				srcname[range[i].src].c_str() : "?",
+				range[i].start, range[i].end);
+	if (n > RANGE_MAX)
+		(void)fprintf(logfile, "\t... (%zu more)\n", n - RANGE_MAX);
+	/* sources without provenance (see taint_any()) */
+	if (n == 0)
+		(void)fprintf(logfile, "\t(unknown input)\n");
+}
+
+/*
+ * get the label of the operands of a tainted branch;
+ * the register (if any) and the target address
+ *
+ * @tags:	the register labels (NULL for none)
+ * @n:		the number of register (and memory) labels
+ * @paddr:	the memory operand (0 for none)
+ * @taddr:	the target address
+ */
+static uint32_t
+sink_label(const uint32_t *tags, size_t n, ADDRINT paddr, ADDRINT taddr)
+{
+	uint32_t lbl = TAG_ZERO;
+	size_t i;
+
+	if (tags != NULL)
+		for (i = 0; i < n; i++)
+			lbl = tag_union(lbl, tags[i]);
+	if (paddr != 0)
+		lbl = tag_union(lbl, tagmap_lbl_orn(paddr, n));
+
+	return tag_union(lbl, tagmap_lbl_orn(taddr, n));
+}
+#endif
+
+/*
+ * taint-source helper
+ *
+ * tag the bytes that were read from an interesting
+ * descriptor; with TAGMAP_LABEL every byte is labeled
+ * with its input source (the descriptor) and its offset
+ * in the input stream
+ *
+ * @fd:		the descriptor
+ * @addr:	the address of the data
+ * @len:	the length of the data
+ */
+static void
+taint_src(int fd, size_t addr, size_t len)
+{
+#ifdef	TAGMAP_LABEL
+	/* iterator */
+	map<int, stream_t>::iterator it;
+	/* stream */
+	stream_t stream;
+	/* descriptor path */
+	char lpath[PATH_MAX], path[PATH_MAX];
+	ssize_t n;
+
+	/* a new input stream */
+	if ((it = fdstream.find(fd)) == fdstream.end()) {
+		/* name the source after the descriptor path */
+		(void)snprintf(lpath, PATH_MAX, "/proc/self/fd/%d", fd);
+		if ((n = readlink(lpath, path, PATH_MAX - 1)) < 0)
+			n = snprintf(path, PATH_MAX, "fd %d", fd);
+		path[n] = '\0';
+
+		stream.src = srcname.size();
+		stream.off = 0;
+		if (stream.src < TAG_PROV_SRC_MAX)
+			srcname.push_back(string(path));
+		it = fdstream.insert(make_pair(fd, stream)).first;
+	}
+
+	/* out of sources; any source */
+	if (unlikely(it->second.src >= TAG_PROV_SRC_MAX))
+		tagmap_lbl_setn(addr, len, TAG_LBL_ALL);
+	else
+		tagmap_lbl_setprov(addr, len, it->second.src, it->second.off);
+
+	/* housekeeping */
+	it->second.off += len;
+#else
+	tagmap_setn(addr, len, TAG_ALL8);
+#endif
+}
+
+/*
+ * taint-source helper
+ *
+ * tag data that do not belong to an input
+ * stream (e.g., ancillary data)
+ *
+ * @addr:	the address of the data
+ * @len:	the length of the data
+ */
+static void
+taint_any(size_t addr, size_t len)
+{
+#ifdef	TAGMAP_LABEL
+	tagmap_lbl_setn(addr, len, TAG_LBL_ALL);
+#else
+	tagmap_setn(addr, len, TAG_ALL8);
+#endif
+}
+
 /* 
  * DTA/DFT alert
  *
@@ -114,10 +263,14 @@ alert(ADDRINT ins, ADDRINT bt)
 		(void)fprintf(logfile, " ____ ____ ____ ____\n");
 		(void)fprintf(logfile, "||w |||o |||o |||t ||\n");
 		(void)fprintf(logfile, "||__|||__|||__|||__||\t");
-		(void)fprintf(logfile, "[%d]: 0x%08x --> 0x%08x\n",
-							getpid(), ins, bt);
+		(void)fprintf(logfile, "[%d]: 0x%08lx --> 0x%08lx\n",
+				getpid(), (unsigned long)ins, (unsigned long)bt);
 
 		(void)fprintf(logfile, "|/__\\|/__\\|/__\\|/__\\|\n");
+#ifdef	TAGMAP_LABEL
+		/* provenance; the input bytes that reached the sink */
+		report_ranges(logfile, sink_lbl);
+#endif
 		
 		/* cleanup */
 		(void)fclose(logfile);
@@ -129,10 +282,37 @@ alert(ADDRINT ins, ADDRINT bt)
 			logpath.Value().c_str() + " (" +
 			string(strerror(errno)) + ")\n");
 
+	/* the taint state at the time of the alert (see tagmap_dump()) */
+	if (!dumppath.Value().empty())
+		(void)tagmap_dump(dumppath.Value().c_str(), 0);
+
 	/* terminate */
 	exit(EXIT_FAILURE);
 }
 
+#if defined(TARGET_IA32E)
+/*
+ * 64-bit register assertion (taint-sink, DFT-sink)
+ *
+ * called before an instruction that uses a register
+ * for an indirect branch; returns a positive value
+ * whenever the register value or the target address
+ * are tainted
+ *
+ * returns:	0 (clean), >0 (tainted)
+ */
+static ADDRINT PIN_FAST_ANALYSIS_CALL
+assert_reg64(thread_ctx_t *thread_ctx, uint32_t reg, ADDRINT addr)
+{
+	/* 
+	 * combine the register tag along with the tag
+	 * markings of the target address
+	 */
+	return thread_ctx->vcpu.gpr[reg] || tagmap_getl(addr) ||
+		tagmap_getl(addr + WORD_LEN);
+}
+#endif
+
 /*
  * 32-bit register assertion (taint-sink, DFT-sink)
  *
@@ -144,13 +324,26 @@ alert(ADDRINT ins, ADDRINT bt)
  * returns:	0 (clean), >0 (tainted)
  */
 static ADDRINT PIN_FAST_ANALYSIS_CALL
-assert_reg32(thread_ctx_t *thread_ctx, uint32_t reg, uint32_t addr)
+assert_reg32(thread_ctx_t *thread_ctx, uint32_t reg, ADDRINT addr)
 {
 	/* 
 	 * combine the register tag along with the tag
 	 * markings of the target address
 	 */
+#ifdef	TAGMAP_LABEL
+	/* clean; optimized branch */
+	if (likely((thread_ctx->vcpu.gpr[reg][0] |
+		thread_ctx->vcpu.gpr[reg][1] | thread_ctx->vcpu.gpr[reg][2] |
+		thread_ctx->vcpu.gpr[reg][3]) == TAG_ZERO &&
+		tagmap_getl(addr) == TAG_ZERO))
+		return 0;
+
+	/* provenance */
+	sink_lbl = sink_label(thread_ctx->vcpu.gpr[reg], 4, 0, addr);
+	return 1;
+#else
 	return thread_ctx->vcpu.gpr[reg] || tagmap_getl(addr);
+#endif
 }
 
 /*
@@ -164,16 +357,47 @@ assert_reg32(thread_ctx_t *thread_ctx, uint32_t reg, uint32_t addr)
  * returns:	0 (clean), >0 (tainted)
  */
 static ADDRINT PIN_FAST_ANALYSIS_CALL
-assert_reg16(thread_ctx_t *thread_ctx, uint32_t reg, uint32_t addr)
+assert_reg16(thread_ctx_t *thread_ctx, uint32_t reg, ADDRINT addr)
 {
 	/* 
 	 * combine the register tag along with the tag
 	 * markings of the target address
 	 */
+#ifdef	TAGMAP_LABEL
+	/* clean; optimized branch */
+	if (likely((thread_ctx->vcpu.gpr[reg][0] |
+		thread_ctx->vcpu.gpr[reg][1]) == TAG_ZERO &&
+		tagmap_getw(addr) == TAG_ZERO))
+		return 0;
+
+	/* provenance */
+	sink_lbl = sink_label(thread_ctx->vcpu.gpr[reg], 2, 0, addr);
+	return 1;
+#else
 	return (thread_ctx->vcpu.gpr[reg] & VCPU_MASK16)
 		|| tagmap_getw(addr);
+#endif
 }
 
+#if defined(TARGET_IA32E)
+/*
+ * 64-bit memory assertion (taint-sink, DFT-sink)
+ *
+ * called before an instruction that uses a memory
+ * location for an indirect branch; returns a positive
+ * value whenever the memory value (i.e., effective address),
+ * or the target address, are tainted
+ *
+ * returns:	0 (clean), >0 (tainted)
+ */
+static ADDRINT PIN_FAST_ANALYSIS_CALL
+assert_mem64(ADDRINT paddr, ADDRINT taddr)
+{
+	return tagmap_getl(paddr) || tagmap_getl(paddr + WORD_LEN) ||
+		tagmap_getl(taddr) || tagmap_getl(taddr + WORD_LEN);
+}
+#endif
+
 /*
  * 32-bit memory assertion (taint-sink, DFT-sink)
  *
@@ -187,7 +411,18 @@ assert_reg16(thread_ctx_t *thread_ctx, uint32_t reg, uint32_t addr)
 static ADDRINT PIN_FAST_ANALYSIS_CALL
 assert_mem32(ADDRINT paddr, ADDRINT taddr)
 {
+#ifdef	TAGMAP_LABEL
+	/* clean; optimized branch */
+	if (likely(tagmap_getl(paddr) == TAG_ZERO &&
+		tagmap_getl(taddr) == TAG_ZERO))
+		return 0;
+
+	/* provenance */
+	sink_lbl = sink_label(NULL, 4, paddr, taddr);
+	return 1;
+#else
 	return tagmap_getl(paddr) || tagmap_getl(taddr);
+#endif
 }
 
 /*
@@ -203,7 +438,18 @@ assert_mem32(ADDRINT paddr, ADDRINT taddr)
 static ADDRINT PIN_FAST_ANALYSIS_CALL
 assert_mem16(ADDRINT paddr, ADDRINT taddr)
 {
+#ifdef	TAGMAP_LABEL
+	/* clean; optimized branch */
+	if (likely(tagmap_getw(paddr) == TAG_ZERO &&
+		tagmap_getw(taddr) == TAG_ZERO))
+		return 0;
+
+	/* provenance */
+	sink_lbl = sink_label(NULL, 2, paddr, taddr);
+	return 1;
+#else
 	return tagmap_getw(paddr) || tagmap_getw(taddr);
+#endif
 }
 
 /*
@@ -233,6 +479,23 @@ dta_instrument_jmp_call(INS ins)
 
 			/* size analysis */
 
+#if defined(TARGET_IA32E)
+			/* 64-bit register */
+			if (REG_is_gr64(reg))
+				/*
+				 * instrument assert_reg64() before branch;
+				 * conditional instrumentation -- if
+				 */
+				INS_InsertIfCall(ins,
+					IPOINT_BEFORE,
+					(AFUNPTR)assert_reg64,
+					IARG_FAST_ANALYSIS_CALL,
+					IARG_REG_VALUE, thread_ctx_ptr,
+					IARG_UINT32, REG32_INDX(reg),
+					IARG_REG_VALUE, reg,
+					IARG_END);
+			else
+#endif
 			/* 32-bit register */
 			if (REG_is_gr32(reg))
 				/*
@@ -266,6 +529,22 @@ dta_instrument_jmp_call(INS ins)
 		/* call via memory */
 			/* size analysis */
 				
+#if defined(TARGET_IA32E)
+			/* 64-bit */
+			if (INS_MemoryReadSize(ins) == QUAD_LEN)
+				/*
+				 * instrument assert_mem64() before branch;
+				 * conditional instrumentation -- if
+				 */
+				INS_InsertIfCall(ins,
+					IPOINT_BEFORE,
+					(AFUNPTR)assert_mem64,
+					IARG_FAST_ANALYSIS_CALL,
+					IARG_MEMORYREAD_EA,
+					IARG_BRANCH_TARGET_ADDR,
+					IARG_END);
+			else
+#endif
 			/* 32-bit */
 			if (INS_MemoryReadSize(ins) == WORD_LEN)
 				/*
@@ -319,6 +598,22 @@ dta_instrument_ret(INS ins)
 {
 	/* size analysis */
 				
+#if defined(TARGET_IA32E)
+	/* 64-bit */
+	if (INS_MemoryReadSize(ins) == QUAD_LEN)
+		/*
+		 * instrument assert_mem64() before ret;
+		 * conditional instrumentation -- if
+		 */
+		INS_InsertIfCall(ins,
+			IPOINT_BEFORE,
+			(AFUNPTR)assert_mem64,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_MEMORYREAD_EA,
+			IARG_BRANCH_TARGET_ADDR,
+			IARG_END);
+	else
+#endif
 	/* 32-bit */
 	if (INS_MemoryReadSize(ins) == WORD_LEN)
 		/*
@@ -372,7 +667,8 @@ post_read_hook(syscall_ctx_t *ctx)
 	/* taint-source */
 	if (fdset.find(ctx->arg[SYSCALL_ARG0]) != fdset.end())
         	/* set the tag markings */
-	        tagmap_setn(ctx->arg[SYSCALL_ARG1], (size_t)ctx->ret, TAG_ALL8);
+	        taint_src((int)ctx->arg[SYSCALL_ARG0], ctx->arg[SYSCALL_ARG1],
+							(size_t)ctx->ret);
 	else
         	/* clear the tag markings */
 	        tagmap_clrn(ctx->arg[SYSCALL_ARG1], (size_t)ctx->ret);
@@ -414,7 +710,8 @@ post_readv_hook(syscall_ctx_t *ctx)
 		/* taint interesting data and zero everything else */	
 		if (it != fdset.end())
                 	/* set the tag markings */
-                	tagmap_setn((size_t)iov->iov_base, iov_tot, TAG_ALL8);
+                	taint_src((int)ctx->arg[SYSCALL_ARG0],
+					(size_t)iov->iov_base, iov_tot);
 		else
                 	/* clear the tag markings */
                 	tagmap_clrn((size_t)iov->iov_base, iov_tot);
@@ -519,8 +816,8 @@ post_socketcall_hook(syscall_ctx_t *ctx)
 			/* taint-source */	
 			if (fdset.find((int)args[SYSCALL_ARG0]) != fdset.end())
 				/* set the tag markings */
-				tagmap_setn(args[SYSCALL_ARG1],
-						(size_t)ctx->ret, TAG_ALL8);
+				taint_src((int)args[SYSCALL_ARG0],
+					args[SYSCALL_ARG1], (size_t)ctx->ret);
 			else
 				/* clear the tag markings */
 				tagmap_clrn(args[SYSCALL_ARG1],
@@ -534,8 +831,8 @@ post_socketcall_hook(syscall_ctx_t *ctx)
 			/* taint-source */	
 			if (fdset.find((int)args[SYSCALL_ARG0]) != fdset.end())
 				/* set the tag markings */
-				tagmap_setn(args[SYSCALL_ARG1],
-						(size_t)ctx->ret, TAG_ALL8);
+				taint_src((int)args[SYSCALL_ARG0],
+					args[SYSCALL_ARG1], (size_t)ctx->ret);
 			else
 				/* clear the tag markings */
 				tagmap_clrn(args[SYSCALL_ARG1],
@@ -569,7 +866,7 @@ post_socketcall_hook(syscall_ctx_t *ctx)
 				return;
 			
 			/* get the descriptor */
-			it = fdset.find((int)ctx->arg[SYSCALL_ARG0]);
+			it = fdset.find((int)args[SYSCALL_ARG0]);
 
 			/* extract the message header */
 			msg = (struct msghdr *)args[SYSCALL_ARG1];
@@ -590,8 +887,8 @@ post_socketcall_hook(syscall_ctx_t *ctx)
 				/* taint-source */
 				if (it != fdset.end())
 					/* set the tag markings */
-					tagmap_setn((size_t)msg->msg_control,
-						msg->msg_controllen, TAG_ALL8);
+					taint_any((size_t)msg->msg_control,
+						msg->msg_controllen);
 					
 				else
 					/* clear the tag markings */
@@ -621,8 +918,8 @@ post_socketcall_hook(syscall_ctx_t *ctx)
 				/* taint-source */	
 				if (it != fdset.end())
 					/* set the tag markings */
-					tagmap_setn((size_t)iov->iov_base,
-							iov_tot, TAG_ALL8);
+					taint_src((int)args[SYSCALL_ARG0],
+						(size_t)iov->iov_base, iov_tot);
 				else
 					/* clear the tag markings */
 					tagmap_clrn((size_t)iov->iov_base,
@@ -641,6 +938,87 @@ post_socketcall_hook(syscall_ctx_t *ctx)
 	}
 }
 
+#if defined(TARGET_IA32E)
+/*
+ * x86-64 has no socketcall(2); the socket syscalls
+ * are repackaged the way socketcall(2) passes them
+ *
+ * @ctx:	the syscall context
+ * @call:	the socketcall(2) demux index
+ */
+static inline void
+post_socket_demux(syscall_ctx_t *ctx, int call)
+{
+	/* socketcall(2) context */
+	syscall_ctx_t sctx = *ctx;
+
+	/* socket call arguments */
+	unsigned long args[SYSCALL_ARG_NUM];
+
+	/* iterator */
+	size_t i;
+
+	/* copy the arguments */
+	for (i = 0; i < SYSCALL_ARG_NUM; i++)
+		args[i] = ctx->arg[i];
+
+	/* demux index and argument block */
+	sctx.arg[SYSCALL_ARG0] = call;
+	sctx.arg[SYSCALL_ARG1] = (ADDRINT)args;
+
+	post_socketcall_hook(&sctx);
+}
+
+/* socket(2) */
+static void
+post_socket_hook(syscall_ctx_t *ctx)
+{
+	post_socket_demux(ctx, SYS_SOCKET);
+}
+
+/* accept(2), accept4(2) */
+static void
+post_accept_hook(syscall_ctx_t *ctx)
+{
+	post_socket_demux(ctx, SYS_ACCEPT);
+}
+
+/* getsockname(2), getpeername(2) */
+static void
+post_getsockname_hook(syscall_ctx_t *ctx)
+{
+	post_socket_demux(ctx, SYS_GETSOCKNAME);
+}
+
+/* socketpair(2) */
+static void
+post_socketpair_hook(syscall_ctx_t *ctx)
+{
+	post_socket_demux(ctx, SYS_SOCKETPAIR);
+}
+
+/* recvfrom(2); recv(2) is recvfrom(2) on x86-64 */
+static void
+post_recvfrom_hook(syscall_ctx_t *ctx)
+{
+	post_socket_demux(ctx, SYS_RECVFROM);
+}
+
+/* recvmsg(2) */
+static void
+post_recvmsg_hook(syscall_ctx_t *ctx)
+{
+	post_socket_demux(ctx, SYS_RECVMSG);
+}
+
+/* getsockopt(2) */
+static void
+post_getsockopt_hook(syscall_ctx_t *ctx)
+{
+	post_socket_demux(ctx, SYS_GETSOCKOPT);
+}
+#endif
+
 /*
  * auxiliary (helper) function
  *
@@ -688,6 +1066,10 @@ post_close_hook(syscall_ctx_t *ctx)
 	it = fdset.find((int)ctx->arg[SYSCALL_ARG0]);
 	if (likely(it != fdset.end()))
 		fdset.erase(it);
+#ifdef	TAGMAP_LABEL
+	/* the descriptor may be reused for another input */
+	fdstream.erase((int)ctx->arg[SYSCALL_ARG0]);
+#endif
 }
 
 /*
@@ -778,9 +1160,31 @@ main(int argc, char **argv)
 	(void)syscall_set_post(&syscall_desc[__NR_readv], post_readv_hook);
 
 	/* socket(2), accept(2), recv(2), recvfrom(2), recvmsg(2) */
-	if (net.Value() != 0)
+	if (net.Value() != 0) {
+#if defined(TARGET_IA32E)
+		(void)syscall_set_post(&syscall_desc[__NR_socket],
+			post_socket_hook);
+		(void)syscall_set_post(&syscall_desc[__NR_accept],
+			post_accept_hook);
+		(void)syscall_set_post(&syscall_desc[__NR_accept4],
+			post_accept_hook);
+		(void)syscall_set_post(&syscall_desc[__NR_getsockname],
+			post_getsockname_hook);
+		(void)syscall_set_post(&syscall_desc[__NR_getpeername],
+			post_getsockname_hook);
+		(void)syscall_set_post(&syscall_desc[__NR_socketpair],
+			post_socketpair_hook);
+		(void)syscall_set_post(&syscall_desc[__NR_recvfrom],
+			post_recvfrom_hook);
+		(void)syscall_set_post(&syscall_desc[__NR_recvmsg],
+			post_recvmsg_hook);
+		(void)syscall_set_post(&syscall_desc[__NR_getsockopt],
+			post_getsockopt_hook);
+#else
 		(void)syscall_set_post(&syscall_desc[__NR_socketcall],
 			post_socketcall_hook);
+#endif
+	}
 
 	/* dup(2), dup2(2) */
 	(void)syscall_set_post(&syscall_desc[__NR_dup], post_dup_hook);
@@ -0,0 +1,154 @@
+/*-
+ * Copyright (c) 2011, 2012, 2013, Columbia University
+ * All rights reserved.
+ *
+ * This software was developed by Vasileios P. Kemerlis <vpk@cs.columbia.edu>
+ * at Columbia University, New York, NY, USA, in June 2011.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *   * Redistributions of source code must retain the above copyright
+ *     notice, this list of conditions and the following disclaimer.
+ *   * Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *   * Neither the name of Columbia University nor the
+ *     names of its contributors may be used to endorse or promote products
+ *     derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * memloop; a memory-heavy workload for comparing the cost of the tag
+ * lookups of the different tagmap layouts (e.g., the STAB against
+ * TAGMAP_DIRECT). It is a plain program, not a Pintool; see the README
+ *
+ * the buffer is read from a file, so that it is tainted when the file
+ * channel is a taint source (e.g., libdft-dta with `-f 1'), and then it
+ * is swept with word loads and stores that stride over its pages; the
+ * checksum keeps the compiler from eliding the loops
+ *
+ * usage: memloop <file> [size (MB, default 16)] [iterations (default 32)]
+ */
+
+#include <sys/time.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define PAGE_SZ		4096		/* page size			*/
+#define MB		(1UL << 20)	/* megabyte			*/
+#define SIZE_DFL	16		/* default size (MB)		*/
+#define ITER_DFL	32		/* default iterations		*/
+
+/*
+ * fill a buffer from a file; short files are read again from the start
+ *
+ * @fd:		the file
+ * @buf:	the buffer
+ * @len:	its size in bytes
+ *
+ * returns:	0 on success, 1 on error
+ */
+static int
+fill(int fd, unsigned char *buf, size_t len)
+{
+	ssize_t	n;	/* bytes read	*/
+	size_t	off;	/* iterator	*/
+
+	for (off = 0; off < len; off += (size_t)n) {
+		if ((n = read(fd, buf + off, len - off)) < 0)
+			return 1;
+
+		/* end of file; rewind */
+		if (n == 0 && (off == 0 || lseek(fd, 0, SEEK_SET) < 0))
+			return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * memloop
+ *
+ * sweep the buffer page by page, and word by word within the pages, so
+ * that consecutive accesses hit different pages (i.e., different STAB
+ * entries), and copy every word to the other half of the buffer
+ */
+int
+main(int argc, char **argv)
+{
+	size_t		size, iter;	/* arguments			*/
+	size_t		words, pages;	/* words (per half), pages	*/
+	size_t		i, p, w;	/* iterators			*/
+	unsigned long	*src, *dst;	/* the halves of the buffer	*/
+	unsigned long	sum = 0;	/* checksum			*/
+	unsigned char	*buf;		/* the buffer			*/
+	struct timeval	start, end;	/* the time of the sweeps	*/
+	int		fd;		/* the file			*/
+
+	if (argc < 2) {
+		(void)fprintf(stderr,
+			"usage: %s <file> [size (MB)] [iterations]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+	size	= ((argc > 2) ? strtoul(argv[2], NULL, 0) : SIZE_DFL) * MB;
+	iter	= (argc > 3) ? strtoul(argv[3], NULL, 0) : ITER_DFL;
+	if (size == 0 || iter == 0) {
+		(void)fprintf(stderr, "%s: invalid size or iterations\n",
+				argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	/* the buffer */
+	errno = 0;
+	if ((buf = (unsigned char *)malloc(size)) == NULL) {
+		(void)fprintf(stderr, "%s: malloc: %s\n", argv[0],
+				strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if ((fd = open(argv[1], O_RDONLY)) < 0 || fill(fd, buf, size) != 0) {
+		(void)fprintf(stderr, "%s: %s: %s\n", argv[0], argv[1],
+				(errno != 0) ? strerror(errno) : "empty file");
+		return EXIT_FAILURE;
+	}
+	(void)close(fd);
+
+	src	= (unsigned long *)buf;
+	dst	= (unsigned long *)(buf + size / 2);
+	pages	= size / 2 / PAGE_SZ;
+	words	= PAGE_SZ / sizeof(unsigned long);
+
+	(void)gettimeofday(&start, NULL);
+	for (i = 0; i < iter; i++)
+		for (w = 0; w < words; w++)
+			for (p = 0; p < pages; p++) {
+				sum		+= src[p * words + w];
+				dst[p * words + w] = src[p * words + w] ^ sum;
+			}
+	(void)gettimeofday(&end, NULL);
+
+	(void)printf("%zu MB, %zu iterations: %.3f s (checksum %lx)\n",
+			size / MB, iter,
+			(double)(end.tv_sec - start.tv_sec) +
+			(double)(end.tv_usec - start.tv_usec) / 1e6, sum);
+
+	free(buf);
+	return EXIT_SUCCESS;
+}